@@ -30,7 +30,6 @@ public class CityGMLImporter : ModuleRules
                 "Engine",
                 "Slate",
                 "SlateCore",
-                "XmlParser",
                 "DesktopPlatform",
                 "Projects",
                 "ProceduralMeshComponent",
@@ -47,7 +46,11 @@ public class CityGMLImporter : ModuleRules
                 "Engine",
                 "Slate",
                 "SlateCore",
-                "UnrealEd"
+                "UnrealEd",
+                "MeshDescription",
+                "StaticMeshDescription",
+                "AssetTools",
+                "AssetRegistry"
                 // ... add private dependencies that you statically link with here ...	
             }
         );
@@ -60,6 +63,9 @@ public class CityGMLImporter : ModuleRules
             }
         );
 
+        // Streaming-Entpacken von .gml.gz und Zip-Archiven
+        AddEngineThirdPartyPrivateStaticDependencies(Target, "zlib");
+
 
 
     }
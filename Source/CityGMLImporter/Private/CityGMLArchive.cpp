@@ -0,0 +1,522 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#include "CityGMLArchive.h"
+#include "CityGMLStats.h"
+#include "Async/Async.h"
+#include "HAL/Event.h"
+#include "HAL/PlatformFilemanager.h"
+#include "Misc/Crc.h"
+#include "Misc/Paths.h"
+#include "Misc/ScopeLock.h"
+#include "Misc/SecureHash.h"
+
+THIRD_PARTY_INCLUDES_START
+#include "zlib.h"
+THIRD_PARTY_INCLUDES_END
+
+#define LOCTEXT_NAMESPACE "FCityGMLImporterModule"
+
+namespace
+{
+    // Größe eines entpackten Blocks und Anzahl der Blöcke, die der Entpacker vorauslaufen darf
+    const int32 BlockSize = 1024 * 1024;
+    const int32 MaxQueuedBlocks = 4;
+    // Lesepuffer für die komprimierten Daten
+    const int32 InputChunkSize = 256 * 1024;
+
+    // Signaturen der Zip-Strukturen
+    const uint32 LocalHeaderSignature = 0x04034b50;
+    const uint32 CentralHeaderSignature = 0x02014b50;
+    const uint32 EndOfCentralDirSignature = 0x06054b50;
+    const uint32 Zip64EndOfCentralDirSignature = 0x06064b50;
+    const uint32 Zip64LocatorSignature = 0x07064b50;
+
+    // Zip ist Little Endian, wie alle Plattformen der Engine
+    uint16 ReadU16(const uint8* Data) { uint16 Value; FMemory::Memcpy(&Value, Data, sizeof(Value)); return Value; }
+    uint32 ReadU32(const uint8* Data) { uint32 Value; FMemory::Memcpy(&Value, Data, sizeof(Value)); return Value; }
+    uint64 ReadU64(const uint8* Data) { uint64 Value; FMemory::Memcpy(&Value, Data, sizeof(Value)); return Value; }
+
+    bool ReadAt(IFileHandle& File, int64 Offset, uint8* Data, int64 Size)
+    {
+        return File.Seek(Offset) && File.Read(Data, Size);
+    }
+
+    /**
+     * Liest das Central Directory eines Zip-Archivs, auch im ZIP64-Format für Archive über 4 GB.
+     * Übernommen werden nur .gml und .xml Einträge, die gespeichert oder mit Deflate komprimiert sind.
+     */
+    bool ReadZipDirectory(const FString& ArchivePath, TArray<FCityGMLSource>& OutEntries, FText& OutError)
+    {
+        TUniquePtr<IFileHandle> File(FPlatformFileManager::Get().GetPlatformFile().OpenRead(*ArchivePath));
+        if (!File) {
+            OutError = FText::Format(LOCTEXT("ZipOpenFailed", "Failed to open archive: {0}"), FText::FromString(ArchivePath));
+            return false;
+        }
+        const int64 FileSize = File->Size();
+
+        // End of Central Directory: 22 Bytes am Ende, davor höchstens 64 KB Kommentar
+        const int64 TailSize = FMath::Min<int64>(FileSize, 22 + 0xFFFF);
+        TArray<uint8> Tail;
+        Tail.SetNumUninitialized(TailSize);
+        if (TailSize < 22 || !ReadAt(*File, FileSize - TailSize, Tail.GetData(), TailSize)) {
+            OutError = FText::Format(LOCTEXT("ZipTooSmall", "Not a zip archive: {0}"), FText::FromString(ArchivePath));
+            return false;
+        }
+        int64 EndPos = INDEX_NONE;
+        for (int64 i = TailSize - 22; i >= 0; --i) {
+            if (ReadU32(&Tail[i]) == EndOfCentralDirSignature) {
+                EndPos = i;
+                break;
+            }
+        }
+        if (EndPos == INDEX_NONE) {
+            OutError = FText::Format(LOCTEXT("ZipNoDirectory", "Not a zip archive: {0}"), FText::FromString(ArchivePath));
+            return false;
+        }
+
+        uint64 NumEntries = ReadU16(&Tail[EndPos + 10]);
+        uint64 DirectorySize = ReadU32(&Tail[EndPos + 12]);
+        uint64 DirectoryOffset = ReadU32(&Tail[EndPos + 16]);
+        if (NumEntries == 0xFFFF || DirectorySize == 0xFFFFFFFF || DirectoryOffset == 0xFFFFFFFF) {
+            // ZIP64: der Locator steht direkt vor dem End of Central Directory
+            uint8 Locator[20];
+            uint8 End64[56];
+            const int64 LocatorPos = FileSize - TailSize + EndPos - 20;
+            if (LocatorPos < 0 || !ReadAt(*File, LocatorPos, Locator, 20) || ReadU32(Locator) != Zip64LocatorSignature
+                || !ReadAt(*File, ReadU64(Locator + 8), End64, 56) || ReadU32(End64) != Zip64EndOfCentralDirSignature) {
+                OutError = FText::Format(LOCTEXT("ZipBadZip64", "Damaged ZIP64 archive: {0}"), FText::FromString(ArchivePath));
+                return false;
+            }
+            NumEntries = ReadU64(End64 + 32);
+            DirectorySize = ReadU64(End64 + 40);
+            DirectoryOffset = ReadU64(End64 + 48);
+        }
+
+        TArray<uint8> Directory;
+        if (DirectoryOffset + DirectorySize > uint64(FileSize) || DirectorySize > MAX_int32) {
+            OutError = FText::Format(LOCTEXT("ZipBadDirectory", "Damaged zip archive: {0}"), FText::FromString(ArchivePath));
+            return false;
+        }
+        Directory.SetNumUninitialized(DirectorySize);
+        if (!ReadAt(*File, DirectoryOffset, Directory.GetData(), DirectorySize)) {
+            OutError = FText::Format(LOCTEXT("ZipReadFailed", "Failed to read archive: {0}"), FText::FromString(ArchivePath));
+            return false;
+        }
+
+        int64 Pos = 0;
+        for (uint64 Entry = 0; Entry < NumEntries; ++Entry) {
+            if (Pos + 46 > Directory.Num() || ReadU32(&Directory[Pos]) != CentralHeaderSignature) {
+                OutError = FText::Format(LOCTEXT("ZipBadEntry", "Damaged zip archive: {0}"), FText::FromString(ArchivePath));
+                return false;
+            }
+            const uint8* Header = &Directory[Pos];
+            const uint16 Flags = ReadU16(Header + 8);
+            const uint16 Method = ReadU16(Header + 10);
+            const uint16 NameLength = ReadU16(Header + 28);
+            const uint16 ExtraLength = ReadU16(Header + 30);
+            const uint16 CommentLength = ReadU16(Header + 32);
+            if (Pos + 46 + NameLength + ExtraLength + CommentLength > Directory.Num()) {
+                OutError = FText::Format(LOCTEXT("ZipBadEntry", "Damaged zip archive: {0}"), FText::FromString(ArchivePath));
+                return false;
+            }
+
+            FCityGMLSource Source;
+            Source.FilePath = ArchivePath;
+            // Bit 11: Name in UTF-8, sonst Codepage 437, für ASCII-Namen ist beides gleich
+            const FUTF8ToTCHAR Name((const ANSICHAR*)(Header + 46), NameLength);
+            Source.EntryName = FString(Name.Length(), Name.Get());
+            Source.Crc32 = ReadU32(Header + 16);
+            Source.CompressedSize = ReadU32(Header + 20);
+            Source.UncompressedSize = ReadU32(Header + 24);
+            Source.LocalHeaderOffset = ReadU32(Header + 42);
+
+            // ZIP64 Extra Field: nur die Werte, die im Header auf 0xFFFFFFFF stehen, in fester Reihenfolge
+            const uint8* Extra = Header + 46 + NameLength;
+            for (int32 ExtraPos = 0; ExtraPos + 4 <= ExtraLength;) {
+                const uint16 ExtraId = ReadU16(Extra + ExtraPos);
+                const uint16 ExtraSize = ReadU16(Extra + ExtraPos + 2);
+                if (ExtraId == 0x0001) {
+                    const uint8* Value = Extra + ExtraPos + 4;
+                    const uint8* ValueEnd = Value + FMath::Min<int32>(ExtraSize, ExtraLength - ExtraPos - 4);
+                    if (Source.UncompressedSize == 0xFFFFFFFF && Value + 8 <= ValueEnd) { Source.UncompressedSize = ReadU64(Value); Value += 8; }
+                    if (Source.CompressedSize == 0xFFFFFFFF && Value + 8 <= ValueEnd) { Source.CompressedSize = ReadU64(Value); Value += 8; }
+                    if (Source.LocalHeaderOffset == 0xFFFFFFFF && Value + 8 <= ValueEnd) { Source.LocalHeaderOffset = ReadU64(Value); }
+                }
+                ExtraPos += 4 + ExtraSize;
+            }
+            Pos += 46 + NameLength + ExtraLength + CommentLength;
+
+            const FString Extension = FPaths::GetExtension(Source.EntryName).ToLower();
+            if (Source.EntryName.EndsWith(TEXT("/")) || Source.EntryName.StartsWith(TEXT("__MACOSX/")) || (Extension != TEXT("gml") && Extension != TEXT("xml"))) {
+                continue;
+            }
+            if (Flags & 0x1) {
+                UE_LOG(LogTemp, Warning, TEXT("Skipping encrypted zip entry %s"), *Source.GetDisplayPath());
+                continue;
+            }
+            if (Method != 0 && Method != 8) {
+                UE_LOG(LogTemp, Warning, TEXT("Skipping zip entry %s with unsupported compression method %d"), *Source.GetDisplayPath(), Method);
+                continue;
+            }
+            Source.Compression = Method == 0 ? ECityGMLCompression::ZipStored : ECityGMLCompression::ZipDeflate;
+            OutEntries.Add(MoveTemp(Source));
+        }
+        return true;
+    }
+
+    /**
+     * Warteschlange begrenzter Länge zwischen Entpacker und Leser. Leere Blöcke werden wiederverwendet,
+     * sodass pro Eingabe höchstens MaxQueuedBlocks + 2 Blöcke angelegt werden.
+     */
+    class FBlockQueue
+    {
+    public:
+        FBlockQueue()
+            : DataAvailable(FPlatformProcess::GetSynchEventFromPool(false))
+            , SpaceAvailable(FPlatformProcess::GetSynchEventFromPool(false))
+        {
+        }
+
+        ~FBlockQueue()
+        {
+            FPlatformProcess::ReturnSynchEventToPool(DataAvailable);
+            FPlatformProcess::ReturnSynchEventToPool(SpaceAvailable);
+        }
+
+        /** Ein leerer Block mit BlockSize Bytes */
+        TArray<uint8> GetEmptyBlock()
+        {
+            TArray<uint8> Block;
+            {
+                FScopeLock Lock(&Mutex);
+                if (Free.Num() > 0) {
+                    Block = Free.Pop(false);
+                }
+            }
+            Block.SetNumUninitialized(BlockSize, false);
+            return Block;
+        }
+
+        /** Wartet, bis Platz ist. false, wenn der Leser aufgehört hat */
+        bool Push(TArray<uint8>&& Block)
+        {
+            for (;;) {
+                {
+                    FScopeLock Lock(&Mutex);
+                    if (bAborted) {
+                        return false;
+                    }
+                    if (Full.Num() < MaxQueuedBlocks) {
+                        Full.Add(MoveTemp(Block));
+                        DataAvailable->Trigger();
+                        return true;
+                    }
+                }
+                SpaceAvailable->Wait();
+            }
+        }
+
+        /** Wartet auf den nächsten Block. false, wenn keiner mehr kommt */
+        bool Pop(TArray<uint8>& OutBlock)
+        {
+            for (;;) {
+                {
+                    FScopeLock Lock(&Mutex);
+                    if (Full.Num() > 0) {
+                        OutBlock = MoveTemp(Full[0]);
+                        Full.RemoveAt(0, 1, false);
+                        SpaceAvailable->Trigger();
+                        return true;
+                    }
+                    if (bClosed) {
+                        return false;
+                    }
+                }
+                DataAvailable->Wait();
+            }
+        }
+
+        void Recycle(TArray<uint8>&& Block)
+        {
+            FScopeLock Lock(&Mutex);
+            Free.Add(MoveTemp(Block));
+        }
+
+        /** Vom Entpacker: es kommen keine Blöcke mehr */
+        void Close()
+        {
+            FScopeLock Lock(&Mutex);
+            bClosed = true;
+            DataAvailable->Trigger();
+        }
+
+        /** Vom Leser: weitere Blöcke werden nicht mehr gebraucht */
+        void Abort()
+        {
+            FScopeLock Lock(&Mutex);
+            bAborted = true;
+            SpaceAvailable->Trigger();
+        }
+
+    private:
+        FCriticalSection Mutex;
+        FEvent* DataAvailable;
+        FEvent* SpaceAvailable;
+        TArray<TArray<uint8>> Full;
+        TArray<TArray<uint8>> Free;
+        bool bClosed = false;
+        bool bAborted = false;
+    };
+
+    /** Läuft auf dem Entpacker-Thread und schiebt den entpackten Inhalt blockweise in die Warteschlange */
+    bool Decompress(const FCityGMLSource& Source, FBlockQueue& Queue, FText& OutError, const FThreadSafeBool* CancelFlag)
+    {
+        CITYGML_SCOPE_CYCLE_COUNTER(STAT_CityGML_Decompress);
+        TUniquePtr<IFileHandle> File(FPlatformFileManager::Get().GetPlatformFile().OpenRead(*Source.FilePath));
+        if (!File) {
+            OutError = FText::Format(LOCTEXT("Loadingfailure", "Failed to load XML file: {0}"), FText::FromString(Source.FilePath));
+            return false;
+        }
+
+        // Bereich der komprimierten Daten in der Datei
+        int64 DataStart = 0;
+        int64 DataSize = File->Size();
+        if (Source.Compression != ECityGMLCompression::Gzip) {
+            uint8 LocalHeader[30];
+            if (!ReadAt(*File, Source.LocalHeaderOffset, LocalHeader, 30) || ReadU32(LocalHeader) != LocalHeaderSignature) {
+                OutError = FText::Format(LOCTEXT("ZipBadLocalHeader", "Damaged zip entry: {0}"), FText::FromString(Source.GetDisplayPath()));
+                return false;
+            }
+            // Name und Extra Field können im Local Header anders lang sein als im Central Directory
+            DataStart = Source.LocalHeaderOffset + 30 + ReadU16(LocalHeader + 26) + ReadU16(LocalHeader + 28);
+            DataSize = Source.CompressedSize;
+            if (!File->Seek(DataStart)) {
+                OutError = FText::Format(LOCTEXT("ZipBadLocalHeader", "Damaged zip entry: {0}"), FText::FromString(Source.GetDisplayPath()));
+                return false;
+            }
+        }
+
+        TArray<uint8> Input;
+        Input.SetNumUninitialized(InputChunkSize);
+        int64 Remaining = DataSize;
+        TArray<uint8> Block = Queue.GetEmptyBlock();
+        int32 Filled = 0;
+
+        // Zip-Einträge werden gegen die CRC-32 aus dem Central Directory geprüft, gzip prüft zlib selbst
+        const bool bCheckCrc = Source.Compression != ECityGMLCompression::Gzip;
+        uint32 Crc = 0;
+        auto PushBlock = [&Queue, &Block, &Filled, &Crc, bCheckCrc]() {
+            if (bCheckCrc) {
+                Crc = FCrc::MemCrc32(Block.GetData(), Filled, Crc);
+            }
+            Block.SetNum(Filled, false);
+            const bool bPushed = Queue.Push(MoveTemp(Block));
+            Block = Queue.GetEmptyBlock();
+            Filled = 0;
+            return bPushed;
+        };
+        // Vor dem letzten Block aufgerufen, damit ein beschädigter Eintrag als Lesefehler endet und nicht vollständig ankommt
+        auto IsCrcValid = [&Source, &OutError, &Block, &Filled, &Crc, bCheckCrc]() {
+            if (!bCheckCrc || FCrc::MemCrc32(Block.GetData(), Filled, Crc) == Source.Crc32) {
+                return true;
+            }
+            OutError = FText::Format(LOCTEXT("ZipBadCrc", "Damaged zip entry, CRC-32 does not match: {0}"), FText::FromString(Source.GetDisplayPath()));
+            return false;
+        };
+
+        if (Source.Compression == ECityGMLCompression::ZipStored) {
+            // Gespeicherte Einträge werden direkt in die Blöcke gelesen
+            while (Remaining > 0) {
+                if (CancelFlag && *CancelFlag) {
+                    return false;
+                }
+                const int32 Size = int32(FMath::Min<int64>(Remaining, BlockSize));
+                if (!File->Read(Block.GetData(), Size)) {
+                    OutError = FText::Format(LOCTEXT("ZipReadFailed", "Failed to read archive: {0}"), FText::FromString(Source.GetDisplayPath()));
+                    return false;
+                }
+                Remaining -= Size;
+                Filled = Size;
+                if ((Remaining == 0 && !IsCrcValid()) || !PushBlock()) {
+                    return false;
+                }
+            }
+            // Ein leerer Eintrag hat keinen Block, seine Prüfsumme muss trotzdem stimmen
+            return DataSize > 0 || IsCrcValid();
+        }
+
+        z_stream Stream;
+        FMemory::Memzero(Stream);
+        // gzip mit Header und Prüfsumme, Zip-Einträge als rohes Deflate
+        const int WindowBits = Source.Compression == ECityGMLCompression::Gzip ? 15 + 16 : -15;
+        if (inflateInit2(&Stream, WindowBits) != Z_OK) {
+            OutError = FText::Format(LOCTEXT("InflateInitFailed", "Failed to decompress: {0}"), FText::FromString(Source.GetDisplayPath()));
+            return false;
+        }
+
+        bool bSucceeded = false;
+        for (;;) {
+            if (CancelFlag && *CancelFlag) {
+                break;
+            }
+            if (Stream.avail_in == 0 && Remaining > 0) {
+                const int32 Size = int32(FMath::Min<int64>(Remaining, InputChunkSize));
+                if (!File->Read(Input.GetData(), Size)) {
+                    OutError = FText::Format(LOCTEXT("ZipReadFailed", "Failed to read archive: {0}"), FText::FromString(Source.GetDisplayPath()));
+                    break;
+                }
+                Remaining -= Size;
+                Stream.next_in = Input.GetData();
+                Stream.avail_in = Size;
+            }
+
+            Stream.next_out = Block.GetData() + Filled;
+            Stream.avail_out = BlockSize - Filled;
+            const int Result = inflate(&Stream, Z_NO_FLUSH);
+            Filled = BlockSize - Stream.avail_out;
+
+            if (Result == Z_STREAM_END) {
+                // Aneinandergehängte gzip-Member, z.B. von parallelen Kompressoren, werden nacheinander entpackt.
+                // Ein weiteres Member beginnt mit der Kennung 1f 8b, alles andere dahinter, z.B. Auffüllung mit Nullen, wird ignoriert
+                if (Source.Compression == ECityGMLCompression::Gzip && (Stream.avail_in > 0 || Remaining > 0)) {
+                    if (Stream.avail_in < 2 && Remaining > 0) {
+                        // Die Kennung kann über das Ende des gelesenen Stücks hinausgehen
+                        FMemory::Memmove(Input.GetData(), Stream.next_in, Stream.avail_in);
+                        const int32 Size = int32(FMath::Min<int64>(Remaining, InputChunkSize - Stream.avail_in));
+                        if (!File->Read(Input.GetData() + Stream.avail_in, Size)) {
+                            OutError = FText::Format(LOCTEXT("ZipReadFailed", "Failed to read archive: {0}"), FText::FromString(Source.GetDisplayPath()));
+                            break;
+                        }
+                        Remaining -= Size;
+                        Stream.next_in = Input.GetData();
+                        Stream.avail_in += Size;
+                    }
+                    if (Stream.avail_in >= 2 && Stream.next_in[0] == 0x1f && Stream.next_in[1] == 0x8b) {
+                        inflateReset(&Stream);
+                        continue;
+                    }
+                }
+                bSucceeded = IsCrcValid() && (Filled == 0 || PushBlock());
+                break;
+            }
+            if (Result != Z_OK && !(Result == Z_BUF_ERROR && (Stream.avail_in > 0 || Remaining > 0 || Filled == BlockSize))) {
+                OutError = FText::Format(LOCTEXT("InflateFailed", "Failed to decompress {0}: {1}"), FText::FromString(Source.GetDisplayPath()),
+                    FText::FromString(Result == Z_BUF_ERROR ? TEXT("unexpected end of data") : UTF8_TO_TCHAR(Stream.msg ? Stream.msg : "invalid data")));
+                break;
+            }
+            if (Filled == BlockSize && !PushBlock()) {
+                break;
+            }
+        }
+        inflateEnd(&Stream);
+        return bSucceeded;
+    }
+}
+
+bool CityGMLArchive::IsCompressed(const FString& FilePath)
+{
+    return FilePath.EndsWith(TEXT(".zip"), ESearchCase::IgnoreCase) || FilePath.EndsWith(TEXT(".gz"), ESearchCase::IgnoreCase);
+}
+
+void CityGMLArchive::ExpandSources(const TArray<FString>& Files, TArray<FCityGMLSource>& OutSources)
+{
+    OutSources.Reset();
+    for (const FString& FilePath : Files) {
+        if (FilePath.EndsWith(TEXT(".zip"), ESearchCase::IgnoreCase)) {
+            // Ein fehlerhaftes Archiv wird zu einer Eingabe, die mit dem Fehler fehlschlägt
+            FText Error;
+            const int32 FirstEntry = OutSources.Num();
+            if (!ReadZipDirectory(FilePath, OutSources, Error)) {
+                OutSources.SetNum(FirstEntry);
+                FCityGMLSource& Source = OutSources.AddDefaulted_GetRef();
+                Source.FilePath = FilePath;
+                Source.Error = Error;
+            }
+            else {
+                UE_LOG(LogTemp, Log, TEXT("%s: %d CityGML entries"), *FPaths::GetCleanFilename(FilePath), OutSources.Num() - FirstEntry);
+            }
+            continue;
+        }
+        FCityGMLSource& Source = OutSources.AddDefaulted_GetRef();
+        Source.FilePath = FilePath;
+        Source.Compression = FilePath.EndsWith(TEXT(".gz"), ESearchCase::IgnoreCase) ? ECityGMLCompression::Gzip : ECityGMLCompression::None;
+    }
+}
+
+bool CityGMLArchive::ReadSource(const FCityGMLSource& Source, TFunctionRef<bool(const uint8* Data, int32 Size)> OnBlock, FText& OutError, const FThreadSafeBool* CancelFlag)
+{
+    if (!Source.Error.IsEmpty()) {
+        OutError = Source.Error;
+        return false;
+    }
+
+    if (Source.Compression == ECityGMLCompression::None) {
+        // Unkomprimiert ohne eigenen Thread, der Leser wartet ohnehin auf die Festplatte
+        TUniquePtr<IFileHandle> File(FPlatformFileManager::Get().GetPlatformFile().OpenRead(*Source.FilePath));
+        if (!File) {
+            OutError = FText::Format(LOCTEXT("Loadingfailure", "Failed to load XML file: {0}"), FText::FromString(Source.FilePath));
+            return false;
+        }
+        TArray<uint8> Block;
+        Block.SetNumUninitialized(BlockSize);
+        for (int64 Remaining = File->Size(); Remaining > 0;) {
+            if (CancelFlag && *CancelFlag) {
+                return false;
+            }
+            const int32 Size = int32(FMath::Min<int64>(Remaining, BlockSize));
+            if (!File->Read(Block.GetData(), Size)) {
+                OutError = FText::Format(LOCTEXT("Loadingfailure", "Failed to load XML file: {0}"), FText::FromString(Source.FilePath));
+                return false;
+            }
+            Remaining -= Size;
+            if (!OnBlock(Block.GetData(), Size)) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    // Der Entpacker läuft auf einem eigenen Thread und nicht im Thread-Pool, der bei ParallelImport schon mit Lesern belegt ist
+    TSharedRef<FBlockQueue, ESPMode::ThreadSafe> Queue = MakeShared<FBlockQueue, ESPMode::ThreadSafe>();
+    TSharedRef<FText, ESPMode::ThreadSafe> DecompressError = MakeShared<FText, ESPMode::ThreadSafe>();
+    TFuture<bool> Decompressor = Async(EAsyncExecution::Thread, [Source, Queue, DecompressError, CancelFlag]() {
+        const bool bDecompressed = Decompress(Source, *Queue, *DecompressError, CancelFlag);
+        Queue->Close();
+        return bDecompressed;
+    });
+
+    bool bConsumed = true;
+    TArray<uint8> Block;
+    while (Queue->Pop(Block)) {
+        if (bConsumed && !(CancelFlag && *CancelFlag)) {
+            bConsumed = OnBlock(Block.GetData(), Block.Num());
+        }
+        else {
+            bConsumed = false;
+        }
+        if (!bConsumed) {
+            Queue->Abort();
+        }
+        Queue->Recycle(MoveTemp(Block));
+    }
+
+    const bool bDecompressed = Decompressor.Get();
+    if (!bDecompressed && bConsumed && !(CancelFlag && *CancelFlag)) {
+        OutError = *DecompressError;
+    }
+    return bDecompressed && bConsumed;
+}
+
+FString CityGMLArchive::GetContentHash(const FCityGMLSource& Source)
+{
+    if (!Source.Error.IsEmpty()) {
+        return FString();
+    }
+    if (!Source.EntryName.IsEmpty()) {
+        return FString::Printf(TEXT("zip:%08x:%lld"), Source.Crc32, Source.UncompressedSize);
+    }
+    const FMD5Hash FileHash = FMD5Hash::HashFile(*Source.FilePath);
+    return FileHash.IsValid() ? LexToString(FileHash) : FString();
+}
+
+#undef LOCTEXT_NAMESPACE
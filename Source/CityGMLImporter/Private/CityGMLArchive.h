@@ -0,0 +1,84 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "HAL/ThreadSafeBool.h"
+
+/** Wie der Inhalt einer Eingabe auf der Festplatte liegt */
+enum class ECityGMLCompression : uint8
+{
+	/** Unkomprimierte .gml oder .xml Datei */
+	None,
+	/** .gml.gz, auch mit mehreren aneinandergehängten gzip-Membern und Auffüllung dahinter */
+	Gzip,
+	/** Eintrag eines Zip-Archivs ohne Kompression */
+	ZipStored,
+	/** Eintrag eines Zip-Archivs mit Deflate */
+	ZipDeflate,
+};
+
+/**
+ * Eine Eingabe des Imports: eine Datei auf der Festplatte oder ein einzelner Eintrag eines Zip-Archivs.
+ * Jede Eingabe wird unabhängig von den anderen gelesen und ist damit eine Einheit für ParallelImport.
+ */
+struct FCityGMLSource
+{
+	/** Pfad der Datei, bei Einträgen der Pfad des Archivs */
+	FString FilePath;
+	/** Name des Eintrags im Zip-Archiv, leer bei einzelnen Dateien */
+	FString EntryName;
+	ECityGMLCompression Compression = ECityGMLCompression::None;
+	/** Nur bei Zip-Einträgen: Position des Local File Headers, Größen und CRC32 aus dem Central Directory */
+	int64 LocalHeaderOffset = 0;
+	int64 CompressedSize = 0;
+	int64 UncompressedSize = 0;
+	uint32 Crc32 = 0;
+	/** Gesetzt, wenn das Archiv nicht gelesen werden konnte, die Eingabe schlägt dann mit diesem Fehler fehl */
+	FText Error;
+
+	/** Pfad für Ausgaben und den Geometrie-Cache, bei Einträgen `Archiv.zip/Eintrag.gml` */
+	FString GetDisplayPath() const { return EntryName.IsEmpty() ? FilePath : FilePath / EntryName; }
+};
+
+/**
+ * Liest CityGML direkt aus .gml.gz-Dateien und Zip-Archiven, ohne sie vorher auf die Festplatte zu entpacken.
+ *
+ * Entpackt wird auf einem eigenen Thread in Blöcke fester Größe, die über eine Warteschlange mit begrenzter
+ * Länge an den lesenden Thread gehen. Das Entpacken läuft so gleichzeitig mit der Verarbeitung der Blöcke,
+ * und pro Eingabe liegen höchstens einige Blöcke im Speicher.
+ */
+namespace CityGMLArchive
+{
+	/** true für Dateien, die als Archiv oder gzip gelesen werden (.zip, .gz) */
+	bool IsCompressed(const FString& FilePath);
+
+	/**
+	 * Löst die ausgewählten Dateien in Eingaben auf. Ein Zip-Archiv wird zu einer Eingabe pro enthaltener
+	 * .gml oder .xml Datei in der Reihenfolge des Archivs, alle anderen Dateien zu genau einer Eingabe.
+	 *
+	 * @param Files Pfade der ausgewählten Dateien
+	 * @param OutSources Die Eingaben in Auswahlreihenfolge
+	 */
+	void ExpandSources(const TArray<FString>& Files, TArray<FCityGMLSource>& OutSources);
+
+	/**
+	 * Liest den entpackten Inhalt einer Eingabe blockweise. Bei komprimierten Eingaben läuft das Entpacken
+	 * auf einem eigenen Thread, OnBlock wird auf dem aufrufenden Thread in Dateireihenfolge aufgerufen.
+	 *
+	 * @param Source Die Eingabe
+	 * @param OnBlock Erhält jeden Block, ein Block ist nur während des Aufrufs gültig. false bricht das Lesen ab
+	 * @param OutError Fehlermeldung, falls die Eingabe nicht gelesen werden konnte
+	 * @param CancelFlag Optional, bricht das Lesen ab, sobald es gesetzt wird
+	 * @return true, wenn die Eingabe vollständig gelesen wurde
+	 */
+	bool ReadSource(const FCityGMLSource& Source, TFunctionRef<bool(const uint8* Data, int32 Size)> OnBlock, FText& OutError, const FThreadSafeBool* CancelFlag = nullptr);
+
+	/**
+	 * Kennung des Inhalts für den Geometrie-Cache. Bei Zip-Einträgen aus CRC32 und Größe des Central Directory,
+	 * sodass das Archiv dafür nicht gelesen werden muss, sonst der MD5-Hash der Datei.
+	 *
+	 * @return Die Kennung, leer wenn die Datei nicht gelesen werden konnte
+	 */
+	FString GetContentHash(const FCityGMLSource& Source);
+}
@@ -0,0 +1,396 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#include "CityGMLAttributeStore.h"
+#include "CityGMLSerialization.h"
+#include "Hash/CityHash.h"
+#include "Serialization/Archive.h"
+
+namespace
+{
+    /** Straße und Hausnummer als ein Schlüssel */
+    FORCEINLINE uint64 MakeAddressKey(int32 Street, int32 Number)
+    {
+        return (uint64(uint32(Street)) << 32) | uint64(uint32(Number));
+    }
+}
+
+constexpr float FCityGMLAttributeStore::NoHeight;
+
+FCityGMLStringPool::FCityGMLStringPool()
+{
+    Reset();
+}
+
+uint32 FCityGMLStringPool::HashText(FStringView Text)
+{
+    return CityHash32((const char*)Text.GetData(), Text.Len() * sizeof(TCHAR));
+}
+
+int32 FCityGMLStringPool::FindSlot(FStringView Text, uint32 Hash) const
+{
+    const int32 Mask = Slots.Num() - 1;
+    for (int32 Slot = int32(Hash & uint32(Mask));; Slot = (Slot + 1) & Mask) {
+        const int32 Index = Slots[Slot];
+        if (Index == INDEX_NONE || Get(Index).Equals(Text, ESearchCase::CaseSensitive)) {
+            return Slot;
+        }
+    }
+}
+
+void FCityGMLStringPool::Rehash(int32 NumSlots)
+{
+    Slots.Init(INDEX_NONE, NumSlots);
+    for (int32 Index = 1; Index < Num(); ++Index) {
+        const FStringView Text = Get(Index);
+        Slots[FindSlot(Text, HashText(Text))] = Index;
+    }
+}
+
+int32 FCityGMLStringPool::Intern(FStringView Text)
+{
+    if (Text.Len() == 0) {
+        return 0;
+    }
+    // Höchstens zur Hälfte belegt, damit die Suche kurz bleibt
+    if (Slots.Num() < (Num() + 1) * 2) {
+        Rehash(FMath::Max(64, Slots.Num() * 2));
+    }
+    const int32 Slot = FindSlot(Text, HashText(Text));
+    if (Slots[Slot] != INDEX_NONE) {
+        return Slots[Slot];
+    }
+    const int32 Index = Num();
+    Chars.Append(Text.GetData(), Text.Len());
+    Starts.Add(Chars.Num());
+    Slots[Slot] = Index;
+    return Index;
+}
+
+int32 FCityGMLStringPool::Find(FStringView Text) const
+{
+    if (Text.Len() == 0) {
+        return 0;
+    }
+    if (Slots.Num() == 0) {
+        return INDEX_NONE;
+    }
+    return Slots[FindSlot(Text, HashText(Text))];
+}
+
+SIZE_T FCityGMLStringPool::GetAllocatedSize() const
+{
+    return Chars.GetAllocatedSize() + Starts.GetAllocatedSize() + Slots.GetAllocatedSize();
+}
+
+void FCityGMLStringPool::Reset()
+{
+    Chars.Empty();
+    Starts.Reset();
+    // Der leere Text
+    Starts.Add(0);
+    Starts.Add(0);
+    Slots.Empty();
+}
+
+void FCityGMLStringPool::Serialize(FArchive& Ar)
+{
+    CityGMLSerialization::SerializeBulk(Ar, Chars);
+    CityGMLSerialization::SerializeBulk(Ar, Starts);
+    if (!Ar.IsLoading()) {
+        return;
+    }
+    bool bValid = !Ar.IsError() && Starts.Num() >= 2 && Starts[0] == 0 && Starts[1] == 0 && Starts.Last() == Chars.Num();
+    for (int32 i = 1; bValid && i < Starts.Num(); ++i) {
+        bValid = Starts[i] >= Starts[i - 1];
+    }
+    if (!bValid) {
+        Ar.SetError();
+        Reset();
+        return;
+    }
+    Rehash(FMath::Max(64, int32(FMath::RoundUpToPowerOfTwo(uint32(Num()) * 2))));
+}
+
+FCityGMLAddress FCityGMLAttributeStore::GetAddress(int32 Building) const
+{
+    FCityGMLAddress Address;
+    Address.Street = FString(Strings.Get(Streets[Building]));
+    Address.Number = FString(Strings.Get(Numbers[Building]));
+    Address.PostalCode = FString(Strings.Get(PostalCodes[Building]));
+    return Address;
+}
+
+void FCityGMLAttributeStore::Add(FStringView Id, const FCityGMLAddress& Address, float MeasuredHeight)
+{
+    if (bIndexed) {
+        ResetIndex();
+    }
+    Ids.Add(Strings.Intern(Id));
+    Streets.Add(Strings.Intern(Address.Street));
+    Numbers.Add(Strings.Intern(Address.Number));
+    PostalCodes.Add(Strings.Intern(Address.PostalCode));
+    SurfaceTypes.Add(0);
+    MeasuredHeights.Add(MeasuredHeight);
+}
+
+void FCityGMLAttributeStore::AddRow(const FCityGMLAttributeStore& Source, int32 Building)
+{
+    if (bIndexed) {
+        ResetIndex();
+    }
+    Ids.Add(Strings.Intern(Source.Strings.Get(Source.Ids[Building])));
+    Streets.Add(Strings.Intern(Source.Strings.Get(Source.Streets[Building])));
+    Numbers.Add(Strings.Intern(Source.Strings.Get(Source.Numbers[Building])));
+    PostalCodes.Add(Strings.Intern(Source.Strings.Get(Source.PostalCodes[Building])));
+    SurfaceTypes.Add(Source.SurfaceTypes[Building]);
+    MeasuredHeights.Add(Source.MeasuredHeights[Building]);
+}
+
+void FCityGMLAttributeStore::Append(FCityGMLAttributeStore&& Other)
+{
+    if (Num() == 0) {
+        // Nichts umzuschlüsseln, der Pool wird einfach übernommen
+        *this = MoveTemp(Other);
+        ResetIndex();
+        Other.Reset();
+        return;
+    }
+    ResetIndex();
+
+    // Jeder Text des anderen Pools wird einmal übernommen, danach werden nur noch Indizes übersetzt
+    TArray<int32> Remap;
+    Remap.SetNumUninitialized(Other.Strings.Num());
+    for (int32 Index = 0; Index < Other.Strings.Num(); ++Index) {
+        Remap[Index] = Strings.Intern(Other.Strings.Get(Index));
+    }
+    auto AppendColumn = [&Remap](TArray<int32>& Column, const TArray<int32>& OtherColumn) {
+        Column.Reserve(Column.Num() + OtherColumn.Num());
+        for (const int32 Index : OtherColumn) {
+            Column.Add(Remap[Index]);
+        }
+    };
+    AppendColumn(Ids, Other.Ids);
+    AppendColumn(Streets, Other.Streets);
+    AppendColumn(Numbers, Other.Numbers);
+    AppendColumn(PostalCodes, Other.PostalCodes);
+    SurfaceTypes.Append(MoveTemp(Other.SurfaceTypes));
+    MeasuredHeights.Append(MoveTemp(Other.MeasuredHeights));
+    Other.Reset();
+}
+
+void FCityGMLAttributeStore::BuildIndex(TArray<FBox>&& InBounds)
+{
+    check(InBounds.Num() == Num());
+    ResetIndex();
+    Bounds = MoveTemp(InBounds);
+
+    IdIndex.Reserve(Num());
+    AddressIndex.Reserve(Num());
+    StreetIndex.Reserve(Num());
+    for (int32 Building = 0; Building < Num(); ++Building) {
+        if (Ids[Building] != 0) {
+            IdIndex.Add(Ids[Building], Building);
+        }
+        if (Streets[Building] != 0) {
+            AddressIndex.Add(MakeAddressKey(Streets[Building], Numbers[Building]), Building);
+            StreetIndex.Add(Streets[Building], Building);
+        }
+    }
+
+    FBox2D Extent(ForceInit);
+    for (const FBox& Box : Bounds) {
+        if (Box.IsValid) {
+            Extent += FBox2D(FVector2D(Box.Min), FVector2D(Box.Max));
+        }
+    }
+    bIndexed = true;
+    if (!Extent.bIsValid) {
+        return;
+    }
+
+    // Im Mittel etwa vier Gebäude pro Zelle, bei sehr schmalen Gebieten höchstens 1024 Zellen pro Achse
+    const FVector2D Size = Extent.GetSize();
+    CellSize = FMath::Max3(FMath::Sqrt(Size.X * Size.Y * 4.0f / Num()), FMath::Max(Size.X, Size.Y) / 1024.0f, 1.0f);
+    GridOrigin = Extent.Min;
+    GridSize = FIntPoint(FMath::FloorToInt(Size.X / CellSize) + 1, FMath::FloorToInt(Size.Y / CellSize) + 1);
+
+    // Zwei Durchläufe: Gebäude pro Zelle zählen, dann einsortieren
+    CellStart.SetNumZeroed(GridSize.X * GridSize.Y + 1);
+    for (const FBox& Box : Bounds) {
+        if (!Box.IsValid) {
+            continue;
+        }
+        const FIntPoint MinCell = GetCell(FVector2D(Box.Min));
+        const FIntPoint MaxCell = GetCell(FVector2D(Box.Max));
+        for (int32 Y = MinCell.Y; Y <= MaxCell.Y; ++Y) {
+            for (int32 X = MinCell.X; X <= MaxCell.X; ++X) {
+                CellStart[X + Y * GridSize.X + 1]++;
+            }
+        }
+    }
+    for (int32 Cell = 1; Cell < CellStart.Num(); ++Cell) {
+        CellStart[Cell] += CellStart[Cell - 1];
+    }
+    CellBuildings.SetNumUninitialized(CellStart.Last());
+    TArray<int32> Cursor(CellStart.GetData(), CellStart.Num() - 1);
+    for (int32 Building = 0; Building < Bounds.Num(); ++Building) {
+        const FBox& Box = Bounds[Building];
+        if (!Box.IsValid) {
+            continue;
+        }
+        const FIntPoint MinCell = GetCell(FVector2D(Box.Min));
+        const FIntPoint MaxCell = GetCell(FVector2D(Box.Max));
+        for (int32 Y = MinCell.Y; Y <= MaxCell.Y; ++Y) {
+            for (int32 X = MinCell.X; X <= MaxCell.X; ++X) {
+                CellBuildings[Cursor[X + Y * GridSize.X]++] = Building;
+            }
+        }
+    }
+}
+
+FIntPoint FCityGMLAttributeStore::GetCell(const FVector2D& Point) const
+{
+    return FIntPoint(
+        FMath::Clamp(FMath::FloorToInt((Point.X - GridOrigin.X) / CellSize), 0, GridSize.X - 1),
+        FMath::Clamp(FMath::FloorToInt((Point.Y - GridOrigin.Y) / CellSize), 0, GridSize.Y - 1));
+}
+
+int32 FCityGMLAttributeStore::FindById(FStringView Id) const
+{
+    const int32 Text = Strings.Find(Id);
+    if (Text <= 0) {
+        return INDEX_NONE;
+    }
+    if (!bIndexed) {
+        return Ids.IndexOfByKey(Text);
+    }
+    // Doppelte IDs sind möglich, gemeldet wird das erste Gebäude
+    int32 First = INDEX_NONE;
+    for (TMultiMap<int32, int32>::TConstKeyIterator It = IdIndex.CreateConstKeyIterator(Text); It; ++It) {
+        First = First == INDEX_NONE ? It.Value() : FMath::Min(First, It.Value());
+    }
+    return First;
+}
+
+void FCityGMLAttributeStore::FindByAddress(FStringView Street, FStringView Number, TArray<int32>& OutBuildings) const
+{
+    OutBuildings.Reset();
+    const int32 StreetText = Strings.Find(Street);
+    const int32 NumberText = Strings.Find(Number);
+    if (StreetText <= 0 || NumberText == INDEX_NONE) {
+        return;
+    }
+    const bool bAnyNumber = Number.Len() == 0;
+    if (!bIndexed) {
+        for (int32 Building = 0; Building < Num(); ++Building) {
+            if (Streets[Building] == StreetText && (bAnyNumber || Numbers[Building] == NumberText)) {
+                OutBuildings.Add(Building);
+            }
+        }
+        return;
+    }
+    if (bAnyNumber) {
+        StreetIndex.MultiFind(StreetText, OutBuildings);
+    }
+    else {
+        AddressIndex.MultiFind(MakeAddressKey(StreetText, NumberText), OutBuildings);
+    }
+    OutBuildings.Sort();
+}
+
+void FCityGMLAttributeStore::FindInBox(const FBox2D& Box, TArray<int32>& OutBuildings) const
+{
+    OutBuildings.Reset();
+    if (!bIndexed || GridSize.X == 0 || !Box.bIsValid) {
+        return;
+    }
+    const FVector2D GridMax = GridOrigin + FVector2D(GridSize) * CellSize;
+    if (Box.Max.X < GridOrigin.X || Box.Max.Y < GridOrigin.Y || Box.Min.X > GridMax.X || Box.Min.Y > GridMax.Y) {
+        return;
+    }
+
+    const FIntPoint MinCell = GetCell(Box.Min);
+    const FIntPoint MaxCell = GetCell(Box.Max);
+    for (int32 Y = MinCell.Y; Y <= MaxCell.Y; ++Y) {
+        for (int32 X = MinCell.X; X <= MaxCell.X; ++X) {
+            const int32 Cell = X + Y * GridSize.X;
+            for (int32 i = CellStart[Cell]; i < CellStart[Cell + 1]; ++i) {
+                const int32 Building = CellBuildings[i];
+                const FBox& Bound = Bounds[Building];
+                if (Bound.Min.X > Box.Max.X || Bound.Max.X < Box.Min.X || Bound.Min.Y > Box.Max.Y || Bound.Max.Y < Box.Min.Y) {
+                    continue;
+                }
+                // Gebäude über mehreren Zellen werden nur in ihrer ersten Zelle innerhalb des Suchbereichs gemeldet
+                const FIntPoint First = GetCell(FVector2D(Bound.Min));
+                if (FMath::Max(First.X, MinCell.X) == X && FMath::Max(First.Y, MinCell.Y) == Y) {
+                    OutBuildings.Add(Building);
+                }
+            }
+        }
+    }
+    OutBuildings.Sort();
+}
+
+SIZE_T FCityGMLAttributeStore::GetAllocatedSize() const
+{
+    return Strings.GetAllocatedSize() + Ids.GetAllocatedSize() + Streets.GetAllocatedSize() + Numbers.GetAllocatedSize()
+        + PostalCodes.GetAllocatedSize() + SurfaceTypes.GetAllocatedSize() + MeasuredHeights.GetAllocatedSize()
+        + Bounds.GetAllocatedSize() + IdIndex.GetAllocatedSize() + AddressIndex.GetAllocatedSize() + StreetIndex.GetAllocatedSize()
+        + CellStart.GetAllocatedSize() + CellBuildings.GetAllocatedSize();
+}
+
+void FCityGMLAttributeStore::Serialize(FArchive& Ar)
+{
+    Strings.Serialize(Ar);
+    CityGMLSerialization::SerializeBulk(Ar, Ids);
+    CityGMLSerialization::SerializeBulk(Ar, Streets);
+    CityGMLSerialization::SerializeBulk(Ar, Numbers);
+    CityGMLSerialization::SerializeBulk(Ar, PostalCodes);
+    CityGMLSerialization::SerializeBulk(Ar, SurfaceTypes);
+    CityGMLSerialization::SerializeBulk(Ar, MeasuredHeights);
+    if (Ar.IsLoading()) {
+        ResetIndex();
+    }
+}
+
+bool FCityGMLAttributeStore::IsConsistent() const
+{
+    const int32 NumRows = Num();
+    if (Streets.Num() != NumRows || Numbers.Num() != NumRows || PostalCodes.Num() != NumRows || SurfaceTypes.Num() != NumRows || MeasuredHeights.Num() != NumRows) {
+        return false;
+    }
+    for (const TArray<int32>* Column : { &Ids, &Streets, &Numbers, &PostalCodes }) {
+        for (const int32 Index : *Column) {
+            if (Index < 0 || Index >= Strings.Num()) {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+void FCityGMLAttributeStore::ResetIndex()
+{
+    bIndexed = false;
+    Bounds.Empty();
+    IdIndex.Empty();
+    AddressIndex.Empty();
+    StreetIndex.Empty();
+    GridOrigin = FVector2D::ZeroVector;
+    CellSize = 1.0f;
+    GridSize = FIntPoint::ZeroValue;
+    CellStart.Empty();
+    CellBuildings.Empty();
+}
+
+void FCityGMLAttributeStore::Reset()
+{
+    Strings.Reset();
+    Ids.Empty();
+    Streets.Empty();
+    Numbers.Empty();
+    PostalCodes.Empty();
+    SurfaceTypes.Empty();
+    MeasuredHeights.Empty();
+    ResetIndex();
+}
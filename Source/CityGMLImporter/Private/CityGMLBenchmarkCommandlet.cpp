@@ -0,0 +1,153 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#include "CityGMLBenchmarkCommandlet.h"
+#include "CityGMLImporter.h"
+#include "CityGMLSynthetic.h"
+#include "HAL/FileManager.h"
+#include "HAL/PlatformMemory.h"
+#include "Interfaces/IPluginManager.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Paths.h"
+
+namespace
+{
+    /** Durchsatz, 0 wenn keine Zeit gemessen wurde */
+    double PerSecond(double Amount, double Seconds)
+    {
+        return Seconds > 0.0 ? Amount / Seconds : 0.0;
+    }
+}
+
+UCityGMLBenchmarkCommandlet::UCityGMLBenchmarkCommandlet()
+{
+    IsClient = false;
+    IsEditor = true;
+    IsServer = false;
+    LogToConsole = true;
+}
+
+int32 UCityGMLBenchmarkCommandlet::Main(const FString& Params)
+{
+    FCityGMLSyntheticOptions Options;
+    FString LoDParam = TEXT("All");
+    int32 NumFiles = 4;
+    int32 Iterations = 3;
+    FParse::Value(*Params, TEXT("LoD="), LoDParam);
+    FParse::Value(*Params, TEXT("Buildings="), Options.Buildings);
+    FParse::Value(*Params, TEXT("Faces="), Options.FacesPerBuilding);
+    FParse::Value(*Params, TEXT("Vertices="), Options.VerticesPerRing);
+    FParse::Value(*Params, TEXT("Files="), NumFiles);
+    FParse::Value(*Params, TEXT("Iterations="), Iterations);
+    const bool bKeepFiles = FParse::Param(*Params, TEXT("KeepFiles"));
+    NumFiles = FMath::Max(1, NumFiles);
+    Iterations = FMath::Max(1, Iterations);
+
+    const FString WorkDir = FPaths::Combine(FPaths::ProjectSavedDir(), TEXT("CityGMLBenchmark"));
+    FString CsvPath = FPaths::Combine(WorkDir, TEXT("Results.csv"));
+    FParse::Value(*Params, TEXT("Csv="), CsvPath);
+
+    TSharedPtr<IPlugin> Plugin = IPluginManager::Get().FindPlugin(TEXT("CityGMLImporter"));
+    const FString Version = Plugin.IsValid() ? Plugin->GetDescriptor().VersionName : FString();
+
+    TArray<FString> LoDs;
+    if (LoDParam == TEXT("All")) {
+        LoDs = { TEXT("LoD1"), TEXT("LoD2"), TEXT("LoD3") };
+    }
+    else {
+        LoDs.Add(LoDParam);
+    }
+
+    FCityGMLImporterModule& Importer = FModuleManager::LoadModuleChecked<FCityGMLImporterModule>(TEXT("CityGMLImporter"));
+    FString Csv;
+    if (!IFileManager::Get().FileExists(*CsvPath)) {
+        Csv += TEXT("PluginVersion,Date,LoD,Files,Buildings,FacesPerBuilding,VerticesPerRing,MB,WallSeconds,TotalMBps,BuildingsPerSecond,TrianglesPerSecond,ReadMBps,ParseMBps,ParseBuildingsPerSecond,PosListVerticesPerSecond,MakeFaceTrianglesPerSecond,UVVerticesPerSecond,TangentVerticesPerSecond,PeakUsedPhysicalMB,GeometryMB\n");
+    }
+
+    for (const FString& LoD : LoDs) {
+        // Dateien erzeugen, jede Datei bekommt einen eigenen Teil der Gebäude
+        TArray<FString> Files;
+        int64 TotalBytes = 0;
+        const int32 BuildingsPerFile = FMath::DivideAndRoundUp(FMath::Max(1, Options.Buildings), NumFiles);
+        for (int32 i = 0; i < NumFiles; ++i) {
+            FCityGMLSyntheticOptions FileOptions = Options;
+            FileOptions.LoD = LoD;
+            FileOptions.FirstBuilding = i * BuildingsPerFile;
+            FileOptions.Buildings = FMath::Min(BuildingsPerFile, Options.Buildings - FileOptions.FirstBuilding);
+            if (FileOptions.Buildings <= 0) {
+                break;
+            }
+            const FString FilePath = FPaths::Combine(WorkDir, FString::Printf(TEXT("Synthetic_%s_%d.gml"), *LoD, i));
+            if (!CityGMLSynthetic::WriteDocument(FilePath, FileOptions)) {
+                UE_LOG(LogTemp, Error, TEXT("Could not write %s"), *FilePath);
+                return 1;
+            }
+            TotalBytes += IFileManager::Get().FileSize(*FilePath);
+            Files.Add(FilePath);
+        }
+        const double MegaBytes = TotalBytes / (1024.0 * 1024.0);
+
+        // Schnellster Durchlauf zählt, der erste wärmt Dateicache und Allokatoren auf
+        double BestWall = MAX_dbl;
+        FCityGMLFileStats Best;
+        SIZE_T GeometryBytes = 0;
+        for (int32 Iteration = 0; Iteration < Iterations; ++Iteration) {
+            FCityGMLGeometryStore Geometry;
+            TArray<FCityGMLFileStats> FileStats;
+            const double Start = FPlatformTime::Seconds();
+            const int32 Succeeded = Importer.RunHeadlessImport(Files, 1.0f, FVector(565000.0f, 5933000.0f, 0.0f), false, Geometry, &FileStats);
+            const double Wall = FPlatformTime::Seconds() - Start;
+            if (Succeeded != Files.Num()) {
+                UE_LOG(LogTemp, Error, TEXT("CityGMLBenchmark: only %d of %d %s files imported"), Succeeded, Files.Num(), *LoD);
+                return 1;
+            }
+
+            if (Wall < BestWall) {
+                BestWall = Wall;
+                Best = FCityGMLFileStats();
+                for (const FCityGMLFileStats& Stats : FileStats) {
+                    Best.ReadSeconds += Stats.ReadSeconds;
+                    Best.ParseSeconds += Stats.ParseSeconds;
+                    Best.TriangulateSeconds += Stats.TriangulateSeconds;
+                    Best.PhaseTimes += Stats.PhaseTimes;
+                    Best.Buildings += Stats.Buildings;
+                    Best.Faces += Stats.Faces;
+                    Best.Vertices += Stats.Vertices;
+                    Best.WeldedVertices += Stats.WeldedVertices;
+                    Best.Triangles += Stats.Triangles;
+                }
+                GeometryBytes = Geometry.GetAllocatedSize();
+            }
+        }
+
+        const double PeakMB = FPlatformMemory::GetStats().PeakUsedPhysical / (1024.0 * 1024.0);
+        UE_LOG(LogTemp, Display, TEXT("CityGMLBenchmark %s: %d files, %.2f MB, %d buildings, %d faces, %d triangles, best of %d: %.3f s"),
+            *LoD, Files.Num(), MegaBytes, Best.Buildings, Best.Faces, Best.Triangles, Iterations, BestWall);
+        UE_LOG(LogTemp, Display, TEXT("  total      %8.1f MB/s %10.0f buildings/s %12.0f triangles/s"), PerSecond(MegaBytes, BestWall), PerSecond(Best.Buildings, BestWall), PerSecond(Best.Triangles, BestWall));
+        UE_LOG(LogTemp, Display, TEXT("  read       %8.1f MB/s"), PerSecond(MegaBytes, Best.ReadSeconds));
+        UE_LOG(LogTemp, Display, TEXT("  parse      %8.1f MB/s %10.0f buildings/s"), PerSecond(MegaBytes, Best.ParseSeconds), PerSecond(Best.Buildings, Best.ParseSeconds));
+        UE_LOG(LogTemp, Display, TEXT("  posList    %12.0f vertices/s"), PerSecond(Best.Vertices, Best.PhaseTimes.PosListSeconds));
+        UE_LOG(LogTemp, Display, TEXT("  MakeFace   %12.0f triangles/s"), PerSecond(Best.Triangles, Best.PhaseTimes.MakeFaceSeconds));
+        UE_LOG(LogTemp, Display, TEXT("  UVs        %12.0f vertices/s"), PerSecond(Best.Vertices, Best.PhaseTimes.UVSeconds));
+        UE_LOG(LogTemp, Display, TEXT("  tangents   %12.0f vertices/s"), PerSecond(Best.Vertices, Best.PhaseTimes.TangentSeconds));
+        UE_LOG(LogTemp, Display, TEXT("  weld       %12.0f vertices/s, %d vertices removed"), PerSecond(Best.Vertices + Best.WeldedVertices, Best.PhaseTimes.WeldSeconds), Best.WeldedVertices);
+        UE_LOG(LogTemp, Display, TEXT("  peak memory %.1f MB, geometry %.1f MB"), PeakMB, GeometryBytes / (1024.0 * 1024.0));
+
+        Csv += FString::Printf(TEXT("%s,%s,%s,%d,%d,%d,%d,%.3f,%.6f,%.3f,%.1f,%.1f,%.3f,%.3f,%.1f,%.1f,%.1f,%.1f,%.1f,%.1f,%.1f\n"),
+            *Version, *FDateTime::Now().ToIso8601(), *LoD, Files.Num(), Best.Buildings, Options.FacesPerBuilding, Options.VerticesPerRing, MegaBytes, BestWall,
+            PerSecond(MegaBytes, BestWall), PerSecond(Best.Buildings, BestWall), PerSecond(Best.Triangles, BestWall),
+            PerSecond(MegaBytes, Best.ReadSeconds), PerSecond(MegaBytes, Best.ParseSeconds), PerSecond(Best.Buildings, Best.ParseSeconds),
+            PerSecond(Best.Vertices, Best.PhaseTimes.PosListSeconds), PerSecond(Best.Triangles, Best.PhaseTimes.MakeFaceSeconds),
+            PerSecond(Best.Vertices, Best.PhaseTimes.UVSeconds), PerSecond(Best.Vertices, Best.PhaseTimes.TangentSeconds),
+            PeakMB, GeometryBytes / (1024.0 * 1024.0));
+
+        if (!bKeepFiles) {
+            for (const FString& FilePath : Files) {
+                IFileManager::Get().Delete(*FilePath);
+            }
+        }
+    }
+
+    FFileHelper::SaveStringToFile(Csv, *CsvPath, FFileHelper::EEncodingOptions::AutoDetect, &IFileManager::Get(), FILEWRITE_Append);
+    UE_LOG(LogTemp, Display, TEXT("CityGMLBenchmark results appended to %s"), *CsvPath);
+    return 0;
+}
@@ -0,0 +1,28 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Commandlets/Commandlet.h"
+#include "CityGMLBenchmarkCommandlet.generated.h"
+
+/**
+ * Misst den Durchsatz des Imports mit künstlichen CityGML-Dateien aus CityGMLSynthetic, ohne Editor-Oberfläche.
+ *
+ * Aufruf:
+ *   UE4Editor-Cmd <Projekt>.uproject -run=CityGMLBenchmark [-LoD=LoD2|All] [-Buildings=10000] [-Faces=8] [-Vertices=5]
+ *     [-Files=4] [-Iterations=3] [-KeepFiles] [-Csv=<Datei>]
+ *
+ * Pro LoD werden MB/s, Gebäude/s und Dreiecke/s für jede Phase sowie der Spitzenverbrauch an Speicher ausgegeben
+ * und als Zeile an die CSV-Datei angehängt. Die Zeiten der Phasen sind über alle Threads summiert.
+ */
+UCLASS()
+class UCityGMLBenchmarkCommandlet : public UCommandlet
+{
+	GENERATED_BODY()
+
+public:
+	UCityGMLBenchmarkCommandlet();
+
+	virtual int32 Main(const FString& Params) override;
+};
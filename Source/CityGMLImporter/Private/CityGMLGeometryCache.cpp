@@ -0,0 +1,202 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#include "CityGMLGeometryCache.h"
+#include "CityGMLSerialization.h"
+#include "HAL/FileManager.h"
+#include "HAL/IConsoleManager.h"
+#include "HAL/PlatformFilemanager.h"
+#include "Async/MappedFileHandle.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Paths.h"
+#include "Serialization/LargeMemoryReader.h"
+#include "Serialization/MemoryReader.h"
+
+namespace
+{
+    const uint32 CacheMagic = 0x434D4743; // "CGMC"
+    // Muss erhöht werden, sobald sich das Format oder die Triangulierung ändert
+    const uint32 CacheVersion = 5;
+
+    /** Liest oder schreibt einen Eintrag, Key und LoD werden beim Laden mit dem Inhalt der Datei gefüllt */
+    void SerializeEntry(FArchive& Ar, FString& Key, FString& LoD, FCityGMLGeometryStore& Geometry)
+    {
+        uint32 Magic = CacheMagic;
+        uint32 Version = CacheVersion;
+        int32 TangentSize = sizeof(FProcMeshTangent);
+        Ar << Magic << Version << TangentSize;
+        if (Magic != CacheMagic || Version != CacheVersion || TangentSize != int32(sizeof(FProcMeshTangent))) {
+            Ar.SetError();
+            return;
+        }
+        Ar << Key << LoD;
+
+        CityGMLSerialization::SerializeBulk(Ar, Geometry.Positions);
+        CityGMLSerialization::SerializeBulk(Ar, Geometry.Normals);
+        CityGMLSerialization::SerializeBulk(Ar, Geometry.UVs);
+        CityGMLSerialization::SerializeBulk(Ar, Geometry.Tangents);
+        CityGMLSerialization::SerializeBulk(Ar, Geometry.Indices);
+        CityGMLSerialization::SerializeBulk(Ar, Geometry.FaceVertexStart);
+        CityGMLSerialization::SerializeBulk(Ar, Geometry.FaceIndexStart);
+        CityGMLSerialization::SerializeBulk(Ar, Geometry.FaceSurfaceType);
+        CityGMLSerialization::SerializeBulk(Ar, Geometry.BuildingFaceStart);
+        Geometry.Attributes.Serialize(Ar);
+    }
+
+    /** true, wenn die Anfänge nicht abnehmen und alle zwischen 0 und End liegen */
+    bool IsStartTable(const TArray<int32>& Starts, int32 End)
+    {
+        int32 Previous = 0;
+        for (const int32 Start : Starts) {
+            if (Start < Previous || Start > End) {
+                return false;
+            }
+            Previous = Start;
+        }
+        return true;
+    }
+
+    /** Prüft, ob die geladenen Puffer zueinander passen, damit die Zugriffe über Flächen und Gebäude im Bereich bleiben */
+    bool IsConsistent(const FCityGMLGeometryStore& Geometry)
+    {
+        const int32 NumVertices = Geometry.NumVertices();
+        if (Geometry.Normals.Num() != NumVertices || Geometry.UVs.Num() != NumVertices || Geometry.Tangents.Num() != NumVertices) {
+            return false;
+        }
+        if (Geometry.FaceVertexStart.Num() != Geometry.FaceIndexStart.Num() || Geometry.FaceSurfaceType.Num() != Geometry.NumFaces() || Geometry.Indices.Num() % 3 != 0) {
+            return false;
+        }
+        if (Geometry.Attributes.Num() != Geometry.NumBuildings() || !Geometry.Attributes.IsConsistent()) {
+            return false;
+        }
+        if (!IsStartTable(Geometry.FaceVertexStart, NumVertices) || !IsStartTable(Geometry.FaceIndexStart, Geometry.Indices.Num())
+            || !IsStartTable(Geometry.BuildingFaceStart, Geometry.NumFaces())) {
+            return false;
+        }
+        for (const ECityGMLSurfaceType SurfaceType : Geometry.FaceSurfaceType) {
+            if (uint32(SurfaceType) >= uint32(ECityGMLSurfaceType::Num)) {
+                return false;
+            }
+        }
+        for (int32 Index : Geometry.Indices) {
+            if (Index < 0 || Index >= NumVertices) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    FString GetCachePath(const FString& FilePath)
+    {
+        // Ein Eintrag pro Quelldatei, der Pfad steckt im Namen, damit gleichnamige Dateien sich nicht überschreiben
+        const FString FullPath = FPaths::ConvertRelativePathToFull(FilePath);
+        const uint32 PathHash = FCrc::StrCrc32(*FullPath.ToLower());
+        return FPaths::Combine(CityGMLGeometryCache::GetCacheDir(), FString::Printf(TEXT("%s_%08x.cgmcache"), *FPaths::GetBaseFilename(FilePath), PathHash));
+    }
+
+    void ClearGeometryCache()
+    {
+        const FString CacheDir = CityGMLGeometryCache::GetCacheDir();
+        if (IFileManager::Get().DeleteDirectory(*CacheDir, false, true)) {
+            UE_LOG(LogTemp, Log, TEXT("Deleted CityGML geometry cache %s"), *CacheDir);
+        }
+    }
+
+    FAutoConsoleCommand ClearGeometryCacheCommand(
+        TEXT("CityGML.ClearGeometryCache"),
+        TEXT("Deletes all cached CityGML geometry under Saved/CityGMLCache"),
+        FConsoleCommandDelegate::CreateStatic(&ClearGeometryCache)
+    );
+}
+
+FString CityGMLGeometryCache::GetCacheDir()
+{
+    return FPaths::Combine(FPaths::ProjectSavedDir(), TEXT("CityGMLCache"));
+}
+
+FString CityGMLGeometryCache::MakeKey(const FCityGMLSource& Source, float Scale, const FVector& Offset, float WeldTolerance, float WeldCreaseAngle, const FString& Region)
+{
+    const FString ContentHash = CityGMLArchive::GetContentHash(Source);
+    if (ContentHash.IsEmpty()) {
+        return FString();
+    }
+    if (WeldTolerance <= 0.0f) {
+        WeldCreaseAngle = 0.0f;
+    }
+    return FString::Printf(TEXT("%s|%.9g|%.17g|%.17g|%.17g|%.9g|%.9g|%s"), *ContentHash, Scale, Offset.X, Offset.Y, Offset.Z, WeldTolerance, WeldCreaseAngle, *Region);
+}
+
+bool CityGMLGeometryCache::Load(const FString& FilePath, const FString& Key, FCityGMLGeometryStore& OutGeometry, FString& OutLoD)
+{
+    if (Key.IsEmpty()) {
+        return false;
+    }
+    return LoadFromFile(GetCachePath(FilePath), Key, OutGeometry, OutLoD);
+}
+
+bool CityGMLGeometryCache::LoadFromFile(const FString& InputPath, const FString& Key, FCityGMLGeometryStore& OutGeometry, FString& OutLoD)
+{
+    if (!IFileManager::Get().FileExists(*InputPath)) {
+        return false;
+    }
+
+    FString StoredKey;
+    bool bLoaded = false;
+
+    // Bevorzugt gemappt lesen, die Puffer werden dann direkt aus dem Seitencache kopiert
+    TUniquePtr<IMappedFileHandle> MappedFile(FPlatformFileManager::Get().GetPlatformFile().OpenMapped(*InputPath));
+    if (MappedFile) {
+        TUniquePtr<IMappedFileRegion> Region(MappedFile->MapRegion(0, MappedFile->GetFileSize()));
+        if (Region) {
+            FLargeMemoryReader Ar(Region->GetMappedPtr(), Region->GetMappedSize());
+            SerializeEntry(Ar, StoredKey, OutLoD, OutGeometry);
+            bLoaded = !Ar.IsError();
+        }
+    }
+    else {
+        TArray<uint8> Bytes;
+        if (FFileHelper::LoadFileToArray(Bytes, *InputPath, FILEREAD_Silent)) {
+            FMemoryReader Ar(Bytes);
+            SerializeEntry(Ar, StoredKey, OutLoD, OutGeometry);
+            bLoaded = !Ar.IsError();
+        }
+    }
+
+    if (!bLoaded || StoredKey != Key || !IsConsistent(OutGeometry)) {
+        // Veraltet oder beschädigt, wird beim nächsten Import neu geschrieben
+        OutGeometry.Reset();
+        OutLoD.Reset();
+        return false;
+    }
+    return true;
+}
+
+bool CityGMLGeometryCache::Save(const FString& FilePath, const FString& Key, const FCityGMLGeometryStore& Geometry, const FString& LoD)
+{
+    if (Key.IsEmpty()) {
+        return false;
+    }
+    return SaveToFile(GetCachePath(FilePath), Key, Geometry, LoD);
+}
+
+bool CityGMLGeometryCache::SaveToFile(const FString& OutputPath, const FString& Key, const FCityGMLGeometryStore& Geometry, const FString& LoD)
+{
+    const FString TempPath = OutputPath + TEXT(".tmp");
+
+    // Erst in eine temporäre Datei schreiben, damit ein abgebrochener Import keinen halben Eintrag hinterlässt
+    TUniquePtr<FArchive> Ar(IFileManager::Get().CreateFileWriter(*TempPath));
+    if (!Ar) {
+        return false;
+    }
+    FString WrittenKey = Key;
+    FString WrittenLoD = LoD;
+    SerializeEntry(*Ar, WrittenKey, WrittenLoD, const_cast<FCityGMLGeometryStore&>(Geometry));
+    const bool bWritten = Ar->Close() && !Ar->IsError();
+    Ar.Reset();
+
+    if (!bWritten || !IFileManager::Get().Move(*OutputPath, *TempPath, true, true)) {
+        IFileManager::Get().Delete(*TempPath, false, false, true);
+        UE_LOG(LogTemp, Warning, TEXT("Could not write CityGML geometry %s"), *OutputPath);
+        return false;
+    }
+    return true;
+}
@@ -0,0 +1,81 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "CityGMLGeometryStore.h"
+#include "CityGMLArchive.h"
+
+/**
+ * Binärer Zwischenspeicher für die triangulierte Geometrie einer CityGML-Datei unter Saved/CityGMLCache.
+ *
+ * Pro Quelldatei gibt es genau eine Cache-Datei. Der Schlüssel besteht aus dem Hash des Dateiinhalts
+ * und allen Einstellungen, die das Ergebnis verändern (Skalierung, Offset, Verschweißen, Auswahlbereich). Das LoD ergibt sich aus
+ * dem Inhalt und wird mit abgelegt. Passt der Schlüssel nicht mehr, gilt der Eintrag als veraltet
+ * und wird beim nächsten erfolgreichen Import überschrieben.
+ * Beim Laden wird die Datei in den Speicher gemappt und die Puffer werden blockweise übernommen,
+ * sodass weder geparst noch trianguliert werden muss.
+ */
+namespace CityGMLGeometryCache
+{
+	/** Verzeichnis, in dem alle Cache-Dateien liegen */
+	FString GetCacheDir();
+
+	/**
+	 * Berechnet den Schlüssel für eine Quelldatei. Bei Einträgen eines Zip-Archivs
+	 * wird statt des Dateiinhalts die Prüfsumme des Eintrags aus dem Archiv verwendet.
+	 *
+	 * @param Source Die CityGML Datei oder der Eintrag eines Zip-Archivs
+	 * @param Scale Die verwendete Skalierung
+	 * @param Offset Der Offset, der bei Dateien mit gml:Envelope abgezogen wird
+	 * @param WeldTolerance Toleranz beim Verschweißen der Vertices, 0 wenn nicht verschweißt wird
+	 * @param WeldCreaseAngle Grenzwinkel beim Verschweißen der Vertices
+	 * @param Region Auswahlbereich des Imports, leer wenn alle Gebäude gelesen werden
+	 * @return Der Schlüssel, leer wenn die Datei nicht gelesen werden konnte
+	 */
+	FString MakeKey(const FCityGMLSource& Source, float Scale, const FVector& Offset, float WeldTolerance, float WeldCreaseAngle, const FString& Region);
+
+	/**
+	 * Lädt die Geometrie einer Quelldatei aus dem Cache.
+	 *
+	 * @param FilePath Pfad zur CityGML Datei
+	 * @param Key Schlüssel aus MakeKey
+	 * @param OutGeometry Die gespeicherte Geometrie
+	 * @param OutLoD Das LoD der Quelldatei
+	 * @return false, wenn kein gültiger Eintrag zum Schlüssel vorliegt
+	 */
+	bool Load(const FString& FilePath, const FString& Key, FCityGMLGeometryStore& OutGeometry, FString& OutLoD);
+
+	/**
+	 * Lädt eine Geometrie im Format des Caches von einem beliebigen Pfad, Gegenstück zu SaveToFile.
+	 *
+	 * @param InputPath Pfad der Datei
+	 * @param Key Schlüssel, mit dem die Datei geschrieben wurde
+	 * @param OutGeometry Die gespeicherte Geometrie
+	 * @param OutLoD Das gespeicherte LoD
+	 * @return false, wenn die Datei fehlt, beschädigt ist oder einen anderen Schlüssel enthält
+	 */
+	bool LoadFromFile(const FString& InputPath, const FString& Key, FCityGMLGeometryStore& OutGeometry, FString& OutLoD);
+
+	/**
+	 * Schreibt die Geometrie einer Quelldatei in den Cache und ersetzt einen vorhandenen Eintrag.
+	 *
+	 * @param FilePath Pfad zur CityGML Datei
+	 * @param Key Schlüssel aus MakeKey
+	 * @param Geometry Die triangulierte Geometrie der Datei
+	 * @param LoD Das LoD der Quelldatei
+	 * @return true, wenn die Datei geschrieben wurde
+	 */
+	bool Save(const FString& FilePath, const FString& Key, const FCityGMLGeometryStore& Geometry, const FString& LoD);
+
+	/**
+	 * Schreibt eine Geometrie im Format des Caches an einen beliebigen Pfad, z.B. als Ergebnis des Commandlets.
+	 *
+	 * @param OutputPath Zielpfad, die Datei wird ersetzt
+	 * @param Key Beliebiger Schlüssel, der mit abgelegt wird
+	 * @param Geometry Die zu schreibende Geometrie
+	 * @param LoD Das LoD der Geometrie
+	 * @return true, wenn die Datei geschrieben wurde
+	 */
+	bool SaveToFile(const FString& OutputPath, const FString& Key, const FCityGMLGeometryStore& Geometry, const FString& LoD);
+}
@@ -0,0 +1,296 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#include "CityGMLGeometryStore.h"
+#include "Async/ParallelFor.h"
+#include "Hash/CityHash.h"
+
+void FCityGMLGeometryStore::AddBuilding(FStringView Id, const FCityGMLAddress& Address, float MeasuredHeight)
+{
+    BuildingFaceStart.Add(NumFaces());
+    Attributes.Add(Id, Address, MeasuredHeight);
+}
+
+void FCityGMLGeometryStore::AddFace(ECityGMLSurfaceType SurfaceType)
+{
+    FaceVertexStart.Add(NumVertices());
+    FaceIndexStart.Add(Indices.Num());
+    FaceSurfaceType.Add(SurfaceType);
+    if (Attributes.SurfaceTypes.Num() > 0) {
+        Attributes.SurfaceTypes.Last() |= uint8(1 << uint8(SurfaceType));
+    }
+}
+
+SIZE_T FCityGMLGeometryStore::GetAllocatedSize() const
+{
+    return Positions.GetAllocatedSize() + Normals.GetAllocatedSize() + UVs.GetAllocatedSize() + Tangents.GetAllocatedSize()
+        + Indices.GetAllocatedSize() + FaceVertexStart.GetAllocatedSize() + FaceIndexStart.GetAllocatedSize() + FaceSurfaceType.GetAllocatedSize()
+        + BuildingFaceStart.GetAllocatedSize() + Attributes.GetAllocatedSize();
+}
+
+void FCityGMLGeometryStore::AppendBuilding(const FCityGMLGeometryStore& Source, int32 Building, const FVector& Translation)
+{
+    BuildingFaceStart.Add(NumFaces());
+    Attributes.AddRow(Source.Attributes, Building);
+
+    // Das Gebäude wird als Ganzes kopiert, verschweißte Flächen zeigen auch auf Vertices anderer Flächen
+    const int32 SourceVertexStart = Source.GetBuildingVertexStart(Building);
+    const int32 SourceVertexEnd = Source.GetBuildingVertexEnd(Building);
+    const int32 SourceIndexStart = Source.GetBuildingIndexStart(Building);
+    const int32 SourceIndexEnd = Source.GetBuildingIndexEnd(Building);
+    const int32 VertexStart = NumVertices();
+    const int32 IndexStart = Indices.Num();
+
+    for (int32 Face = Source.GetFirstFace(Building); Face < Source.GetFaceEnd(Building); ++Face) {
+        FaceVertexStart.Add(Source.FaceVertexStart[Face] - SourceVertexStart + VertexStart);
+        FaceIndexStart.Add(Source.FaceIndexStart[Face] - SourceIndexStart + IndexStart);
+        FaceSurfaceType.Add(Source.FaceSurfaceType[Face]);
+    }
+
+    for (int32 v = SourceVertexStart; v < SourceVertexEnd; ++v) {
+        Positions.Add(Source.Positions[v] + Translation);
+    }
+    const int32 NumBuildingVertices = SourceVertexEnd - SourceVertexStart;
+    Normals.Append(Source.Normals.GetData() + SourceVertexStart, NumBuildingVertices);
+    UVs.Append(Source.UVs.GetData() + SourceVertexStart, NumBuildingVertices);
+    Tangents.Append(Source.Tangents.GetData() + SourceVertexStart, NumBuildingVertices);
+
+    for (int32 i = SourceIndexStart; i < SourceIndexEnd; ++i) {
+        Indices.Add(Source.Indices[i] - SourceVertexStart + VertexStart);
+    }
+}
+
+int32 FCityGMLGeometryStore::WeldVertices(float Tolerance, float CreaseAngle)
+{
+    const int32 OldNumVertices = NumVertices();
+    if (OldNumVertices == 0 || Tolerance <= 0.0f) {
+        return 0;
+    }
+    const float InvTolerance = 1.0f / Tolerance;
+    const float MinDot = FMath::Cos(FMath::DegreesToRadians(CreaseAngle));
+
+    // Alter Vertex -> neuer Vertex, die Arrays werden dabei von vorne nach hinten zusammengeschoben
+    TArray<int32> Remap;
+    Remap.SetNumUninitialized(OldNumVertices);
+    // Erste Normale jedes neuen Vertex, damit sich der Vergleich nicht mit der Mittelung verschiebt
+    TArray<FVector> FirstNormals;
+    FirstNormals.SetNumUninitialized(OldNumVertices);
+    // Gerundete Position -> zuletzt angelegter Vertex, ältere Vertices derselben Zelle über NextInCell
+    TMap<FIntVector, int32> Cells;
+    TArray<int32> NextInCell;
+    NextInCell.SetNumUninitialized(OldNumVertices);
+
+    int32 Write = 0;
+    for (int32 Building = 0; Building < NumBuildings(); ++Building) {
+        const int32 FirstFace = GetFirstFace(Building);
+        const int32 FaceEnd = GetFaceEnd(Building);
+        const int32 BuildingWriteStart = Write;
+        Cells.Reset();
+
+        for (int32 Face = FirstFace; Face < FaceEnd; ++Face) {
+            const int32 ReadStart = FaceVertexStart[Face];
+            const int32 ReadEnd = GetFaceVertexEnd(Face);
+            FaceVertexStart[Face] = Write;
+
+            for (int32 v = ReadStart; v < ReadEnd; ++v) {
+                const FVector& Position = Positions[v];
+                const FIntVector Cell(FMath::RoundToInt(Position.X * InvTolerance), FMath::RoundToInt(Position.Y * InvTolerance), FMath::RoundToInt(Position.Z * InvTolerance));
+                int32* Head = Cells.Find(Cell);
+
+                int32 Match = INDEX_NONE;
+                for (int32 Candidate = Head ? *Head : INDEX_NONE; Candidate != INDEX_NONE; Candidate = NextInCell[Candidate]) {
+                    if (FVector::DotProduct(FirstNormals[Candidate], Normals[v]) >= MinDot) {
+                        Match = Candidate;
+                        break;
+                    }
+                }
+
+                if (Match != INDEX_NONE) {
+                    // Normalen aufsummieren, am Ende des Gebäudes normalisieren
+                    Normals[Match] += Normals[v];
+                    Remap[v] = Match;
+                    continue;
+                }
+
+                // Write <= v, daher kann in denselben Arrays kopiert werden
+                Positions[Write] = Position;
+                Normals[Write] = Normals[v];
+                UVs[Write] = UVs[v];
+                Tangents[Write] = Tangents[v];
+                FirstNormals[Write] = Normals[v];
+                NextInCell[Write] = Head ? *Head : INDEX_NONE;
+                Cells.Add(Cell, Write);
+                Remap[v] = Write;
+                Write++;
+            }
+        }
+
+        for (int32 v = BuildingWriteStart; v < Write; ++v) {
+            Normals[v] = Normals[v].GetSafeNormal();
+        }
+    }
+
+    // Indizes umschreiben und Dreiecke ohne Fläche entfernen
+    int32 IndexWrite = 0;
+    for (int32 Face = 0; Face < NumFaces(); ++Face) {
+        const int32 ReadStart = FaceIndexStart[Face];
+        const int32 ReadEnd = GetFaceIndexEnd(Face);
+        FaceIndexStart[Face] = IndexWrite;
+        for (int32 i = ReadStart; i + 2 < ReadEnd; i += 3) {
+            const int32 A = Remap[Indices[i]];
+            const int32 B = Remap[Indices[i + 1]];
+            const int32 C = Remap[Indices[i + 2]];
+            if (A == B || B == C || A == C) {
+                continue;
+            }
+            Indices[IndexWrite++] = A;
+            Indices[IndexWrite++] = B;
+            Indices[IndexWrite++] = C;
+        }
+    }
+
+    Positions.SetNum(Write);
+    Normals.SetNum(Write);
+    UVs.SetNum(Write);
+    Tangents.SetNum(Write);
+    Indices.SetNum(IndexWrite);
+    return OldNumVertices - Write;
+}
+
+FVector FCityGMLGeometryStore::GetBuildingCentroid(int32 Building) const
+{
+    const int32 FirstFace = GetFirstFace(Building);
+    const int32 FaceEnd = GetFaceEnd(Building);
+    if (FirstFace >= FaceEnd) {
+        return FVector::ZeroVector;
+    }
+    const int32 VertexStart = FaceVertexStart[FirstFace];
+    const int32 VertexEnd = GetFaceVertexEnd(FaceEnd - 1);
+    if (VertexStart >= VertexEnd) {
+        return FVector::ZeroVector;
+    }
+
+    FVector Sum = FVector::ZeroVector;
+    for (int32 v = VertexStart; v < VertexEnd; ++v) {
+        Sum += Positions[v];
+    }
+    Sum /= float(VertexEnd - VertexStart);
+    Sum.Z = 0.0f;
+    return Sum;
+}
+
+uint64 FCityGMLGeometryStore::GetBuildingHash(int32 Building) const
+{
+    const int32 VertexStart = GetBuildingVertexStart(Building);
+    const int32 NumBuildingVertices = GetBuildingVertexEnd(Building) - VertexStart;
+    const int32 IndexStart = GetBuildingIndexStart(Building);
+    const int32 IndexEnd = GetBuildingIndexEnd(Building);
+
+    // Vertex-Attribute direkt als Bytes, die Tangenten folgen aus Positionen und UVs
+    uint64 Hash = CityHash64WithSeed((const char*)(Positions.GetData() + VertexStart), NumBuildingVertices * sizeof(FVector), NumBuildingVertices);
+    Hash = CityHash64WithSeed((const char*)(Normals.GetData() + VertexStart), NumBuildingVertices * sizeof(FVector), Hash);
+    Hash = CityHash64WithSeed((const char*)(UVs.GetData() + VertexStart), NumBuildingVertices * sizeof(FVector2D), Hash);
+
+    // Start-Tabellen und Indizes relativ zum Gebäude
+    TArray<int32> Topology;
+    Topology.Reserve((GetFaceEnd(Building) - GetFirstFace(Building)) * 3 + IndexEnd - IndexStart);
+    for (int32 Face = GetFirstFace(Building); Face < GetFaceEnd(Building); ++Face) {
+        Topology.Add(FaceVertexStart[Face] - VertexStart);
+        Topology.Add(FaceIndexStart[Face] - IndexStart);
+        Topology.Add((int32)FaceSurfaceType[Face]);
+    }
+    for (int32 i = IndexStart; i < IndexEnd; ++i) {
+        Topology.Add(Indices[i] - VertexStart);
+    }
+    Hash = CityHash64WithSeed((const char*)Topology.GetData(), Topology.Num() * sizeof(int32), Hash);
+
+    const int32 Texts[] = { Attributes.Ids[Building], Attributes.Streets[Building], Attributes.Numbers[Building], Attributes.PostalCodes[Building] };
+    for (const int32 Text : Texts) {
+        // Die Länge trennt die Texte, "ab","c" und "a","bc" ergeben verschiedene Hashes
+        const FStringView Line = Attributes.Strings.Get(Text);
+        Hash = CityHash64WithSeed((const char*)Line.GetData(), Line.Len() * sizeof(TCHAR), Hash + Line.Len());
+    }
+    const float MeasuredHeight = Attributes.MeasuredHeights[Building];
+    Hash = CityHash64WithSeed((const char*)&MeasuredHeight, sizeof(MeasuredHeight), Hash);
+    return Hash;
+}
+
+void FCityGMLGeometryStore::Append(FCityGMLGeometryStore&& Other)
+{
+    if (NumBuildings() == 0 && NumVertices() == 0) {
+        // Nichts zu verschieben, die Arrays werden einfach übernommen
+        *this = MoveTemp(Other);
+        Other.Reset();
+        return;
+    }
+
+    const int32 VertexBase = NumVertices();
+    const int32 IndexBase = Indices.Num();
+    const int32 FaceBase = NumFaces();
+
+    if (VertexBase > 0) {
+        // Indizes in Blöcken parallel verschieben, große Dateien haben Millionen davon
+        const int32 ChunkSize = 64 * 1024;
+        const int32 NumChunks = FMath::DivideAndRoundUp(Other.Indices.Num(), ChunkSize);
+        ParallelFor(NumChunks, [&Other, VertexBase, ChunkSize](int32 Chunk) {
+            const int32 End = FMath::Min((Chunk + 1) * ChunkSize, Other.Indices.Num());
+            for (int32 i = Chunk * ChunkSize; i < End; ++i) {
+                Other.Indices[i] += VertexBase;
+            }
+        });
+    }
+    for (int32& Start : Other.FaceVertexStart) {
+        Start += VertexBase;
+    }
+    for (int32& Start : Other.FaceIndexStart) {
+        Start += IndexBase;
+    }
+    for (int32& Start : Other.BuildingFaceStart) {
+        Start += FaceBase;
+    }
+
+    Positions.Append(MoveTemp(Other.Positions));
+    Normals.Append(MoveTemp(Other.Normals));
+    UVs.Append(MoveTemp(Other.UVs));
+    Tangents.Append(MoveTemp(Other.Tangents));
+    Indices.Append(MoveTemp(Other.Indices));
+    FaceVertexStart.Append(MoveTemp(Other.FaceVertexStart));
+    FaceIndexStart.Append(MoveTemp(Other.FaceIndexStart));
+    FaceSurfaceType.Append(MoveTemp(Other.FaceSurfaceType));
+    BuildingFaceStart.Append(MoveTemp(Other.BuildingFaceStart));
+    Attributes.Append(MoveTemp(Other.Attributes));
+    Other.Reset();
+}
+
+void FCityGMLGeometryStore::GetBuildingBounds(TArray<FBox>& OutBounds) const
+{
+    const int32 First = OutBounds.Num();
+    OutBounds.AddUninitialized(NumBuildings());
+    ParallelFor(NumBuildings(), [this, &OutBounds, First](int32 Building) {
+        FBox Box(ForceInit);
+        for (int32 v = GetBuildingVertexStart(Building); v < GetBuildingVertexEnd(Building); ++v) {
+            Box += Positions[v];
+        }
+        OutBounds[First + Building] = Box;
+    });
+}
+
+void FCityGMLGeometryStore::BuildAttributeIndex()
+{
+    TArray<FBox> Bounds;
+    GetBuildingBounds(Bounds);
+    Attributes.BuildIndex(MoveTemp(Bounds));
+}
+
+void FCityGMLGeometryStore::Reset()
+{
+    Positions.Empty();
+    Normals.Empty();
+    UVs.Empty();
+    Tangents.Empty();
+    Indices.Empty();
+    FaceVertexStart.Empty();
+    FaceIndexStart.Empty();
+    FaceSurfaceType.Empty();
+    BuildingFaceStart.Empty();
+    Attributes.Reset();
+}
@@ -0,0 +1,115 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#include "CityGMLImportCommandlet.h"
+#include "CityGMLImporter.h"
+#include "CityGMLGeometryCache.h"
+#include "CityGMLReader.h"
+#include "HAL/FileManager.h"
+#include "Misc/Paths.h"
+
+UCityGMLImportCommandlet::UCityGMLImportCommandlet()
+{
+    IsClient = false;
+    IsEditor = true;
+    IsServer = false;
+    LogToConsole = true;
+}
+
+int32 UCityGMLImportCommandlet::Main(const FString& Params)
+{
+    FString InputParam;
+    FString OutputPath;
+    if (!FParse::Value(*Params, TEXT("Input="), InputParam, false) || !FParse::Value(*Params, TEXT("Output="), OutputPath)) {
+        UE_LOG(LogTemp, Error, TEXT("Usage: -run=CityGMLImport -Input=<file or directory>[;...] -Output=<file> [-Scale=1.0] [-Origin=X,Y,Z] [-Shard=0 -NumShards=1] [-Region=<MinX,MinY,MaxX,MaxY>] [-NoCache]"));
+        return 1;
+    }
+
+    float Scale = 1.0f;
+    FParse::Value(*Params, TEXT("Scale="), Scale);
+
+    // Auswahlbereich, die Anführungszeichen erlauben Polygone mit Leerzeichen
+    FString RegionParam;
+    FParse::Value(*Params, TEXT("Region="), RegionParam, false);
+    FCityGMLRegion Region;
+    if (!FCityGMLRegion::Parse(RegionParam, Region)) {
+        UE_LOG(LogTemp, Error, TEXT("Invalid region %s"), *RegionParam);
+        return 1;
+    }
+
+    // Voreinstellung wie im Editor: HafenCity, bei einem Auswahlbereich dessen Mittelpunkt
+    FVector Origin = Region.bIsSet ? Region.GetCenter() : FVector(565000.0f, 5933000.0f, 0.0f);
+    FString OriginParam;
+    if (FParse::Value(*Params, TEXT("Origin="), OriginParam, false)) {
+        TArray<FString> Components;
+        OriginParam.ParseIntoArray(Components, TEXT(","), true);
+        for (int32 i = 0; i < FMath::Min(Components.Num(), 3); ++i) {
+            Origin[i] = FCString::Atof(*Components[i]);
+        }
+    }
+
+    int32 Shard = 0;
+    int32 NumShards = 1;
+    FParse::Value(*Params, TEXT("Shard="), Shard);
+    FParse::Value(*Params, TEXT("NumShards="), NumShards);
+    if (NumShards < 1 || Shard < 0 || Shard >= NumShards) {
+        UE_LOG(LogTemp, Error, TEXT("Invalid shard %d of %d"), Shard, NumShards);
+        return 1;
+    }
+    const bool bUseCache = !FParse::Param(*Params, TEXT("NoCache"));
+
+    // Eingaben auflösen, Ordner rekursiv
+    TArray<FString> AllFiles;
+    TArray<FString> Inputs;
+    InputParam.ParseIntoArray(Inputs, TEXT(";"), true);
+    for (const FString& Input : Inputs) {
+        const FString FullPath = FPaths::ConvertRelativePathToFull(Input);
+        if (IFileManager::Get().DirectoryExists(*FullPath)) {
+            TArray<FString> Found;
+            IFileManager::Get().FindFilesRecursive(Found, *FullPath, TEXT("*.gml"), true, false);
+            IFileManager::Get().FindFilesRecursive(Found, *FullPath, TEXT("*.xml"), true, false, false);
+            IFileManager::Get().FindFilesRecursive(Found, *FullPath, TEXT("*.gz"), true, false, false);
+            IFileManager::Get().FindFilesRecursive(Found, *FullPath, TEXT("*.zip"), true, false, false);
+            AllFiles.Append(Found);
+        }
+        else if (IFileManager::Get().FileExists(*FullPath)) {
+            AllFiles.Add(FullPath);
+        }
+        else {
+            UE_LOG(LogTemp, Warning, TEXT("Input not found: %s"), *Input);
+        }
+    }
+
+    // Sortiert, damit jeder Prozess dieselbe Liste sieht und die Shards sich nicht überschneiden
+    AllFiles.Sort();
+    TArray<FString> Files;
+    for (int32 i = Shard; i < AllFiles.Num(); i += NumShards) {
+        Files.Add(AllFiles[i]);
+    }
+    if (NumShards > 1) {
+        OutputPath = FPaths::Combine(FPaths::GetPath(OutputPath), FString::Printf(TEXT("%s_shard%d.%s"), *FPaths::GetBaseFilename(OutputPath), Shard, *FPaths::GetExtension(OutputPath)));
+    }
+    if (Files.Num() == 0) {
+        UE_LOG(LogTemp, Error, TEXT("No CityGML files for shard %d of %d"), Shard, NumShards);
+        return 1;
+    }
+    UE_LOG(LogTemp, Display, TEXT("CityGMLImport: %d of %d files in shard %d/%d, scale %g, origin %s"), Files.Num(), AllFiles.Num(), Shard, NumShards, Scale, *Origin.ToString());
+
+    const double Start = FPlatformTime::Seconds();
+    FCityGMLImporterModule& Importer = FModuleManager::LoadModuleChecked<FCityGMLImporterModule>(TEXT("CityGMLImporter"));
+    FCityGMLGeometryStore Geometry;
+    const int32 FilesSucceeded = Importer.RunHeadlessImport(Files, Scale, Origin, bUseCache, Geometry, nullptr, RegionParam);
+    if (FilesSucceeded <= 0) {
+        UE_LOG(LogTemp, Error, TEXT("CityGMLImport: no file could be imported"));
+        return 1;
+    }
+
+    const FString Key = FString::Printf(TEXT("Scale=%g Origin=%s Shard=%d/%d Region=%s"), Scale, *Origin.ToString(), Shard, NumShards, *RegionParam);
+    if (!CityGMLGeometryCache::SaveToFile(OutputPath, Key, Geometry, FString())) {
+        UE_LOG(LogTemp, Error, TEXT("CityGMLImport: could not write %s"), *OutputPath);
+        return 1;
+    }
+
+    UE_LOG(LogTemp, Display, TEXT("CityGMLImport: %d/%d files, %d buildings, %d triangles written to %s in %.3f s"),
+        FilesSucceeded, Files.Num(), Geometry.NumBuildings(), Geometry.NumTriangles(), *OutputPath, FPlatformTime::Seconds() - Start);
+    return FilesSucceeded == Files.Num() ? 0 : 1;
+}
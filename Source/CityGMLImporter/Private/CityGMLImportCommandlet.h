@@ -0,0 +1,32 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Commandlets/Commandlet.h"
+#include "CityGMLImportCommandlet.generated.h"
+
+/**
+ * Importiert CityGML-Dateien ohne Editor-Oberfläche, z.B. auf Build-Maschinen.
+ * Das Ergebnis wird im Binärformat des Geometrie-Caches gespeichert.
+ *
+ * Aufruf:
+ *   UE4Editor-Cmd <Projekt>.uproject -run=CityGMLImport -Input=<Datei oder Ordner>[;...] -Output=<Datei>
+ *     [-Scale=1.0] [-Origin=565000,5933000,0] [-Shard=0 -NumShards=1] [-Region=<Bereich>] [-NoCache]
+ *
+ * Ordner werden rekursiv nach .gml, .xml, .gz und .zip Dateien durchsucht, gepackte Dateien und Zip-Archive
+ * werden wie beim Import über das Menü gelesen. Mit -Shard und -NumShards wird die
+ * sortierte Dateiliste auf mehrere Prozesse verteilt, jeder Prozess schreibt seine eigene Ausgabedatei.
+ * -Region nimmt einen Auswahlbereich im Format von ImportRegion, ein Rechteck "MinX,MinY,MaxX,MaxY" oder ein Polygon "X Y, X Y, ..."
+ * in UTM, mit Leerzeichen in Anführungszeichen. Ohne -Origin liegt der Ursprung dann im Mittelpunkt des Bereichs.
+ */
+UCLASS()
+class UCityGMLImportCommandlet : public UCommandlet
+{
+	GENERATED_BODY()
+
+public:
+	UCityGMLImportCommandlet();
+
+	virtual int32 Main(const FString& Params) override;
+};
@@ -8,33 +8,129 @@
 #include "HAL/PlatformFilemanager.h"
 #include "Framework/Application/SlateApplication.h"
 #include "DesktopPlatformModule.h"
-#include "XmlParser/Public/XmlFile.h"
 #include "Engine/World.h"
+#include "Editor.h"
+#include "DrawDebugHelpers.h"
 #include "ProceduralMeshComponent.h"
 #include "Engine/StaticMeshActor.h"
-#include "PolygonHelper.h"
-#include "GeometryData.h"
-#include "GeometryDataHelper.h"
+#include "Engine/StaticMesh.h"
+#include "Components/StaticMeshComponent.h"
+#include "Components/HierarchicalInstancedStaticMeshComponent.h"
+#include "CityGMLReader.h"
+#include "CityGMLTagPaths.h"
+#include "CityGMLArchive.h"
+#include "CityGMLPosList.h"
+#include "CityGMLTiling.h"
+#include "CityGMLTriangulator.h"
+#include "CityGMLVertexKernels.h"
+#include "CityGMLGeometryCache.h"
+#include "CityGMLStaticMesh.h"
+#include "CityGMLInstancing.h"
+#include "CityGMLStats.h"
+#include "Interfaces/IPluginManager.h"
+#include "ProfilingDebugging/ScopedTimers.h"
+#include "Async/Async.h"
+#include "Async/ParallelFor.h"
+#include "Async/TaskGraphInterfaces.h"
+#include "Hash/CityHash.h"
+#include "HAL/Event.h"
+#include "HAL/ThreadSafeCounter.h"
+#include "HAL/PlatformMemory.h"
+#include "Misc/QueuedThreadPool.h"
+#include "Misc/ScopeLock.h"
+#include "Containers/Ticker.h"
+#include "HAL/IConsoleManager.h"
+#include "Framework/Notifications/NotificationManager.h"
+#include "Widgets/Notifications/SNotificationList.h"
 
 
 static const FName CityGMLImporterTabName("CityGMLImporter");
 
 #define LOCTEXT_NAMESPACE "FCityGMLImporterModule"
 
-TArray<TArray<TArray<FVector>>> AllBuildings;
-TArray<TArray<TArray<int32>>> AllTriangles;
-TArray<TArray<FString>> AllAdresses;
-int32 VertexOffset = 0;
-TArray<FVector> Normalen;
-TArray<FVector2D> UVs;
-TArray<FProcMeshTangent> Tangents;
+FCityGMLGeometryStore CityGeometry; // Alle Gebäude aller Dateien
+TArray<FCityGMLTile> CityTiles; // Kacheln bei OneMesh und TiledMesh
+FCityGMLTileSpool CityTileSpool; // Ausgelagerte Kacheln bei MemoryBudgetMB
+TArray<FCityGMLInstanceGroup> CityInstanceGroups; // Gleiche Gebäude bei InstanceIdenticalBuildings
 int32 FilesSuccesful = 0;
 FText Fehlermeldung;
 
 bool OneMesh = true;
+bool TiledMesh = true; // Bei OneMesh ein Mesh pro Kachel statt eines einzigen Meshes
+float TileSize = 500.0f; // Kantenlänge einer Kachel in Metern
+int32 MemoryBudgetMB = 0; // Bei OneMesh und TiledMesh: Obergrenze für die Geometrie im Speicher, größere Kacheln werden ausgelagert. 0 = unbegrenzt
 float Skalierung = 1.0f; // 100 Normalgroeße bei UE 
+bool SectionPerSurfaceType = false; // Pro Gebäude eine Section pro Dach, Wand und Boden statt einer Section
+bool ParallelImport = true; // Dateien auf Worker-Threads verarbeiten
+int32 ImportThreads = 0; // 0 = so viele Threads wie der Thread-Pool hat
+bool ParallelTriangulation = true; // Gebäude einer Datei auf dem Task-Graph triangulieren
+static const int32 BuildingBatchSize = 64; // Gebäude pro Triangulierungs-Task
+float MeshBuildBudgetMs = 10.0f; // Zeit pro Editor-Tick für das Erzeugen der Actors
+bool BakeStaticMeshes = false; // UStaticMesh-Assets statt ProceduralMeshComponents erzeugen
+FString StaticMeshPath = TEXT("/Game/CityGML"); // Content-Ordner für die Assets bei BakeStaticMeshes
+static const int32 StaticMeshBatchSize = 16; // Assets, die gemeinsam gebaut werden
+bool InstanceIdenticalBuildings = true; // Bei BakeStaticMeshes und ohne OneMesh gleiche Gebäude als Instanzen eines Meshes zeichnen
+float InstanceTolerance = 0.01f; // Abstand in Metern, bis zu dem zwei Gebäude als gleich gelten
+bool GenerateMeshLODs = true; // Bei BakeStaticMeshes vereinfachte Render-LODs erzeugen
+TArray<float> LODScreenSizes = { 0.3f, 0.1f }; // Bildschirmgröße, ab der LOD 1, 2, ... verwendet wird
+TArray<float> LODTrianglePercents = { 0.5f, 0.2f }; // Anteil der Dreiecke von LOD 0 für LOD 1, 2, ...
+bool FootprintProxyLOD = true; // Letztes LOD: LoD2/LoD3-Gebäude als hochgezogener Grundriss
+float FootprintProxyScreenSize = 0.03f; // Bildschirmgröße, ab der der Grundriss verwendet wird
+bool ExportStatsCsv = true; // Kennzahlen jedes Imports als CSV unter Saved/CityGMLImporter/Stats ablegen
+bool UseGeometryCache = true; // Triangulierte Geometrie unter Saved/CityGMLCache zwischenspeichern
+bool WeldVertices = true; // Gemeinsame Ecken der Flächen eines Gebäudes nur einmal speichern
+float WeldTolerance = 0.001f; // Abstand in Metern, unter dem zwei Ecken als gleich gelten
+float WeldCreaseAngle = 10.0f; // Größter Winkel zwischen den Normalen in Grad, darüber bleibt die Kante hart
+bool IncrementalImport = false; // Nur Actors neuer und geänderter Gebäude erzeugen, Zuordnung zum letzten Import über die gml:id
+
+// Wird bei Dateien mit gml:Envelope von den UTM-Koordinaten abgezogen
+// Nördlich der Elbe: 548000, 5935000
+// Für die HafenCity:
+FVector CityOrigin = FVector(565000.0f, 5933000.0f, 0.0f);
+
+// Nur Gebäude in diesem Bereich importieren, in UTM-Koordinaten wie CityOrigin. Leer = alle Gebäude
+// Rechteck: "MinX,MinY,MaxX,MaxY", Polygon: "X Y, X Y, X Y, ..."
+FString ImportRegion = TEXT("");
+bool CenterOnRegion = true; // Bei gesetzter ImportRegion deren Mittelpunkt als CityOrigin verwenden
+FCityGMLRegion CityRegion; // Gelesene ImportRegion des laufenden Imports
+float HighlightSeconds = 10.0f; // So lange markiert CityGML.FindBuilding die gefundenen Gebäude
+
+
+namespace
+{
+    void FindBuilding(const TArray<FString>& Args)
+    {
+        FModuleManager::GetModuleChecked<FCityGMLImporterModule>(TEXT("CityGMLImporter")).FindBuildings(Args);
+    }
+
+    FAutoConsoleCommand FindBuildingCommand(
+        TEXT("CityGML.FindBuilding"),
+        TEXT("Finds buildings of the last CityGML import and highlights them. Usage: CityGML.FindBuilding id <gml:id> | address <street> [number] | box <MinX> <MinY> <MaxX> <MaxY> (UTM)"),
+        FConsoleCommandWithArgsDelegate::CreateStatic(&FindBuilding)
+    );
+}
 
 
+/** Kennzahlen einer Datei, bevor ihre Geometrie in den globalen Speicher verschoben wird */
+static FCityGMLFileStats MakeFileStats(const FCityGMLFileGeometry& Result)
+{
+    FCityGMLFileStats Stats;
+    Stats.FilePath = Result.FilePath;
+    Stats.bSucceeded = Result.bSucceeded;
+    Stats.bFromCache = Result.bFromCache;
+    Stats.ReadSeconds = Result.ReadSeconds;
+    Stats.ParseSeconds = Result.ParseSeconds;
+    Stats.TriangulateSeconds = Result.TriangulateSeconds;
+    Stats.PhaseTimes = Result.PhaseTimes;
+    Stats.Buildings = Result.Geometry.NumBuildings();
+    Stats.Faces = Result.Geometry.NumFaces();
+    Stats.Vertices = Result.Geometry.NumVertices();
+    Stats.Triangles = Result.Geometry.NumTriangles();
+    Stats.WeldedVertices = Result.WeldedVertices;
+    Stats.Bytes = Result.Geometry.GetAllocatedSize();
+    return Stats;
+}
+
 void FCityGMLImporterModule::StartupModule()
 {    FLevelEditorModule& LevelEditorModule = FModuleManager::LoadModuleChecked<FLevelEditorModule>("LevelEditor");
 
@@ -45,7 +141,18 @@ void FCityGMLImporterModule::StartupModule()
 }
 
 void FCityGMLImporterModule::ShutdownModule()
-{}
+{
+    if (ActiveImport.IsValid()) {
+        // Hintergrund-Import abbrechen, bevor das Modul entladen wird
+        ActiveImport->bCancelRequested = true;
+        if (ImportTask.IsValid()) {
+            ImportTask.Wait();
+        }
+        FTicker::GetCoreTicker().RemoveTicker(TickerHandle);
+        ActiveImport.Reset();
+    }
+    CityTileSpool.Reset();
+}
 
 void FCityGMLImporterModule::AddMenuExtension(FMenuBuilder& Builder)
 {
@@ -59,6 +166,10 @@ void FCityGMLImporterModule::AddMenuExtension(FMenuBuilder& Builder)
 
 void FCityGMLImporterModule::PluginButtonClicked()
 {
+    if (ActiveImport.IsValid()) {
+        FMessageDialog::Open(EAppMsgType::Ok, LOCTEXT("ImportRunning", "A CityGML import is already running"));
+        return;
+    }
 
     TArray<FString> OutFiles;
     IDesktopPlatform* DesktopPlatform = FDesktopPlatformModule::Get();
@@ -71,7 +182,7 @@ void FCityGMLImporterModule::PluginButtonClicked()
             TEXT("Select CityGML files to import"),
             FPaths::ProjectDir(),
             TEXT(""),
-            TEXT("CityGML Files (*.xml, *.gml)|*.xml;*.gml"),
+            TEXT("CityGML Files (*.xml, *.gml, *.gml.gz, *.zip)|*.xml;*.gml;*.gz;*.zip"),
             EFileDialogFlags::Multiple,
             OutFiles
         );
@@ -79,19 +190,408 @@ void FCityGMLImporterModule::PluginButtonClicked()
 
     if (bBOpened && OutFiles.Num() > 0)
     {
-        AllBuildings.Empty();
-        AllTriangles.Empty();
-        Normalen.Empty();
-        UVs.Empty();
-        VertexOffset = 0;
-        Tangents.Empty();
-        FilesSuccesful = 0;
-        for (const FString& SelectedFile : OutFiles) {
-            ProcessCityGML(SelectedFile);
-        }
-        if(OneMesh) {
-            CreateOneMeshFromPolygon(AllBuildings, AllTriangles);
+        StartImport(OutFiles);
+    }
+    else
+    {
+        FMessageDialog::Open(EAppMsgType::Ok, LOCTEXT("FileNotSelected", "No File selected"));
+    }
+}
+
+void FCityGMLImporterModule::StartImport(const TArray<FString>& Files)
+{
+    if (!FCityGMLRegion::Parse(ImportRegion, CityRegion)) {
+        FMessageDialog::Open(EAppMsgType::Ok, FText::Format(LOCTEXT("InvalidRegion", "Invalid ImportRegion: {0}"), FText::FromString(ImportRegion)));
+        return;
+    }
+    if (CityRegion.bIsSet && CenterOnRegion) {
+        // Der Ausschnitt liegt dann um den Ursprung des Levels
+        CityOrigin = CityRegion.GetCenter();
+    }
+
+    CityGeometry.Reset();
+    CityTiles.Empty();
+    CityInstanceGroups.Empty();
+    FilesSuccesful = 0;
+    Fehlermeldung = FText::GetEmpty();
+    SpawnedActors.Reset();
+    CreatedStaticMeshes.Reset();
+    FileStats.Reset();
+    CurrentBuildings.Reset();
+    CurrentMeshes.Reset();
+    JobKeys.Reset();
+    JobHashes.Reset();
+    PendingJobs.Reset();
+    FacesMeshed = 0;
+    SectionsCreated = 0;
+
+    ActiveImport = MakeShared<FCityGMLImportProgress, ESPMode::ThreadSafe>();
+    ActiveImport->NumFiles = Files.Num();
+    ImportStartSeconds = FPlatformTime::Seconds();
+
+    FNotificationInfo Info(GetProgressText());
+    Info.bFireAndForget = false;
+    Info.bUseThrobber = true;
+    Info.ButtonDetails.Add(FNotificationButtonInfo(
+        LOCTEXT("CancelImport", "Cancel"),
+        LOCTEXT("CancelImport_Tooltip", "Cancel the CityGML import, the level stays unchanged"),
+        FSimpleDelegate::CreateRaw(this, &FCityGMLImporterModule::CancelImport),
+        SNotificationItem::CS_Pending
+    ));
+    ProgressNotification = FSlateNotificationManager::Get().AddNotification(Info);
+    if (ProgressNotification.IsValid()) {
+        ProgressNotification->SetCompletionState(SNotificationItem::CS_Pending);
+    }
+
+    // Lesen, Parsen und Triangulieren laufen auf einem eigenen Thread, der Editor bleibt bedienbar
+    ImportTask = Async(EAsyncExecution::Thread, [this, Files]() {
+        RunImport(Files);
+    });
+    TickerHandle = FTicker::GetCoreTicker().AddTicker(FTickerDelegate::CreateRaw(this, &FCityGMLImporterModule::TickImport));
+}
+
+int32 FCityGMLImporterModule::RunHeadlessImport(const TArray<FString>& Files, float Scale, FVector Origin, bool bUseCache, FCityGMLGeometryStore& OutGeometry, TArray<FCityGMLFileStats>* OutFileStats, const FString& Region)
+{
+    FCityGMLRegion HeadlessRegion;
+    if (ActiveImport.IsValid() || !FCityGMLRegion::Parse(Region, HeadlessRegion)) {
+        return -1;
+    }
+    // Die Einstellungen gelten nur für diesen Aufruf, danach sind wieder die des Editors und sein letzter Import aktiv
+    TGuardValue<FString> RegionGuard(ImportRegion, Region);
+    TGuardValue<FCityGMLRegion> CityRegionGuard(CityRegion, HeadlessRegion);
+    TGuardValue<float> ScaleGuard(Skalierung, Scale);
+    TGuardValue<FVector> OriginGuard(CityOrigin, Origin);
+    TGuardValue<bool> CacheGuard(UseGeometryCache, bUseCache);
+    TGuardValue<int32> FilesGuard(FilesSuccesful, 0);
+    TGuardValue<FText> ErrorGuard(Fehlermeldung, FText::GetEmpty());
+    FCityGMLGeometryStore EditorGeometry = MoveTemp(CityGeometry);
+    CityGeometry.Reset();
+
+    FCityGMLImportProgress Progress;
+    Progress.NumFiles = Files.Num();
+    TArray<FCityGMLFileGeometry> Results = ProcessCityGMLFiles(Files, Progress);
+    if (OutFileStats) {
+        OutFileStats->Reset();
+        for (const FCityGMLFileGeometry& Result : Results) {
+            OutFileStats->Add(MakeFileStats(Result));
+        }
+    }
+    for (FCityGMLFileGeometry& Result : Results) {
+        MergeFileGeometry(Result);
+    }
+
+    // Vor dem Zurücksetzen der Einstellungen festhalten
+    const int32 FilesSucceeded = FilesSuccesful;
+    OutGeometry = MoveTemp(CityGeometry);
+    CityGeometry = MoveTemp(EditorGeometry);
+    return FilesSucceeded;
+}
+
+TArray<int32> FCityGMLImporterModule::FindBuildings(const TArray<FString>& Args)
+{
+    TArray<int32> Found;
+    if (ActiveImport.IsValid() || !CityGeometry.Attributes.IsIndexed()) {
+        UE_LOG(LogTemp, Warning, TEXT("CityGML.FindBuilding: no finished CityGML import"));
+        return Found;
+    }
+    const FCityGMLAttributeStore& Attributes = CityGeometry.Attributes;
+    const FString Mode = Args.Num() > 0 ? Args[0].ToLower() : FString();
+
+    const double QueryStart = FPlatformTime::Seconds();
+    if (Mode == TEXT("id") && Args.Num() == 2) {
+        const int32 Building = Attributes.FindById(Args[1]);
+        if (Building != INDEX_NONE) {
+            Found.Add(Building);
+        }
+    }
+    else if (Mode == TEXT("address") && Args.Num() >= 2) {
+        // Straßennamen können Leerzeichen enthalten, eine abschließende Zahl ist die Hausnummer
+        int32 StreetEnd = Args.Num();
+        if (Args.Num() > 2 && FChar::IsDigit(Args.Last()[0])) {
+            StreetEnd--;
+        }
+        FString Street = Args[1];
+        for (int32 i = 2; i < StreetEnd; ++i) {
+            Street += TEXT(" ") + Args[i];
+        }
+        Attributes.FindByAddress(Street, StreetEnd < Args.Num() ? FStringView(Args.Last()) : FStringView(), Found);
+    }
+    else if (Mode == TEXT("box") && Args.Num() == 5) {
+        // Dieselbe Umrechnung wie ConvertUtmToUnreal: UTM-Osten wird zu Unreal-Y, UTM-Norden zu Unreal-X
+        const FVector Min = ConvertUtmToUnreal(FCString::Atod(*Args[1]), FCString::Atod(*Args[2]), 0.0, CityOrigin);
+        const FVector Max = ConvertUtmToUnreal(FCString::Atod(*Args[3]), FCString::Atod(*Args[4]), 0.0, CityOrigin);
+        FBox2D Box(ForceInit);
+        Box += FVector2D(Min);
+        Box += FVector2D(Max);
+        Attributes.FindInBox(Box, Found);
+    }
+    else {
+        UE_LOG(LogTemp, Warning, TEXT("Usage: CityGML.FindBuilding id <gml:id> | address <street> [number] | box <MinX> <MinY> <MaxX> <MaxY>"));
+        return Found;
+    }
+    const double QuerySeconds = FPlatformTime::Seconds() - QueryStart;
+    UE_LOG(LogTemp, Log, TEXT("CityGML.FindBuilding: %d of %d buildings found in %.1f us"), Found.Num(), Attributes.Num(), QuerySeconds * 1000000.0);
+
+    const int32 MaxLogged = 20;
+    for (int32 i = 0; i < FMath::Min(Found.Num(), MaxLogged); ++i) {
+        const int32 Building = Found[i];
+        const FCityGMLAddress Address = Attributes.GetAddress(Building);
+        const FStringView Id = Attributes.GetId(Building);
+        UE_LOG(LogTemp, Log, TEXT("  %d %.*s: %s %s, %s, height %.1f m"), Building, Id.Len(), Id.GetData(),
+            *Address.Street, *Address.Number, *Address.PostalCode, Attributes.MeasuredHeights[Building]);
+    }
+
+    UWorld* World = GEditor ? GEditor->GetEditorWorldContext().World() : nullptr;
+    if (!World) {
+        return Found;
+    }
+    GEditor->SelectNone(false, true);
+    for (const int32 Building : Found) {
+        const FBox& Bounds = Attributes.GetBounds(Building);
+        if (Bounds.IsValid) {
+            DrawDebugBox(World, Bounds.GetCenter(), Bounds.GetExtent(), FColor::Yellow, false, HighlightSeconds, 0, 2.0f * Skalierung);
+        }
+        // Nur Gebäude mit eigenem Actor können ausgewählt werden, Kacheln und OneMesh enthalten viele Gebäude
+        const FCityGMLImportedMesh* Mesh = ImportedMeshes.Find(FString(Attributes.GetId(Building)));
+        if (Mesh && Mesh->Actor.IsValid()) {
+            GEditor->SelectActor(Mesh->Actor.Get(), true, false);
+        }
+    }
+    GEditor->NoteSelectionChange();
+    return Found;
+}
+
+void FCityGMLImporterModule::RunImport(const TArray<FString>& Files)
+{
+    if (MemoryBudgetMB > 0) {
+        if (OneMesh && TiledMesh && TileSize > 0.0f) {
+            RunBudgetedImport(Files);
+            return;
+        }
+        UE_LOG(LogTemp, Warning, TEXT("MemoryBudgetMB only applies to OneMesh with TiledMesh, importing without a memory budget"));
+    }
+
+    FCityGMLImportProgress& Progress = *ActiveImport;
+    TArray<FCityGMLFileGeometry> Results = ProcessCityGMLFiles(Files, Progress);
+    if (Progress.bCancelRequested) {
+        return;
+    }
+
+    // Kennzahlen festhalten, bevor die Geometrie in den globalen Speicher verschoben wird
+    for (const FCityGMLFileGeometry& Result : Results) {
+        FileStats.Add(MakeFileStats(Result));
+    }
+
+    // Zusammenführen in Auswahlreihenfolge, damit das Ergebnis nicht von der Threadanzahl abhängt
+    {
+        CITYGML_SCOPE_CYCLE_COUNTER(STAT_CityGML_Merge);
+        for (FCityGMLFileGeometry& Result : Results) {
+            MergeFileGeometry(Result);
+        }
+        Results.Empty();
+    }
+    {
+        // gml:id, Adresse und Lage der Gebäude für CityGML.FindBuilding
+        CITYGML_SCOPE_CYCLE_COUNTER(STAT_CityGML_BuildIndex);
+        const double IndexStart = FPlatformTime::Seconds();
+        CityGeometry.BuildAttributeIndex();
+        UE_LOG(LogTemp, Log, TEXT("CityGML attribute index: %d buildings, %d distinct strings, %.1f MB, built in %.3f s"),
+            CityGeometry.NumBuildings(), CityGeometry.Attributes.Strings.Num(), CityGeometry.Attributes.GetAllocatedSize() / (1024.0 * 1024.0), FPlatformTime::Seconds() - IndexStart);
+    }
+    SET_DWORD_STAT(STAT_CityGML_Buildings, CityGeometry.NumBuildings());
+    SET_DWORD_STAT(STAT_CityGML_Faces, CityGeometry.NumFaces());
+    SET_DWORD_STAT(STAT_CityGML_Vertices, CityGeometry.NumVertices());
+    SET_DWORD_STAT(STAT_CityGML_Triangles, CityGeometry.NumTriangles());
+    SET_MEMORY_STAT(STAT_CityGML_GeometryMemory, CityGeometry.GetAllocatedSize());
+
+    if (OneMesh && TiledMesh && TileSize > 0.0f) {
+        // Die Kachelgröße ist in Metern angegeben, die Positionen sind bereits skaliert
+        CityGMLTiling::BuildTiles(CityGeometry, TileSize * Skalierung, CityTiles);
+    }
+    if (!OneMesh && BakeStaticMeshes && InstanceIdenticalBuildings) {
+        CityGMLInstancing::FindIdenticalBuildings(CityGeometry, InstanceTolerance * Skalierung, CityInstanceGroups);
+        LogInstanceStats();
+    }
+    HashMeshJobs();
+}
+
+void FCityGMLImporterModule::RunBudgetedImport(const TArray<FString>& Files)
+{
+    FCityGMLImportProgress& Progress = *ActiveImport;
+    // Die Kachelgröße ist in Metern angegeben, die Positionen sind bereits skaliert
+    CityTileSpool.Begin(TileSize * Skalierung, int64(MemoryBudgetMB) * 1024 * 1024);
+
+    // Jede Datei wird verteilt, sobald sie und alle vorherigen fertig sind, im globalen Speicher bleiben nur die Sachdaten
+    TArray<FBox> Bounds;
+    ProcessCityGMLFiles(Files, Progress, [this, &Bounds](FCityGMLFileGeometry& Result, int64 OutstandingBytes) {
+        CITYGML_SCOPE_CYCLE_COUNTER(STAT_CityGML_Merge);
+        FileStats.Add(MakeFileStats(Result));
+        if (Result.bSucceeded) {
+            CityTileSpool.AddFile(Result.Geometry, OutstandingBytes);
+            Result.Geometry.GetBuildingBounds(Bounds);
+            CityGeometry.Attributes.Append(MoveTemp(Result.Geometry.Attributes));
+            FilesSuccesful++;
+        }
+        else if (!Result.Error.IsEmpty()) {
+            Fehlermeldung = Result.Error;
+        }
+        Result.Geometry.Reset();
+    });
+    if (Progress.bCancelRequested) {
+        return;
+    }
+    CityTileSpool.Finish(CityTiles);
+
+    {
+        CITYGML_SCOPE_CYCLE_COUNTER(STAT_CityGML_BuildIndex);
+        const double IndexStart = FPlatformTime::Seconds();
+        CityGeometry.Attributes.BuildIndex(MoveTemp(Bounds));
+        UE_LOG(LogTemp, Log, TEXT("CityGML attribute index: %d buildings, %d distinct strings, %.1f MB, built in %.3f s"),
+            CityGeometry.Attributes.Num(), CityGeometry.Attributes.Strings.Num(), CityGeometry.Attributes.GetAllocatedSize() / (1024.0 * 1024.0), FPlatformTime::Seconds() - IndexStart);
+    }
+    int32 NumTriangles = 0;
+    for (const FCityGMLTile& Tile : CityTiles) {
+        NumTriangles += Tile.NumTriangles;
+    }
+    SET_DWORD_STAT(STAT_CityGML_Buildings, CityGeometry.Attributes.Num());
+    SET_DWORD_STAT(STAT_CityGML_Triangles, NumTriangles);
+    SET_MEMORY_STAT(STAT_CityGML_GeometryMemory, CityTileSpool.GetPeakBytes());
+    HashMeshJobs();
+}
+
+bool FCityGMLImporterModule::TickImport(float DeltaTime)
+{
+    FCityGMLImportProgress& Progress = *ActiveImport;
+    if (ProgressNotification.IsValid()) {
+        ProgressNotification->SetText(GetProgressText());
+    }
+    if (!ImportTask.IsReady()) {
+        return true;
+    }
+    if (Progress.bCancelRequested) {
+        FinishImport(true);
+        return false;
+    }
+
+    if (!Progress.bBuildingMeshes) {
+        UE_LOG(LogTemp, Log, TEXT("CityGML import: %d files processed in %.3f s"), Progress.NumFiles, FPlatformTime::Seconds() - ImportStartSeconds);
+        Progress.bBuildingMeshes = true;
+        Progress.MeshesBuilt = 0;
+        if (FilesSuccesful > 0) {
+            SelectMeshJobs();
+        }
+        Progress.NumMeshes = PendingJobs.Num();
+        MeshStartSeconds = FPlatformTime::Seconds();
+    }
+
+    // Actors werden in Portionen erzeugt, damit der Editor nicht hängt
+    UWorld* World = GEditor->GetEditorWorldContext().World();
+    const double TickEnd = FPlatformTime::Seconds() + MeshBuildBudgetMs / 1000.0;
+    while (World && Progress.MeshesBuilt < Progress.NumMeshes) {
+        if (BakeStaticMeshes) {
+            // Assets werden in Blöcken gebaut, ein Block wird nicht vom Zeitbudget unterbrochen
+            const int32 NumJobs = FMath::Min(StaticMeshBatchSize, Progress.NumMeshes - Progress.MeshesBuilt);
+            CreateStaticMeshBatch(World, MakeArrayView(PendingJobs.GetData() + Progress.MeshesBuilt, NumJobs));
+            Progress.MeshesBuilt += NumJobs;
         }
+        else {
+            const int32 Job = PendingJobs[Progress.MeshesBuilt];
+            if (AActor* Actor = CreateMeshJob(World, Job)) {
+                SpawnedActors.Add(Actor);
+                FCityGMLImportedMesh& Mesh = CurrentMeshes.Add(JobKeys[Job]);
+                Mesh.Hash = JobHashes[Job];
+                Mesh.Actor = Actor;
+            }
+            Progress.MeshesBuilt++;
+        }
+        if (FPlatformTime::Seconds() >= TickEnd) {
+            break;
+        }
+    }
+
+    if (!World || Progress.MeshesBuilt >= Progress.NumMeshes) {
+        FinishImport(false);
+        return false;
+    }
+    return true;
+}
+
+void FCityGMLImporterModule::CancelImport()
+{
+    if (ActiveImport.IsValid()) {
+        ActiveImport->bCancelRequested = true;
+    }
+}
+
+void FCityGMLImporterModule::FinishImport(bool bCancelled)
+{
+    if (bCancelled) {
+        // Alles wieder entfernen, was dieser Import im Level erzeugt hat
+        for (const TWeakObjectPtr<AActor>& Actor : SpawnedActors) {
+            if (Actor.IsValid()) {
+                Actor->Destroy();
+            }
+        }
+        for (const TWeakObjectPtr<UStaticMesh>& StaticMesh : CreatedStaticMeshes) {
+            if (StaticMesh.IsValid()) {
+                CityGMLStaticMesh::DiscardStaticMesh(StaticMesh.Get());
+            }
+        }
+        CityGeometry.Reset();
+        CityTiles.Empty();
+        CityInstanceGroups.Empty();
+        CurrentBuildings.Reset();
+        CurrentMeshes.Reset();
+        UE_LOG(LogTemp, Log, TEXT("CityGML import cancelled, %d actors and %d static meshes removed"), SpawnedActors.Num(), CreatedStaticMeshes.Num());
+    }
+    else {
+        if (FilesSuccesful > 0) {
+            ApplyMeshUpdates();
+        }
+        if (OneMesh && TiledMesh && TileSize > 0.0f) {
+            LogTileStats();
+        }
+        if (CityTileSpool.IsActive()) {
+            LogMemoryBudget();
+        }
+        if (!OneMesh && FacesMeshed > 0) {
+            // Vorher wurde jede Fläche als eigene Section mit eigenem Draw Call erzeugt
+            UE_LOG(LogTemp, Log, TEXT("CityGML sections: %d faces merged into %d sections, draw calls %d -> %d"), FacesMeshed, SectionsCreated, FacesMeshed, SectionsCreated);
+        }
+        UE_LOG(LogTemp, Log, TEXT("CityGML import: %d actors created in %.3f s, total %.3f s"), SpawnedActors.Num(), FPlatformTime::Seconds() - MeshStartSeconds, FPlatformTime::Seconds() - ImportStartSeconds);
+        if (CreatedStaticMeshes.Num() > 0) {
+            UE_LOG(LogTemp, Log, TEXT("CityGML import: %d static meshes created under %s, save them with the level"), CreatedStaticMeshes.Num(), *StaticMeshPath);
+        }
+        if (ExportStatsCsv) {
+            WriteStatsCsv();
+        }
+    }
+    if (CityTileSpool.IsActive()) {
+        // Die Kacheln wurden beim Erzeugen der Meshes freigegeben, übrig sind nur noch ausgelagerte Teile unveränderter Kacheln
+        CityTileSpool.Reset();
+        CityTiles.Empty();
+    }
+    SpawnedActors.Reset();
+    CreatedStaticMeshes.Reset();
+    JobKeys.Reset();
+    JobHashes.Reset();
+    PendingJobs.Reset();
+    ActiveImport.Reset();
+    ImportTask = TFuture<void>();
+
+    if (ProgressNotification.IsValid()) {
+        if (bCancelled) {
+            ProgressNotification->SetText(LOCTEXT("ImportCancelled", "CityGML import cancelled"));
+        }
+        else {
+            ProgressNotification->SetText(FText::Format(LOCTEXT("ImportFinished", "CityGML import finished: {0} Files loaded."), FilesSuccesful));
+        }
+        ProgressNotification->SetCompletionState(bCancelled || FilesSuccesful == 0 ? SNotificationItem::CS_Fail : SNotificationItem::CS_Success);
+        ProgressNotification->ExpireAndFadeout();
+        ProgressNotification.Reset();
+    }
+
+    if (!bCancelled) {
         if (FilesSuccesful > 0) {
             FText DialogText = FText::Format(
                 LOCTEXT("FilesLoaded", "{0} Files loaded."),
@@ -102,425 +602,936 @@ void FCityGMLImporterModule::PluginButtonClicked()
         else {
             FMessageDialog::Open(EAppMsgType::Ok, Fehlermeldung);
         }
+    }
+}
 
+FText FCityGMLImporterModule::GetProgressText() const
+{
+    if (!ActiveImport.IsValid()) {
+        return FText::GetEmpty();
     }
-    else
-    {
-        FMessageDialog::Open(EAppMsgType::Ok, LOCTEXT("FileNotSelected", "No File selected"));
+    const FCityGMLImportProgress& Progress = *ActiveImport;
+    if (Progress.bCancelRequested) {
+        return LOCTEXT("ProgressCancelling", "Cancelling CityGML import...");
+    }
+    if (Progress.bBuildingMeshes) {
+        return FText::Format(LOCTEXT("ProgressMeshes", "Building meshes: {0} / {1}"), Progress.MeshesBuilt, Progress.NumMeshes);
+    }
+
+    // Dateien werden parallel verarbeitet, angezeigt wird die Phase, die gerade am weitesten zurückliegt
+    FText Phase;
+    if (Progress.FilesRead.GetValue() < Progress.NumFiles) {
+        Phase = LOCTEXT("PhaseRead", "Reading files");
+    }
+    else if (Progress.FilesParsed.GetValue() < Progress.NumFiles) {
+        Phase = LOCTEXT("PhaseParse", "Parsing");
     }
+    else {
+        Phase = LOCTEXT("PhaseTriangulate", "Triangulating");
+    }
+    return FText::Format(LOCTEXT("ProgressFiles", "{0}: {1} / {2} files read, {3} buildings parsed, {4} triangulated"),
+        Phase, Progress.FilesRead.GetValue(), Progress.NumFiles, Progress.BuildingsParsed.GetValue(), Progress.BuildingsTriangulated.GetValue());
 }
 
-void FCityGMLImporterModule::ProcessCityGML(const FString& FilePath) 
+void FCityGMLImporterModule::WriteStatsCsv()
 {
-    // XML-Datei laden
-    FXmlFile XmlFile(FilePath);
-    if (!XmlFile.IsValid())
-    {
-        UE_LOG(LogTemp, Error, TEXT("Failed to load XML file: %s"), *FilePath);
-        Fehlermeldung = FText::Format(LOCTEXT("Loadingfailure", "Failed to load XML file: {0}"), FText::FromString(FilePath));
-        return;
+    TSharedPtr<IPlugin> Plugin = IPluginManager::Get().FindPlugin(TEXT("CityGMLImporter"));
+    const FString Version = Plugin.IsValid() ? Plugin->GetDescriptor().VersionName : FString();
+    const double MeshSeconds = FPlatformTime::Seconds() - MeshStartSeconds;
+    const double TotalSeconds = FPlatformTime::Seconds() - ImportStartSeconds;
+
+    FString Csv = TEXT("PluginVersion,File,Succeeded,FromCache,ReadSeconds,ParseSeconds,TriangulateSeconds,PosListSeconds,MakeFaceSeconds,UVSeconds,TangentSeconds,WeldSeconds,MeshSeconds,TotalSeconds,Buildings,Faces,Vertices,WeldedVertices,Triangles,Bytes\n");
+    FCityGMLFileStats Total;
+    Total.FilePath = TEXT("Total");
+    Total.bSucceeded = FilesSuccesful > 0;
+    for (const FCityGMLFileStats& Stats : FileStats) {
+        // Pro Datei gibt es keine eigene Mesh-Zeit, die Actors werden für alle Dateien gemeinsam erzeugt
+        Csv += FString::Printf(TEXT("%s,\"%s\",%d,%d,%.6f,%.6f,%.6f,%.6f,%.6f,%.6f,%.6f,%.6f,,,%d,%d,%d,%d,%d,%lld\n"),
+            *Version, *FPaths::GetCleanFilename(Stats.FilePath), Stats.bSucceeded, Stats.bFromCache,
+            Stats.ReadSeconds, Stats.ParseSeconds, Stats.TriangulateSeconds,
+            Stats.PhaseTimes.PosListSeconds, Stats.PhaseTimes.MakeFaceSeconds, Stats.PhaseTimes.UVSeconds, Stats.PhaseTimes.TangentSeconds, Stats.PhaseTimes.WeldSeconds,
+            Stats.Buildings, Stats.Faces, Stats.Vertices, Stats.WeldedVertices, Stats.Triangles, Stats.Bytes);
+
+        Total.bFromCache |= Stats.bFromCache;
+        Total.ReadSeconds += Stats.ReadSeconds;
+        Total.ParseSeconds += Stats.ParseSeconds;
+        Total.TriangulateSeconds += Stats.TriangulateSeconds;
+        Total.PhaseTimes += Stats.PhaseTimes;
+        Total.Buildings += Stats.Buildings;
+        Total.Faces += Stats.Faces;
+        Total.Vertices += Stats.Vertices;
+        Total.WeldedVertices += Stats.WeldedVertices;
+        Total.Triangles += Stats.Triangles;
+        Total.Bytes += Stats.Bytes;
+    }
+    Csv += FString::Printf(TEXT("%s,%s,%d,%d,%.6f,%.6f,%.6f,%.6f,%.6f,%.6f,%.6f,%.6f,%.6f,%.6f,%d,%d,%d,%d,%d,%lld\n"),
+        *Version, *Total.FilePath, Total.bSucceeded, Total.bFromCache,
+        Total.ReadSeconds, Total.ParseSeconds, Total.TriangulateSeconds,
+        Total.PhaseTimes.PosListSeconds, Total.PhaseTimes.MakeFaceSeconds, Total.PhaseTimes.UVSeconds, Total.PhaseTimes.TangentSeconds, Total.PhaseTimes.WeldSeconds,
+        MeshSeconds, TotalSeconds, Total.Buildings, Total.Faces, Total.Vertices, Total.WeldedVertices, Total.Triangles, Total.Bytes);
+
+    const FString CsvPath = FPaths::Combine(FPaths::ProjectSavedDir(), TEXT("CityGMLImporter"), TEXT("Stats"), FString::Printf(TEXT("Import_%s.csv"), *FDateTime::Now().ToString()));
+    if (FFileHelper::SaveStringToFile(Csv, *CsvPath)) {
+        UE_LOG(LogTemp, Log, TEXT("CityGML import stats written to %s"), *CsvPath);
+    }
+}
+
+AActor* FCityGMLImporterModule::CreateMeshJob(UWorld* World, int32 Job)
+{
+    CITYGML_SCOPE_CYCLE_COUNTER(STAT_CityGML_CreateMesh);
+    if (OneMesh) {
+        if (TiledMesh && TileSize > 0.0f) {
+            return CreateTileMesh(World, Job);
+        }
+        return CreateOneMeshFromPolygon(World, CityGeometry);
     }
+    return CreateMeshFromPolygon(World, CityGeometry, Job);
+}
 
-    // Überprüfen, ob es sich um eine CityGML-Datei handelt und Rootnode bekommen
-    FXmlNode* RootNode = XmlFile.GetRootNode();
-    int32 BoundedByNumber;
-    FString LoD;
-    if (RootNode) {
-        if (RootNode->GetTag() == TEXT("core:CityModel")) { // LoD 1 oder 2
-            BoundedByNumber = 1;
+void FCityGMLImporterModule::CreateStaticMeshBatch(UWorld* World, TArrayView<const int32> Jobs)
+{
+    CITYGML_SCOPE_CYCLE_COUNTER(STAT_CityGML_CreateMesh);
+    const bool bTiled = OneMesh && TiledMesh && TileSize > 0.0f;
+
+    FCityGMLMeshLODSettings LODSettings;
+    LODSettings.ScreenSizes = LODScreenSizes;
+    LODSettings.TrianglePercents = LODTrianglePercents;
+    LODSettings.bFootprintProxy = FootprintProxyLOD;
+    LODSettings.ProxyScreenSize = FootprintProxyScreenSize;
+    LODSettings.UVScale = Skalierung;
+    const FCityGMLMeshLODSettings* LODs = GenerateMeshLODs ? &LODSettings : nullptr;
+
+    // Erst alle Mesh Descriptions anlegen, dann gemeinsam bauen
+    TArray<UStaticMesh*> StaticMeshes;
+    TArray<FVector> Pivots;
+    TArray<FString> Labels;
+    TArray<const FCityGMLInstanceGroup*> Groups;
+    TArray<int32> MeshJobs;
+    for (const int32 Job : Jobs) {
+        UStaticMesh* StaticMesh = nullptr;
+        FVector Pivot = FVector::ZeroVector;
+        FString Label;
+        const FCityGMLInstanceGroup* Group = nullptr;
+        if (bTiled) {
+            FCityGMLTile& Tile = CityTiles[Job];
+            if (!LoadSpilledTile(Tile)) {
+                continue;
+            }
+            // Die Kachel ist bereits auf ihren Mittelpunkt bezogen
+            Pivot = Tile.Origin;
+            Label = FString::Printf(TEXT("CityGMLTile_%d_%d"), Tile.Cell.X, Tile.Cell.Y);
+            StaticMesh = CityGMLStaticMesh::CreateStaticMesh(Tile.Geometry, 0, Tile.Geometry.NumBuildings(), FVector::ZeroVector, StaticMeshPath, TEXT("SM_") + Label, SectionPerSurfaceType, LODs);
+            if (CityTileSpool.IsActive()) {
+                // Die Mesh Description hat ihre eigene Kopie
+                Tile.Geometry.Reset();
+            }
         }
-        else if (RootNode->GetTag() == TEXT("CityModel")) { // LoD 3
-            BoundedByNumber = 0;
-            LoD = "LoD3";
+        else if (OneMesh) {
+            Label = TEXT("CityGMLMesh");
+            StaticMesh = CityGMLStaticMesh::CreateStaticMesh(CityGeometry, 0, CityGeometry.NumBuildings(), FVector::ZeroVector, StaticMeshPath, TEXT("SM_") + Label, SectionPerSurfaceType, LODs);
         }
         else {
-            UE_LOG(LogTemp, Error, TEXT("The File does not appear to be in CityGML format"));
-            Fehlermeldung = FText::Format(LOCTEXT("NotCityGML", "The File does not appear to be in CityGML format: {0}"), FText::FromString(FilePath));
-
-            return;
+            // Bei Instanzen ist der Job eine Gruppe gleicher Gebäude, das Mesh entsteht aus ihrem Prototyp
+            int32 Building = Job;
+            if (CityInstanceGroups.Num() > 0) {
+                Group = &CityInstanceGroups[Job];
+                Building = Group->Prototype;
+                Pivot = Group->Origins[0];
+            }
+            else {
+                // Pivot im Grundriss-Schwerpunkt, so bleiben die Positionen im Asset klein
+                Pivot = CityGeometry.GetBuildingCentroid(Building);
+            }
+            Label = Building < CityGeometry.Attributes.Num() ? FString(CityGeometry.Attributes.GetId(Building)) : FString::Printf(TEXT("Building_%d"), Building);
+            StaticMesh = CityGMLStaticMesh::CreateStaticMesh(CityGeometry, Building, Building + 1, Pivot, StaticMeshPath, TEXT("SM_") + Label, SectionPerSurfaceType, LODs);
+            FacesMeshed += CityGeometry.GetFaceEnd(Building) - CityGeometry.GetFirstFace(Building);
+        }
+        if (StaticMesh) {
+            StaticMeshes.Add(StaticMesh);
+            Pivots.Add(Pivot);
+            Labels.Add(Label);
+            Groups.Add(Group);
+            MeshJobs.Add(Job);
+            CreatedStaticMeshes.Add(StaticMesh);
         }
-   
-    } else {
-        UE_LOG(LogTemp, Error, TEXT("The file lacks Content: %s"), *FilePath);
-        Fehlermeldung = FText::Format(LOCTEXT("NoContent", "The file lacks Content: {0}"), FText::FromString(FilePath));
-        return;
     }
+    CityGMLStaticMesh::BuildStaticMeshes(StaticMeshes);
 
-    const TArray<FXmlNode*>& CityObjectMembers = RootNode->GetChildrenNodes();
-    FVector OffsetVector = FVector(0.0f, 0.0f, 0.0f);
-    const FXmlNode* BoundaryNode = CityObjectMembers[BoundedByNumber]->FindChildNode(TEXT("gml:Envelope"));
+    for (int32 i = 0; i < StaticMeshes.Num(); ++i) {
+        AActor* Actor = nullptr;
+        if (Groups[i] && Groups[i]->Buildings.Num() > 1) {
+            Actor = SpawnInstancedBuildings(World, StaticMeshes[i], *Groups[i], Labels[i]);
+        }
+        else if (AStaticMeshActor* MeshActor = World->SpawnActor<AStaticMeshActor>(AStaticMeshActor::StaticClass(), FTransform(Pivots[i]))) {
+            MeshActor->GetStaticMeshComponent()->SetStaticMesh(StaticMeshes[i]);
+            MeshActor->SetActorLabel(Labels[i]);
+            SpawnedActors.Add(MeshActor);
+            SectionsCreated += StaticMeshes[i]->GetStaticMaterials().Num();
+            Actor = MeshActor;
+        }
+        if (Actor) {
+            FCityGMLImportedMesh& Mesh = CurrentMeshes.Add(JobKeys[MeshJobs[i]]);
+            Mesh.Hash = JobHashes[MeshJobs[i]];
+            Mesh.Actor = Actor;
+        }
+    }
+}
 
-    if (BoundaryNode) {
-        // Aus dem Boundary Vektor die x und y Koordinaten extrahieren für einen Offset
-        FString lowerCorner = BoundaryNode->GetChildrenNodes()[0]->GetContent();
-        TArray<FString> OffsetArray;
-        lowerCorner.ParseIntoArray(OffsetArray, TEXT(" "), true);
+AActor* FCityGMLImporterModule::SpawnInstancedBuildings(UWorld* World, UStaticMesh* StaticMesh, const FCityGMLInstanceGroup& Group, const FString& Label)
+{
+    // Ein Actor pro Gruppe am Ursprung des Prototyps, die Instanzen sind relativ dazu verschoben
+    AActor* Actor = World->SpawnActor<AActor>(AActor::StaticClass(), FTransform(Group.Origins[0]));
+    if (!Actor) {
+        return nullptr;
+    }
+    UHierarchicalInstancedStaticMeshComponent* Instances = NewObject<UHierarchicalInstancedStaticMeshComponent>(Actor);
+    Actor->SetRootComponent(Instances);
+    Actor->AddInstanceComponent(Instances);
+    Instances->SetWorldLocation(Group.Origins[0]);
+    Instances->SetStaticMesh(StaticMesh);
+    Instances->RegisterComponent();
+
+    TArray<FTransform> Transforms;
+    Transforms.Reserve(Group.Origins.Num());
+    for (const FVector& Origin : Group.Origins) {
+        Transforms.Add(FTransform(Origin - Group.Origins[0]));
+    }
+    Instances->AddInstances(Transforms, false);
 
-        // Die 3Fache Setzung der Werte ist drin, weil ich das so schneller zeigen kann
-        //OffsetVector.X = FCString::Atof(*OffsetArray[0]);
-        //OffsetVector.Y = FCString::Atof(*OffsetArray[1]);
+    Actor->SetActorLabel(FString::Printf(TEXT("%s_x%d"), *Label, Group.Buildings.Num()));
+    SpawnedActors.Add(Actor);
+    SectionsCreated += StaticMesh->GetStaticMaterials().Num();
+    return Actor;
+}
 
-        // Nördlich der Elbe 
-        //OffsetVector.X = 548000.0f;
-        //OffsetVector.Y = 5935000.0f;
+void FCityGMLImporterModule::LogInstanceStats() const
+{
+    const int32 NumBuildings = CityGeometry.NumBuildings();
+    if (CityInstanceGroups.Num() == 0 || NumBuildings == 0) {
+        return;
+    }
+    int32 InstancedGroups = 0;
+    int64 SavedVertices = 0;
+    int64 SavedIndices = 0;
+    for (const FCityGMLInstanceGroup& Group : CityInstanceGroups) {
+        if (Group.Buildings.Num() > 1) {
+            InstancedGroups++;
+            const int32 Copies = Group.Buildings.Num() - 1;
+            SavedVertices += int64(Copies) * (CityGeometry.GetBuildingVertexEnd(Group.Prototype) - CityGeometry.GetBuildingVertexStart(Group.Prototype));
+            SavedIndices += int64(Copies) * (CityGeometry.GetBuildingIndexEnd(Group.Prototype) - CityGeometry.GetBuildingIndexStart(Group.Prototype));
+        }
+    }
+    const int64 BytesPerVertex = sizeof(FVector) + sizeof(FVector) + sizeof(FVector2D) + sizeof(FProcMeshTangent);
+    // Jede Gruppe ist ein Actor, gleiche Gebäude teilen sich Mesh und Draw Call
+    UE_LOG(LogTemp, Log, TEXT("CityGML instancing: %d buildings -> %d unique meshes (%.2f instances per mesh), %d instanced groups, %.1f MB geometry saved"),
+        NumBuildings, CityInstanceGroups.Num(), double(NumBuildings) / CityInstanceGroups.Num(), InstancedGroups,
+        (SavedVertices * BytesPerVertex + SavedIndices * sizeof(int32)) / (1024.0 * 1024.0));
+}
 
-        // Für die HafenCity
-        OffsetVector.X = 565000.0f;
-        OffsetVector.Y = 5933000.0f;
+void FCityGMLImporterModule::HashMeshJobs()
+{
+    const int32 NumBuildings = CityGeometry.Attributes.Num();
+    TArray<uint64> BuildingHashes;
+    if (CityTileSpool.IsActive()) {
+        // Die Geometrie liegt nur noch in den Kacheln, die Hashes wurden beim Verteilen der Dateien gebildet
+        BuildingHashes = CityTileSpool.GetBuildingHashes();
+    }
+    else {
+        BuildingHashes.SetNumUninitialized(NumBuildings);
+        ParallelFor(NumBuildings, [&BuildingHashes](int32 Building) {
+            BuildingHashes[Building] = CityGeometry.GetBuildingHash(Building);
+        });
     }
 
-    const FXmlNode* NameNode = CityObjectMembers[0];
-    if (NameNode) {
-        if (LoD.IsEmpty()) {
-            LoD = NameNode->GetContent().Left(4);
-        }
-        if (LoD == "LoD1") {
-            ProcessLoD1(CityObjectMembers, OffsetVector);
+    // Schlüssel pro Gebäude ist die gml:id, fehlende IDs über den Index, doppelte werden durchnummeriert
+    TArray<FString> BuildingKeys;
+    BuildingKeys.Reserve(NumBuildings);
+    CurrentBuildings.Reset();
+    CurrentBuildings.Reserve(NumBuildings);
+    BuildingUpdates = FCityGMLUpdateCounts();
+    for (int32 Building = 0; Building < NumBuildings; ++Building) {
+        const FString Id(CityGeometry.Attributes.GetId(Building));
+        FString Key = Id.IsEmpty() ? FString::Printf(TEXT("Building_%d"), Building) : Id;
+        for (int32 Duplicate = 2; CurrentBuildings.Contains(Key); ++Duplicate) {
+            Key = FString::Printf(TEXT("%s#%d"), *Id, Duplicate);
         }
-        else if (LoD == "LoD2") {
-            ProcessLoD2(CityObjectMembers, OffsetVector);
+        CurrentBuildings.Add(Key, BuildingHashes[Building]);
+
+        const uint64* Previous = ImportedBuildings.Find(Key);
+        if (!Previous) {
+            BuildingUpdates.Added++;
         }
-        else if (LoD == "LoD3") {
-            ProcessLoD3(CityObjectMembers, OffsetVector);
+        else if (*Previous != BuildingHashes[Building]) {
+            BuildingUpdates.Modified++;
         }
         else {
-            UE_LOG(LogTemp, Error, TEXT("This Level of Detail is not supported"));
-            return;
+            BuildingUpdates.Unchanged++;
+        }
+        BuildingKeys.Add(MoveTemp(Key));
+    }
+    for (const TPair<FString, uint64>& Previous : ImportedBuildings) {
+        if (!CurrentBuildings.Contains(Previous.Key)) {
+            BuildingUpdates.Removed++;
         }
+    }
 
+    // Einstellungen, die das Aussehen eines Actors ändern, gehen in jeden Job-Hash ein
+    FString Settings = FString::Printf(TEXT("%d|%d|%s|%d|%d|%g|%g"), SectionPerSurfaceType, BakeStaticMeshes, *StaticMeshPath, GenerateMeshLODs, FootprintProxyLOD, FootprintProxyScreenSize, TileSize);
+    for (int32 i = 0; i < LODScreenSizes.Num(); ++i) {
+        Settings += FString::Printf(TEXT("|%g:%g"), LODScreenSizes[i], LODTrianglePercents.IsValidIndex(i) ? LODTrianglePercents[i] : 0.0f);
     }
+    const uint64 SettingsHash = CityHash64((const char*)*Settings, Settings.Len() * sizeof(TCHAR));
+    auto Combine = [](uint64 Hash, uint64 Value) {
+        return CityHash128to64(Uint128_64(Hash, Value));
+    };
+
+    JobKeys.Reset();
+    JobHashes.Reset();
+    if (OneMesh && TiledMesh && TileSize > 0.0f) {
+        // Die Positionen einer Kachel sind auf ihren Mittelpunkt bezogen, daher wird ihr eigener Speicher gehasht
+        JobHashes.SetNumUninitialized(CityTiles.Num());
+        ParallelFor(CityTiles.Num(), [this, SettingsHash, &Combine](int32 TileIndex) {
+            const FCityGMLTile& Tile = CityTiles[TileIndex];
+            uint64 Hash = SettingsHash;
+            if (CityTileSpool.IsActive()) {
+                // Ausgelagerte Gebäude werden dafür nicht geladen
+                for (const uint64 BuildingHash : Tile.BuildingHashes) {
+                    Hash = Combine(Hash, BuildingHash);
+                }
+            }
+            else {
+                for (int32 Building = 0; Building < Tile.Geometry.NumBuildings(); ++Building) {
+                    Hash = Combine(Hash, Tile.Geometry.GetBuildingHash(Building));
+                }
+            }
+            JobHashes[TileIndex] = Hash;
+        });
+        for (const FCityGMLTile& Tile : CityTiles) {
+            JobKeys.Add(FString::Printf(TEXT("CityGMLTile_%d_%d"), Tile.Cell.X, Tile.Cell.Y));
+        }
+    }
+    else if (OneMesh) {
+        uint64 Hash = SettingsHash;
+        for (const uint64 BuildingHash : BuildingHashes) {
+            Hash = Combine(Hash, BuildingHash);
+        }
+        JobKeys.Add(TEXT("CityGMLMesh"));
+        JobHashes.Add(Hash);
+    }
+    else if (CityInstanceGroups.Num() > 0) {
+        // Die Positionen der Gebäude sind absolut, damit ändert sich der Hash auch, wenn eine Instanz verschoben wird
+        for (const FCityGMLInstanceGroup& Group : CityInstanceGroups) {
+            uint64 Hash = SettingsHash;
+            for (const int32 Building : Group.Buildings) {
+                Hash = Combine(Hash, BuildingHashes[Building]);
+            }
+            JobKeys.Add(BuildingKeys[Group.Prototype]);
+            JobHashes.Add(Hash);
+        }
+    }
+    else {
+        for (int32 Building = 0; Building < NumBuildings; ++Building) {
+            JobKeys.Add(BuildingKeys[Building]);
+            JobHashes.Add(Combine(SettingsHash, BuildingHashes[Building]));
+        }
+    }
+}
 
-    FilesSuccesful++;
-    UE_LOG(LogTemp, Log, TEXT("Finished processing CityGML file: %s"), *FilePath);
+void FCityGMLImporterModule::SelectMeshJobs()
+{
+    PendingJobs.Reset();
+    CurrentMeshes.Reset();
+    MeshUpdates = FCityGMLUpdateCounts();
+    for (int32 Job = 0; Job < JobKeys.Num(); ++Job) {
+        const FCityGMLImportedMesh* Previous = ImportedMeshes.Find(JobKeys[Job]);
+        if (IncrementalImport && Previous && Previous->Hash == JobHashes[Job] && Previous->Actor.IsValid()) {
+            // Der Actor des letzten Imports bleibt unverändert stehen
+            CurrentMeshes.Add(JobKeys[Job], *Previous);
+            MeshUpdates.Unchanged++;
+            continue;
+        }
+        if (Previous) {
+            MeshUpdates.Modified++;
+        }
+        else {
+            MeshUpdates.Added++;
+        }
+        PendingJobs.Add(Job);
+    }
+}
 
+void FCityGMLImporterModule::ApplyMeshUpdates()
+{
+    if (IncrementalImport) {
+        // Ersetzte Actors und Actors entfernter Gebäude verschwinden erst jetzt, ein Abbruch lässt das Level unverändert.
+        // Konnte eine Datei nicht gelesen werden, bleiben fehlende Gebäude stehen, statt als entfernt zu gelten.
+        const bool bAllFilesLoaded = ActiveImport.IsValid() && FilesSuccesful == ActiveImport->NumFiles;
+        const TSet<FString> Keys(JobKeys);
+        for (const TPair<FString, FCityGMLImportedMesh>& Previous : ImportedMeshes) {
+            const FCityGMLImportedMesh* Current = CurrentMeshes.Find(Previous.Key);
+            if (Current && Current->Actor == Previous.Value.Actor) {
+                continue;
+            }
+            if (!Keys.Contains(Previous.Key)) {
+                if (!bAllFilesLoaded) {
+                    CurrentMeshes.Add(Previous.Key, Previous.Value);
+                    continue;
+                }
+                MeshUpdates.Removed++;
+            }
+            if (Previous.Value.Actor.IsValid()) {
+                Previous.Value.Actor->Destroy();
+            }
+        }
+        if (!bAllFilesLoaded) {
+            for (const TPair<FString, uint64>& Previous : ImportedBuildings) {
+                if (!CurrentBuildings.Contains(Previous.Key)) {
+                    CurrentBuildings.Add(Previous.Key, Previous.Value);
+                    BuildingUpdates.Removed--;
+                    BuildingUpdates.Unchanged++;
+                }
+            }
+        }
+        UE_LOG(LogTemp, Log, TEXT("CityGML incremental import: buildings %d unchanged, %d modified, %d added, %d removed"),
+            BuildingUpdates.Unchanged, BuildingUpdates.Modified, BuildingUpdates.Added, BuildingUpdates.Removed);
+        UE_LOG(LogTemp, Log, TEXT("CityGML incremental import: actors %d kept, %d rebuilt, %d added, %d removed"),
+            MeshUpdates.Unchanged, MeshUpdates.Modified, MeshUpdates.Added, MeshUpdates.Removed);
+    }
+    ImportedBuildings = MoveTemp(CurrentBuildings);
+    ImportedMeshes = MoveTemp(CurrentMeshes);
+    CurrentBuildings.Reset();
+    CurrentMeshes.Reset();
 }
 
-void FCityGMLImporterModule::ProcessLoD1(const TArray<FXmlNode*>& CityObjectMembers, FVector OffsetVector) {
-    // Verarbeite die CityObjectMembers für LoD1
-    UE_LOG(LogTemp, Log, TEXT("Processing LoD1"));
+TArray<FCityGMLFileGeometry> FCityGMLImporterModule::ProcessCityGMLFiles(const TArray<FString>& Files, FCityGMLImportProgress& Progress, const TFunction<void(FCityGMLFileGeometry&, int64)>& OnFileDone)
+{
+    // Jeder Eintrag eines Zip-Archivs ist eine eigene Eingabe und wird wie eine Datei verteilt
+    TArray<FCityGMLSource> Sources;
+    CityGMLArchive::ExpandSources(Files, Sources);
+    Progress.NumFiles = Sources.Num();
+
+    TArray<FCityGMLFileGeometry> Results;
+    Results.SetNum(Sources.Num());
+
+    int32 ThreadCount = 1;
+    if (ParallelImport && GThreadPool) {
+        ThreadCount = ImportThreads > 0 ? ImportThreads : GThreadPool->GetNumThreads();
+        ThreadCount = FMath::Clamp(ThreadCount, 1, Sources.Num());
+    }
 
-    // Iteriere über alle Knoten
-    TArray<TArray<TArray<FVector>>> allBuildingsFromFile; // Alle Gebäude
-    TArray<TArray<TArray<int32>>> allBuildingsFromFileTriangles;
-    TArray<FString> BuildingIds;
-    TArray<TArray<FString>> allAddressInfo;
-    for (FXmlNode* CityObjectMember : CityObjectMembers)
-    {
-        // Suche nach Building-Knoten
-        const FXmlNode* BuildingNode = CityObjectMember->FindChildNode(TEXT("bldg:Building"));
-        if (BuildingNode) {
-
-            TArray<TArray<FVector>> BuildingVectors; // Ein Gebäude
-            TArray<TArray<int32>> BuildingTriangles;
-            FString BuildingID = BuildingNode->GetAttribute(TEXT("gml:id"));
-            TArray<FString> AddressInfo;
-
-            const FXmlNode* Lod1SolidNode = BuildingNode->FindChildNode(TEXT("bldg:lod1Solid"));
-            if (Lod1SolidNode) {
-
-                const FXmlNode* SolidNode = Lod1SolidNode->FindChildNode(TEXT("gml:Solid"));
-                if (SolidNode) {
-
-                    const FXmlNode* ExteriorNode = SolidNode->FindChildNode(TEXT("gml:exterior"));
-                    if (ExteriorNode) {
-
-                        const FXmlNode* CompositeSurfaceNode = ExteriorNode->FindChildNode(TEXT("gml:CompositeSurface"));
-                        if (CompositeSurfaceNode) {
-                            
-                            // Verarbeite alle gml:surfaceMember-Knoten also die einzelnen Waende oder Decken
-                            for (const FXmlNode* SurfaceMemberNode : CompositeSurfaceNode->GetChildrenNodes()) {
-                                TArray<FVector> Vertices; // Für eine Fläche
-                                TArray<int32> Triangles;
-                                const FXmlNode* PolygonNode = SurfaceMemberNode->FindChildNode(TEXT("gml:Polygon"));
-                                if (PolygonNode) {
-                                    Vertices = ParsePolygon(PolygonNode, OffsetVector);
-                                    TArray<FVector> v;
-                                    if (Vertices.Num() >= 3) { 
-                                        FGeometryData data = GeometryDataHelper::MakeFace(Vertices, false);
-
-                                        Triangles = data.Indices;
-                                        for (int i = 0; i < Triangles.Num(); ++i) {
-                                            Triangles[i] = Triangles[i] + VertexOffset;
-                                        }
-
-                                        //Triangles = GenerateTriangles(Vertices);
-                                        //GenerateNormals(Vertices);
-                                        Normalen.Append(data.Normals);
-                                        GenerateUVs(Vertices);
-                                        GenerateTangents(Vertices, Triangles);
-                                    }
-                                    if (OneMesh) {
-                                        VertexOffset += Vertices.Num();
-                                    }
-                                }
-                                BuildingVectors.Add(Vertices);
-                                BuildingTriangles.Add(Triangles);
-                            } // Wand bzw. Decke Ende
-                            const FXmlNode* AddressNode = BuildingNode->FindChildNode(TEXT("bldg:address"));
-                            if (AddressNode) {
-                                AddressInfo = GetAdress(AddressNode);
+    int32 CacheHits = 0;
+    int64 VerticesKept = 0;
+    int64 VerticesWelded = 0;
+    // Fertige Dateien werden in Reihenfolge der Dateien ausgewertet und an OnFileDone übergeben
+    auto Deliver = [&Results, &OnFileDone, &CacheHits, &VerticesKept, &VerticesWelded](int32 i, int64 OutstandingBytes) {
+        FCityGMLFileGeometry& Result = Results[i];
+        UE_LOG(LogTemp, Log, TEXT("  %s: read %.3f s, parse %.3f s, triangulate %.3f s, %d buildings%s"),
+            *FPaths::GetCleanFilename(Result.FilePath), Result.ReadSeconds, Result.ParseSeconds, Result.TriangulateSeconds, Result.Geometry.NumBuildings(),
+            Result.bFromCache ? TEXT(" (cached)") : TEXT(""));
+        CacheHits += Result.bFromCache ? 1 : 0;
+        if (!Result.bFromCache) {
+            VerticesKept += Result.Geometry.NumVertices();
+            VerticesWelded += Result.WeldedVertices;
+        }
+        if (OnFileDone) {
+            OnFileDone(Result, OutstandingBytes);
+        }
+    };
+
+    if (ThreadCount <= 1) {
+        for (int32 i = 0; i < Sources.Num() && !Progress.bCancelRequested; ++i) {
+            ProcessCityGML(Sources[i], Results[i], Progress);
+            Deliver(i, 0);
+        }
+    }
+    else {
+        // Jeder Worker holt sich die nächste freie Datei, das Ergebnis landet immer am Index der Datei
+        FThreadSafeCounter NextFile;
+        FCriticalSection DeliverLock;
+        TArray<bool> bFinished;
+        bFinished.SetNumZeroed(Sources.Num());
+        FThreadSafeCounter NextDeliver;
+
+        // Bei MemoryBudgetMB gehören auch die Dateien zum Budget, die noch gelesen werden oder auf ihre Verteilung warten.
+        // Fertige Ergebnisse zählen mit ihrer Größe, laufende Dateien mit der größten bisher verteilten. Alles unter DeliverLock
+        const bool bBudgeted = OnFileDone && CityTileSpool.IsActive();
+        TArray<int64> ResultBytes;
+        ResultBytes.SetNumZeroed(Sources.Num());
+        int64 PendingBytes = 0;
+        int32 NumPending = 0;
+        int32 NumInFlight = 0;
+        int64 LargestFileBytes = 0;
+
+        // Ein Event pro Worker, ausgelöst nach jeder fertigen Datei, wenn also verteilt, ausgelagert oder eine Datei beendet wurde.
+        // Ein Trigger ohne Wartenden bleibt bis zum nächsten Wait erhalten, so geht keiner zwischen Prüfung und Wait verloren
+        TArray<FEvent*> FileDone;
+        for (int32 t = 0; t < ThreadCount; ++t) {
+            FileDone.Add(FPlatformProcess::GetSynchEventFromPool(false));
+        }
+        // Der Abbruch löst kein Event aus und wird daher in diesem Abstand geprüft
+        const uint32 CancelPollMs = 100;
+
+        TArray<TFuture<void>> Workers;
+        for (int32 t = 0; t < ThreadCount; ++t) {
+            Workers.Add(Async(EAsyncExecution::ThreadPool, [&, t]() {
+                for (int32 i = NextFile.Increment() - 1; i < Sources.Num() && !Progress.bCancelRequested; i = NextFile.Increment() - 1) {
+                    // Mit OnFileDone werden fertige Dateien sofort abgegeben, höchstens ThreadCount Ergebnisse warten gleichzeitig im Speicher
+                    while (OnFileDone && i - NextDeliver.GetValue() >= ThreadCount && !Progress.bCancelRequested) {
+                        FileDone[t]->Wait(CancelPollMs);
+                    }
+                    // Eine Datei beginnt erst, wenn sie geschätzt noch ins Budget passt. Bis die erste Datei verteilt ist, gibt es keine
+                    // Schätzung und es läuft nur eine. Ohne laufende Datei wartet auch kein Ergebnis mehr, dann beginnt sie immer
+                    while (bBudgeted && !Progress.bCancelRequested) {
+                        {
+                            FScopeLock Lock(&DeliverLock);
+                            const int64 UsedBytes = CityTileSpool.GetResidentBytes() + PendingBytes + (NumInFlight + 1) * LargestFileBytes;
+                            if (NumInFlight == 0 || (LargestFileBytes > 0 && UsedBytes <= CityTileSpool.GetBudgetBytes())) {
+                                NumInFlight++;
+                                break;
                             }
                         }
+                        FileDone[t]->Wait(CancelPollMs);
+                    }
+                    if (Progress.bCancelRequested) {
+                        break;
+                    }
+                    ProcessCityGML(Sources[i], Results[i], Progress);
+
+                    FScopeLock Lock(&DeliverLock);
+                    bFinished[i] = true;
+                    if (bBudgeted) {
+                        NumInFlight--;
+                        ResultBytes[i] = Results[i].Geometry.GetAllocatedSize();
+                        PendingBytes += ResultBytes[i];
+                        NumPending++;
+                    }
+                    while (NextDeliver.GetValue() < Sources.Num() && bFinished[NextDeliver.GetValue()]) {
+                        const int32 Next = NextDeliver.GetValue();
+                        int64 OutstandingBytes = 0;
+                        if (bBudgeted) {
+                            PendingBytes -= ResultBytes[Next];
+                            NumPending--;
+                            LargestFileBytes = FMath::Max(LargestFileBytes, ResultBytes[Next]);
+                            // Jeder Worker ohne wartendes Ergebnis kann gleich eine weitere Datei lesen
+                            const int32 NumReading = FMath::Max(FMath::Min(ThreadCount - 1, Sources.Num() - 1 - Next) - NumPending, 0);
+                            OutstandingBytes = PendingBytes + NumReading * LargestFileBytes;
+                        }
+                        Deliver(Next, OutstandingBytes);
+                        NextDeliver.Increment();
                     }
+                    for (FEvent* Event : FileDone) {
+                        Event->Trigger();
+                    }
+                }
+            }));
+        }
+        for (TFuture<void>& Worker : Workers) {
+            Worker.Wait();
+        }
+        for (FEvent* Event : FileDone) {
+            FPlatformProcess::ReturnSynchEventToPool(Event);
+        }
+    }
+
+    if (VerticesWelded > 0) {
+        // Position, Normale, UV und Tangente pro Vertex, so auch im Vertex-Buffer der GPU
+        const int64 BytesPerVertex = sizeof(FVector) + sizeof(FVector) + sizeof(FVector2D) + sizeof(FProcMeshTangent);
+        UE_LOG(LogTemp, Log, TEXT("CityGML vertex welding: %lld -> %lld vertices (-%.1f%%), %.1f MB saved"),
+            VerticesKept + VerticesWelded, VerticesKept, 100.0 * VerticesWelded / (VerticesKept + VerticesWelded), VerticesWelded * BytesPerVertex / (1024.0 * 1024.0));
+    }
+    if (UseGeometryCache && Results.Num() > 0) {
+        UE_LOG(LogTemp, Log, TEXT("CityGML geometry cache: %d hits, %d misses (%.0f%% hit rate)"), CacheHits, Results.Num() - CacheHits, 100.0 * CacheHits / Results.Num());
+    }
+    UE_LOG(LogTemp, Log, TEXT("CityGML import used %d thread(s)"), ThreadCount);
+    return Results;
+}
+
+void FCityGMLImporterModule::ProcessCityGML(const FCityGMLSource& Source, FCityGMLFileGeometry& FileGeometry, FCityGMLImportProgress& Progress) 
+{
+    // Bei Archiv-Einträgen "Archiv.zip/Eintrag.gml", so auch im Cache und im Output Log
+    const FString FilePath = Source.GetDisplayPath();
+    FileGeometry.FilePath = FilePath;
+
+    // Unveränderte Dateien werden direkt aus dem Cache übernommen, ohne zu parsen oder zu triangulieren
+    FString CacheKey;
+    if (UseGeometryCache) {
+        CITYGML_SCOPE_CYCLE_COUNTER(STAT_CityGML_LoadCache);
+        const double CacheStart = FPlatformTime::Seconds();
+        CacheKey = CityGMLGeometryCache::MakeKey(Source, Skalierung, CityOrigin, WeldVertices ? WeldTolerance : 0.0f, WeldCreaseAngle, CityRegion.bIsSet ? ImportRegion : FString());
+        FString CachedLoD;
+        if (CityGMLGeometryCache::Load(FilePath, CacheKey, FileGeometry.Geometry, CachedLoD)) {
+            FileGeometry.ReadSeconds = FPlatformTime::Seconds() - CacheStart;
+            FileGeometry.bFromCache = true;
+            FileGeometry.bSucceeded = true;
+            Progress.FilesRead.Increment();
+            Progress.FilesParsed.Increment();
+            Progress.BuildingsParsed.Add(FileGeometry.Geometry.NumBuildings());
+            Progress.BuildingsTriangulated.Add(FileGeometry.Geometry.NumBuildings());
+            UE_LOG(LogTemp, Log, TEXT("Loaded %d %s buildings from cache: %s"), FileGeometry.Geometry.NumBuildings(), *CachedLoD, *FilePath);
+            return;
+        }
+    }
+
+    FCityGMLBuildingAssembler Assembler;
+
+    // Ein Block von Gebäuden, der als Ganzes auf einem Task trianguliert wird
+    struct FBuildingBatch
+    {
+        TArray<FCityGMLBuilding> Input;
+        FCityGMLGeometryStore Output;
+        double Seconds = 0.0;
+        FCityGMLPhaseTimes PhaseTimes;
+        int32 WeldedVertices = 0;
+        TFuture<void> Done;
+    };
+    TArray<TSharedPtr<FBuildingBatch, ESPMode::ThreadSafe>> InFlight;
+    TSharedPtr<FBuildingBatch, ESPMode::ThreadSafe> Pending = MakeShared<FBuildingBatch, ESPMode::ThreadSafe>();
+    const int32 MaxInFlight = FMath::Max(2, FTaskGraphInterface::Get().GetNumWorkerThreads() * 2);
+
+    // Fan-in: fertige Blöcke werden immer in Lesereihenfolge übernommen
+    auto CollectOldest = [&FileGeometry, &InFlight]() {
+        TSharedPtr<FBuildingBatch, ESPMode::ThreadSafe> Batch = InFlight[0];
+        InFlight.RemoveAt(0, 1, false);
+        Batch->Done.Wait();
+        FileGeometry.Geometry.Append(MoveTemp(Batch->Output));
+        FileGeometry.TriangulateSeconds += Batch->Seconds;
+        FileGeometry.PhaseTimes += Batch->PhaseTimes;
+        FileGeometry.WeldedVertices += Batch->WeldedVertices;
+    };
+
+    // Fan-out: ist ein Block voll, wird er auf dem Task-Graph trianguliert, während der Reader weiterliest
+    auto Dispatch = [this, &Assembler, &Pending, &InFlight, &FileGeometry, &CollectOldest, &Progress, MaxInFlight]() {
+        if (Pending->Input.Num() == 0) {
+            return;
+        }
+        TSharedPtr<FBuildingBatch, ESPMode::ThreadSafe> Batch = Pending;
+        Pending = MakeShared<FBuildingBatch, ESPMode::ThreadSafe>();
+
+        FVector OffsetVector = FVector(0.0f, 0.0f, 0.0f);
+        if (Assembler.HasEnvelope()) {
+            OffsetVector = CityOrigin;
+        }
+        const FCityGMLLoDPaths* Paths = CityGMLTagPaths::FindLoD(Assembler.GetLoD());
+
+        auto Triangulate = [this, Batch, OffsetVector, Paths, &Progress]() {
+            const double TriangulateStart = FPlatformTime::Seconds();
+            // Ein Triangulator pro Block, seine Arbeitspuffer werden für alle Flächen des Blocks wiederverwendet
+            FCityGMLTriangulator Triangulator;
+            for (const FCityGMLBuilding& Building : Batch->Input) {
+                if (Progress.bCancelRequested) {
+                    break;
+                }
+                if (Paths) {
+                    TriangulateBuilding(Building, *Paths, OffsetVector, Batch->Output, Triangulator, Batch->PhaseTimes);
                 }
+                Progress.BuildingsTriangulated.Increment();
+            }
+            Batch->Input.Empty();
+            if (WeldVertices) {
+                // Pro Gebäude, die Blöcke enthalten nur ganze Gebäude
+                CITYGML_SCOPE_CYCLE_COUNTER(STAT_CityGML_WeldVertices);
+                FScopedDurationTimer Timer(Batch->PhaseTimes.WeldSeconds);
+                Batch->WeldedVertices = Batch->Output.WeldVertices(WeldTolerance * Skalierung, WeldCreaseAngle);
             }
+            Batch->Seconds = FPlatformTime::Seconds() - TriangulateStart;
+        };
+
+        if (ParallelTriangulation) {
+            Batch->Done = Async(EAsyncExecution::TaskGraph, MoveTemp(Triangulate));
+            InFlight.Add(Batch);
+            if (InFlight.Num() > MaxInFlight) {
+                CollectOldest();
+            }
+        }
+        else {
+            Triangulate();
+            FileGeometry.Geometry.Append(MoveTemp(Batch->Output));
+            FileGeometry.TriangulateSeconds += Batch->Seconds;
+            FileGeometry.PhaseTimes += Batch->PhaseTimes;
+            FileGeometry.WeldedVertices += Batch->WeldedVertices;
+        }
+    };
+
+    Assembler.OnLoaded = [&Progress]() {
+        Progress.FilesRead.Increment();
+    };
+    Assembler.OnBuilding = [&Pending, &Dispatch, &Progress](FCityGMLBuilding&& Building) {
+        Progress.BuildingsParsed.Increment();
+        Pending->Input.Add(MoveTemp(Building));
+        if (Pending->Input.Num() >= BuildingBatchSize) {
+            Dispatch();
+        }
+    };
+
+    const double ReadStart = FPlatformTime::Seconds();
+    FCityGMLReader Reader(Assembler);
+    Reader.SetCancelFlag(&Progress.bCancelRequested);
+    Reader.SetRegion(&CityRegion);
+    FText ReadError;
+    const bool bRead = Reader.ReadSource(Source, ReadError);
+    const double ReaderSeconds = FPlatformTime::Seconds() - ReadStart;
+    Progress.FilesParsed.Increment();
+
+    // Die Gebäude verweisen in die gemappte Datei, alle Blöcke müssen fertig sein, bevor der Reader sie freigibt
+    Dispatch();
+    while (InFlight.Num() > 0) {
+        CollectOldest();
+    }
+    FileGeometry.ReadSeconds = Reader.GetLoadSeconds();
+    FileGeometry.ParseSeconds = ReaderSeconds - FileGeometry.ReadSeconds;
 
-            BuildingIds.Add(BuildingID);
-            allBuildingsFromFile.Add(BuildingVectors);
-            allBuildingsFromFileTriangles.Add(BuildingTriangles);
-            allAddressInfo.Add(AddressInfo);
+    if (!bRead) {
+        FileGeometry.Geometry.Reset();
+        if (Reader.IsCancelled()) {
+            return;
         }
-    } // Gebäude zuende
-    if (!OneMesh) {
-        CreateMeshFromPolygon(allBuildingsFromFile, allBuildingsFromFileTriangles, BuildingIds);
-    }    AllBuildings.Append(allBuildingsFromFile);
-    AllTriangles.Append(allBuildingsFromFileTriangles);
-    AllAdresses.Append(allAddressInfo);
+        if (Reader.IsUnsupportedLoD()) {
+            UE_LOG(LogTemp, Error, TEXT("This Level of Detail is not supported"));
+            return;
+        }
+        UE_LOG(LogTemp, Error, TEXT("%s"), *ReadError.ToString());
+        FileGeometry.Error = ReadError;
+        return;
+    }
+    UE_LOG(LogTemp, Log, TEXT("Processed %d %s buildings"), FileGeometry.Geometry.NumBuildings(), *Assembler.GetLoD());
+    if (Reader.GetMappedBytes() > 0) {
+        UE_LOG(LogTemp, Verbose, TEXT("Parsed %.1f MB in place from the mapped file"), Reader.GetMappedBytes() / (1024.0 * 1024.0));
+    }
+    else {
+        UE_LOG(LogTemp, Verbose, TEXT("Parsed in blocks, largest token carried across a block boundary %d bytes"), Reader.GetMaxCarryBytes());
+    }
+    if (Reader.GetNumSkippedBuildings() > 0) {
+        UE_LOG(LogTemp, Log, TEXT("Skipped %d buildings outside the import region"), Reader.GetNumSkippedBuildings());
+    }
+
+    if (UseGeometryCache) {
+        CityGMLGeometryCache::Save(FilePath, CacheKey, FileGeometry.Geometry, Assembler.GetLoD());
+    }
+
+    FileGeometry.bSucceeded = true;
+    UE_LOG(LogTemp, Log, TEXT("Finished processing CityGML file: %s"), *FilePath);
+
 }
-void FCityGMLImporterModule::ProcessLoD2(const TArray<FXmlNode*>& CityObjectMembers, FVector OffSetVector)
+
+void FCityGMLImporterModule::MergeFileGeometry(FCityGMLFileGeometry& FileGeometry)
 {
-    // Verarbeite die CityObjectMembers für LoD2
-    UE_LOG(LogTemp, Log, TEXT("Processing LoD2"));
-
-    TArray<TArray<TArray<FVector>>> allBuildingsFromFile; // Alle Gebäude
-    TArray<TArray<TArray<int32>>> allBuildingsFromFileTriangles;
-    TArray<FString> BuildingIds;
-    TArray<TArray<FString>> allAddressInfo;
-
-    for (FXmlNode* CityObjectMember : CityObjectMembers) {
-
-        // Suche nach Building-Knoten
-        const FXmlNode* BuildingNode = CityObjectMember->FindChildNode(TEXT("bldg:Building"));
-        if (BuildingNode) {
-            TArray<TArray<FVector>> BuildingVectors; // Ein Gebäude
-            TArray<TArray<int32>> BuildingTriangles;
-            FString BuildingID = BuildingNode->GetAttribute(TEXT("gml:id"));
-            TArray<FString> AddressInfo;
-
-            for (const FXmlNode* BoundedByNode : BuildingNode->GetChildrenNodes()) {
-
-                if (BoundedByNode->GetTag() == "bldg:boundedBy") {
-                    TArray<FVector> Vertices; // Für eine Fläche
-                    TArray<int32> Triangles;
-
-                    const FXmlNode* SurfaceNode = BoundedByNode->GetFirstChildNode();
-                    if (SurfaceNode) {
-
-                        const FXmlNode* Lod2MultiSurfaceNode = SurfaceNode->FindChildNode(TEXT("bldg:lod2MultiSurface"));
-                        if (Lod2MultiSurfaceNode) {
-
-                            const FXmlNode* MultiSurfaceNode = Lod2MultiSurfaceNode->FindChildNode(TEXT("gml:MultiSurface"));
-                            if (MultiSurfaceNode) {
-
-                                const FXmlNode* SurfaceMemberNode = MultiSurfaceNode->FindChildNode(TEXT("gml:surfaceMember"));
-                                if (SurfaceMemberNode) {
-
-                                    const FXmlNode* PolygonNode = SurfaceMemberNode->FindChildNode(TEXT("gml:Polygon"));
-                                    if (PolygonNode) {
-
-                                        Vertices = ParsePolygon(PolygonNode, OffSetVector);
-                                        if (Vertices.Num() >= 3) {
-                                            
-                                            FGeometryData data = GeometryDataHelper::MakeFace(Vertices, false);
-
-                                            Triangles = data.Indices;
-                                            for (int i = 0; i < Triangles.Num(); ++i) {
-                                                Triangles[i] = Triangles[i] + VertexOffset;
-                                            }
-
-                                            //Triangles = GenerateTriangles(Vertices);
-                                            //GenerateNormals(Vertices);
-                                            Normalen.Append(data.Normals);
-                                            GenerateUVs(Vertices);
-                                            GenerateTangents(Vertices, Triangles);
-                                        }
-                                        if (OneMesh) {
-                                            VertexOffset += Vertices.Num();
-                                        }
-                                    }
-                                }
-                            }
-                        }
-                    }
-                    BuildingVectors.Add(Vertices);
-                    BuildingTriangles.Add(Triangles);
-                }
-                else if (BoundedByNode->GetTag() == TEXT("bldg:address")) {
-                    AddressInfo = GetAdress(BoundedByNode);
+    if (!FileGeometry.bSucceeded) {
+        if (!FileGeometry.Error.IsEmpty()) {
+            Fehlermeldung = FileGeometry.Error;
+        }
+        return;
+    }
+
+    // Indizes und Start-Tabellen der Datei werden hinter die bisherigen Gebäude verschoben
+    CityGeometry.Append(MoveTemp(FileGeometry.Geometry));
+    FilesSuccesful++;
+}
+
+void FCityGMLImporterModule::TriangulateBuilding(const FCityGMLBuilding& Building, const FCityGMLLoDPaths& Paths, FVector OffsetVector, FCityGMLGeometryStore& Geometry, FCityGMLTriangulator& Triangulator, FCityGMLPhaseTimes& Times) {
+    Geometry.AddBuilding(Building.Id, Building.Address, Building.MeasuredHeight);
+    for (const FCityGMLSurface& Surface : Building.Surfaces) { // RoofSurface, WallSurface, GroundSurface oder lod1Solid
+        if (Paths.bOneFacePerSurface) {
+            // Pro bldg:boundedBy eine Fläche aus dem ersten surfaceMember
+            AddFace(Building, Surface, Surface.PosLists.Num() > 0 ? 0 : INDEX_NONE, OffsetVector, Geometry, Triangulator, Times);
+            continue;
+        }
+        // Verarbeite alle gml:surfaceMember also die einzelnen Waende oder Decken
+        for (int32 Member = 0; Member < Surface.PosLists.Num(); ++Member) {
+            AddFace(Building, Surface, Member, OffsetVector, Geometry, Triangulator, Times);
+        }
+    } // Dach / Bodenflaeche / Wand Ende
+}
+
+void FCityGMLImporterModule::AddFace(const FCityGMLBuilding& Building, const FCityGMLSurface& Surface, int32 Member, FVector OffsetVector, FCityGMLGeometryStore& Geometry, FCityGMLTriangulator& Triangulator, FCityGMLPhaseTimes& Times) {
+    const int32 FaceStart = Geometry.NumVertices();
+    Geometry.AddFace(Surface.Type);
+
+    // Äußerer Ring und Löcher werden hintereinander direkt an die Positionen des Speichers angehängt
+    int32 NumOuter = 0;
+    TArray<int32, TInlineAllocator<8>> HoleStarts;
+    if (Member != INDEX_NONE) {
+        CITYGML_SCOPE_CYCLE_COUNTER(STAT_CityGML_ParsePosList);
+        FScopedDurationTimer Timer(Times.PosListSeconds);
+        NumOuter = ParseRing(Building.GetPosList(Surface.PosLists[Member]), OffsetVector, Geometry.Positions);
+        if (NumOuter >= 3) {
+            for (const FCityGMLTextRange& Interior : Surface.GetInteriors(Member)) {
+                const int32 HoleStart = Geometry.NumVertices() - FaceStart;
+                if (ParseRing(Building.GetPosList(Interior), OffsetVector, Geometry.Positions) >= 3) {
+                    HoleStarts.Add(HoleStart);
                 }
-            } // Dach / Bodenflaeche / Wand Ende
-            allBuildingsFromFile.Add(BuildingVectors);
-            allBuildingsFromFileTriangles.Add(BuildingTriangles);
-            BuildingIds.Add(BuildingID);
-            allAddressInfo.Add(AddressInfo);
-        }
-    } // Gebäude Ende Schleife
-    if (!OneMesh) {
-        CreateMeshFromPolygon(allBuildingsFromFile, allBuildingsFromFileTriangles, BuildingIds);
-    }    AllBuildings.Append(allBuildingsFromFile);
-    AllTriangles.Append(allBuildingsFromFileTriangles);
-    AllAdresses.Append(allAddressInfo);
-}
-
-void FCityGMLImporterModule::ProcessLoD3(const TArray<FXmlNode*>& CityObjectMembers, FVector OffSetVector) {
-    // Für LoD3 gibt es keine Adressinformationen
-    // Verarbeite die CityObjectMembers für LoD3
-    UE_LOG(LogTemp, Log, TEXT("Processing LoD3"));
-
-    TArray<TArray<TArray<FVector>>> allBuildingsFromFile; // Alle Gebäude
-    TArray<TArray<TArray<int32>>> allBuildingsFromFileTriangles;
-    TArray<FString> BuildingIds;
-
-    for (FXmlNode* CityObjectMember : CityObjectMembers) {
-
-        // Suche nach Building-Knoten
-        const FXmlNode* BuildingNode = CityObjectMember->FindChildNode(TEXT("bldg:Building"));
-        if (BuildingNode) {
-            TArray<TArray<FVector>> BuildingVectors; // Ein Gebäude
-            TArray<TArray<int32>> BuildingTriangles;
-            FString BuildingID = BuildingNode->GetAttribute(TEXT("gml:id"));
-
-            for (const FXmlNode* BoundedByNode : BuildingNode->GetChildrenNodes()) {
-
-                if (BoundedByNode->GetTag() == "bldg:boundedBy") { // Für die Textur koordianten hier auf app:appearence pruefen und ein paar layer darunter auslesen
-
-                    const FXmlNode* SurfaceNode = BoundedByNode->GetFirstChildNode(); // RoofSurface oder WallSurface oder GroundSurface
-                    if (SurfaceNode) {
-
-                        const FXmlNode* Lod3MultiSurfaceNode = SurfaceNode->FindChildNode(TEXT("bldg:lod3MultiSurface"));
-                        if (Lod3MultiSurfaceNode) {
-
-                            const FXmlNode* MultiSurfaceNode = Lod3MultiSurfaceNode->FindChildNode(TEXT("gml:MultiSurface"));
-                            if (MultiSurfaceNode) {
-
-                                const TArray<FXmlNode*>& SurfaceMemberNodes = MultiSurfaceNode->GetChildrenNodes();
-                                for (const FXmlNode* SurfaceMemberNode : SurfaceMemberNodes) {
-                                    TArray<FVector> Vertices; // Für eine Fläche
-                                    TArray<int32> Triangles;
-                                    if (SurfaceMemberNode && SurfaceMemberNode->GetTag() == TEXT("gml:surfaceMember")) {
-                                        const FXmlNode* PolygonNode = SurfaceMemberNode->FindChildNode(TEXT("gml:Polygon"));
-                                        if (PolygonNode) {
-
-                                            Vertices = ParsePolygon(PolygonNode, OffSetVector);
-                                            if (Vertices.Num() >= 3) {
-                                                FGeometryData data = GeometryDataHelper::MakeFace(Vertices, false);
-
-                                                Triangles = data.Indices;
-                                                for (int i = 0; i < Triangles.Num(); ++i) {
-                                                    Triangles[i] = Triangles[i] + VertexOffset;
-                                                }
-
-                                                //Triangles = GenerateTriangles(Vertices);
-                                                //GenerateNormals(Vertices);
-                                                Normalen.Append(data.Normals);
-                                                GenerateUVs(Vertices);
-                                                GenerateTangents(Vertices, Triangles);
-                                            }
-                                            if (OneMesh) {
-                                                VertexOffset += Vertices.Num();
-                                            }
-                                        }
-                                    }
-                                    BuildingVectors.Add(Vertices);
-                                    BuildingTriangles.Add(Triangles);
-                                }
-                            }
-                        }
-                    }
+                else {
+                    // Ein Loch ohne Fläche wird verworfen
+                    Geometry.Positions.SetNum(FaceStart + HoleStart, false);
                 }
-            } // Dach / Bodenflaeche / Wand Ende
-            allBuildingsFromFile.Add(BuildingVectors);
-            allBuildingsFromFileTriangles.Add(BuildingTriangles);
-            BuildingIds.Add(BuildingID);
+            }
+        }
+    }
+    const int32 NumVertices = Geometry.NumVertices() - FaceStart;
+    const TArrayView<const FVector> Vertices(Geometry.Positions.GetData() + FaceStart, NumVertices);
+
+    if (NumOuter >= 3) {
+        const int32 IndexStart = Geometry.Indices.Num();
+        FVector Normal;
+        {
+            CITYGML_SCOPE_CYCLE_COUNTER(STAT_CityGML_MakeFace);
+            FScopedDurationTimer Timer(Times.MakeFaceSeconds);
+            // Die Indizes werden direkt auf den Anfang des Speichers bezogen
+            Normal = Triangulator.Triangulate(Vertices, HoleStarts, FaceStart, Geometry.Indices);
+        }
+
+        // Die Fläche ist eben, alle Vertices bekommen die Normale ihrer Ebene
+        Geometry.Normals.Reserve(Geometry.Normals.Num() + NumVertices);
+        for (int32 i = 0; i < NumVertices; ++i) {
+            Geometry.Normals.Add(Normal);
         }
-    } // Gebäude Ende Schleife
-    if (!OneMesh) {
-        CreateMeshFromPolygon(allBuildingsFromFile, allBuildingsFromFileTriangles, BuildingIds);
+        {
+            CITYGML_SCOPE_CYCLE_COUNTER(STAT_CityGML_GenerateUVs);
+            FScopedDurationTimer Timer(Times.UVSeconds);
+            GenerateUVs(Vertices, Geometry.UVs);
+        }
+        {
+            CITYGML_SCOPE_CYCLE_COUNTER(STAT_CityGML_GenerateTangents);
+            FScopedDurationTimer Timer(Times.TangentSeconds);
+            GenerateTangents(Vertices, MakeArrayView(Geometry.Indices.GetData() + IndexStart, Geometry.Indices.Num() - IndexStart), FaceStart,
+                MakeArrayView(Geometry.UVs.GetData() + FaceStart, NumVertices), MakeArrayView(Geometry.Normals.GetData() + FaceStart, NumVertices), Geometry.Tangents);
+        }
+    }
+    else {
+        // Entartete Flächen bekommen leere Attribute, damit alle Puffer zu den Vertices passen
+        Geometry.Normals.AddZeroed(NumVertices);
+        Geometry.UVs.AddZeroed(NumVertices);
+        Geometry.Tangents.AddDefaulted(NumVertices);
     }
-    AllBuildings.Append(allBuildingsFromFile);
-    AllTriangles.Append(allBuildingsFromFileTriangles);
 }
 
-FVector FCityGMLImporterModule::ConvertUtmToUnreal(float UTM_X, float UTM_Y, float UTM_Z, FVector OriginOffset)
+FVector FCityGMLImporterModule::ConvertUtmToUnreal(double UTM_X, double UTM_Y, double UTM_Z, FVector OriginOffset)
 {
     // Vertausche die Achsen: X -> Y und Y -> X ( X Osten/ Y Norden)
     // Skalierung 1:100 ohne den Faktor
-    float UnrealX = (UTM_Y - OriginOffset.Y) * Skalierung;
-    float UnrealY = (UTM_X - OriginOffset.X) * Skalierung;
+    // Der Offset wird in double abgezogen, float allein hat bei UTM-Nordwerten nur eine Genauigkeit von 0.5 m
+    float UnrealX = float((UTM_Y - OriginOffset.Y) * Skalierung);
+    float UnrealY = float((UTM_X - OriginOffset.X) * Skalierung);
 
-    return FVector(UnrealX, UnrealY, UTM_Z * Skalierung + 200.0f);
+    return FVector(UnrealX, UnrealY, float(UTM_Z * Skalierung) + 200.0f);
 }
 
-void FCityGMLImporterModule::CreateOneMeshFromPolygon(TArray<TArray<TArray<FVector>>>& Buildings, TArray<TArray<TArray<int32>>>& Triangles) { 
-    UWorld* World = GEditor->GetEditorWorldContext().World();
+AActor* FCityGMLImporterModule::CreateOneMeshFromPolygon(UWorld* World, const FCityGMLGeometryStore& Geometry) { 
+    // Ein MeshActor für alle Dateien
+    AStaticMeshActor* MeshActor = World->SpawnActor<AStaticMeshActor>(AStaticMeshActor::StaticClass(), FTransform());
 
-    if (World) {
-        // Ein MeshActor pro File
-        AStaticMeshActor* MeshActor = World->SpawnActor<AStaticMeshActor>(AStaticMeshActor::StaticClass(), FTransform());
+    if (MeshActor) {
+        UProceduralMeshComponent* ProceduralMesh = NewObject<UProceduralMeshComponent>(MeshActor);
+        MeshActor->SetRootComponent(ProceduralMesh);
+        ProceduralMesh->RegisterComponent();
 
-        if (MeshActor) {
-            UProceduralMeshComponent* ProceduralMesh = NewObject<UProceduralMeshComponent>(MeshActor);
-            MeshActor->SetRootComponent(ProceduralMesh);
-            ProceduralMesh->RegisterComponent();
+        // Die Puffer des Speichers passen bereits zusammen und werden ohne Umkopieren übergeben
+        ProceduralMesh->CreateMeshSection(0, Geometry.Positions, Geometry.Indices, Geometry.Normals, Geometry.UVs, TArray<FColor>(), Geometry.Tangents, true);
 
-            TArray<FVector> AllVerticesMesh;
-            TArray<int32> AllTrianglesMesh;
+        MeshActor->SetActorLabel(TEXT("CityGMLMesh"));
+    }
+    return MeshActor;
+}
 
-            // Offsets für Triangles, pro Gebäude
+AActor* FCityGMLImporterModule::CreateTileMesh(UWorld* World, int32 TileIndex) {
+    FCityGMLTile& Tile = CityTiles[TileIndex];
+    if (!LoadSpilledTile(Tile)) {
+        return nullptr;
+    }
 
-            for (int32 i = 0; i < Buildings.Num(); ++i) { // Jedes Gebäude
-                const TArray<TArray<FVector>>& Building = Buildings[i];
-                const TArray<TArray<int32>>& BuildingTriangles = Triangles[i];
+    // Ein MeshActor pro Kachel, platziert im Mittelpunkt der Kachel
+    AStaticMeshActor* MeshActor = World->SpawnActor<AStaticMeshActor>(AStaticMeshActor::StaticClass(), FTransform(Tile.Origin));
 
-                // Für jede Fläche/Wand
-                for (int32 j = 0; j < Building.Num(); ++j) {
-                    const TArray<FVector>& Vertices = Building[j];
-                    const TArray<int32>& TrianglesArray = BuildingTriangles[j];
+    if (MeshActor) {
+        UProceduralMeshComponent* ProceduralMesh = NewObject<UProceduralMeshComponent>(MeshActor);
+        MeshActor->SetRootComponent(ProceduralMesh);
+        ProceduralMesh->RegisterComponent();
+        ProceduralMesh->SetWorldLocation(Tile.Origin);
 
-                    AllVerticesMesh.Append(Vertices);
-                    AllTrianglesMesh.Append(TrianglesArray);
+        const FCityGMLGeometryStore& TileGeometry = Tile.Geometry;
+        ProceduralMesh->CreateMeshSection(0, TileGeometry.Positions, TileGeometry.Indices, TileGeometry.Normals, TileGeometry.UVs, TArray<FColor>(), TileGeometry.Tangents, true);
 
-                }
-            }
+        MeshActor->SetActorLabel(FString::Printf(TEXT("CityGMLTile_%d_%d"), Tile.Cell.X, Tile.Cell.Y));
+    }
+    if (CityTileSpool.IsActive()) {
+        // Die Mesh-Section hat ihre eigene Kopie, so liegt immer nur eine geladene Kachel im Speicher
+        Tile.Geometry.Reset();
+    }
+    return MeshActor;
+}
 
-            ProceduralMesh->CreateMeshSection(0, AllVerticesMesh, AllTrianglesMesh, Normalen, UVs, TArray<FColor>(), Tangents, true);
+bool FCityGMLImporterModule::LoadSpilledTile(FCityGMLTile& Tile) {
+    if (!CityTileSpool.IsActive() || CityTileSpool.LoadTile(Tile)) {
+        return true;
+    }
+    // Ohne die ausgelagerten Teile fehlten Gebäude, die Kachel wird daher gar nicht erzeugt
+    UE_LOG(LogTemp, Error, TEXT("CityGML tile %d_%d skipped: a spilled part could not be read, %d buildings of the tile would be missing"),
+        Tile.Cell.X, Tile.Cell.Y, Tile.BuildingHashes.Num() - Tile.Geometry.NumBuildings());
+    Tile.Geometry.Reset();
+    return false;
+}
 
-            MeshActor->SetActorLabel(TEXT("CityGMLMesh"));
-        }
+void FCityGMLImporterModule::LogTileStats() {
+    if (CityTiles.Num() == 0) {
+        return;
     }
+    int32 MinTriangles = MAX_int32;
+    int32 MaxTriangles = 0;
+    int64 NumTriangles = 0;
+    for (const FCityGMLTile& Tile : CityTiles) {
+        MinTriangles = FMath::Min(MinTriangles, Tile.NumTriangles);
+        MaxTriangles = FMath::Max(MaxTriangles, Tile.NumTriangles);
+        NumTriangles += Tile.NumTriangles;
+    }
+    // Jede Kachel hat genau eine Section mit einem Material
+    UE_LOG(LogTemp, Log, TEXT("CityGML tiling: %d tiles of %.0f m, triangles per tile min %d / avg %d / max %d, %d draw calls"),
+        CityTiles.Num(), TileSize, MinTriangles, int32(NumTriangles / CityTiles.Num()), MaxTriangles, CityTiles.Num());
 }
 
-TArray<FVector> FCityGMLImporterModule::ParsePolygon(const FXmlNode* PolygonNode, FVector OffsetVector) {
-    TArray<FVector> Vertices;
-    const FXmlNode* PolygonExteriorNode = PolygonNode->FindChildNode(TEXT("gml:exterior"));
-    if (PolygonExteriorNode) {
-        const FXmlNode* LinearRingNode = PolygonExteriorNode->FindChildNode(TEXT("gml:LinearRing"));
-        if (LinearRingNode) {
-            const FXmlNode* PosListNode = LinearRingNode->FindChildNode(TEXT("gml:posList"));
-            if (PosListNode) {
-                FString PosList = PosListNode->GetContent();
-                TArray<FString> PosArray;
-                PosList.ParseIntoArray(PosArray, TEXT(" "), true);
-                for (int32 i = 0; i < PosArray.Num() - 3; i += 3) {
-                    Vertices.Add(ConvertUtmToUnreal(FCString::Atof(*PosArray[i]), FCString::Atof(*PosArray[i + 1]), FCString::Atof(*PosArray[i + 2]), OffsetVector));
-                }
-            }
-        }
+void FCityGMLImporterModule::LogMemoryBudget() {
+    const double MB = 1024.0 * 1024.0;
+    const int64 BudgetBytes = CityTileSpool.GetBudgetBytes();
+    const int64 PeakBytes = CityTileSpool.GetPeakBytes();
+    UE_LOG(LogTemp, Log, TEXT("CityGML memory budget: peak %.1f MB of %d MB (%.0f%%) for tiles and the file being distributed, %d tile parts spilled to disk with %.1f MB"),
+        PeakBytes / MB, MemoryBudgetMB, 100.0 * PeakBytes / BudgetBytes, CityTileSpool.GetNumSpillFiles(), CityTileSpool.GetSpilledBytes() / MB);
+
+    // Der Prozess enthält auch den Editor selbst und die Dateien, die auf anderen Worker-Threads gerade verarbeitet werden
+    const FPlatformMemoryStats MemoryStats = FPlatformMemory::GetStats();
+    UE_LOG(LogTemp, Log, TEXT("CityGML memory budget: process peak %.1f MB physical, %.1f MB in use after the import"),
+        MemoryStats.PeakUsedPhysical / MB, MemoryStats.UsedPhysical / MB);
+    if (PeakBytes > BudgetBytes) {
+        UE_LOG(LogTemp, Warning, TEXT("CityGML memory budget exceeded: the largest file and its tiles need more than a quarter of MemoryBudgetMB or tiles could not be spilled, split the input or raise the budget"));
     }
-    return Vertices;
 }
 
-TArray<int32> FCityGMLImporterModule::GenerateTriangles(const TArray<FVector>& Vertices) {
+int32 FCityGMLImporterModule::ParseRing(FAnsiStringView PosList, FVector OffsetVector, TArray<FVector>& OutVertices) {
+    // Die Zahlen werden ohne Zwischenstrings direkt aus dem UTF-8 Text gelesen und erst danach gemeinsam umgerechnet
+    TArray<double, TInlineAllocator<3 * 128>> Coordinates;
+    int32 NumPoints = CityGMLPosList::ParseCoordinates(PosList.GetData(), PosList.GetData() + PosList.Len(), Coordinates);
+    // Der letzte Punkt schließt den Ring und ist gleich dem ersten
+    NumPoints = FMath::Max(NumPoints - 1, 0);
+
+    // Dieselbe Rechnung wie ConvertUtmToUnreal
+    FCityGMLUtmTransform Transform;
+    Transform.OriginX = OffsetVector.X;
+    Transform.OriginY = OffsetVector.Y;
+    Transform.Scale = Skalierung;
+    Transform.ZOffset = 200.0f;
+    const int32 Start = OutVertices.AddUninitialized(NumPoints);
+    CityGMLVertexKernels::TransformUtm(Coordinates.GetData(), NumPoints, Transform, OutVertices.GetData() + Start);
+    return NumPoints;
+}
+
+TArray<int32> FCityGMLImporterModule::GenerateTriangles(const TArray<FVector>& Vertices, int32 FaceVertexOffset) {
     TArray<int32> Triangles; // Implementierung des "Fan"-Algorithmus
     for (int32 k = 1; k < Vertices.Num() - 1; ++k) {
-        Triangles.Add(0 + VertexOffset);
-        Triangles.Add(k + VertexOffset);
-        Triangles.Add(k + 1 + VertexOffset);
+        Triangles.Add(0 + FaceVertexOffset);
+        Triangles.Add(k + FaceVertexOffset);
+        Triangles.Add(k + 1 + FaceVertexOffset);
     }
     return Triangles;
 }
 
-void FCityGMLImporterModule::GenerateNormals(const TArray<FVector>& Vertices) {
+void FCityGMLImporterModule::GenerateNormals(const TArray<FVector>& Vertices, TArray<FVector>& OutNormals) {
         FVector Vertex1 = Vertices[0];
         FVector Vertex2 = Vertices[1];
         FVector Vertex3 = Vertices[2];
@@ -531,136 +1542,82 @@ void FCityGMLImporterModule::GenerateNormals(const TArray<FVector>& Vertices) {
         FVector FaceNormal = FVector::CrossProduct(Edge1, Edge2).GetSafeNormal();
 
         for (int32 i = 0; i < Vertices.Num(); ++i) {
-            Normalen.Add(FaceNormal);
+            OutNormals.Add(FaceNormal);
         }
 }
 
-void FCityGMLImporterModule::GenerateUVs(const TArray<FVector>& Vertices) {
-    for (int32 i2 = 0; i2 < Vertices.Num(); i2++) {
-
-        FVector Vertex = Vertices[i2];
-        FVector2D UV;
-
-        if (FMath::Abs(Vertex.Z) > FMath::Abs(Vertex.X) && FMath::Abs(Vertex.Z) > FMath::Abs(Vertex.Y)) {
-            // Projekt auf die Z-Ebene
-            UV.X = Vertex.X / Skalierung;
-            UV.Y = Vertex.Y / Skalierung;
-        }
-        else if (FMath::Abs(Vertex.X) > FMath::Abs(Vertex.Y)) {
-            // Projekt auf die X-Ebene
-            UV.X = Vertex.Y / Skalierung;
-            UV.Y = Vertex.Z / Skalierung;
-        }
-        else {
-            // Projekt auf die Y-Ebene
-            UV.X = Vertex.X / Skalierung;
-            UV.Y = Vertex.Z / Skalierung;
-        }
-        UVs.Add(UV);
-    }
+void FCityGMLImporterModule::GenerateUVs(TArrayView<const FVector> Vertices, TArray<FVector2D>& OutUVs) {
+    // Projektion auf die Ebene senkrecht zur betragsgrößten Koordinate, ohne Verzweigungen für vier Vertices gleichzeitig
+    const int32 Start = OutUVs.AddUninitialized(Vertices.Num());
+    CityGMLVertexKernels::BoxProjectUVs(Vertices, Skalierung, OutUVs.GetData() + Start);
 }
 
-void FCityGMLImporterModule::CreateMeshFromPolygon(TArray<TArray<TArray<FVector>>>& Buildings, TArray<TArray<TArray<int32>>>& Triangles, TArray<FString> BuildingIds) {
-    UWorld* World = GEditor->GetEditorWorldContext().World();
-
-    if (World) {
-        for (int32 i = 0; i < Buildings.Num(); ++i) { // Jedes Gebäude durchlaufen
-            const TArray<TArray<FVector>>& Building = Buildings[i];
-            const TArray<TArray<int32>>& BuildingTriangles = Triangles[i];
-            FString BuildingID = BuildingIds.IsValidIndex(i) ? BuildingIds[i] : FString::Printf(TEXT("Building_%d"), i);
-
-            AStaticMeshActor* MeshActor = World->SpawnActor<AStaticMeshActor>(AStaticMeshActor::StaticClass(), FTransform());
-            if (MeshActor) {
-                // Erstelle ein neues ProceduralMeshComponent für das Gebäude
-                UProceduralMeshComponent* ProceduralMesh = NewObject<UProceduralMeshComponent>(MeshActor);
-                MeshActor->SetRootComponent(ProceduralMesh);
-                ProceduralMesh->RegisterComponent();
-
-                // Für jeden Abschnitt des Gebäudes (jede Fläche/Wand)
-                for (int32 j = 0; j < Building.Num(); ++j) {
-                    const TArray<FVector>& Vertices = Building[j];
-                    const TArray<int32>& TrianglesArray = BuildingTriangles[j];
-
-                    ProceduralMesh->CreateMeshSection(j, Vertices, TrianglesArray, TArray<FVector>(), TArray<FVector2D>(), TArray<FColor>(), TArray<FProcMeshTangent>(), true);
+AActor* FCityGMLImporterModule::CreateMeshFromPolygon(UWorld* World, const FCityGMLGeometryStore& Geometry, int32 i) {
+    FString BuildingID = i < Geometry.Attributes.Num() ? FString(Geometry.Attributes.GetId(i)) : FString::Printf(TEXT("Building_%d"), i);
+
+    AStaticMeshActor* MeshActor = World->SpawnActor<AStaticMeshActor>(AStaticMeshActor::StaticClass(), FTransform());
+    if (MeshActor) {
+        // Erstelle ein neues ProceduralMeshComponent für das Gebäude
+        UProceduralMeshComponent* ProceduralMesh = NewObject<UProceduralMeshComponent>(MeshActor);
+        MeshActor->SetRootComponent(ProceduralMesh);
+        ProceduralMesh->RegisterComponent();
+
+        // Die Flächen des Gebäudes werden in eine Section bzw. eine Section pro Flächentyp zusammengefasst
+        struct FSection
+        {
+            TArray<FVector> Vertices;
+            TArray<int32> Triangles;
+            TArray<FVector> Normals;
+            TArray<FVector2D> UVs;
+            TArray<FProcMeshTangent> Tangents;
+            /** Vertex des Gebäudes -> Vertex der Section, verschweißte Vertices werden nur einmal übernommen */
+            TArray<int32> Remap;
+        };
+        FSection Sections[(int32)ECityGMLSurfaceType::Num];
+
+        const int32 VertexStart = Geometry.GetBuildingVertexStart(i);
+        const int32 NumBuildingVertices = Geometry.GetBuildingVertexEnd(i) - VertexStart;
+        for (int32 j = Geometry.GetFirstFace(i); j < Geometry.GetFaceEnd(i); ++j) {
+            FSection& Section = Sections[SectionPerSurfaceType ? (int32)Geometry.FaceSurfaceType[j] : 0];
+            if (Section.Remap.Num() == 0) {
+                Section.Remap.Init(INDEX_NONE, NumBuildingVertices);
+            }
+            for (int32 k = Geometry.FaceIndexStart[j]; k < Geometry.GetFaceIndexEnd(j); ++k) {
+                const int32 Vertex = Geometry.Indices[k];
+                int32& SectionVertex = Section.Remap[Vertex - VertexStart];
+                if (SectionVertex == INDEX_NONE) {
+                    SectionVertex = Section.Vertices.Add(Geometry.Positions[Vertex]);
+                    Section.Normals.Add(Geometry.Normals[Vertex]);
+                    Section.UVs.Add(Geometry.UVs[Vertex]);
+                    Section.Tangents.Add(Geometry.Tangents[Vertex]);
                 }
-                MeshActor->SetActorLabel(BuildingID);
+                Section.Triangles.Add(SectionVertex);
             }
+            FacesMeshed++;
         }
-    }
-}
 
-void FCityGMLImporterModule::GenerateTangents(const TArray<FVector>& Vertices, const TArray<int32> Triangles) {
-    FVector Tangent;
-    for (int32 i = 0; i < Triangles.Num(); i += 3) {
-        const FVector& v0 = Vertices[Triangles[i] - VertexOffset];
-        const FVector& v1 = Vertices[Triangles[i + 1] - VertexOffset];
-        const FVector& v2 = Vertices[Triangles[i + 2] - VertexOffset];
-
-        const FVector2D& uv0 = UVs[Triangles[i] - VertexOffset];
-        const FVector2D& uv1 = UVs[Triangles[i + 1] - VertexOffset];
-        const FVector2D& uv2 = UVs[Triangles[i + 2] - VertexOffset];
-
-        FVector Edge3 = v1 - v0;
-        FVector Edge4 = v2 - v0;
-        FVector2D UVEdge1 = uv1 - uv0;
-        FVector2D UVEdge2 = uv2 - uv0;
-
-        // Tangent calculation
-        float f = 1.0f / (UVEdge1.X * UVEdge2.Y - UVEdge2.X * UVEdge1.Y);
-        Tangent = f * (Edge3 * UVEdge2.Y - Edge4 * UVEdge1.Y);
-        Tangent.Normalize();
-
-    }
-
-    for (int32 i2 = 0; i2 < Vertices.Num(); i2++) {
-        Tangents.Add(FProcMeshTangent(Tangent, true));
-
-    }
-}
-
-TArray<FString> FCityGMLImporterModule::GetAdress(const FXmlNode* node) {
-    TArray<FString> AddressInfo;
-
-    const FXmlNode* AdressNode = node->FindChildNode(TEXT("core:Address"));
-    if (AdressNode) {
-        const FXmlNode* XalAdressNode = AdressNode->FindChildNode(TEXT("core:xalAddress"));
-        if (XalAdressNode) {
-            const FXmlNode* AddressDetailsNode = XalAdressNode->FindChildNode(TEXT("xAL:AddressDetails"));
-            if (AddressDetailsNode) {
-                const FXmlNode* CountryNode = AddressDetailsNode->FindChildNode(TEXT("xAL:Country"));
-                if (CountryNode) {
-                    const TArray<FXmlNode*>& CountryNodeChildren = CountryNode->GetChildrenNodes();
-                    for (const FXmlNode* LocalityNode : CountryNodeChildren) {
-                        if (LocalityNode->GetTag() == TEXT("xAL:Locality")) {
-                            const TArray<FXmlNode*>& Children = LocalityNode->GetChildrenNodes();
-                            for (const FXmlNode* AdressAndStreetNode : Children) {
-                                if (AdressAndStreetNode->GetTag() == TEXT("xAL:Thoroughfare")) {
-                                    const FXmlNode* ThoroughfareNodeAndStreet = AdressAndStreetNode->FindChildNode(TEXT("xAL:ThoroughfareName"));
-                                    if (ThoroughfareNodeAndStreet) {
-                                        // Strasse
-                                        AddressInfo.Add(ThoroughfareNodeAndStreet->GetContent());
-                                    }
-                                    const FXmlNode* ThoroughfareNodeAndNumber = AdressAndStreetNode->FindChildNode(TEXT("xAL:ThoroughfareNumber"));
-                                    if (ThoroughfareNodeAndNumber) {
-                                        // Hausnummer 
-                                        AddressInfo.Add(ThoroughfareNodeAndNumber->GetContent());
-                                    }
-                                }
-                                else if (AdressAndStreetNode->GetTag() == TEXT("xAL:PostalCode")) {
-                                    const FXmlNode* PostalCodeNode = AdressAndStreetNode->FindChildNode(TEXT("xAL:PostalCodeNumber"));
-                                    if (PostalCodeNode) {
-                                        // Postleitzahl
-                                        AddressInfo.Add(PostalCodeNode->GetContent());
-                                    }
-                                }
-                            }
-                        }
-                    }
-                }
+        int32 SectionIndex = 0;
+        for (FSection& Section : Sections) {
+            if (Section.Triangles.Num() > 0) {
+                ProceduralMesh->CreateMeshSection(SectionIndex++, Section.Vertices, Section.Triangles, Section.Normals, Section.UVs, TArray<FColor>(), Section.Tangents, true);
             }
         }
+        SectionsCreated += SectionIndex;
+        MeshActor->SetActorLabel(BuildingID);
+    }
+    return MeshActor;
+}
+
+void FCityGMLImporterModule::GenerateTangents(TArrayView<const FVector> Vertices, TArrayView<const int32> Triangles, int32 FaceVertexOffset, TArrayView<const FVector2D> FaceUVs, TArrayView<const FVector> FaceNormals, TArray<FProcMeshTangent>& OutTangents) {
+    // Jeder Vertex bekommt die Tangente seiner eigenen Dreiecke statt der des letzten Dreiecks der Fläche
+    TArray<FVector, TInlineAllocator<128>> Tangents;
+    Tangents.AddUninitialized(Vertices.Num());
+    CityGMLVertexKernels::ComputeTangents(Vertices, FaceUVs, FaceNormals, Triangles, FaceVertexOffset, Tangents.GetData());
+
+    OutTangents.Reserve(OutTangents.Num() + Tangents.Num());
+    for (const FVector& Tangent : Tangents) {
+        OutTangents.Add(FProcMeshTangent(Tangent, true));
     }
-    return AddressInfo;
 }
 
 #undef LOCTEXT_NAMESPACE
@@ -0,0 +1,131 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#include "CityGMLInstancing.h"
+#include "Async/ParallelFor.h"
+
+namespace
+{
+    /** Minimum der Bounding Box eines Gebäudes */
+    FVector GetBuildingOrigin(const FCityGMLGeometryStore& Geometry, int32 Building)
+    {
+        const int32 VertexStart = Geometry.GetBuildingVertexStart(Building);
+        const int32 VertexEnd = Geometry.GetBuildingVertexEnd(Building);
+        if (VertexStart >= VertexEnd) {
+            return FVector::ZeroVector;
+        }
+        FVector Origin = Geometry.Positions[VertexStart];
+        for (int32 v = VertexStart + 1; v < VertexEnd; ++v) {
+            Origin = Origin.ComponentMin(Geometry.Positions[v]);
+        }
+        return Origin;
+    }
+
+    FIntVector Quantize(const FVector& Value, float InvStep)
+    {
+        return FIntVector(FMath::RoundToInt(Value.X * InvStep), FMath::RoundToInt(Value.Y * InvStep), FMath::RoundToInt(Value.Z * InvStep));
+    }
+
+    /** Hash über Form und Topologie eines Gebäudes relativ zu seinem Ursprung */
+    uint32 HashBuilding(const FCityGMLGeometryStore& Geometry, int32 Building, const FVector& Origin, float InvTolerance)
+    {
+        const int32 VertexStart = Geometry.GetBuildingVertexStart(Building);
+        const int32 VertexEnd = Geometry.GetBuildingVertexEnd(Building);
+        const int32 IndexStart = Geometry.GetBuildingIndexStart(Building);
+        const int32 IndexEnd = Geometry.GetBuildingIndexEnd(Building);
+
+        uint32 Hash = GetTypeHash(VertexEnd - VertexStart);
+        Hash = HashCombine(Hash, GetTypeHash(IndexEnd - IndexStart));
+        for (int32 Face = Geometry.GetFirstFace(Building); Face < Geometry.GetFaceEnd(Building); ++Face) {
+            Hash = HashCombine(Hash, GetTypeHash(Geometry.FaceIndexStart[Face] - IndexStart));
+            Hash = HashCombine(Hash, GetTypeHash((uint8)Geometry.FaceSurfaceType[Face]));
+        }
+        for (int32 v = VertexStart; v < VertexEnd; ++v) {
+            Hash = HashCombine(Hash, GetTypeHash(Quantize(Geometry.Positions[v] - Origin, InvTolerance)));
+        }
+        for (int32 i = IndexStart; i < IndexEnd; ++i) {
+            Hash = HashCombine(Hash, GetTypeHash(Geometry.Indices[i] - VertexStart));
+        }
+        return Hash;
+    }
+
+    /** Genauer Vergleich zweier Gebäude mit gleichem Hash */
+    bool IsSameShape(const FCityGMLGeometryStore& Geometry, int32 A, const FVector& OriginA, int32 B, const FVector& OriginB, float Tolerance)
+    {
+        const int32 VertexStartA = Geometry.GetBuildingVertexStart(A);
+        const int32 VertexStartB = Geometry.GetBuildingVertexStart(B);
+        const int32 NumVertices = Geometry.GetBuildingVertexEnd(A) - VertexStartA;
+        const int32 IndexStartA = Geometry.GetBuildingIndexStart(A);
+        const int32 IndexStartB = Geometry.GetBuildingIndexStart(B);
+        const int32 NumIndices = Geometry.GetBuildingIndexEnd(A) - IndexStartA;
+        const int32 NumFaces = Geometry.GetFaceEnd(A) - Geometry.GetFirstFace(A);
+        if (NumVertices != Geometry.GetBuildingVertexEnd(B) - VertexStartB || NumIndices != Geometry.GetBuildingIndexEnd(B) - IndexStartB
+            || NumFaces != Geometry.GetFaceEnd(B) - Geometry.GetFirstFace(B)) {
+            return false;
+        }
+        for (int32 f = 0; f < NumFaces; ++f) {
+            const int32 FaceA = Geometry.GetFirstFace(A) + f;
+            const int32 FaceB = Geometry.GetFirstFace(B) + f;
+            if (Geometry.FaceSurfaceType[FaceA] != Geometry.FaceSurfaceType[FaceB]
+                || Geometry.FaceIndexStart[FaceA] - IndexStartA != Geometry.FaceIndexStart[FaceB] - IndexStartB) {
+                return false;
+            }
+        }
+        for (int32 i = 0; i < NumIndices; ++i) {
+            if (Geometry.Indices[IndexStartA + i] - VertexStartA != Geometry.Indices[IndexStartB + i] - VertexStartB) {
+                return false;
+            }
+        }
+        for (int32 v = 0; v < NumVertices; ++v) {
+            const FVector& PositionA = Geometry.Positions[VertexStartA + v];
+            const FVector& PositionB = Geometry.Positions[VertexStartB + v];
+            if (!(PositionA - OriginA).Equals(PositionB - OriginB, Tolerance) || !Geometry.Normals[VertexStartA + v].Equals(Geometry.Normals[VertexStartB + v], 1.e-3f)) {
+                return false;
+            }
+        }
+        return true;
+    }
+}
+
+void CityGMLInstancing::FindIdenticalBuildings(const FCityGMLGeometryStore& Geometry, float Tolerance, TArray<FCityGMLInstanceGroup>& OutGroups)
+{
+    OutGroups.Reset();
+    const int32 NumBuildings = Geometry.NumBuildings();
+    if (NumBuildings == 0 || Tolerance <= 0.0f) {
+        return;
+    }
+    const float InvTolerance = 1.0f / Tolerance;
+
+    // Ursprung und Hash sind pro Gebäude unabhängig
+    TArray<FVector> Origins;
+    TArray<uint32> Hashes;
+    Origins.SetNumUninitialized(NumBuildings);
+    Hashes.SetNumUninitialized(NumBuildings);
+    ParallelFor(NumBuildings, [&Geometry, &Origins, &Hashes, InvTolerance](int32 Building) {
+        Origins[Building] = GetBuildingOrigin(Geometry, Building);
+        Hashes[Building] = HashBuilding(Geometry, Building, Origins[Building], InvTolerance);
+    });
+
+    // Zuordnen in Reihenfolge des Speichers, damit das Ergebnis nicht von der Threadanzahl abhängt
+    TMultiMap<uint32, int32> GroupsByHash;
+    TArray<int32, TInlineAllocator<4>> Candidates;
+    for (int32 Building = 0; Building < NumBuildings; ++Building) {
+        Candidates.Reset();
+        GroupsByHash.MultiFind(Hashes[Building], Candidates, true);
+
+        int32 GroupIndex = INDEX_NONE;
+        for (int32 Candidate : Candidates) {
+            const FCityGMLInstanceGroup& Group = OutGroups[Candidate];
+            if (IsSameShape(Geometry, Group.Prototype, Group.Origins[0], Building, Origins[Building], Tolerance)) {
+                GroupIndex = Candidate;
+                break;
+            }
+        }
+        if (GroupIndex == INDEX_NONE) {
+            GroupIndex = OutGroups.AddDefaulted();
+            OutGroups[GroupIndex].Prototype = Building;
+            GroupsByHash.Add(Hashes[Building], GroupIndex);
+        }
+        OutGroups[GroupIndex].Buildings.Add(Building);
+        OutGroups[GroupIndex].Origins.Add(Origins[Building]);
+    }
+}
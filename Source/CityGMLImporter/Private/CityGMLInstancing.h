@@ -0,0 +1,34 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "CityGMLGeometryStore.h"
+
+/**
+ * Gebäude mit bis auf eine Verschiebung gleicher Geometrie, z.B. Reihenhäuser einer Siedlung.
+ * Alle Gebäude der Gruppe werden mit der Geometrie des Prototyps gezeichnet.
+ */
+struct FCityGMLInstanceGroup
+{
+	/** Das Gebäude, aus dem das gemeinsame Mesh erzeugt wird, gleich Buildings[0] */
+	int32 Prototype = INDEX_NONE;
+	/** Alle Gebäude der Gruppe in der Reihenfolge des Speichers */
+	TArray<int32> Buildings;
+	/** Ursprung jedes Gebäudes (Minimum seiner Bounding Box), die Geometrie ist relativ dazu gleich */
+	TArray<FVector> Origins;
+};
+
+namespace CityGMLInstancing
+{
+	/**
+	 * Fasst Gebäude zusammen, deren Geometrie relativ zu ihrem eigenen Ursprung gleich ist.
+	 * Verglichen werden Positionen und Normalen sowie Flächen, Flächentypen und Dreiecke. Die UVs werden
+	 * nicht verglichen, da sie aus der Weltposition berechnet sind.
+	 *
+	 * @param Geometry Der Speicher mit allen Gebäuden
+	 * @param Tolerance Rasterweite, auf die die relativen Positionen für den Vergleich gerundet werden
+	 * @param OutGroups Eine Gruppe pro eindeutiger Geometrie in der Reihenfolge ihres ersten Gebäudes
+	 */
+	void FindIdenticalBuildings(const FCityGMLGeometryStore& Geometry, float Tolerance, TArray<FCityGMLInstanceGroup>& OutGroups);
+}
@@ -0,0 +1,98 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#include "CityGMLPosList.h"
+#include "HAL/IConsoleManager.h"
+#include "Math/RandomStream.h"
+
+namespace
+{
+    /** Erzeugt posLists, wie sie in den Hamburger LoD2-Daten vorkommen: UTM32 mit drei Nachkommastellen */
+    TArray<FString> MakeBenchmarkPosLists(int32 Count)
+    {
+        FRandomStream Random(4711);
+        TArray<FString> PosLists;
+        PosLists.Reserve(Count);
+        for (int32 i = 0; i < Count; ++i) {
+            const double BaseX = Random.FRandRange(560000.0f, 570000.0f);
+            const double BaseY = Random.FRandRange(5930000.0f, 5940000.0f);
+            const int32 NumVertices = Random.RandRange(4, 40);
+            FString PosList;
+            for (int32 v = 0; v < NumVertices; ++v) {
+                PosList += FString::Printf(TEXT("%.3f %.3f %.3f "), BaseX + Random.FRandRange(0.0f, 30.0f), BaseY + Random.FRandRange(0.0f, 30.0f), Random.FRandRange(5.0f, 60.0f));
+            }
+            PosLists.Add(PosList.TrimEnd());
+        }
+        return PosLists;
+    }
+
+    /**
+     * Vergleicht den bisherigen Weg über ParseIntoArray und Atof mit CityGMLPosList::ParseVertices.
+     * Aufruf in der Konsole: CityGML.BenchmarkPosList [Anzahl posLists] [Durchläufe]
+     */
+    void BenchmarkPosList(const TArray<FString>& Args)
+    {
+        const int32 Count = Args.Num() > 0 ? FCString::Atoi(*Args[0]) : 10000;
+        const int32 Iterations = Args.Num() > 1 ? FCString::Atoi(*Args[1]) : 5;
+        const TArray<FString> PosLists = MakeBenchmarkPosLists(FMath::Max(Count, 1));
+
+        int64 TotalChars = 0;
+        for (const FString& PosList : PosLists) {
+            TotalChars += PosList.Len();
+        }
+        const double MegaBytes = double(TotalChars) * Iterations / (1024.0 * 1024.0);
+
+        // Bisheriger Weg: ein FString pro Koordinate
+        double Checksum = 0.0;
+        double Start = FPlatformTime::Seconds();
+        for (int32 Iteration = 0; Iteration < Iterations; ++Iteration) {
+            for (const FString& PosList : PosLists) {
+                TArray<FString> PosArray;
+                PosList.ParseIntoArray(PosArray, TEXT(" "), true);
+                TArray<FVector> Vertices;
+                for (int32 i = 0; i < PosArray.Num() - 2; i += 3) {
+                    Vertices.Add(FVector(FCString::Atof(*PosArray[i]), FCString::Atof(*PosArray[i + 1]), FCString::Atof(*PosArray[i + 2])));
+                }
+                Checksum += Vertices.Num();
+            }
+        }
+        const double OldSeconds = FPlatformTime::Seconds() - Start;
+
+        // Neuer Weg: direkt aus dem Zeichenpuffer
+        Start = FPlatformTime::Seconds();
+        for (int32 Iteration = 0; Iteration < Iterations; ++Iteration) {
+            for (const FString& PosList : PosLists) {
+                TArray<FVector> Vertices;
+                CityGMLPosList::ParseVertices(*PosList, *PosList + PosList.Len(), Vertices, [](double X, double Y, double Z) {
+                    return FVector(float(X), float(Y), float(Z));
+                });
+                Checksum -= Vertices.Num();
+            }
+        }
+        const double NewSeconds = FPlatformTime::Seconds() - Start;
+
+        // Abweichung der Ergebnisse prüfen
+        float MaxDifference = 0.0f;
+        for (const FString& PosList : PosLists) {
+            TArray<FString> PosArray;
+            PosList.ParseIntoArray(PosArray, TEXT(" "), true);
+            const TCHAR* Cursor = *PosList;
+            const TCHAR* End = Cursor + PosList.Len();
+            for (const FString& Token : PosArray) {
+                double Value = 0.0;
+                CityGMLPosList::ParseDouble(Cursor, End, Value);
+                MaxDifference = FMath::Max(MaxDifference, FMath::Abs(float(Value) - FCString::Atof(*Token)));
+            }
+        }
+
+        UE_LOG(LogTemp, Log, TEXT("PosList benchmark: %d posLists, %d iterations, %.2f MB"), PosLists.Num(), Iterations, MegaBytes);
+        UE_LOG(LogTemp, Log, TEXT("  ParseIntoArray + Atof: %.3f s (%.1f MB/s)"), OldSeconds, MegaBytes / FMath::Max(OldSeconds, 1e-9));
+        UE_LOG(LogTemp, Log, TEXT("  CityGMLPosList:        %.3f s (%.1f MB/s), %.1fx faster"), NewSeconds, MegaBytes / FMath::Max(NewSeconds, 1e-9), OldSeconds / FMath::Max(NewSeconds, 1e-9));
+        UE_LOG(LogTemp, Log, TEXT("  max difference %g, vertex count mismatch %g"), MaxDifference, Checksum);
+    }
+
+    FAutoConsoleCommand BenchmarkPosListCommand(
+        TEXT("CityGML.BenchmarkPosList"),
+        TEXT("Compares the posList parser with ParseIntoArray + Atof. Args: [PosListCount] [Iterations]"),
+        FConsoleCommandWithArgsDelegate::CreateStatic(&BenchmarkPosList)
+    );
+}
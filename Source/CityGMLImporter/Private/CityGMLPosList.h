@@ -0,0 +1,248 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+/**
+ * Zerlegt den Inhalt einer gml:posList ohne Zwischenstrings direkt aus dem Zeichenpuffer in Zahlen.
+ * Die Funktionen sind für TCHAR und für 8-Bit Zeichen (UTF-8) nutzbar.
+ *
+ * Für das übliche UTM-Format mit fester Nachkommazahl (z.B. "565123.456") werden die Ziffern
+ * blockweise per SWAR (mehrere Zeichen in einem 64-Bit Register) umgerechnet. Zahlen, die nicht
+ * exakt über den schnellen Weg darstellbar sind, werden über einen Stack-Puffer an Atod übergeben.
+ */
+namespace CityGMLPosList
+{
+	/** Exakt darstellbare Zehnerpotenzen für den schnellen Weg (Clinger) */
+	static constexpr double PowersOfTen[] = {
+		1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10,
+		1e11, 1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+	};
+
+	template<typename CharType>
+	FORCEINLINE bool IsSpace(CharType Char)
+	{
+		return Char == ' ' || Char == '\n' || Char == '\r' || Char == '\t';
+	}
+
+	template<typename CharType>
+	FORCEINLINE bool IsDigit(CharType Char)
+	{
+		return Char >= '0' && Char <= '9';
+	}
+
+	/**
+	 * Versucht einen Block von Ziffern auf einmal zu lesen.
+	 * Bei 8-Bit Zeichen sind es 8 Ziffern, bei 16-Bit Zeichen 4 Ziffern pro 64-Bit Wort.
+	 *
+	 * @param Cursor Position im Text, wird bei Erfolg hinter den Block verschoben
+	 * @param End Ende des Textes
+	 * @param Mantissa Bisher gelesener Wert, wird um den Block erweitert
+	 * @return Anzahl der gelesenen Ziffern, 0 wenn kein vollständiger Block vorliegt
+	 */
+	template<typename CharType>
+	FORCEINLINE int32 ParseDigitBlock(const CharType*& Cursor, const CharType* End, uint64& Mantissa)
+	{
+#if PLATFORM_LITTLE_ENDIAN
+		if (sizeof(CharType) == 1 && End - Cursor >= 8) {
+			uint64 Chunk;
+			FMemory::Memcpy(&Chunk, Cursor, 8);
+			// Jedes Byte muss zwischen '0' und '9' liegen
+			if (((Chunk & 0xF0F0F0F0F0F0F0F0ULL) | (((Chunk + 0x0606060606060606ULL) & 0xF0F0F0F0F0F0F0F0ULL) >> 4)) == 0x3333333333333333ULL) {
+				const uint64 Digits = Chunk - 0x3030303030303030ULL;
+				uint64 Value = (Digits * 10) + (Digits >> 8);
+				Value = (((Value & 0x000000FF000000FFULL) * (100 + (1000000ULL << 32))) + (((Value >> 16) & 0x000000FF000000FFULL) * (1 + (10000ULL << 32)))) >> 32;
+				Mantissa = Mantissa * 100000000ULL + (Value & 0xFFFFFFFFULL);
+				Cursor += 8;
+				return 8;
+			}
+		}
+		else if (sizeof(CharType) == 2 && End - Cursor >= 4) {
+			uint64 Chunk;
+			FMemory::Memcpy(&Chunk, Cursor, 8);
+			// Jedes 16-Bit Zeichen muss zwischen '0' und '9' liegen
+			if (((Chunk & 0xFFF0FFF0FFF0FFF0ULL) | (((Chunk + 0x0006000600060006ULL) & 0xFFF0FFF0FFF0FFF0ULL) >> 4)) == 0x0033003300330033ULL) {
+				const uint64 Digits = Chunk - 0x0030003000300030ULL;
+				uint64 Value = (Digits * 10) + (Digits >> 16);
+				Value = ((Value & 0x0000FFFF0000FFFFULL) * (1 + (100ULL << 32))) >> 32;
+				Mantissa = Mantissa * 10000ULL + (Value & 0xFFFFFFFFULL);
+				Cursor += 4;
+				return 4;
+			}
+		}
+#endif
+		return 0;
+	}
+
+	/**
+	 * Liest eine Dezimalzahl ab Cursor, führende Leerzeichen werden übersprungen.
+	 *
+	 * @param Cursor Position im Text, steht danach hinter der Zahl
+	 * @param End Ende des Textes
+	 * @param OutValue Die gelesene Zahl
+	 * @return false, wenn keine Zahl mehr gefunden wurde
+	 */
+	template<typename CharType>
+	bool ParseDouble(const CharType*& Cursor, const CharType* End, double& OutValue)
+	{
+		while (Cursor < End && IsSpace(*Cursor)) {
+			++Cursor;
+		}
+		if (Cursor >= End) {
+			return false;
+		}
+
+		const CharType* Start = Cursor;
+		bool bNegative = false;
+		if (*Cursor == '-' || *Cursor == '+') {
+			bNegative = *Cursor == '-';
+			++Cursor;
+		}
+
+		uint64 Mantissa = 0;
+		int32 Digits = 0;
+		int32 Exponent = 0;
+
+		// Vorkommastellen, bei mehr als 19 Ziffern könnte die Mantisse überlaufen
+		while (Digits <= 11) {
+			const int32 BlockDigits = ParseDigitBlock(Cursor, End, Mantissa);
+			if (BlockDigits == 0) {
+				break;
+			}
+			Digits += BlockDigits;
+		}
+		while (Cursor < End && IsDigit(*Cursor)) {
+			if (Digits < 19) {
+				Mantissa = Mantissa * 10 + (*Cursor - '0');
+			}
+			else {
+				++Exponent;
+			}
+			++Digits;
+			++Cursor;
+		}
+
+		// Nachkommastellen
+		if (Cursor < End && *Cursor == '.') {
+			++Cursor;
+			while (Digits <= 11) {
+				const int32 BlockDigits = ParseDigitBlock(Cursor, End, Mantissa);
+				if (BlockDigits == 0) {
+					break;
+				}
+				Digits += BlockDigits;
+				Exponent -= BlockDigits;
+			}
+			while (Cursor < End && IsDigit(*Cursor)) {
+				if (Digits < 19) {
+					Mantissa = Mantissa * 10 + (*Cursor - '0');
+					--Exponent;
+				}
+				++Digits;
+				++Cursor;
+			}
+		}
+
+		bool bExactFastPath = Digits > 0 && Digits <= 19;
+
+		// Exponent, z.B. 1.5e3
+		if (Cursor < End && (*Cursor == 'e' || *Cursor == 'E')) {
+			++Cursor;
+			bool bNegativeExponent = false;
+			if (Cursor < End && (*Cursor == '-' || *Cursor == '+')) {
+				bNegativeExponent = *Cursor == '-';
+				++Cursor;
+			}
+			int32 ExplicitExponent = 0;
+			while (Cursor < End && IsDigit(*Cursor)) {
+				ExplicitExponent = FMath::Min(ExplicitExponent * 10 + (*Cursor - '0'), 100000);
+				++Cursor;
+			}
+			Exponent += bNegativeExponent ? -ExplicitExponent : ExplicitExponent;
+		}
+
+		// Ungültige Zeichen bis zum nächsten Leerzeichen überspringen, wie Atof sie ignoriert
+		const CharType* TokenEnd = Cursor;
+		while (Cursor < End && !IsSpace(*Cursor)) {
+			++Cursor;
+		}
+
+		if (Digits == 0) {
+			OutValue = 0.0;
+			return true;
+		}
+
+		// Schneller Weg: Mantisse und Zehnerpotenz sind exakt als double darstellbar, das Ergebnis ist korrekt gerundet
+		if (bExactFastPath && Mantissa <= (1ULL << 53) && Exponent >= -22 && Exponent <= 22) {
+			const double Value = static_cast<double>(Mantissa);
+			OutValue = Exponent >= 0 ? Value * PowersOfTen[Exponent] : Value / PowersOfTen[-Exponent];
+			if (bNegative) {
+				OutValue = -OutValue;
+			}
+			return true;
+		}
+
+		// Langsamer Weg über einen Puffer auf dem Stack, ohne Heap-Allokation
+		ANSICHAR Buffer[128];
+		const int32 Length = FMath::Min<int32>(UE_ARRAY_COUNT(Buffer) - 1, static_cast<int32>(TokenEnd - Start));
+		for (int32 i = 0; i < Length; ++i) {
+			Buffer[i] = static_cast<ANSICHAR>(Start[i]);
+		}
+		Buffer[Length] = 0;
+		OutValue = FCStringAnsi::Atod(Buffer);
+		return true;
+	}
+
+	/**
+	 * Liest alle Koordinaten-Tripel einer posList, rechnet sie mit Transform um und hängt sie an OutVertices an.
+	 * Das Array wird vorab anhand der Textlänge reserviert, sodass höchstens eine Allokation entsteht.
+	 *
+	 * @param Begin Anfang des posList-Inhalts
+	 * @param End Ende des posList-Inhalts
+	 * @param OutVertices Array, an das die umgerechneten Vertices angehängt werden
+	 * @param Transform Wandelt X, Y, Z aus der Datei in einen FVector um
+	 * @return Anzahl der angehängten Vertices
+	 */
+	template<typename CharType, typename TransformType>
+	int32 ParseVertices(const CharType* Begin, const CharType* End, TArray<FVector>& OutVertices, TransformType&& Transform)
+	{
+		// Ein UTM-Tripel wie "565123.45 5933123.45 12.34 " ist selten kürzer als 16 Zeichen
+		OutVertices.Reserve(OutVertices.Num() + static_cast<int32>((End - Begin) / 16) + 1);
+
+		const int32 StartNum = OutVertices.Num();
+		const CharType* Cursor = Begin;
+		double X, Y, Z;
+		while (ParseDouble(Cursor, End, X) && ParseDouble(Cursor, End, Y) && ParseDouble(Cursor, End, Z)) {
+			OutVertices.Add(Transform(X, Y, Z));
+		}
+		return OutVertices.Num() - StartNum;
+	}
+
+	/**
+	 * Liest alle Koordinaten-Tripel einer posList ohne Umrechnung und hängt sie an OutCoordinates an,
+	 * drei Werte pro Vertex. Eine unvollständige letzte Koordinate wird verworfen.
+	 * So können die Vertices danach gemeinsam umgerechnet werden (CityGMLVertexKernels::TransformUtm).
+	 *
+	 * @param Begin Anfang des posList-Inhalts
+	 * @param End Ende des posList-Inhalts
+	 * @param OutCoordinates Array, an das X, Y, Z jedes Vertex angehängt werden
+	 * @return Anzahl der angehängten Vertices
+	 */
+	template<typename CharType, typename AllocatorType>
+	int32 ParseCoordinates(const CharType* Begin, const CharType* End, TArray<double, AllocatorType>& OutCoordinates)
+	{
+		// Wie bei ParseVertices: ein Tripel ist selten kürzer als 16 Zeichen, also etwa 5 Zeichen pro Zahl
+		OutCoordinates.Reserve(OutCoordinates.Num() + static_cast<int32>((End - Begin) / 5) + 3);
+
+		const int32 StartNum = OutCoordinates.Num();
+		const CharType* Cursor = Begin;
+		double X, Y, Z;
+		while (ParseDouble(Cursor, End, X) && ParseDouble(Cursor, End, Y) && ParseDouble(Cursor, End, Z)) {
+			OutCoordinates.Add(X);
+			OutCoordinates.Add(Y);
+			OutCoordinates.Add(Z);
+		}
+		return (OutCoordinates.Num() - StartNum) / 3;
+	}
+}
@@ -0,0 +1,525 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#include "CityGMLReader.h"
+#include "CityGMLPosList.h"
+#include "CityGMLStats.h"
+#include "HAL/PlatformFilemanager.h"
+#include "Misc/FileHelper.h"
+#include "ProfilingDebugging/ScopedTimers.h"
+
+#define LOCTEXT_NAMESPACE "FCityGMLImporterModule"
+
+void FCityGMLBuildingAssembler::OnFileLoaded(const ANSICHAR* InMappedText)
+{
+    MappedText = InMappedText;
+    if (OnLoaded) {
+        OnLoaded();
+    }
+}
+
+void FCityGMLBuildingAssembler::OnLoD(const FString& InLoD)
+{
+    LoD = InLoD;
+}
+
+void FCityGMLBuildingAssembler::OnEnvelope()
+{
+    bHasEnvelope = true;
+}
+
+void FCityGMLBuildingAssembler::OnBuildingBegin(const FString& BuildingId)
+{
+    Current.Reset();
+    Current.Id = BuildingId;
+    Current.Text = MappedText;
+}
+
+void FCityGMLBuildingAssembler::OnSurfaceBegin(ECityGMLSurfaceType SurfaceType)
+{
+    FCityGMLSurface& Surface = Current.Surfaces.AddDefaulted_GetRef();
+    Surface.Type = SurfaceType;
+}
+
+void FCityGMLBuildingAssembler::OnSurfaceMember()
+{
+    if (Current.Surfaces.Num() > 0) {
+        FCityGMLSurface& Surface = Current.Surfaces.Last();
+        Surface.PosLists.AddDefaulted();
+        Surface.InteriorStart.Add(Surface.Interiors.Num());
+    }
+}
+
+void FCityGMLBuildingAssembler::OnPosList(FAnsiStringView PosList)
+{
+    if (Current.Surfaces.Num() > 0 && Current.Surfaces.Last().PosLists.Num() > 0) {
+        Current.Surfaces.Last().PosLists.Last() = MakeRange(PosList);
+    }
+}
+
+void FCityGMLBuildingAssembler::OnInteriorPosList(FAnsiStringView PosList)
+{
+    if (Current.Surfaces.Num() > 0 && Current.Surfaces.Last().PosLists.Num() > 0) {
+        Current.Surfaces.Last().Interiors.Add(MakeRange(PosList));
+    }
+}
+
+FCityGMLTextRange FCityGMLBuildingAssembler::MakeRange(FAnsiStringView PosList)
+{
+    FCityGMLTextRange Range;
+    Range.Length = PosList.Len();
+    if (MappedText) {
+        Range.Offset = PosList.GetData() - MappedText;
+    }
+    else {
+        // Der Block wird gleich wiederverwendet, nur der Inhalt der posList wird kopiert
+        Range.Offset = Current.OwnedText.Num();
+        Current.OwnedText.Append(PosList.GetData(), PosList.Len());
+    }
+    return Range;
+}
+
+void FCityGMLBuildingAssembler::OnAddress(const FCityGMLAddress& Address)
+{
+    Current.Address = Address;
+}
+
+void FCityGMLBuildingAssembler::OnMeasuredHeight(float Height)
+{
+    Current.MeasuredHeight = Height;
+}
+
+void FCityGMLBuildingAssembler::OnBuildingSkipped()
+{
+    Current.Reset();
+}
+
+void FCityGMLBuildingAssembler::OnBuildingEnd()
+{
+    if (OnBuilding) {
+        OnBuilding(MoveTemp(Current));
+    }
+    Current.Reset();
+}
+
+bool FCityGMLRegion::Parse(const FString& Text, FCityGMLRegion& OutRegion)
+{
+    OutRegion = FCityGMLRegion();
+    TArray<FString> Tokens;
+    Text.ParseIntoArrayWS(Tokens, TEXT(","));
+    if (Tokens.Num() == 0) {
+        return true;
+    }
+    TArray<double> Values;
+    for (const FString& Token : Tokens) {
+        if (!Token.IsNumeric()) {
+            return false;
+        }
+        Values.Add(FCString::Atod(*Token));
+    }
+
+    if (Values.Num() == 4) {
+        OutRegion.MinX = FMath::Min(Values[0], Values[2]);
+        OutRegion.MinY = FMath::Min(Values[1], Values[3]);
+        OutRegion.MaxX = FMath::Max(Values[0], Values[2]);
+        OutRegion.MaxY = FMath::Max(Values[1], Values[3]);
+    }
+    else if (Values.Num() >= 6 && Values.Num() % 2 == 0) {
+        OutRegion.Polygon = Values;
+        OutRegion.MinX = OutRegion.MaxX = Values[0];
+        OutRegion.MinY = OutRegion.MaxY = Values[1];
+        for (int32 i = 2; i < Values.Num(); i += 2) {
+            OutRegion.MinX = FMath::Min(OutRegion.MinX, Values[i]);
+            OutRegion.MaxX = FMath::Max(OutRegion.MaxX, Values[i]);
+            OutRegion.MinY = FMath::Min(OutRegion.MinY, Values[i + 1]);
+            OutRegion.MaxY = FMath::Max(OutRegion.MaxY, Values[i + 1]);
+        }
+    }
+    else {
+        return false;
+    }
+    OutRegion.bIsSet = true;
+    return true;
+}
+
+bool FCityGMLRegion::Contains(double X, double Y) const
+{
+    if (!bIsSet) {
+        return true;
+    }
+    if (X < MinX || X > MaxX || Y < MinY || Y > MaxY) {
+        return false;
+    }
+    if (Polygon.Num() == 0) {
+        return true;
+    }
+    // Gerade-Ungerade-Regel, die Kanten werden in double gerechnet
+    bool bInside = false;
+    const int32 NumPoints = Polygon.Num() / 2;
+    for (int32 i = 0, j = NumPoints - 1; i < NumPoints; j = i++) {
+        const double XI = Polygon[2 * i];
+        const double YI = Polygon[2 * i + 1];
+        const double XJ = Polygon[2 * j];
+        const double YJ = Polygon[2 * j + 1];
+        if ((YI > Y) != (YJ > Y) && X < (XJ - XI) * (Y - YI) / (YJ - YI) + XI) {
+            bInside = !bInside;
+        }
+    }
+    return bInside;
+}
+
+FCityGMLReader::FCityGMLReader(ICityGMLReaderListener& InListener)
+    : Listener(InListener)
+{}
+
+const ANSICHAR* FCityGMLReader::MapFile(const FString& FilePath, int64& OutSize)
+{
+    MappedFile.Reset(FPlatformFileManager::Get().GetPlatformFile().OpenMapped(*FilePath));
+    if (MappedFile && MappedFile->GetFileSize() > 0) {
+        MappedRegion.Reset(MappedFile->MapRegion(0, MappedFile->GetFileSize()));
+    }
+    if (!MappedRegion) {
+        MappedFile.Reset();
+        return nullptr;
+    }
+
+    const uint8* Bytes = MappedRegion->GetMappedPtr();
+    OutSize = MappedRegion->GetMappedSize();
+    if (OutSize >= 2 && ((Bytes[0] == 0xFF && Bytes[1] == 0xFE) || (Bytes[0] == 0xFE && Bytes[1] == 0xFF))) {
+        // UTF-16 wie bisher über LoadFileToString lesen und einmal nach UTF-8 umwandeln
+        MappedRegion.Reset();
+        MappedFile.Reset();
+        FString Contents;
+        if (!FFileHelper::LoadFileToString(Contents, *FilePath)) {
+            return nullptr;
+        }
+        FTCHARToUTF8 Converter(*Contents, Contents.Len());
+        ConvertedText.SetNumUninitialized(Converter.Length());
+        FMemory::Memcpy(ConvertedText.GetData(), Converter.Get(), Converter.Length());
+        OutSize = ConvertedText.Num();
+        return ConvertedText.GetData();
+    }
+    MappedBytes = OutSize;
+    return reinterpret_cast<const ANSICHAR*>(Bytes);
+}
+
+bool FCityGMLReader::ReadSource(const FCityGMLSource& Source, FText& OutError)
+{
+    Stack.Reset();
+    Tags.Reset();
+    LoDPaths = nullptr;
+    Matcher.Compile(CityGMLTagPaths::GetUndecided());
+    LoD.Reset();
+    bRootHasChild = false;
+    PendingIdName = PendingIdValue = FAnsiStringView();
+    bBuildingDecided = false;
+    bSkippingBuilding = false;
+    NumSkippedBuildings = 0;
+    bUnsupportedLoD = false;
+    bCancelled = false;
+    AbortReason = FText::GetEmpty();
+    LoadSeconds = 0.0;
+    // Views in die vorherige Eingabe werden ungültig
+    MappedRegion.Reset();
+    MappedFile.Reset();
+    ConvertedText.Empty();
+    MappedBytes = 0;
+    MaxCarryBytes = 0;
+
+    const double LoadStart = FPlatformTime::Seconds();
+    const FString FilePath = Source.GetDisplayPath();
+    FCityGMLXmlTokenizer Tokenizer(*this);
+    bool bParsed = false;
+
+    // Unkomprimierte Dateien werden gemappt und ohne Kopie direkt geparst
+    const ANSICHAR* Text = nullptr;
+    int64 TextSize = 0;
+    if (Source.Compression == ECityGMLCompression::None && Source.Error.IsEmpty()) {
+        CITYGML_SCOPE_CYCLE_COUNTER(STAT_CityGML_ReadFile);
+        Text = MapFile(Source.FilePath, TextSize);
+    }
+
+    if (Text) {
+        LoadSeconds = FPlatformTime::Seconds() - LoadStart;
+        Listener.OnFileLoaded(Text);
+        CITYGML_SCOPE_CYCLE_COUNTER(STAT_CityGML_ParseXml);
+        bParsed = Tokenizer.Parse(Text, TextSize);
+    }
+    else {
+        // Komprimierte Eingaben und Dateien, die sich nicht mappen lassen, werden blockweise gelesen und geparst
+        Listener.OnFileLoaded(nullptr);
+        double ParseSeconds = 0.0;
+        bool bLoaded = false;
+        {
+            CITYGML_SCOPE_CYCLE_COUNTER(STAT_CityGML_ReadFile);
+            bLoaded = CityGMLArchive::ReadSource(Source, [&Tokenizer, &ParseSeconds](const uint8* Data, int32 Size) {
+                CITYGML_SCOPE_CYCLE_COUNTER(STAT_CityGML_ParseXml);
+                FScopedDurationTimer Timer(ParseSeconds);
+                return Tokenizer.Feed(Data, Size);
+            }, OutError, CancelFlag);
+        }
+        LoadSeconds = FPlatformTime::Seconds() - LoadStart - ParseSeconds;
+        MaxCarryBytes = Tokenizer.GetMaxCarryBytes();
+        if (bLoaded) {
+            CITYGML_SCOPE_CYCLE_COUNTER(STAT_CityGML_ParseXml);
+            bParsed = Tokenizer.Finish();
+        }
+        else if (!Tokenizer.HasFailed() && AbortReason.IsEmpty() && !bUnsupportedLoD) {
+            // Lesefehler oder Abbruch während des Entpackens
+            bCancelled = CancelFlag && *CancelFlag;
+            return false;
+        }
+    }
+
+    if (!AbortReason.IsEmpty()) {
+        OutError = AbortReason;
+        return false;
+    }
+    if (!bParsed || bUnsupportedLoD) {
+        if (Text && Tokenizer.GetErrorOffset() >= 0) {
+            // Die Zeile wird nur im Fehlerfall gezählt
+            int32 ErrorLine = 1;
+            for (int64 i = 0; i < FMath::Min(Tokenizer.GetErrorOffset(), TextSize); ++i) {
+                ErrorLine += Text[i] == '\n' ? 1 : 0;
+            }
+            OutError = FText::Format(LOCTEXT("ParserFailure", "Failed to load XML file: {0} ({1}, line {2})"), FText::FromString(FilePath), Tokenizer.GetError(), ErrorLine);
+        }
+        else {
+            OutError = FText::Format(LOCTEXT("ParserFailureOffset", "Failed to load XML file: {0} ({1}, byte {2})"), FText::FromString(FilePath), Tokenizer.GetError(), Tokenizer.GetErrorOffset());
+        }
+        return false;
+    }
+    if (LoD.IsEmpty()) {
+        OutError = FText::Format(LOCTEXT("NoContent", "The file lacks Content: {0}"), FText::FromString(FilePath));
+        return false;
+    }
+    return true;
+}
+
+bool FCityGMLReader::ProcessAttribute(FAnsiStringView AttributeName, FAnsiStringView AttributeValue)
+{
+    // Attribute kommen vor ihrem Element, Namespace-Deklarationen gelten damit schon für dessen Namen
+    if (AttributeName.Len() >= 5 && FCStringAnsi::Strncmp(AttributeName.GetData(), "xmlns", 5) == 0) {
+        if (AttributeName.Len() == 5) {
+            Tags.DeclareNamespace(FAnsiStringView(), AttributeValue, Stack.Num());
+        }
+        else if (AttributeName[5] == ':') {
+            Tags.DeclareNamespace(AttributeName.Mid(6), AttributeValue, Stack.Num());
+        }
+        return true;
+    }
+    // Das id-Attribut wird erst mit dem Element aufgelöst, es könnte vor der Deklaration seines Präfix stehen
+    if (CityGMLXml::Equals(AttributeName.Right(2), "id")) {
+        PendingIdName = AttributeName;
+        PendingIdValue = AttributeValue;
+    }
+    return true;
+}
+
+void FCityGMLReader::SetLoD(const FCityGMLLoDPaths& Paths)
+{
+    LoDPaths = &Paths;
+    LoD = Paths.LoD;
+    Matcher.Compile(Paths);
+    Listener.OnLoD(LoD);
+}
+
+bool FCityGMLReader::DecideBuilding(double X, double Y)
+{
+    bBuildingDecided = true;
+    if (Region->Contains(X, Y)) {
+        return true;
+    }
+    bSkippingBuilding = true;
+    NumSkippedBuildings++;
+    Listener.OnBuildingSkipped();
+    return false;
+}
+
+bool FCityGMLReader::ProcessElement(FAnsiStringView ElementName, FAnsiStringView ElementData)
+{
+    if (CancelFlag && *CancelFlag) {
+        bCancelled = true;
+        AbortReason = LOCTEXT("Cancelled", "The import was cancelled");
+        return false;
+    }
+
+    // Im übersprungenen Gebäude werden die Tags nicht mehr aufgelöst
+    const ECityGMLNode Parent = Stack.Num() > 0 ? Stack.Last() : ECityGMLNode::Other;
+    const ECityGMLTag Tag = bSkippingBuilding ? ECityGMLTag::Unknown : Tags.Resolve(ElementName);
+    const ECityGMLNode Node = Classify(Parent, Tag, ElementData);
+    PendingIdName = PendingIdValue = FAnsiStringView();
+    if (!AbortReason.IsEmpty() || bUnsupportedLoD) {
+        return false;
+    }
+    Stack.Add(Node);
+    return true;
+}
+
+ECityGMLNode FCityGMLReader::Classify(ECityGMLNode Parent, ECityGMLTag Tag, FAnsiStringView ElementData)
+{
+    // Zahlen werden wie die posLists direkt aus dem UTF-8 Text gelesen
+    auto ParseXY = [ElementData](double& OutX, double& OutY) {
+        const ANSICHAR* Cursor = ElementData.GetData();
+        const ANSICHAR* End = Cursor + ElementData.Len();
+        OutX = OutY = 0.0;
+        if (CityGMLPosList::ParseDouble(Cursor, End, OutX)) {
+            CityGMLPosList::ParseDouble(Cursor, End, OutY);
+        }
+    };
+
+    if (bSkippingBuilding) {
+        // Der Rest des Gebäudes wird nur noch vom Tokenizer überlesen
+        return ECityGMLNode::Other;
+    }
+
+    if (Stack.Num() == 0) {
+        // Überprüfen, ob es sich um eine CityGML-Datei handelt, der Präfix spielt keine Rolle
+        if (Tag != ECityGMLTag::CityModel) {
+            AbortReason = LOCTEXT("NotCityGML", "The File does not appear to be in CityGML format");
+        }
+        return ECityGMLNode::Root;
+    }
+
+    if (Parent == ECityGMLNode::Root && !bRootHasChild) {
+        bRootHasChild = true;
+        // Das LoD steht in den ersten vier Zeichen des ersten Kindknotens, sonst legt es die erste Geometrie fest
+        const FString Name = CityGMLXml::ToString(ElementData.Left(4));
+        if (Name.StartsWith(TEXT("LoD"))) {
+            if (const FCityGMLLoDPaths* Paths = CityGMLTagPaths::FindLoD(Name)) {
+                SetLoD(*Paths);
+            }
+            else {
+                bUnsupportedLoD = true;
+                return ECityGMLNode::Other;
+            }
+        }
+    }
+
+    const ECityGMLNode Node = Matcher.Match(Parent, Tag);
+    switch (Node) {
+    case ECityGMLNode::RootEnvelope:
+        Listener.OnEnvelope();
+        break;
+
+    case ECityGMLNode::Building:
+        Listener.OnBuildingBegin(PendingIdName.Len() > 0 && Tags.Resolve(PendingIdName) == ECityGMLTag::Id ? CityGMLXml::ToString(PendingIdValue) : FString());
+        bBuildingDecided = !Region || !Region->bIsSet;
+        EnvelopeCorners = 0;
+        break;
+    case ECityGMLNode::BuildingBoundedBy:
+        return bBuildingDecided ? ECityGMLNode::Other : Node;
+    case ECityGMLNode::LowerCorner:
+        ParseXY(EnvelopeLower[0], EnvelopeLower[1]);
+        EnvelopeCorners++;
+        break;
+    case ECityGMLNode::UpperCorner:
+        ParseXY(EnvelopeUpper[0], EnvelopeUpper[1]);
+        EnvelopeCorners++;
+        break;
+
+    case ECityGMLNode::Lod1Solid:
+    case ECityGMLNode::MultiSurfaceProperty:
+        if (!LoDPaths) {
+            SetLoD(*CityGMLTagPaths::FindLoDByGeometry(Tag));
+        }
+        if (Node == ECityGMLNode::Lod1Solid) {
+            Listener.OnSurfaceBegin(ECityGMLSurfaceType::Other);
+        }
+        break;
+    case ECityGMLNode::BoundedBy:
+        Listener.OnBoundedByBegin();
+        break;
+    case ECityGMLNode::Surface:
+        Listener.OnSurfaceBegin(CityGMLTagPaths::GetSurfaceType(Tag));
+        break;
+    case ECityGMLNode::SurfaceMember:
+        Listener.OnSurfaceMember();
+        break;
+    case ECityGMLNode::PosList:
+        if (!bBuildingDecided) {
+            // Ohne Envelope entscheidet der erste Punkt der ersten posList
+            double X, Y;
+            ParseXY(X, Y);
+            if (!DecideBuilding(X, Y)) {
+                return ECityGMLNode::Other;
+            }
+        }
+        Listener.OnPosList(ElementData);
+        break;
+    case ECityGMLNode::InteriorPosList:
+        // Die äußere posList derselben Fläche hat schon über den Bereich entschieden
+        Listener.OnInteriorPosList(ElementData);
+        break;
+
+    case ECityGMLNode::Address:
+        AddressInfo.Reset();
+        break;
+    case ECityGMLNode::ThoroughfareName:
+        AddressInfo.Street = CityGMLXml::ToString(ElementData);
+        break;
+    case ECityGMLNode::ThoroughfareNumber:
+        AddressInfo.Number = CityGMLXml::ToString(ElementData);
+        break;
+    case ECityGMLNode::PostalCodeNumber:
+        AddressInfo.PostalCode = CityGMLXml::ToString(ElementData);
+        break;
+    case ECityGMLNode::MeasuredHeight: {
+        // Die Einheit (uom) ist bei den Hamburger Daten immer Meter
+        const ANSICHAR* Cursor = ElementData.GetData();
+        double Height = 0.0;
+        if (CityGMLPosList::ParseDouble(Cursor, Cursor + ElementData.Len(), Height)) {
+            Listener.OnMeasuredHeight(float(Height));
+        }
+        break;
+    }
+
+    default:
+        break;
+    }
+    return Node;
+}
+
+bool FCityGMLReader::ProcessClose(FAnsiStringView Element)
+{
+    if (Stack.Num() == 0) {
+        return true;
+    }
+    Tags.EndScope(Stack.Num() - 1);
+
+    if (bSkippingBuilding) {
+        // Bis zum Ende des übersprungenen Gebäudes keine Ereignisse mehr
+        if (Stack.Last() == ECityGMLNode::Building) {
+            bSkippingBuilding = false;
+        }
+        Stack.Pop(false);
+        return true;
+    }
+
+    switch (Stack.Last()) {
+    case ECityGMLNode::Building:
+        Listener.OnBuildingEnd();
+        break;
+    case ECityGMLNode::BuildingEnvelope:
+        if (!bBuildingDecided && EnvelopeCorners >= 2) {
+            DecideBuilding((EnvelopeLower[0] + EnvelopeUpper[0]) * 0.5, (EnvelopeLower[1] + EnvelopeUpper[1]) * 0.5);
+        }
+        break;
+    case ECityGMLNode::BoundedBy:
+        Listener.OnBoundedByEnd();
+        break;
+    case ECityGMLNode::Surface:
+    case ECityGMLNode::Lod1Solid:
+        Listener.OnSurfaceEnd();
+        break;
+    case ECityGMLNode::Address:
+        Listener.OnAddress(AddressInfo);
+        break;
+    default:
+        break;
+    }
+
+    Stack.Pop(false);
+    return true;
+}
+
+#undef LOCTEXT_NAMESPACE
@@ -0,0 +1,302 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "HAL/ThreadSafeBool.h"
+#include "Async/MappedFileHandle.h"
+#include "CityGMLArchive.h"
+#include "CityGMLXmlTokenizer.h"
+#include "CityGMLTagPaths.h"
+
+/** Bereich eines posList-Inhalts im UTF-8 Text, auf den ein FCityGMLBuilding verweist */
+struct FCityGMLTextRange
+{
+	int64 Offset = 0;
+	int32 Length = 0;
+};
+
+/**
+ * Eine Begrenzungsfläche eines Gebäudes (Dach, Wand, Boden) mit den posList-Inhalten ihrer surfaceMember.
+ * Bei LoD1 bildet der lod1Solid selbst die einzige Fläche des Gebäudes.
+ */
+struct FCityGMLSurface
+{
+	/** Dach, Wand oder Boden aus dem Tag der Fläche, Other beim lod1Solid */
+	ECityGMLSurfaceType Type = ECityGMLSurfaceType::Other;
+	/** Ein Eintrag pro surfaceMember, leer wenn der surfaceMember kein Polygon enthält */
+	TArray<FCityGMLTextRange> PosLists;
+	/** posLists der gml:interior Ringe (Innenhöfe, Öffnungen) aller surfaceMember hintereinander */
+	TArray<FCityGMLTextRange> Interiors;
+	/** Ein Eintrag pro surfaceMember: sein erster Ring in Interiors */
+	TArray<int32> InteriorStart;
+
+	/** Die inneren Ringe eines surfaceMembers */
+	TArrayView<const FCityGMLTextRange> GetInteriors(int32 Member) const
+	{
+		const int32 End = Member + 1 < InteriorStart.Num() ? InteriorStart[Member + 1] : Interiors.Num();
+		return MakeArrayView(Interiors.GetData() + InteriorStart[Member], End - InteriorStart[Member]);
+	}
+};
+
+/**
+ * Alle Daten eines einzelnen Gebäudes, wie sie vom FCityGMLReader gelesen werden.
+ * Es wird immer nur ein Gebäude gleichzeitig im Speicher gehalten.
+ *
+ * Die posLists werden nicht kopiert, solange die Datei gemappt ist: sie verweisen dann in den Text der Datei,
+ * der bis zum Ende des FCityGMLReader gültig bleibt. Nur bei blockweise gelesenen Eingaben liegt der Text in OwnedText.
+ */
+struct FCityGMLBuilding
+{
+	FString Id;
+	/** Straße, Hausnummer und Postleitzahl, soweit vorhanden */
+	FCityGMLAddress Address;
+	/** bldg:measuredHeight in Metern oder FCityGMLAttributeStore::NoHeight */
+	float MeasuredHeight = FCityGMLAttributeStore::NoHeight;
+	TArray<FCityGMLSurface> Surfaces;
+	/** Text der gemappten Datei, nullptr bei blockweise gelesenen Eingaben */
+	const ANSICHAR* Text = nullptr;
+	/** Kopie der posLists, wenn die Eingabe blockweise gelesen wurde */
+	TArray<ANSICHAR> OwnedText;
+
+	/** Inhalt einer gml:posList als UTF-8 */
+	FAnsiStringView GetPosList(const FCityGMLTextRange& Range) const
+	{
+		const ANSICHAR* Base = OwnedText.Num() > 0 ? OwnedText.GetData() : Text;
+		return Base ? FAnsiStringView(Base + Range.Offset, Range.Length) : FAnsiStringView();
+	}
+
+	void Reset()
+	{
+		Id.Reset();
+		Address.Reset();
+		MeasuredHeight = FCityGMLAttributeStore::NoHeight;
+		Surfaces.Reset();
+		Text = nullptr;
+		OwnedText.Reset();
+	}
+};
+
+/**
+ * Auswahlbereich für den Import in den Koordinaten der Datei (bei Dateien mit gml:Envelope UTM),
+ * entweder ein Rechteck oder ein Polygon. Ein Gebäude gehört dazu, wenn sein Bezugspunkt im Bereich liegt.
+ */
+struct FCityGMLRegion
+{
+	double MinX = 0.0;
+	double MinY = 0.0;
+	double MaxX = 0.0;
+	double MaxY = 0.0;
+	/** Eckpunkte X, Y, X, Y, ... des Polygons, leer bei einem Rechteck */
+	TArray<double> Polygon;
+	bool bIsSet = false;
+
+	/**
+	 * Liest einen Bereich aus Text: vier Zahlen "MinX,MinY,MaxX,MaxY" für ein Rechteck
+	 * oder mindestens drei Punkte "X Y, X Y, X Y, ..." für ein Polygon.
+	 *
+	 * @param Text Der Bereich, leer für keinen Bereich
+	 * @param OutRegion Der gelesene Bereich
+	 * @return false, wenn der Text nicht gelesen werden konnte
+	 */
+	static bool Parse(const FString& Text, FCityGMLRegion& OutRegion);
+
+	/** true, wenn der Punkt im Bereich liegt oder kein Bereich gesetzt ist */
+	bool Contains(double X, double Y) const;
+	/** Mittelpunkt des umschließenden Rechtecks */
+	FVector GetCenter() const { return FVector(float((MinX + MaxX) * 0.5), float((MinY + MaxY) * 0.5), 0.0f); }
+};
+
+/**
+ * Empfänger der Ereignisse, die der FCityGMLReader beim Durchlaufen einer Datei auslöst.
+ * Die Ereignisse kommen in Dokumentreihenfolge, ein Gebäude ist mit OnBuildingEnd abgeschlossen.
+ */
+class ICityGMLReaderListener
+{
+public:
+	virtual ~ICityGMLReaderListener() {}
+
+	/**
+	 * Die Eingabe ist geöffnet, danach beginnt das Parsen.
+	 *
+	 * @param MappedText Anfang der gemappten Datei. Alle Views der folgenden Ereignisse zeigen in diesen Text und bleiben
+	 *                   bis zum Ende des Readers gültig. nullptr, wenn die Eingabe blockweise gelesen wird, die Views
+	 *                   gelten dann nur während des jeweiligen Ereignisses.
+	 */
+	virtual void OnFileLoaded(const ANSICHAR* MappedText) {}
+	/** Das LoD der Datei steht fest, aus dem Namen der Datei oder spätestens mit der ersten Geometrie-Eigenschaft */
+	virtual void OnLoD(const FString& LoD) {}
+	/** Die Datei besitzt einen gml:Envelope */
+	virtual void OnEnvelope() {}
+	virtual void OnBuildingBegin(const FString& BuildingId) {}
+	virtual void OnBoundedByBegin() {}
+	virtual void OnSurfaceBegin(ECityGMLSurfaceType SurfaceType) {}
+	virtual void OnSurfaceMember() {}
+	/** Inhalt der gml:posList des äußeren Rings des aktuellen surfaceMembers als UTF-8 */
+	virtual void OnPosList(FAnsiStringView PosList) {}
+	/** Inhalt der gml:posList eines inneren Rings des aktuellen surfaceMembers, kommt nach seinem OnPosList */
+	virtual void OnInteriorPosList(FAnsiStringView PosList) {}
+	virtual void OnSurfaceEnd() {}
+	virtual void OnBoundedByEnd() {}
+	virtual void OnAddress(const FCityGMLAddress& Address) {}
+	/** Inhalt der bldg:measuredHeight des aktuellen Gebäudes in Metern */
+	virtual void OnMeasuredHeight(float Height) {}
+	virtual void OnBuildingEnd() {}
+	/** Das aktuelle Gebäude liegt außerhalb des Auswahlbereichs, für es kommt kein OnBuildingEnd */
+	virtual void OnBuildingSkipped() {}
+};
+
+/**
+ * Setzt die Ereignisse des Readers zu einem FCityGMLBuilding zusammen
+ * und übergibt jedes fertige Gebäude sofort an OnBuilding.
+ */
+class FCityGMLBuildingAssembler : public ICityGMLReaderListener
+{
+public:
+	/** Wird für jedes vollständig gelesene Gebäude aufgerufen, das Gebäude kann übernommen werden */
+	TFunction<void(FCityGMLBuilding&&)> OnBuilding;
+	/** Wird aufgerufen, sobald die Datei geladen ist und das Parsen beginnt */
+	TFunction<void()> OnLoaded;
+
+	const FString& GetLoD() const { return LoD; }
+	bool HasEnvelope() const { return bHasEnvelope; }
+
+	virtual void OnFileLoaded(const ANSICHAR* InMappedText) override;
+	virtual void OnLoD(const FString& InLoD) override;
+	virtual void OnEnvelope() override;
+	virtual void OnBuildingBegin(const FString& BuildingId) override;
+	virtual void OnSurfaceBegin(ECityGMLSurfaceType SurfaceType) override;
+	virtual void OnSurfaceMember() override;
+	virtual void OnPosList(FAnsiStringView PosList) override;
+	virtual void OnInteriorPosList(FAnsiStringView PosList) override;
+	virtual void OnAddress(const FCityGMLAddress& Address) override;
+	virtual void OnMeasuredHeight(float Height) override;
+	virtual void OnBuildingEnd() override;
+	virtual void OnBuildingSkipped() override;
+
+private:
+	/** Bereich einer posList im gemappten Text, bei blockweise gelesenen Eingaben wird sie nach OwnedText kopiert */
+	FCityGMLTextRange MakeRange(FAnsiStringView PosList);
+
+	FCityGMLBuilding Current;
+	const ANSICHAR* MappedText = nullptr;
+	FString LoD;
+	bool bHasEnvelope = false;
+};
+
+/**
+ * Liest eine CityGML-Datei vorwärts mit dem FCityGMLXmlTokenizer, ohne einen DOM-Baum aufzubauen.
+ * Jedes Tag wird über seinen Namespace zu einem ECityGMLTag aufgelöst, die Bedeutung des Elements ergibt sich dann
+ * aus den Pfaden des LoD (CityGMLTagPaths) mit einem Tabellenzugriff. Die Ereignisse gehen direkt an den Listener.
+ *
+ * Unkomprimierte Dateien werden gemappt und als UTF-8 direkt im Seitencache geparst, statt sie als UTF-16 FString
+ * zu laden. Tags und posLists werden als Views an den Listener gegeben und erst dort bei Bedarf umgewandelt.
+ */
+class FCityGMLReader : private ICityGMLXmlCallback
+{
+public:
+	explicit FCityGMLReader(ICityGMLReaderListener& InListener);
+
+	/**
+	 * Liest eine Eingabe ein und löst dabei die Ereignisse aus.
+	 * Komprimierte Eingaben (.gml.gz, Zip-Einträge) werden dabei mit CityGMLArchive blockweise entpackt und geparst.
+	 * Eine gemappte Datei bleibt bis zum nächsten Aufruf oder bis zum Ende des Readers gemappt.
+	 *
+	 * @param Source Die Datei oder der Eintrag eines Zip-Archivs
+	 * @param OutError Fehlermeldung, falls die Eingabe nicht gelesen werden konnte
+	 * @return true, wenn die Eingabe vollständig gelesen wurde
+	 */
+	bool ReadSource(const FCityGMLSource& Source, FText& OutError);
+	/**
+	 * Setzt ein Flag, das während des Parsens abgefragt wird. Wird es gesetzt, bricht ReadSource beim nächsten Element ab.
+	 *
+	 * @param InCancelFlag Flag eines anderen Threads, muss bis zum Ende von ReadSource gültig bleiben
+	 */
+	void SetCancelFlag(const FThreadSafeBool* InCancelFlag) { CancelFlag = InCancelFlag; }
+	/**
+	 * Setzt einen Auswahlbereich. Pro Gebäude wird anhand des Mittelpunkts seines gml:Envelope oder,
+	 * falls es keinen hat, des ersten Punkts seiner ersten posList entschieden, ob es gelesen wird.
+	 * Übersprungene Gebäude werden nicht an den Listener gemeldet, ihre posLists werden weder kopiert noch geparst.
+	 *
+	 * @param InRegion Der Bereich, muss bis zum Ende von ReadSource gültig bleiben, nullptr für alle Gebäude
+	 */
+	void SetRegion(const FCityGMLRegion* InRegion) { Region = InRegion; }
+	/** Anzahl der Gebäude, die außerhalb des Auswahlbereichs lagen */
+	int32 GetNumSkippedBuildings() const { return NumSkippedBuildings; }
+
+	/** true, wenn die Datei ein nicht unterstütztes LoD enthält */
+	bool IsUnsupportedLoD() const { return bUnsupportedLoD; }
+	/** true, wenn das Lesen über das Cancel-Flag abgebrochen wurde */
+	bool IsCancelled() const { return bCancelled; }
+	/** Zeit in Sekunden, die das Laden der Datei von der Festplatte und das Entpacken gedauert hat */
+	double GetLoadSeconds() const { return LoadSeconds; }
+	/** Größe der gemappten Datei, 0 wenn die Eingabe blockweise gelesen wurde */
+	int64 GetMappedBytes() const { return MappedBytes; }
+	/** Beim blockweisen Lesen das größte Token, das über eine Blockgrenze umkopiert wurde */
+	int32 GetMaxCarryBytes() const { return MaxCarryBytes; }
+
+private:
+	// ICityGMLXmlCallback
+	virtual bool ProcessElement(FAnsiStringView ElementName, FAnsiStringView ElementData) override;
+	virtual bool ProcessAttribute(FAnsiStringView AttributeName, FAnsiStringView AttributeValue) override;
+	virtual bool ProcessClose(FAnsiStringView Element) override;
+
+	/** Bestimmt die Bedeutung eines neuen Elements anhand seines Elternelements und löst die Ereignisse aus */
+	ECityGMLNode Classify(ECityGMLNode Parent, ECityGMLTag Tag, FAnsiStringView ElementData);
+	/** Legt das LoD der Datei fest und übersetzt seine Pfade */
+	void SetLoD(const FCityGMLLoDPaths& Paths);
+	/**
+	 * Mappt eine unkomprimierte Datei. UTF-16 Dateien werden stattdessen einmal nach UTF-8 umgewandelt.
+	 *
+	 * @return Der Text, nullptr wenn die Datei nicht gemappt werden konnte
+	 */
+	const ANSICHAR* MapFile(const FString& FilePath, int64& OutSize);
+	/**
+	 * Entscheidet anhand eines Bezugspunkts, ob das aktuelle Gebäude gelesen wird.
+	 *
+	 * @return false, wenn das Gebäude übersprungen wird
+	 */
+	bool DecideBuilding(double X, double Y);
+
+	ICityGMLReaderListener& Listener;
+
+	TArray<ECityGMLNode> Stack;
+	FCityGMLTagTable Tags;
+	/** Übergangstabelle aus den Pfaden des aktuellen LoD */
+	FCityGMLPathMatcher Matcher;
+	/** Pfade des LoD der Datei, nullptr solange es noch nicht feststeht */
+	const FCityGMLLoDPaths* LoDPaths = nullptr;
+	FString LoD;
+	/** Das erste Kind der Wurzel wurde gelesen, sein Text enthält bei den Hamburger Daten das LoD */
+	bool bRootHasChild = false;
+
+	/** Name und Wert eines id-Attributs des nächsten Elements, gültig bis zu seinem ProcessElement */
+	FAnsiStringView PendingIdName;
+	FAnsiStringView PendingIdValue;
+
+	const FCityGMLRegion* Region = nullptr;
+	/** Für das aktuelle Gebäude wurde bereits entschieden, ob es im Bereich liegt */
+	bool bBuildingDecided = false;
+	/** Das aktuelle Gebäude liegt außerhalb, alle Elemente bis zu seinem Ende werden ignoriert */
+	bool bSkippingBuilding = false;
+	/** Ecken des gml:Envelope des aktuellen Gebäudes, X und Y */
+	double EnvelopeLower[2] = { 0.0, 0.0 };
+	double EnvelopeUpper[2] = { 0.0, 0.0 };
+	int32 EnvelopeCorners = 0;
+	int32 NumSkippedBuildings = 0;
+
+	FCityGMLAddress AddressInfo;
+
+	bool bUnsupportedLoD = false;
+	bool bCancelled = false;
+	const FThreadSafeBool* CancelFlag = nullptr;
+	FText AbortReason;
+	double LoadSeconds = 0.0;
+
+	TUniquePtr<IMappedFileHandle> MappedFile;
+	TUniquePtr<IMappedFileRegion> MappedRegion;
+	/** Text einer UTF-16 Datei nach der Umwandlung in UTF-8 */
+	TArray<ANSICHAR> ConvertedText;
+	int64 MappedBytes = 0;
+	int32 MaxCarryBytes = 0;
+};
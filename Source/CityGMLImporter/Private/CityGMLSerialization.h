@@ -0,0 +1,29 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Serialization/Archive.h"
+
+/** Gemeinsame Hilfsfunktionen für die Binärformate des Geometrie-Caches und der Sachdaten */
+namespace CityGMLSerialization
+{
+	/**
+	 * Ein Array als ein Block, ohne jedes Element einzeln zu serialisieren.
+	 * Beim Laden wird eine Länge abgelehnt, die über das Ende des Archivs hinausgeht, das Archiv bekommt dann einen Fehler.
+	 */
+	template<typename T>
+	void SerializeBulk(FArchive& Ar, TArray<T>& Array)
+	{
+		int32 Num = Array.Num();
+		Ar << Num;
+		if (Ar.IsLoading()) {
+			if (Num < 0 || int64(Num) * int64(sizeof(T)) > Ar.TotalSize() - Ar.Tell()) {
+				Ar.SetError();
+				return;
+			}
+			Array.SetNumUninitialized(Num);
+		}
+		Ar.Serialize(Array.GetData(), int64(Num) * sizeof(T));
+	}
+}
@@ -0,0 +1,350 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#include "CityGMLStaticMesh.h"
+#include "Engine/StaticMesh.h"
+#include "Materials/Material.h"
+#include "MeshDescription.h"
+#include "StaticMeshAttributes.h"
+#include "AssetRegistryModule.h"
+#include "AssetToolsModule.h"
+#include "ObjectTools.h"
+#include "UObject/Package.h"
+
+namespace
+{
+    /** Name des Material-Slots einer Fläche, ohne SectionPerSurfaceType gibt es nur einen */
+    FName GetSlotName(ECityGMLSurfaceType SurfaceType, bool bSectionPerSurfaceType)
+    {
+        if (!bSectionPerSurfaceType) {
+            return TEXT("Building");
+        }
+        switch (SurfaceType) {
+        case ECityGMLSurfaceType::Roof:
+            return TEXT("Roof");
+        case ECityGMLSurfaceType::Wall:
+            return TEXT("Wall");
+        case ECityGMLSurfaceType::Ground:
+            return TEXT("Ground");
+        default:
+            return TEXT("Other");
+        }
+    }
+
+    /** Schreibt Vertices und Dreiecke in eine Mesh Description, eine Polygon-Gruppe pro Material-Slot */
+    class FMeshDescriptionWriter
+    {
+    public:
+        explicit FMeshDescriptionWriter(FMeshDescription& InMeshDescription)
+            : MeshDescription(InMeshDescription)
+            , Attributes(InMeshDescription)
+        {
+            Attributes.Register();
+            VertexPositions = Attributes.GetVertexPositions();
+            VertexNormals = Attributes.GetVertexInstanceNormals();
+            VertexTangents = Attributes.GetVertexInstanceTangents();
+            BinormalSigns = Attributes.GetVertexInstanceBinormalSigns();
+            VertexUVs = Attributes.GetVertexInstanceUVs();
+            SlotNames = Attributes.GetPolygonGroupMaterialSlotNames();
+        }
+
+        void Reserve(int32 NumVertices, int32 NumTriangles)
+        {
+            MeshDescription.ReserveNewVertices(NumVertices);
+            MeshDescription.ReserveNewVertexInstances(NumVertices);
+            MeshDescription.ReserveNewTriangles(NumTriangles);
+        }
+
+        FVertexInstanceID AddVertex(const FVector& Position, const FVector& Normal, const FProcMeshTangent& Tangent, const FVector2D& UV)
+        {
+            const FVertexID Vertex = MeshDescription.CreateVertex();
+            VertexPositions[Vertex] = Position;
+            const FVertexInstanceID Instance = MeshDescription.CreateVertexInstance(Vertex);
+            VertexNormals[Instance] = Normal;
+            VertexTangents[Instance] = Tangent.TangentX;
+            BinormalSigns[Instance] = Tangent.bFlipTangentY ? -1.0f : 1.0f;
+            VertexUVs.Set(Instance, 0, UV);
+            return Instance;
+        }
+
+        /** Gruppe zu einem Slot, neue Gruppen in der Reihenfolge ihres ersten Auftretens */
+        FPolygonGroupID GetGroup(FName SlotName)
+        {
+            if (const FPolygonGroupID* Group = Groups.Find(SlotName)) {
+                return *Group;
+            }
+            const FPolygonGroupID Group = MeshDescription.CreatePolygonGroup();
+            SlotNames[Group] = SlotName;
+            SlotOrder.Add(SlotName);
+            return Groups.Add(SlotName, Group);
+        }
+
+        void AddTriangle(FPolygonGroupID Group, FVertexInstanceID A, FVertexInstanceID B, FVertexInstanceID C)
+        {
+            const FVertexInstanceID Triangle[3] = { A, B, C };
+            MeshDescription.CreateTriangle(Group, MakeArrayView(Triangle, 3));
+        }
+
+        /** Wie AddTriangle, die Reihenfolge wird so gewählt, dass die Vorderseite in Richtung Normal zeigt */
+        void AddFacingTriangle(FPolygonGroupID Group, FVertexInstanceID A, FVertexInstanceID B, FVertexInstanceID C, const FVector& Normal)
+        {
+            const FVector PA = GetPosition(A);
+            const FVector PB = GetPosition(B);
+            const FVector PC = GetPosition(C);
+            // Gleiche Konvention wie bei der Berechnung der Flächennormalen im Static Mesh Build
+            if (FVector::DotProduct(FVector::CrossProduct(PC - PA, PB - PA), Normal) < 0.0f) {
+                Swap(B, C);
+            }
+            AddTriangle(Group, A, B, C);
+        }
+
+        const TArray<FName>& GetSlotOrder() const { return SlotOrder; }
+
+    private:
+        FVector GetPosition(FVertexInstanceID Instance) const
+        {
+            return VertexPositions[MeshDescription.GetVertexInstanceVertex(Instance)];
+        }
+
+        FMeshDescription& MeshDescription;
+        FStaticMeshAttributes Attributes;
+        TVertexAttributesRef<FVector> VertexPositions;
+        TVertexInstanceAttributesRef<FVector> VertexNormals;
+        TVertexInstanceAttributesRef<FVector> VertexTangents;
+        TVertexInstanceAttributesRef<float> BinormalSigns;
+        TVertexInstanceAttributesRef<FVector2D> VertexUVs;
+        TPolygonGroupAttributesRef<FName> SlotNames;
+        TMap<FName, FPolygonGroupID> Groups;
+        TArray<FName> SlotOrder;
+    };
+
+    /** Übernimmt die triangulierte Geometrie der Gebäude unverändert */
+    void WriteBuildings(FMeshDescriptionWriter& Writer, const FCityGMLGeometryStore& Geometry, int32 FirstBuilding, int32 BuildingEnd, const FVector& Pivot, bool bSectionPerSurfaceType)
+    {
+        const int32 VertexStart = Geometry.GetBuildingVertexStart(FirstBuilding);
+        const int32 VertexEnd = Geometry.GetBuildingVertexEnd(BuildingEnd - 1);
+        const int32 NumTriangles = (Geometry.GetBuildingIndexEnd(BuildingEnd - 1) - Geometry.GetBuildingIndexStart(FirstBuilding)) / 3;
+
+        // Ein Vertex und eine Vertex-Instanz pro Vertex des Speichers, die Attribute sind bereits pro Vertex berechnet
+        Writer.Reserve(VertexEnd - VertexStart, NumTriangles);
+        TArray<FVertexInstanceID> Instances;
+        Instances.Reserve(VertexEnd - VertexStart);
+        for (int32 v = VertexStart; v < VertexEnd; ++v) {
+            Instances.Add(Writer.AddVertex(Geometry.Positions[v] - Pivot, Geometry.Normals[v], Geometry.Tangents[v], Geometry.UVs[v]));
+        }
+
+        for (int32 Face = Geometry.GetFirstFace(FirstBuilding); Face < Geometry.GetFaceEnd(BuildingEnd - 1); ++Face) {
+            const FPolygonGroupID Group = Writer.GetGroup(GetSlotName(Geometry.FaceSurfaceType[Face], bSectionPerSurfaceType));
+            for (int32 i = Geometry.FaceIndexStart[Face]; i + 2 < Geometry.GetFaceIndexEnd(Face); i += 3) {
+                Writer.AddTriangle(Group, Instances[Geometry.Indices[i] - VertexStart], Instances[Geometry.Indices[i + 1] - VertexStart], Instances[Geometry.Indices[i + 2] - VertexStart]);
+            }
+        }
+    }
+
+    /** Konvexe Hülle in der Grundebene (Monotone Chain), gegen den Uhrzeigersinn ohne doppelten Endpunkt */
+    void ComputeConvexHull(TArray<FVector2D>& Points, TArray<FVector2D>& OutHull)
+    {
+        OutHull.Reset();
+        Points.Sort([](const FVector2D& A, const FVector2D& B) {
+            return A.X != B.X ? A.X < B.X : A.Y < B.Y;
+        });
+        if (Points.Num() < 3) {
+            return;
+        }
+        auto Cross = [](const FVector2D& O, const FVector2D& A, const FVector2D& B) {
+            return (A.X - O.X) * (B.Y - O.Y) - (A.Y - O.Y) * (B.X - O.X);
+        };
+        OutHull.SetNumUninitialized(Points.Num() * 2);
+        int32 Count = 0;
+        for (int32 i = 0; i < Points.Num(); ++i) {
+            while (Count >= 2 && Cross(OutHull[Count - 2], OutHull[Count - 1], Points[i]) <= 0.0f) {
+                Count--;
+            }
+            OutHull[Count++] = Points[i];
+        }
+        for (int32 i = Points.Num() - 2, Lower = Count + 1; i >= 0; --i) {
+            while (Count >= Lower && Cross(OutHull[Count - 2], OutHull[Count - 1], Points[i]) <= 0.0f) {
+                Count--;
+            }
+            OutHull[Count++] = Points[i];
+        }
+        OutHull.SetNum(FMath::Max(0, Count - 1));
+    }
+
+    /**
+     * Ersetzt jedes LoD2/LoD3-Gebäude durch einen Block aus seinem Grundriss (konvexe Hülle aller Vertices),
+     * der vom tiefsten Punkt bis zur mittleren Dachhöhe reicht. LoD1-Gebäude sind bereits Blöcke und werden übernommen.
+     */
+    void WriteFootprintProxies(FMeshDescriptionWriter& Writer, const FCityGMLGeometryStore& Geometry, int32 FirstBuilding, int32 BuildingEnd, const FVector& Pivot,
+        bool bSectionPerSurfaceType, float UVScale)
+    {
+        const FName RoofSlot = GetSlotName(ECityGMLSurfaceType::Roof, bSectionPerSurfaceType);
+        const FName WallSlot = GetSlotName(ECityGMLSurfaceType::Wall, bSectionPerSurfaceType);
+        TArray<FVector2D> Points;
+        TArray<FVector2D> Hull;
+        TArray<FVertexInstanceID> Top;
+
+        for (int32 Building = FirstBuilding; Building < BuildingEnd; ++Building) {
+            const int32 FirstFace = Geometry.GetFirstFace(Building);
+            const int32 FaceEnd = Geometry.GetFaceEnd(Building);
+            bool bHasSurfaceTypes = false;
+            for (int32 Face = FirstFace; Face < FaceEnd; ++Face) {
+                bHasSurfaceTypes |= Geometry.FaceSurfaceType[Face] != ECityGMLSurfaceType::Other;
+            }
+            if (!bHasSurfaceTypes) {
+                if (FirstFace < FaceEnd) {
+                    WriteBuildings(Writer, Geometry, Building, Building + 1, Pivot, bSectionPerSurfaceType);
+                }
+                continue;
+            }
+
+            const int32 VertexStart = Geometry.GetBuildingVertexStart(Building);
+            const int32 VertexEnd = Geometry.GetBuildingVertexEnd(Building);
+            float MinZ = MAX_flt;
+            float MaxZ = -MAX_flt;
+            Points.Reset();
+            for (int32 v = VertexStart; v < VertexEnd; ++v) {
+                const FVector Position = Geometry.Positions[v] - Pivot;
+                Points.Add(FVector2D(Position));
+                MinZ = FMath::Min(MinZ, Position.Z);
+                MaxZ = FMath::Max(MaxZ, Position.Z);
+            }
+            // Mittlere Dachhöhe, damit Giebeldächer von weitem nicht zu hoch wirken
+            double RoofZ = 0.0;
+            int32 NumRoofVertices = 0;
+            for (int32 Face = FirstFace; Face < FaceEnd; ++Face) {
+                if (Geometry.FaceSurfaceType[Face] == ECityGMLSurfaceType::Roof) {
+                    for (int32 i = Geometry.FaceIndexStart[Face]; i < Geometry.GetFaceIndexEnd(Face); ++i) {
+                        RoofZ += Geometry.Positions[Geometry.Indices[i]].Z - Pivot.Z;
+                        NumRoofVertices++;
+                    }
+                }
+            }
+            const float TopZ = NumRoofVertices > 0 ? float(RoofZ / NumRoofVertices) : MaxZ;
+
+            ComputeConvexHull(Points, Hull);
+            if (Hull.Num() < 3 || TopZ <= MinZ) {
+                continue;
+            }
+
+            // Dach als Fächer über die konvexe Hülle
+            const FPolygonGroupID RoofGroup = Writer.GetGroup(RoofSlot);
+            const FProcMeshTangent RoofTangent(FVector(1.0f, 0.0f, 0.0f), false);
+            Top.Reset();
+            for (const FVector2D& Point : Hull) {
+                Top.Add(Writer.AddVertex(FVector(Point, TopZ), FVector::UpVector, RoofTangent, (Point + FVector2D(Pivot)) / UVScale));
+            }
+            for (int32 i = 1; i + 1 < Top.Num(); ++i) {
+                Writer.AddFacingTriangle(RoofGroup, Top[0], Top[i], Top[i + 1], FVector::UpVector);
+            }
+
+            // Eine Wand pro Kante, mit eigenen Vertices für harte Kanten
+            const FPolygonGroupID WallGroup = Writer.GetGroup(WallSlot);
+            for (int32 i = 0; i < Hull.Num(); ++i) {
+                const FVector2D& A = Hull[i];
+                const FVector2D& B = Hull[(i + 1) % Hull.Num()];
+                const FVector2D Edge = B - A;
+                const float Length = Edge.Size();
+                if (Length <= KINDA_SMALL_NUMBER) {
+                    continue;
+                }
+                // Die Hülle läuft gegen den Uhrzeigersinn, außen liegt rechts der Kante
+                const FVector Normal(Edge.Y / Length, -Edge.X / Length, 0.0f);
+                const FProcMeshTangent Tangent(FVector(Edge.X / Length, Edge.Y / Length, 0.0f), false);
+                // U läuft entlang der Kante, V ist die Höhe
+                const FVertexInstanceID A0 = Writer.AddVertex(FVector(A, MinZ), Normal, Tangent, FVector2D(0.0f, MinZ + Pivot.Z) / UVScale);
+                const FVertexInstanceID B0 = Writer.AddVertex(FVector(B, MinZ), Normal, Tangent, FVector2D(Length, MinZ + Pivot.Z) / UVScale);
+                const FVertexInstanceID B1 = Writer.AddVertex(FVector(B, TopZ), Normal, Tangent, FVector2D(Length, TopZ + Pivot.Z) / UVScale);
+                const FVertexInstanceID A1 = Writer.AddVertex(FVector(A, TopZ), Normal, Tangent, FVector2D(0.0f, TopZ + Pivot.Z) / UVScale);
+                Writer.AddFacingTriangle(WallGroup, A0, B0, B1, Normal);
+                Writer.AddFacingTriangle(WallGroup, A0, B1, A1, Normal);
+            }
+        }
+    }
+}
+
+UStaticMesh* CityGMLStaticMesh::CreateStaticMesh(const FCityGMLGeometryStore& Geometry, int32 FirstBuilding, int32 BuildingEnd, const FVector& Pivot,
+    const FString& PackagePath, const FString& AssetName, bool bSectionPerSurfaceType, const FCityGMLMeshLODSettings* LODSettings)
+{
+    if (FirstBuilding >= BuildingEnd || Geometry.GetBuildingIndexStart(FirstBuilding) >= Geometry.GetBuildingIndexEnd(BuildingEnd - 1)) {
+        return nullptr;
+    }
+
+    FMeshDescription MeshDescription;
+    FMeshDescriptionWriter Writer(MeshDescription);
+    WriteBuildings(Writer, Geometry, FirstBuilding, BuildingEnd, Pivot, bSectionPerSurfaceType);
+    TArray<FName> SlotOrder = Writer.GetSlotOrder();
+
+    // Eindeutiger Name, ein erneuter Import überschreibt keine vorhandenen Assets
+    FString PackageName;
+    FString UniqueAssetName;
+    const FString BaseName = FPaths::Combine(PackagePath, ObjectTools::SanitizeObjectName(AssetName));
+    FAssetToolsModule::GetModule().Get().CreateUniqueAssetName(BaseName, FString(), PackageName, UniqueAssetName);
+    UPackage* Package = CreatePackage(*PackageName);
+
+    UStaticMesh* StaticMesh = NewObject<UStaticMesh>(Package, *UniqueAssetName, RF_Public | RF_Standalone | RF_Transactional);
+
+    FStaticMeshSourceModel& SourceModel = StaticMesh->AddSourceModel();
+    // Normalen und Tangenten kommen aus der Triangulierung
+    SourceModel.BuildSettings.bRecomputeNormals = false;
+    SourceModel.BuildSettings.bRecomputeTangents = false;
+    FMeshDescription* Description = StaticMesh->CreateMeshDescription(0);
+    *Description = MoveTemp(MeshDescription);
+    StaticMesh->CommitMeshDescription(0);
+
+    if (LODSettings) {
+        StaticMesh->bAutoComputeLODScreenSize = false;
+        SourceModel.ScreenSize = 1.0f;
+
+        // Vereinfachte LODs werden beim Build aus LOD 0 reduziert
+        const int32 NumReduced = FMath::Min(LODSettings->ScreenSizes.Num(), LODSettings->TrianglePercents.Num());
+        for (int32 LOD = 0; LOD < NumReduced; ++LOD) {
+            FStaticMeshSourceModel& ReducedModel = StaticMesh->AddSourceModel();
+            ReducedModel.BuildSettings = SourceModel.BuildSettings;
+            ReducedModel.ReductionSettings.PercentTriangles = LODSettings->TrianglePercents[LOD];
+            ReducedModel.ScreenSize = LODSettings->ScreenSizes[LOD];
+        }
+
+        if (LODSettings->bFootprintProxy) {
+            FMeshDescription ProxyDescription;
+            FMeshDescriptionWriter ProxyWriter(ProxyDescription);
+            WriteFootprintProxies(ProxyWriter, Geometry, FirstBuilding, BuildingEnd, Pivot, bSectionPerSurfaceType, LODSettings->UVScale);
+            if (ProxyDescription.Triangles().Num() > 0) {
+                for (const FName& SlotName : ProxyWriter.GetSlotOrder()) {
+                    SlotOrder.AddUnique(SlotName);
+                }
+                FStaticMeshSourceModel& ProxyModel = StaticMesh->AddSourceModel();
+                ProxyModel.BuildSettings = SourceModel.BuildSettings;
+                ProxyModel.ScreenSize = LODSettings->ProxyScreenSize;
+                const int32 ProxyLOD = StaticMesh->GetNumSourceModels() - 1;
+                *StaticMesh->CreateMeshDescription(ProxyLOD) = MoveTemp(ProxyDescription);
+                StaticMesh->CommitMeshDescription(ProxyLOD);
+            }
+        }
+    }
+
+    for (const FName& SlotName : SlotOrder) {
+        StaticMesh->GetStaticMaterials().Add(FStaticMaterial(UMaterial::GetDefaultMaterial(MD_Surface), SlotName, SlotName));
+    }
+    return StaticMesh;
+}
+
+void CityGMLStaticMesh::BuildStaticMeshes(const TArray<UStaticMesh*>& StaticMeshes)
+{
+    if (StaticMeshes.Num() == 0) {
+        return;
+    }
+    // Ein gemeinsamer Build verteilt die Assets auf alle Kerne
+    UStaticMesh::BatchBuild(StaticMeshes, true);
+    for (UStaticMesh* StaticMesh : StaticMeshes) {
+        StaticMesh->MarkPackageDirty();
+        FAssetRegistryModule::AssetCreated(StaticMesh);
+    }
+}
+
+void CityGMLStaticMesh::DiscardStaticMesh(UStaticMesh* StaticMesh)
+{
+    FAssetRegistryModule::AssetDeleted(StaticMesh);
+    StaticMesh->ClearFlags(RF_Public | RF_Standalone);
+    StaticMesh->GetOutermost()->SetDirtyFlag(false);
+    StaticMesh->MarkPendingKill();
+}
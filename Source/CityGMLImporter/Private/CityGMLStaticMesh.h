@@ -0,0 +1,63 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "CityGMLGeometryStore.h"
+
+class UStaticMesh;
+
+/** Einstellungen für die Render-LODs eines Assets */
+struct FCityGMLMeshLODSettings
+{
+	/** Bildschirmgröße, ab der das jeweilige vereinfachte LOD verwendet wird, absteigend */
+	TArray<float> ScreenSizes;
+	/** Anteil der Dreiecke von LOD 0 pro vereinfachtem LOD, zwischen 0 und 1 */
+	TArray<float> TrianglePercents;
+	/** Als letztes LOD LoD2/LoD3-Gebäude durch ihren hochgezogenen Grundriss ersetzen */
+	bool bFootprintProxy = true;
+	/** Bildschirmgröße, ab der der Grundriss-Block verwendet wird */
+	float ProxyScreenSize = 0.02f;
+	/** Teiler für die UVs des Grundriss-Blocks, entspricht der Skalierung des Imports */
+	float UVScale = 1.0f;
+};
+
+/**
+ * Erzeugt aus dem Geometrie-Speicher echte UStaticMesh-Assets statt ProceduralMeshComponents.
+ * Die Assets werden im Content Browser angelegt und mit dem Level gespeichert, sodass beim Laden
+ * nichts neu aufgebaut werden muss, und sie können Mesh-LODs, Distance Fields und Instancing verwenden.
+ */
+namespace CityGMLStaticMesh
+{
+	/**
+	 * Legt ein neues Asset mit den Gebäuden [FirstBuilding, BuildingEnd) an und übergibt die Geometrie
+	 * als Mesh Description. Gebaut wird das Asset erst mit BuildStaticMeshes, damit mehrere Assets
+	 * gemeinsam gebaut werden können.
+	 *
+	 * @param Geometry Der Speicher mit den Gebäuden
+	 * @param FirstBuilding Erstes Gebäude des Assets
+	 * @param BuildingEnd Erstes Gebäude, das nicht mehr zum Asset gehört
+	 * @param Pivot Wird von allen Positionen abgezogen, der Actor wird an dieser Stelle platziert
+	 * @param PackagePath Content-Ordner, z.B. /Game/CityGML
+	 * @param AssetName Gewünschter Name, bei Bedarf wird eine Nummer angehängt
+	 * @param bSectionPerSurfaceType Pro Dach, Wand und Boden ein eigener Material-Slot statt eines gemeinsamen
+	 * @param LODSettings Vereinfachte LODs und Grundriss-Block, nullptr für ein Asset ohne weitere LODs
+	 * @return Das Asset oder nullptr, wenn die Gebäude keine Dreiecke haben
+	 */
+	UStaticMesh* CreateStaticMesh(const FCityGMLGeometryStore& Geometry, int32 FirstBuilding, int32 BuildingEnd, const FVector& Pivot,
+		const FString& PackagePath, const FString& AssetName, bool bSectionPerSurfaceType, const FCityGMLMeshLODSettings* LODSettings = nullptr);
+
+	/**
+	 * Baut mehrere mit CreateStaticMesh angelegte Assets gemeinsam und markiert ihre Packages zum Speichern.
+	 *
+	 * @param StaticMeshes Die zu bauenden Assets
+	 */
+	void BuildStaticMeshes(const TArray<UStaticMesh*>& StaticMeshes);
+
+	/**
+	 * Verwirft ein angelegtes Asset wieder, z.B. wenn der Import abgebrochen wurde.
+	 *
+	 * @param StaticMesh Das Asset
+	 */
+	void DiscardStaticMesh(UStaticMesh* StaticMesh);
+}
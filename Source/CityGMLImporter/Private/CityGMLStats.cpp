@@ -0,0 +1,22 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#include "CityGMLStats.h"
+
+DEFINE_STAT(STAT_CityGML_ReadFile);
+DEFINE_STAT(STAT_CityGML_Decompress);
+DEFINE_STAT(STAT_CityGML_ParseXml);
+DEFINE_STAT(STAT_CityGML_LoadCache);
+DEFINE_STAT(STAT_CityGML_ParsePosList);
+DEFINE_STAT(STAT_CityGML_MakeFace);
+DEFINE_STAT(STAT_CityGML_GenerateUVs);
+DEFINE_STAT(STAT_CityGML_GenerateTangents);
+DEFINE_STAT(STAT_CityGML_WeldVertices);
+DEFINE_STAT(STAT_CityGML_Merge);
+DEFINE_STAT(STAT_CityGML_BuildIndex);
+DEFINE_STAT(STAT_CityGML_CreateMesh);
+
+DEFINE_STAT(STAT_CityGML_Buildings);
+DEFINE_STAT(STAT_CityGML_Faces);
+DEFINE_STAT(STAT_CityGML_Vertices);
+DEFINE_STAT(STAT_CityGML_Triangles);
+DEFINE_STAT(STAT_CityGML_GeometryMemory);
@@ -0,0 +1,37 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Stats/Stats.h"
+#include "ProfilingDebugging/CpuProfilerTrace.h"
+
+/**
+ * Stats und Trace-Events für die Phasen des Imports.
+ * Anzeige im Editor mit `stat CityGML`, im Unreal Insights über den Kanal cpu.
+ */
+DECLARE_STATS_GROUP(TEXT("CityGML"), STATGROUP_CityGML, STATCAT_Advanced);
+
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Read file"), STAT_CityGML_ReadFile, STATGROUP_CityGML, );
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Decompress"), STAT_CityGML_Decompress, STATGROUP_CityGML, );
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Parse XML"), STAT_CityGML_ParseXml, STATGROUP_CityGML, );
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Load cache"), STAT_CityGML_LoadCache, STATGROUP_CityGML, );
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Parse posList"), STAT_CityGML_ParsePosList, STATGROUP_CityGML, );
+DECLARE_CYCLE_STAT_EXTERN(TEXT("MakeFace"), STAT_CityGML_MakeFace, STATGROUP_CityGML, );
+DECLARE_CYCLE_STAT_EXTERN(TEXT("GenerateUVs"), STAT_CityGML_GenerateUVs, STATGROUP_CityGML, );
+DECLARE_CYCLE_STAT_EXTERN(TEXT("GenerateTangents"), STAT_CityGML_GenerateTangents, STATGROUP_CityGML, );
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Weld vertices"), STAT_CityGML_WeldVertices, STATGROUP_CityGML, );
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Merge files"), STAT_CityGML_Merge, STATGROUP_CityGML, );
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Build attribute index"), STAT_CityGML_BuildIndex, STATGROUP_CityGML, );
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Create mesh actors"), STAT_CityGML_CreateMesh, STATGROUP_CityGML, );
+
+DECLARE_DWORD_ACCUMULATOR_STAT_EXTERN(TEXT("Buildings"), STAT_CityGML_Buildings, STATGROUP_CityGML, );
+DECLARE_DWORD_ACCUMULATOR_STAT_EXTERN(TEXT("Faces"), STAT_CityGML_Faces, STATGROUP_CityGML, );
+DECLARE_DWORD_ACCUMULATOR_STAT_EXTERN(TEXT("Vertices"), STAT_CityGML_Vertices, STATGROUP_CityGML, );
+DECLARE_DWORD_ACCUMULATOR_STAT_EXTERN(TEXT("Triangles"), STAT_CityGML_Triangles, STATGROUP_CityGML, );
+DECLARE_MEMORY_STAT_EXTERN(TEXT("Geometry memory"), STAT_CityGML_GeometryMemory, STATGROUP_CityGML, );
+
+/** Stat-Zähler und Trace-Event für denselben Bereich */
+#define CITYGML_SCOPE_CYCLE_COUNTER(Stat) \
+	SCOPE_CYCLE_COUNTER(Stat); \
+	TRACE_CPUPROFILER_EVENT_SCOPE(Stat)
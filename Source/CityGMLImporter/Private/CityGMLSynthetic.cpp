@@ -0,0 +1,185 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#include "CityGMLSynthetic.h"
+#include "HAL/IConsoleManager.h"
+#include "Math/RandomStream.h"
+#include "Misc/FileHelper.h"
+
+namespace
+{
+    // Mittelpunkt des Rasters, entspricht dem voreingestellten CityOrigin
+    const double BaseX = 565000.0;
+    const double BaseY = 5933000.0;
+    const double GridSpacing = 40.0;
+
+    /** Ein Punkt in UTM-Koordinaten */
+    struct FPoint
+    {
+        double X, Y, Z;
+    };
+
+    /** Hängt einen geschlossenen Ring als gml:posList an, der erste Punkt wird am Ende wiederholt */
+    void AppendPosList(FString& Out, const TArray<FPoint>& Ring)
+    {
+        Out += TEXT("<gml:posList srsDimension=\"3\">");
+        for (const FPoint& Point : Ring) {
+            Out += FString::Printf(TEXT("%.3f %.3f %.3f "), Point.X, Point.Y, Point.Z);
+        }
+        Out += FString::Printf(TEXT("%.3f %.3f %.3f"), Ring[0].X, Ring[0].Y, Ring[0].Z);
+        Out += TEXT("</gml:posList>");
+    }
+
+    /** gml:Polygon mit äußerem Ring, wie es in jedem surfaceMember steht */
+    void AppendPolygon(FString& Out, const TArray<FPoint>& Ring)
+    {
+        Out += TEXT("<gml:Polygon><gml:exterior><gml:LinearRing>");
+        AppendPosList(Out, Ring);
+        Out += TEXT("</gml:LinearRing></gml:exterior></gml:Polygon>");
+    }
+
+    /**
+     * Baut die Ringe eines Gebäudes: Boden, Dach und Wände.
+     * Boden und Dach sind regelmäßige Vielecke, jede Wand ist ein senkrechtes Vieleck mit Giebel, sodass alle Ringe eben sind.
+     */
+    void MakeBuildingRings(FRandomStream& Random, const FCityGMLSyntheticOptions& Options, int32 Building, TArray<TArray<FPoint>>& OutRings, TArray<const TCHAR*>& OutTypes)
+    {
+        const int32 Columns = FMath::Max(1, FMath::CeilToInt(FMath::Sqrt(float(Options.FirstBuilding + Options.Buildings))));
+        const int32 Index = Options.FirstBuilding + Building;
+        const double CenterX = BaseX + (Index % Columns - Columns / 2) * GridSpacing + Random.FRandRange(-5.0f, 5.0f);
+        const double CenterY = BaseY + (Index / Columns - Columns / 2) * GridSpacing + Random.FRandRange(-5.0f, 5.0f);
+        const double Ground = Random.FRandRange(2.0f, 8.0f);
+        const double Height = Random.FRandRange(6.0f, 40.0f);
+        const double Radius = Random.FRandRange(6.0f, 14.0f);
+        const int32 Vertices = FMath::Max(4, Options.VerticesPerRing);
+        const int32 Walls = FMath::Max(3, Options.FacesPerBuilding - 2);
+
+        auto Footprint = [CenterX, CenterY, Radius](int32 i, int32 Count, double Z) {
+            const double Angle = 2.0 * PI * i / Count;
+            return FPoint{ CenterX + Radius * FMath::Cos(Angle), CenterY + Radius * FMath::Sin(Angle), Z };
+        };
+
+        // Boden gegen den Uhrzeigersinn von oben gesehen nach unten zeigend, Dach umgekehrt
+        TArray<FPoint>& GroundRing = OutRings.AddDefaulted_GetRef();
+        OutTypes.Add(TEXT("bldg:GroundSurface"));
+        for (int32 i = Vertices - 1; i >= 0; --i) {
+            GroundRing.Add(Footprint(i, Vertices, Ground));
+        }
+        TArray<FPoint>& RoofRing = OutRings.AddDefaulted_GetRef();
+        OutTypes.Add(TEXT("bldg:RoofSurface"));
+        for (int32 i = 0; i < Vertices; ++i) {
+            RoofRing.Add(Footprint(i, Vertices, Ground + Height));
+        }
+
+        for (int32 w = 0; w < Walls; ++w) {
+            const FPoint A = Footprint(w, Walls, Ground);
+            const FPoint B = Footprint(w + 1, Walls, Ground);
+            TArray<FPoint>& Wall = OutRings.AddDefaulted_GetRef();
+            OutTypes.Add(TEXT("bldg:WallSurface"));
+            Wall.Add(A);
+            Wall.Add(B);
+            // Oberkante von B nach A mit leichtem Giebel, bleibt in der Ebene der Wand
+            const int32 TopPoints = Vertices - 2;
+            for (int32 t = 0; t < TopPoints; ++t) {
+                const double Alpha = TopPoints == 1 ? 0.5 : double(t) / (TopPoints - 1);
+                const double Gable = FMath::Sin(Alpha * PI) * 2.0;
+                Wall.Add(FPoint{ B.X + (A.X - B.X) * Alpha, B.Y + (A.Y - B.Y) * Alpha, Ground + Height + Gable });
+            }
+        }
+    }
+
+    void AppendAddress(FString& Out, FRandomStream& Random, int32 Index)
+    {
+        Out += TEXT("<bldg:address><core:Address><core:xalAddress><xAL:AddressDetails><xAL:Country><xAL:CountryName>Deutschland</xAL:CountryName><xAL:Locality Type=\"Town\"><xAL:LocalityName>Hamburg</xAL:LocalityName>");
+        Out += FString::Printf(TEXT("<xAL:Thoroughfare Type=\"Street\"><xAL:ThoroughfareNumber>%d</xAL:ThoroughfareNumber><xAL:ThoroughfareName>Synthetische Strasse %d</xAL:ThoroughfareName></xAL:Thoroughfare>"), 1 + Index % 200, Index / 200);
+        Out += FString::Printf(TEXT("<xAL:PostalCode><xAL:PostalCodeNumber>%05d</xAL:PostalCodeNumber></xAL:PostalCode>"), 20000 + Random.RandRange(0, 2999));
+        Out += TEXT("</xAL:Locality></xAL:Country></xAL:AddressDetails></core:xalAddress></core:Address></bldg:address>");
+    }
+
+    void GenerateSynthetic(const TArray<FString>& Args)
+    {
+        if (Args.Num() < 1) {
+            UE_LOG(LogTemp, Warning, TEXT("Usage: CityGML.GenerateSynthetic <Path> [LoD] [Buildings] [FacesPerBuilding] [VerticesPerRing]"));
+            return;
+        }
+        FCityGMLSyntheticOptions Options;
+        if (Args.Num() > 1) { Options.LoD = Args[1]; }
+        if (Args.Num() > 2) { Options.Buildings = FCString::Atoi(*Args[2]); }
+        if (Args.Num() > 3) { Options.FacesPerBuilding = FCString::Atoi(*Args[3]); }
+        if (Args.Num() > 4) { Options.VerticesPerRing = FCString::Atoi(*Args[4]); }
+        if (CityGMLSynthetic::WriteDocument(Args[0], Options)) {
+            UE_LOG(LogTemp, Log, TEXT("Wrote %d synthetic %s buildings to %s"), Options.Buildings, *Options.LoD, *Args[0]);
+        }
+    }
+
+    FAutoConsoleCommand GenerateSyntheticCommand(
+        TEXT("CityGML.GenerateSynthetic"),
+        TEXT("Writes a synthetic CityGML document. Args: <Path> [LoD] [Buildings] [FacesPerBuilding] [VerticesPerRing]"),
+        FConsoleCommandWithArgsDelegate::CreateStatic(&GenerateSynthetic)
+    );
+}
+
+FString CityGMLSynthetic::GenerateDocument(const FCityGMLSyntheticOptions& Options)
+{
+    const bool bLoD1 = Options.LoD == TEXT("LoD1");
+    const bool bLoD3 = Options.LoD == TEXT("LoD3");
+    FRandomStream Random(Options.Seed + Options.FirstBuilding);
+
+    FString Out;
+    Out.Reserve(Options.Buildings * FMath::Max(1, Options.FacesPerBuilding) * (Options.VerticesPerRing * 32 + 256));
+    Out += TEXT("<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n");
+
+    // Envelope: bei LoD1/2 das zweite Kind von core:CityModel, bei LoD3 das erste Kind von CityModel
+    const FString Envelope = FString::Printf(TEXT("<gml:boundedBy><gml:Envelope srsName=\"urn:adv:crs:ETRS89_UTM32*DE_DHHN92_NH\" srsDimension=\"3\"><gml:lowerCorner>%.3f %.3f 0</gml:lowerCorner><gml:upperCorner>%.3f %.3f 100</gml:upperCorner></gml:Envelope></gml:boundedBy>\n"),
+        BaseX - 10000.0, BaseY - 10000.0, BaseX + 10000.0, BaseY + 10000.0);
+    const TCHAR* Namespaces = TEXT("xmlns:core=\"http://www.opengis.net/citygml/1.0\" xmlns:bldg=\"http://www.opengis.net/citygml/building/1.0\" xmlns:gml=\"http://www.opengis.net/gml\" xmlns:xAL=\"urn:oasis:names:tc:ciq:xsdschema:xAL:2.0\"");
+    if (bLoD3) {
+        Out += FString::Printf(TEXT("<CityModel %s>\n"), Namespaces);
+        Out += Envelope;
+    }
+    else {
+        Out += FString::Printf(TEXT("<core:CityModel %s>\n"), Namespaces);
+        // Das LoD steht in den ersten vier Zeichen des ersten Kindes
+        Out += FString::Printf(TEXT("<gml:name>%s synthetic</gml:name>\n"), *Options.LoD);
+        Out += Envelope;
+    }
+
+    TArray<TArray<FPoint>> Rings;
+    TArray<const TCHAR*> Types;
+    for (int32 Building = 0; Building < Options.Buildings; ++Building) {
+        const int32 Index = Options.FirstBuilding + Building;
+        Rings.Reset();
+        Types.Reset();
+        MakeBuildingRings(Random, Options, Building, Rings, Types);
+
+        Out += FString::Printf(TEXT("<core:cityObjectMember><bldg:Building gml:id=\"SYN_%s_%08d\">"), *Options.LoD, Index);
+        if (bLoD1) {
+            Out += TEXT("<bldg:lod1Solid><gml:Solid><gml:exterior><gml:CompositeSurface>");
+            for (const TArray<FPoint>& Ring : Rings) {
+                Out += TEXT("<gml:surfaceMember>");
+                AppendPolygon(Out, Ring);
+                Out += TEXT("</gml:surfaceMember>");
+            }
+            Out += TEXT("</gml:CompositeSurface></gml:exterior></gml:Solid></bldg:lod1Solid>");
+        }
+        else {
+            const TCHAR* Property = bLoD3 ? TEXT("bldg:lod3MultiSurface") : TEXT("bldg:lod2MultiSurface");
+            for (int32 i = 0; i < Rings.Num(); ++i) {
+                Out += FString::Printf(TEXT("<bldg:boundedBy><%s><%s><gml:MultiSurface><gml:surfaceMember>"), Types[i], Property);
+                AppendPolygon(Out, Rings[i]);
+                Out += FString::Printf(TEXT("</gml:surfaceMember></gml:MultiSurface></%s></%s></bldg:boundedBy>"), Property, Types[i]);
+            }
+        }
+        if (!bLoD3) {
+            AppendAddress(Out, Random, Index);
+        }
+        Out += TEXT("</bldg:Building></core:cityObjectMember>\n");
+    }
+
+    Out += bLoD3 ? TEXT("</CityModel>\n") : TEXT("</core:CityModel>\n");
+    return Out;
+}
+
+bool CityGMLSynthetic::WriteDocument(const FString& FilePath, const FCityGMLSyntheticOptions& Options)
+{
+    return FFileHelper::SaveStringToFile(GenerateDocument(Options), *FilePath, FFileHelper::EEncodingOptions::ForceUTF8WithoutBOM);
+}
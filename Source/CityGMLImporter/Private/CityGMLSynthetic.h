@@ -0,0 +1,46 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+/** Einstellungen für ein künstliches CityGML-Dokument */
+struct FCityGMLSyntheticOptions
+{
+	/** "LoD1", "LoD2" oder "LoD3" */
+	FString LoD = TEXT("LoD2");
+	int32 Buildings = 1000;
+	/** Flächen pro Gebäude: Boden, Dach und die übrigen als Wände, mindestens 5 */
+	int32 FacesPerBuilding = 8;
+	/** Vertices pro Ring ohne den schließenden Punkt, mindestens 4 */
+	int32 VerticesPerRing = 5;
+	/** Startwert des Zufallsgenerators, gleiche Einstellungen ergeben dasselbe Dokument */
+	int32 Seed = 4711;
+	/** Erstes Gebäude, damit mehrere Dateien unterschiedliche gml:ids und Positionen bekommen */
+	int32 FirstBuilding = 0;
+};
+
+/**
+ * Erzeugt reproduzierbare CityGML-Dokumente in genau der Struktur, die der FCityGMLReader
+ * und TriangulateBuilding erwarten, z.B. als Last für Benchmarks.
+ * Die Gebäude liegen in einem Raster um die HafenCity, jede Fläche ist eben.
+ */
+namespace CityGMLSynthetic
+{
+	/**
+	 * Erzeugt ein vollständiges Dokument.
+	 *
+	 * @param Options Anzahl der Gebäude, Flächen und Vertices
+	 * @return Der XML-Text des Dokuments
+	 */
+	FString GenerateDocument(const FCityGMLSyntheticOptions& Options);
+
+	/**
+	 * Erzeugt ein Dokument und speichert es als UTF-8.
+	 *
+	 * @param FilePath Zielpfad
+	 * @param Options Anzahl der Gebäude, Flächen und Vertices
+	 * @return true, wenn die Datei geschrieben wurde
+	 */
+	bool WriteDocument(const FString& FilePath, const FCityGMLSyntheticOptions& Options);
+}
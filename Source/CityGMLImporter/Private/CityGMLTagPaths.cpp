@@ -0,0 +1,384 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#include "CityGMLTagPaths.h"
+#include "CityGMLXmlTokenizer.h"
+#include "Hash/CityHash.h"
+
+namespace
+{
+    struct FNamespaceUri
+    {
+        const ANSICHAR* Uri;
+        ECityGMLNamespace Namespace;
+    };
+
+    /** CityGML 1.0, 2.0 und 3.0 */
+    const FNamespaceUri NamespaceUris[] = {
+        { "http://www.opengis.net/citygml/1.0", ECityGMLNamespace::Core },
+        { "http://www.opengis.net/citygml/2.0", ECityGMLNamespace::Core },
+        { "http://www.opengis.net/citygml/3.0", ECityGMLNamespace::Core },
+        { "http://www.opengis.net/citygml/building/1.0", ECityGMLNamespace::Building },
+        { "http://www.opengis.net/citygml/building/2.0", ECityGMLNamespace::Building },
+        { "http://www.opengis.net/citygml/building/3.0", ECityGMLNamespace::Building },
+        { "http://www.opengis.net/gml", ECityGMLNamespace::Gml },
+        { "http://www.opengis.net/gml/3.2", ECityGMLNamespace::Gml },
+        { "urn:oasis:names:tc:ciq:xsdschema:xAL:2.0", ECityGMLNamespace::Xal },
+    };
+
+    /** Übliche Präfixe für Dateien, die ihre Namespaces nicht deklarieren */
+    const FNamespaceUri DefaultPrefixes[] = {
+        { "", ECityGMLNamespace::Core },
+        { "core", ECityGMLNamespace::Core },
+        { "bldg", ECityGMLNamespace::Building },
+        { "gml", ECityGMLNamespace::Gml },
+        { "xAL", ECityGMLNamespace::Xal },
+    };
+
+    struct FLocalName
+    {
+        ECityGMLNamespace Namespace;
+        const ANSICHAR* Name;
+        ECityGMLTag Tag;
+    };
+
+    const FLocalName LocalNames[] = {
+        { ECityGMLNamespace::Core, "CityModel", ECityGMLTag::CityModel },
+        { ECityGMLNamespace::Core, "Address", ECityGMLTag::Address },
+        { ECityGMLNamespace::Core, "xalAddress", ECityGMLTag::XalAddress },
+        { ECityGMLNamespace::Building, "Building", ECityGMLTag::Building },
+        { ECityGMLNamespace::Building, "boundedBy", ECityGMLTag::BuildingBoundedBy },
+        { ECityGMLNamespace::Building, "address", ECityGMLTag::BuildingAddress },
+        { ECityGMLNamespace::Building, "lod1Solid", ECityGMLTag::Lod1Solid },
+        { ECityGMLNamespace::Building, "lod2MultiSurface", ECityGMLTag::Lod2MultiSurface },
+        { ECityGMLNamespace::Building, "lod3MultiSurface", ECityGMLTag::Lod3MultiSurface },
+        { ECityGMLNamespace::Building, "RoofSurface", ECityGMLTag::RoofSurface },
+        { ECityGMLNamespace::Building, "WallSurface", ECityGMLTag::WallSurface },
+        { ECityGMLNamespace::Building, "GroundSurface", ECityGMLTag::GroundSurface },
+        { ECityGMLNamespace::Building, "ClosureSurface", ECityGMLTag::ClosureSurface },
+        { ECityGMLNamespace::Building, "OuterCeilingSurface", ECityGMLTag::OuterCeilingSurface },
+        { ECityGMLNamespace::Building, "OuterFloorSurface", ECityGMLTag::OuterFloorSurface },
+        { ECityGMLNamespace::Building, "measuredHeight", ECityGMLTag::MeasuredHeight },
+        { ECityGMLNamespace::Gml, "id", ECityGMLTag::Id },
+        { ECityGMLNamespace::Gml, "boundedBy", ECityGMLTag::BoundedBy },
+        { ECityGMLNamespace::Gml, "Envelope", ECityGMLTag::Envelope },
+        { ECityGMLNamespace::Gml, "lowerCorner", ECityGMLTag::LowerCorner },
+        { ECityGMLNamespace::Gml, "upperCorner", ECityGMLTag::UpperCorner },
+        { ECityGMLNamespace::Gml, "Solid", ECityGMLTag::Solid },
+        { ECityGMLNamespace::Gml, "exterior", ECityGMLTag::Exterior },
+        { ECityGMLNamespace::Gml, "interior", ECityGMLTag::Interior },
+        { ECityGMLNamespace::Gml, "CompositeSurface", ECityGMLTag::CompositeSurface },
+        { ECityGMLNamespace::Gml, "MultiSurface", ECityGMLTag::MultiSurface },
+        { ECityGMLNamespace::Gml, "surfaceMember", ECityGMLTag::SurfaceMember },
+        { ECityGMLNamespace::Gml, "Polygon", ECityGMLTag::Polygon },
+        { ECityGMLNamespace::Gml, "LinearRing", ECityGMLTag::LinearRing },
+        { ECityGMLNamespace::Gml, "posList", ECityGMLTag::PosList },
+        { ECityGMLNamespace::Xal, "AddressDetails", ECityGMLTag::AddressDetails },
+        { ECityGMLNamespace::Xal, "Country", ECityGMLTag::Country },
+        { ECityGMLNamespace::Xal, "Locality", ECityGMLTag::Locality },
+        { ECityGMLNamespace::Xal, "Thoroughfare", ECityGMLTag::Thoroughfare },
+        { ECityGMLNamespace::Xal, "ThoroughfareName", ECityGMLTag::ThoroughfareName },
+        { ECityGMLNamespace::Xal, "ThoroughfareNumber", ECityGMLTag::ThoroughfareNumber },
+        { ECityGMLNamespace::Xal, "PostalCode", ECityGMLTag::PostalCode },
+        { ECityGMLNamespace::Xal, "PostalCodeNumber", ECityGMLTag::PostalCodeNumber },
+    };
+
+    /** Tag eines lokalen Namens in einem Namespace */
+    ECityGMLTag FindLocalName(ECityGMLNamespace Namespace, FAnsiStringView LocalName)
+    {
+        for (const FLocalName& Known : LocalNames) {
+            if (Known.Namespace == Namespace && CityGMLXml::Equals(LocalName, Known.Name)) {
+                return Known.Tag;
+            }
+        }
+        return ECityGMLTag::Unknown;
+    }
+
+    /** Teilt `bldg:Building` in Präfix und lokalen Namen, ohne Doppelpunkt ist der Präfix leer */
+    void SplitQualifiedName(FAnsiStringView QualifiedName, FAnsiStringView& OutPrefix, FAnsiStringView& OutLocalName)
+    {
+        int32 Colon = INDEX_NONE;
+        QualifiedName.FindChar(':', Colon);
+        OutPrefix = Colon == INDEX_NONE ? FAnsiStringView() : QualifiedName.Left(Colon);
+        OutLocalName = Colon == INDEX_NONE ? QualifiedName : QualifiedName.Mid(Colon + 1);
+    }
+
+    /** Pfade, die in jedem LoD gleich sind: Wurzel, Gebäude, Envelope, Höhe, Polygone und Adressen */
+    const FCityGMLPathRule CommonRules[] = {
+        { ECityGMLNode::Root, ECityGMLTag::Any, ECityGMLNode::RootChild },
+        { ECityGMLNode::Root, ECityGMLTag::BoundedBy, ECityGMLNode::RootBoundedBy },
+        { ECityGMLNode::RootBoundedBy, ECityGMLTag::Envelope, ECityGMLNode::RootEnvelope },
+        { ECityGMLNode::RootChild, ECityGMLTag::Building, ECityGMLNode::Building },
+
+        { ECityGMLNode::Building, ECityGMLTag::BoundedBy, ECityGMLNode::BuildingBoundedBy },
+        { ECityGMLNode::BuildingBoundedBy, ECityGMLTag::Envelope, ECityGMLNode::BuildingEnvelope },
+        { ECityGMLNode::BuildingEnvelope, ECityGMLTag::LowerCorner, ECityGMLNode::LowerCorner },
+        { ECityGMLNode::BuildingEnvelope, ECityGMLTag::UpperCorner, ECityGMLNode::UpperCorner },
+        { ECityGMLNode::Building, ECityGMLTag::MeasuredHeight, ECityGMLNode::MeasuredHeight },
+
+        { ECityGMLNode::SurfaceMember, ECityGMLTag::Polygon, ECityGMLNode::Polygon },
+        { ECityGMLNode::Polygon, ECityGMLTag::Exterior, ECityGMLNode::PolygonExterior },
+        { ECityGMLNode::PolygonExterior, ECityGMLTag::LinearRing, ECityGMLNode::LinearRing },
+        { ECityGMLNode::LinearRing, ECityGMLTag::PosList, ECityGMLNode::PosList },
+        { ECityGMLNode::Polygon, ECityGMLTag::Interior, ECityGMLNode::PolygonInterior },
+        { ECityGMLNode::PolygonInterior, ECityGMLTag::LinearRing, ECityGMLNode::InteriorRing },
+        { ECityGMLNode::InteriorRing, ECityGMLTag::PosList, ECityGMLNode::InteriorPosList },
+
+        { ECityGMLNode::Building, ECityGMLTag::BuildingAddress, ECityGMLNode::Address },
+        { ECityGMLNode::Address, ECityGMLTag::Address, ECityGMLNode::AddressCore },
+        { ECityGMLNode::AddressCore, ECityGMLTag::XalAddress, ECityGMLNode::AddressXal },
+        { ECityGMLNode::AddressXal, ECityGMLTag::AddressDetails, ECityGMLNode::AddressDetails },
+        { ECityGMLNode::AddressDetails, ECityGMLTag::Country, ECityGMLNode::AddressCountry },
+        { ECityGMLNode::AddressCountry, ECityGMLTag::Locality, ECityGMLNode::AddressLocality },
+        { ECityGMLNode::AddressLocality, ECityGMLTag::Thoroughfare, ECityGMLNode::AddressThoroughfare },
+        { ECityGMLNode::AddressLocality, ECityGMLTag::PostalCode, ECityGMLNode::AddressPostalCode },
+        { ECityGMLNode::AddressThoroughfare, ECityGMLTag::ThoroughfareName, ECityGMLNode::ThoroughfareName },
+        { ECityGMLNode::AddressThoroughfare, ECityGMLTag::ThoroughfareNumber, ECityGMLNode::ThoroughfareNumber },
+        { ECityGMLNode::AddressPostalCode, ECityGMLTag::PostalCodeNumber, ECityGMLNode::PostalCodeNumber },
+    };
+
+    /** lod1Solid/Solid/exterior/CompositeSurface, jedes Kind der CompositeSurface ist eine Fläche */
+    const FCityGMLPathRule Lod1Rules[] = {
+        { ECityGMLNode::Building, ECityGMLTag::Lod1Solid, ECityGMLNode::Lod1Solid },
+        { ECityGMLNode::Lod1Solid, ECityGMLTag::Solid, ECityGMLNode::Solid },
+        { ECityGMLNode::Solid, ECityGMLTag::Exterior, ECityGMLNode::SolidExterior },
+        { ECityGMLNode::SolidExterior, ECityGMLTag::CompositeSurface, ECityGMLNode::MemberContainer },
+        { ECityGMLNode::MemberContainer, ECityGMLTag::Any, ECityGMLNode::SurfaceMember },
+    };
+
+#define CITYGML_BOUNDARY_SURFACE_RULES \
+        { ECityGMLNode::Building, ECityGMLTag::BuildingBoundedBy, ECityGMLNode::BoundedBy }, \
+        { ECityGMLNode::BoundedBy, ECityGMLTag::RoofSurface, ECityGMLNode::Surface }, \
+        { ECityGMLNode::BoundedBy, ECityGMLTag::WallSurface, ECityGMLNode::Surface }, \
+        { ECityGMLNode::BoundedBy, ECityGMLTag::GroundSurface, ECityGMLNode::Surface }, \
+        { ECityGMLNode::BoundedBy, ECityGMLTag::ClosureSurface, ECityGMLNode::Surface }, \
+        { ECityGMLNode::BoundedBy, ECityGMLTag::OuterCeilingSurface, ECityGMLNode::Surface }, \
+        { ECityGMLNode::BoundedBy, ECityGMLTag::OuterFloorSurface, ECityGMLNode::Surface }
+
+    /** boundedBy/Fläche/lodNMultiSurface/MultiSurface/surfaceMember */
+    const FCityGMLPathRule Lod2Rules[] = {
+        CITYGML_BOUNDARY_SURFACE_RULES,
+        { ECityGMLNode::Surface, ECityGMLTag::Lod2MultiSurface, ECityGMLNode::MultiSurfaceProperty },
+        { ECityGMLNode::MultiSurfaceProperty, ECityGMLTag::MultiSurface, ECityGMLNode::MemberContainer },
+        { ECityGMLNode::MemberContainer, ECityGMLTag::SurfaceMember, ECityGMLNode::SurfaceMember },
+    };
+
+    const FCityGMLPathRule Lod3Rules[] = {
+        CITYGML_BOUNDARY_SURFACE_RULES,
+        { ECityGMLNode::Surface, ECityGMLTag::Lod3MultiSurface, ECityGMLNode::MultiSurfaceProperty },
+        { ECityGMLNode::MultiSurfaceProperty, ECityGMLTag::MultiSurface, ECityGMLNode::MemberContainer },
+        { ECityGMLNode::MemberContainer, ECityGMLTag::SurfaceMember, ECityGMLNode::SurfaceMember },
+    };
+
+    /** Bis eine Geometrie-Eigenschaft das LoD festlegt, werden nur die Pfade bis zu ihr verfolgt */
+    const FCityGMLPathRule UndecidedRules[] = {
+        CITYGML_BOUNDARY_SURFACE_RULES,
+        { ECityGMLNode::Building, ECityGMLTag::Lod1Solid, ECityGMLNode::Lod1Solid },
+        { ECityGMLNode::Surface, ECityGMLTag::Lod2MultiSurface, ECityGMLNode::MultiSurfaceProperty },
+        { ECityGMLNode::Surface, ECityGMLTag::Lod3MultiSurface, ECityGMLNode::MultiSurfaceProperty },
+    };
+
+#undef CITYGML_BOUNDARY_SURFACE_RULES
+
+    const FCityGMLLoDPaths Lod1Paths = { TEXT("LoD1"), false, MakeArrayView(Lod1Rules) };
+    const FCityGMLLoDPaths Lod2Paths = { TEXT("LoD2"), true, MakeArrayView(Lod2Rules) };
+    const FCityGMLLoDPaths Lod3Paths = { TEXT("LoD3"), false, MakeArrayView(Lod3Rules) };
+    const FCityGMLLoDPaths UndecidedPaths = { TEXT(""), false, MakeArrayView(UndecidedRules) };
+}
+
+FCityGMLTagTable::FCityGMLTagTable()
+{
+    Reset();
+}
+
+void FCityGMLTagTable::Reset()
+{
+    Bindings.Reset();
+    ClearNames();
+}
+
+void FCityGMLTagTable::ClearNames()
+{
+    Entries.Reset();
+    Entries.SetNum(256);
+    Names.Reset();
+    NumEntries = 0;
+}
+
+void FCityGMLTagTable::DeclareNamespace(FAnsiStringView Prefix, FAnsiStringView Uri, int32 Depth)
+{
+    const ECityGMLNamespace Previous = FindNamespace(Prefix);
+    FBinding& Binding = Bindings.AddDefaulted_GetRef();
+    Binding.Prefix.Append(Prefix.GetData(), Prefix.Len());
+    Binding.Namespace = ECityGMLNamespace::Other;
+    Binding.Depth = Depth;
+    for (const FNamespaceUri& Known : NamespaceUris) {
+        if (CityGMLXml::Equals(Uri, Known.Uri)) {
+            Binding.Namespace = Known.Namespace;
+            break;
+        }
+    }
+    // Viele Exporter wiederholen dieselben Deklarationen an jedem Feature, die internierten Namen bleiben dann gültig
+    if (Binding.Namespace != Previous) {
+        RebindPrefix(Prefix);
+    }
+}
+
+void FCityGMLTagTable::EndScope(int32 Depth)
+{
+    while (Bindings.Num() > 0 && Bindings.Last().Depth >= Depth) {
+        const FBinding Removed = Bindings.Pop(false);
+        const FAnsiStringView Prefix(Removed.Prefix.GetData(), Removed.Prefix.Num());
+        if (FindNamespace(Prefix) != Removed.Namespace) {
+            RebindPrefix(Prefix);
+        }
+    }
+}
+
+void FCityGMLTagTable::RebindPrefix(FAnsiStringView Prefix)
+{
+    // Der Name bleibt der Schlüssel, nur sein Tag wird mit dem jetzt gültigen Namespace neu bestimmt
+    const ECityGMLNamespace Namespace = FindNamespace(Prefix);
+    for (FEntry& Entry : Entries) {
+        if (Entry.NameOffset == INDEX_NONE) {
+            continue;
+        }
+        FAnsiStringView EntryPrefix;
+        FAnsiStringView LocalName;
+        SplitQualifiedName(FAnsiStringView(Names.GetData() + Entry.NameOffset, Entry.NameLength), EntryPrefix, LocalName);
+        if (EntryPrefix.Len() == Prefix.Len() && FMemory::Memcmp(EntryPrefix.GetData(), Prefix.GetData(), Prefix.Len()) == 0) {
+            Entry.Tag = FindLocalName(Namespace, LocalName);
+        }
+    }
+}
+
+ECityGMLNamespace FCityGMLTagTable::FindNamespace(FAnsiStringView Prefix) const
+{
+    for (int32 i = Bindings.Num() - 1; i >= 0; --i) {
+        const FBinding& Binding = Bindings[i];
+        if (Binding.Prefix.Num() == Prefix.Len() && FMemory::Memcmp(Binding.Prefix.GetData(), Prefix.GetData(), Prefix.Len()) == 0) {
+            return Binding.Namespace;
+        }
+    }
+    for (const FNamespaceUri& Default : DefaultPrefixes) {
+        if (CityGMLXml::Equals(Prefix, Default.Uri)) {
+            return Default.Namespace;
+        }
+    }
+    return ECityGMLNamespace::Other;
+}
+
+void FCityGMLTagTable::Insert(uint32 Hash, int32 NameOffset, int32 NameLength, ECityGMLTag Tag)
+{
+    const uint32 Mask = uint32(Entries.Num() - 1);
+    uint32 Slot = Hash & Mask;
+    while (Entries[Slot].NameOffset != INDEX_NONE) {
+        Slot = (Slot + 1) & Mask;
+    }
+    FEntry& Entry = Entries[Slot];
+    Entry.Hash = Hash;
+    Entry.NameOffset = NameOffset;
+    Entry.NameLength = NameLength;
+    Entry.Tag = Tag;
+}
+
+ECityGMLTag FCityGMLTagTable::Resolve(FAnsiStringView QualifiedName)
+{
+    const uint32 Hash = CityHash32(QualifiedName.GetData(), uint32(QualifiedName.Len()));
+    const uint32 Mask = uint32(Entries.Num() - 1);
+    for (uint32 Slot = Hash & Mask; Entries[Slot].NameOffset != INDEX_NONE; Slot = (Slot + 1) & Mask) {
+        const FEntry& Entry = Entries[Slot];
+        if (Entry.Hash == Hash && Entry.NameLength == QualifiedName.Len() && FMemory::Memcmp(Names.GetData() + Entry.NameOffset, QualifiedName.GetData(), Entry.NameLength) == 0) {
+            return Entry.Tag;
+        }
+    }
+
+    // Erstes Auftreten im Dokument: Präfix auflösen und den lokalen Namen in seinem Namespace suchen
+    FAnsiStringView Prefix;
+    FAnsiStringView LocalName;
+    SplitQualifiedName(QualifiedName, Prefix, LocalName);
+    const ECityGMLTag Tag = FindLocalName(FindNamespace(Prefix), LocalName);
+
+    if ((NumEntries + 1) * 2 > Entries.Num()) {
+        TArray<FEntry> OldEntries = MoveTemp(Entries);
+        Entries.SetNum(OldEntries.Num() * 2);
+        for (const FEntry& Entry : OldEntries) {
+            if (Entry.NameOffset != INDEX_NONE) {
+                Insert(Entry.Hash, Entry.NameOffset, Entry.NameLength, Entry.Tag);
+            }
+        }
+    }
+    Insert(Hash, Names.Num(), QualifiedName.Len(), Tag);
+    Names.Append(QualifiedName.GetData(), QualifiedName.Len());
+    NumEntries++;
+    return Tag;
+}
+
+void FCityGMLPathMatcher::Compile(const FCityGMLLoDPaths& Paths)
+{
+    const int32 NumTags = int32(ECityGMLTag::Num);
+    Transitions.Init(ECityGMLNode::Other, int32(ECityGMLNode::Num) * NumTags);
+    auto Apply = [this, NumTags](TArrayView<const FCityGMLPathRule> Rules, bool bWildcards) {
+        for (const FCityGMLPathRule& Rule : Rules) {
+            if ((Rule.Tag == ECityGMLTag::Any) != bWildcards) {
+                continue;
+            }
+            ECityGMLNode* Row = Transitions.GetData() + int32(Rule.Parent) * NumTags;
+            if (Rule.Tag == ECityGMLTag::Any) {
+                for (int32 Tag = 0; Tag < NumTags; ++Tag) {
+                    Row[Tag] = Rule.Node;
+                }
+            }
+            else {
+                Row[int32(Rule.Tag)] = Rule.Node;
+            }
+        }
+    };
+    // Regeln für jedes Element zuerst, damit die Regeln für bestimmte Tags Vorrang haben
+    Apply(MakeArrayView(CommonRules), true);
+    Apply(Paths.Rules, true);
+    Apply(MakeArrayView(CommonRules), false);
+    Apply(Paths.Rules, false);
+}
+
+const FCityGMLLoDPaths& CityGMLTagPaths::GetUndecided()
+{
+    return UndecidedPaths;
+}
+
+const FCityGMLLoDPaths* CityGMLTagPaths::FindLoD(const FString& LoD)
+{
+    for (const FCityGMLLoDPaths* Paths : { &Lod1Paths, &Lod2Paths, &Lod3Paths }) {
+        if (LoD == Paths->LoD) {
+            return Paths;
+        }
+    }
+    return nullptr;
+}
+
+const FCityGMLLoDPaths* CityGMLTagPaths::FindLoDByGeometry(ECityGMLTag GeometryProperty)
+{
+    switch (GeometryProperty) {
+    case ECityGMLTag::Lod1Solid:
+        return &Lod1Paths;
+    case ECityGMLTag::Lod2MultiSurface:
+        return &Lod2Paths;
+    case ECityGMLTag::Lod3MultiSurface:
+        return &Lod3Paths;
+    default:
+        return nullptr;
+    }
+}
+
+ECityGMLSurfaceType CityGMLTagPaths::GetSurfaceType(ECityGMLTag SurfaceTag)
+{
+    switch (SurfaceTag) {
+    case ECityGMLTag::RoofSurface:
+        return ECityGMLSurfaceType::Roof;
+    case ECityGMLTag::WallSurface:
+        return ECityGMLSurfaceType::Wall;
+    case ECityGMLTag::GroundSurface:
+        return ECityGMLSurfaceType::Ground;
+    default:
+        return ECityGMLSurfaceType::Other;
+    }
+}
@@ -0,0 +1,219 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Containers/StringView.h"
+#include "CityGMLGeometryStore.h"
+
+/** Namespaces, in denen die gelesenen Elemente liegen. Erkannt wird der Namespace an der URI, nicht am Präfix */
+enum class ECityGMLNamespace : uint8
+{
+	Other,
+	Core,
+	Building,
+	Gml,
+	Xal,
+};
+
+/** Alle Elemente und Attribute, die der Reader auswertet, unabhängig vom Präfix in der Datei */
+enum class ECityGMLTag : uint8
+{
+	Unknown,
+	// core
+	CityModel,
+	Address,
+	XalAddress,
+	// bldg
+	Building,
+	BuildingBoundedBy,
+	BuildingAddress,
+	Lod1Solid,
+	Lod2MultiSurface,
+	Lod3MultiSurface,
+	RoofSurface,
+	WallSurface,
+	GroundSurface,
+	ClosureSurface,
+	OuterCeilingSurface,
+	OuterFloorSurface,
+	MeasuredHeight,
+	// gml
+	Id,
+	BoundedBy,
+	Envelope,
+	LowerCorner,
+	UpperCorner,
+	Solid,
+	Exterior,
+	Interior,
+	CompositeSurface,
+	MultiSurface,
+	SurfaceMember,
+	Polygon,
+	LinearRing,
+	PosList,
+	// xAL
+	AddressDetails,
+	Country,
+	Locality,
+	Thoroughfare,
+	ThoroughfareName,
+	ThoroughfareNumber,
+	PostalCode,
+	PostalCodeNumber,
+
+	Num,
+	/** Nur in Pfadregeln: jedes Element, auch unbekannte */
+	Any = Num,
+};
+
+/** Bedeutung eines Elements auf dem Stapel des Readers, ergibt sich aus der Bedeutung des Elternelements und dem Tag */
+enum class ECityGMLNode : uint8
+{
+	Other,
+	Root,
+	RootChild,
+	RootBoundedBy,
+	RootEnvelope,
+	Building,
+	BuildingBoundedBy,
+	BuildingEnvelope,
+	MeasuredHeight,
+	LowerCorner,
+	UpperCorner,
+	Lod1Solid,
+	Solid,
+	SolidExterior,
+	BoundedBy,
+	Surface,
+	MultiSurfaceProperty,
+	MemberContainer,
+	SurfaceMember,
+	Polygon,
+	PolygonExterior,
+	LinearRing,
+	PosList,
+	PolygonInterior,
+	InteriorRing,
+	InteriorPosList,
+	Address,
+	AddressCore,
+	AddressXal,
+	AddressDetails,
+	AddressCountry,
+	AddressLocality,
+	AddressThoroughfare,
+	ThoroughfareName,
+	ThoroughfareNumber,
+	AddressPostalCode,
+	PostalCodeNumber,
+
+	Num,
+};
+
+/** Ein Schritt eines Elementpfads: ein Kind mit Tag unter einem Element mit Bedeutung Parent bekommt die Bedeutung Node */
+struct FCityGMLPathRule
+{
+	ECityGMLNode Parent;
+	ECityGMLTag Tag;
+	ECityGMLNode Node;
+};
+
+/** Beschreibung eines LoD: die Pfade zu seinen Flächen und wie aus den Flächen Faces werden */
+struct FCityGMLLoDPaths
+{
+	/** "LoD1", "LoD2" oder "LoD3", leer solange das LoD der Datei noch nicht feststeht */
+	const TCHAR* LoD;
+	/** Pro Begrenzungsfläche genau ein Face aus dem ersten surfaceMember, sonst ein Face pro surfaceMember */
+	bool bOneFacePerSurface;
+	/** Pfade zusätzlich zu den gemeinsamen Pfaden für Gebäude, Envelope, Polygone und Adressen */
+	TArrayView<const FCityGMLPathRule> Rules;
+};
+
+/**
+ * Interniert die Tags eines Dokuments: jeder qualifizierte Name wird nur beim ersten Auftreten über seinen Präfix
+ * und die Namespace-Deklarationen aufgelöst, danach genügt ein Hash und ein Vergleich der Bytes.
+ * Nicht deklarierte Präfixe werden wie bisher über die üblichen Namen core, bldg, gml und xAL zugeordnet.
+ */
+class FCityGMLTagTable
+{
+public:
+	FCityGMLTagTable();
+
+	/** Vergisst alle Deklarationen und Namen, für ein neues Dokument */
+	void Reset();
+	/**
+	 * Deklariert einen Präfix für das Element in Tiefe Depth und seine Kinder.
+	 *
+	 * @param Prefix Der Präfix, leer für den Default-Namespace
+	 * @param Uri Die URI aus dem xmlns-Attribut
+	 * @param Depth Tiefe des deklarierenden Elements, 0 für das Wurzelelement
+	 */
+	void DeclareNamespace(FAnsiStringView Prefix, FAnsiStringView Uri, int32 Depth);
+	/** Ein Element in Tiefe Depth wurde geschlossen, seine Deklarationen verfallen */
+	void EndScope(int32 Depth);
+	/** Tag eines Element- oder Attributnamens wie `bldg:Building` */
+	ECityGMLTag Resolve(FAnsiStringView QualifiedName);
+	/** Anzahl der verschiedenen Namen im Dokument */
+	int32 NumInterned() const { return NumEntries; }
+
+private:
+	struct FBinding
+	{
+		TArray<ANSICHAR> Prefix;
+		ECityGMLNamespace Namespace;
+		int32 Depth;
+	};
+	struct FEntry
+	{
+		uint32 Hash = 0;
+		int32 NameOffset = INDEX_NONE;
+		int32 NameLength = 0;
+		ECityGMLTag Tag = ECityGMLTag::Unknown;
+	};
+
+	ECityGMLNamespace FindNamespace(FAnsiStringView Prefix) const;
+	void Insert(uint32 Hash, int32 NameOffset, int32 NameLength, ECityGMLTag Tag);
+	/** Leert die internierten Namen, für ein neues Dokument */
+	void ClearNames();
+	/** Bestimmt die Tags der internierten Namen mit diesem Präfix neu, nachdem sich sein Namespace geändert hat */
+	void RebindPrefix(FAnsiStringView Prefix);
+
+	TArray<FBinding> Bindings;
+	/** Offene Adressierung, die Größe ist immer eine Zweierpotenz */
+	TArray<FEntry> Entries;
+	TArray<ANSICHAR> Names;
+	int32 NumEntries = 0;
+};
+
+/**
+ * Übergangstabelle aus den Pfaden eines LoD: für jede Bedeutung und jeden Tag steht die Bedeutung des Kindes fest,
+ * die Zuordnung eines Elements ist damit ein einziger Tabellenzugriff.
+ */
+class FCityGMLPathMatcher
+{
+public:
+	/** Baut die Tabelle aus den gemeinsamen Pfaden und denen des LoD */
+	void Compile(const FCityGMLLoDPaths& Paths);
+
+	FORCEINLINE ECityGMLNode Match(ECityGMLNode Parent, ECityGMLTag Tag) const
+	{
+		return Transitions[int32(Parent) * int32(ECityGMLTag::Num) + int32(Tag)];
+	}
+
+private:
+	TArray<ECityGMLNode> Transitions;
+};
+
+namespace CityGMLTagPaths
+{
+	/** Pfade, solange das LoD der Datei nicht feststeht. Die erste Geometrie-Eigenschaft legt es fest */
+	const FCityGMLLoDPaths& GetUndecided();
+	/** Die Pfade eines LoD, nullptr für nicht unterstützte LoDs */
+	const FCityGMLLoDPaths* FindLoD(const FString& LoD);
+	/** Das LoD, zu dem eine Geometrie-Eigenschaft wie bldg:lod2MultiSurface gehört */
+	const FCityGMLLoDPaths* FindLoDByGeometry(ECityGMLTag GeometryProperty);
+	/** Art einer Begrenzungsfläche aus ihrem Tag */
+	ECityGMLSurfaceType GetSurfaceType(ECityGMLTag SurfaceTag);
+}
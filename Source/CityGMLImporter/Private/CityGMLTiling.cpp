@@ -0,0 +1,193 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#include "CityGMLTiling.h"
+#include "CityGMLGeometryCache.h"
+#include "Async/ParallelFor.h"
+#include "HAL/FileManager.h"
+#include "Misc/Paths.h"
+
+namespace
+{
+    // Schlüssel der ausgelagerten Dateien, sie werden nur innerhalb eines Imports gelesen
+    const TCHAR* SpillKey = TEXT("CityGMLSpill");
+
+    int64 GetTileBytes(const TArray<FCityGMLTile>& Tiles)
+    {
+        int64 Bytes = 0;
+        for (const FCityGMLTile& Tile : Tiles) {
+            Bytes += Tile.Geometry.GetAllocatedSize();
+        }
+        return Bytes;
+    }
+}
+
+void CityGMLTiling::BuildTiles(const FCityGMLGeometryStore& Geometry, float TileSize, TArray<FCityGMLTile>& OutTiles)
+{
+    OutTiles.Reset();
+    if (TileSize <= 0.0f || Geometry.NumBuildings() == 0) {
+        return;
+    }
+
+    // Gebäude einsortieren, die Reihenfolge innerhalb einer Kachel bleibt die des Speichers
+    TMap<FIntPoint, TArray<int32>> BuildingsPerCell;
+    for (int32 Building = 0; Building < Geometry.NumBuildings(); ++Building) {
+        const FVector Centroid = Geometry.GetBuildingCentroid(Building);
+        const FIntPoint Cell(FMath::FloorToInt(Centroid.X / TileSize), FMath::FloorToInt(Centroid.Y / TileSize));
+        BuildingsPerCell.FindOrAdd(Cell).Add(Building);
+    }
+
+    TArray<FIntPoint> Cells;
+    BuildingsPerCell.GetKeys(Cells);
+    Cells.Sort([](const FIntPoint& A, const FIntPoint& B) {
+        return A.Y != B.Y ? A.Y < B.Y : A.X < B.X;
+    });
+
+    OutTiles.SetNum(Cells.Num());
+    for (int32 i = 0; i < Cells.Num(); ++i) {
+        OutTiles[i].Cell = Cells[i];
+        OutTiles[i].Origin = FVector((Cells[i].X + 0.5f) * TileSize, (Cells[i].Y + 0.5f) * TileSize, 0.0f);
+    }
+
+    // Jede Kachel hat ihren eigenen Speicher, die Kacheln können daher parallel befüllt werden
+    ParallelFor(OutTiles.Num(), [&Geometry, &OutTiles, &BuildingsPerCell](int32 i) {
+        FCityGMLTile& Tile = OutTiles[i];
+        for (int32 Building : BuildingsPerCell.FindChecked(Tile.Cell)) {
+            Tile.Geometry.AppendBuilding(Geometry, Building, -Tile.Origin);
+        }
+        Tile.NumTriangles = Tile.Geometry.NumTriangles();
+    });
+}
+
+void FCityGMLTileSpool::Begin(float InTileSize, int64 InBudgetBytes)
+{
+    // Löscht auch Reste eines abgebrochenen Imports
+    SpillDir = FPaths::Combine(FPaths::ProjectSavedDir(), TEXT("CityGMLSpill"));
+    Reset();
+    bActive = true;
+    TileSize = InTileSize;
+    BudgetBytes = InBudgetBytes;
+}
+
+void FCityGMLTileSpool::AddFile(const FCityGMLGeometryStore& Geometry, int64 OutstandingBytes)
+{
+    // Hash mit den ursprünglichen Positionen, wie ihn HashMeshJobs ohne Budget über den globalen Speicher bildet
+    const int32 FirstHash = BuildingHashes.Num();
+    BuildingHashes.AddUninitialized(Geometry.NumBuildings());
+    ParallelFor(Geometry.NumBuildings(), [this, &Geometry, FirstHash](int32 Building) {
+        BuildingHashes[FirstHash + Building] = Geometry.GetBuildingHash(Building);
+    });
+
+    TArray<FCityGMLTile> FileTiles;
+    CityGMLTiling::BuildTiles(Geometry, TileSize, FileTiles);
+    // Der Hash hängt nicht von der Lage im Speicher ab, er kann daher schon auf den Kacheln der Datei gebildet werden
+    ParallelFor(FileTiles.Num(), [&FileTiles](int32 i) {
+        FCityGMLTile& FileTile = FileTiles[i];
+        FileTile.BuildingHashes.SetNumUninitialized(FileTile.Geometry.NumBuildings());
+        for (int32 Building = 0; Building < FileTile.Geometry.NumBuildings(); ++Building) {
+            FileTile.BuildingHashes[Building] = FileTile.Geometry.GetBuildingHash(Building);
+        }
+    });
+    PeakBytes = FMath::Max(PeakBytes, ResidentBytes + OutstandingBytes + int64(Geometry.GetAllocatedSize()) + GetTileBytes(FileTiles));
+
+    for (FCityGMLTile& FileTile : FileTiles) {
+        if (const int32* TileIndex = TileIndices.Find(FileTile.Cell)) {
+            FCityGMLTile& Tile = Tiles[*TileIndex];
+            Tile.Geometry.Append(MoveTemp(FileTile.Geometry));
+            Tile.BuildingHashes.Append(FileTile.BuildingHashes);
+            Tile.NumTriangles += FileTile.NumTriangles;
+        }
+        else {
+            TileIndices.Add(FileTile.Cell, Tiles.Num());
+            Tiles.Add(MoveTemp(FileTile));
+        }
+    }
+    ResidentBytes = GetTileBytes(Tiles);
+    PeakBytes = FMath::Max(PeakBytes, ResidentBytes + OutstandingBytes + int64(Geometry.GetAllocatedSize()));
+
+    // Die Dateien, die noch gelesen werden oder auf ihre Verteilung warten, teilen sich die drei Viertel mit den Kacheln
+    const int64 TargetBytes = FMath::Max<int64>(BudgetBytes * 3 / 4 - OutstandingBytes, 0);
+    if (ResidentBytes > TargetBytes) {
+        SpillLargestTiles(TargetBytes);
+    }
+}
+
+void FCityGMLTileSpool::SpillLargestTiles(int64 TargetBytes)
+{
+    TArray<int32> Order;
+    for (int32 TileIndex = 0; TileIndex < Tiles.Num(); ++TileIndex) {
+        if (Tiles[TileIndex].Geometry.NumBuildings() > 0) {
+            Order.Add(TileIndex);
+        }
+    }
+    Order.Sort([this](int32 A, int32 B) {
+        return Tiles[A].Geometry.GetAllocatedSize() > Tiles[B].Geometry.GetAllocatedSize();
+    });
+
+    for (const int32 TileIndex : Order) {
+        if (ResidentBytes <= TargetBytes) {
+            break;
+        }
+        FCityGMLTile& Tile = Tiles[TileIndex];
+        const FString SpillPath = FPaths::Combine(SpillDir, FString::Printf(TEXT("Tile_%d_%d_%d.cgmcache"), Tile.Cell.X, Tile.Cell.Y, Tile.SpillFiles.Num()));
+        if (!CityGMLGeometryCache::SaveToFile(SpillPath, SpillKey, Tile.Geometry, FString())) {
+            // Die Kachel bleibt im Speicher, das Budget wird dann überschritten
+            break;
+        }
+        ResidentBytes -= Tile.Geometry.GetAllocatedSize();
+        SpilledBytes += IFileManager::Get().FileSize(*SpillPath);
+        NumSpillFiles++;
+        Tile.SpillFiles.Add(SpillPath);
+        Tile.Geometry.Reset();
+    }
+}
+
+void FCityGMLTileSpool::Finish(TArray<FCityGMLTile>& OutTiles)
+{
+    Tiles.Sort([](const FCityGMLTile& A, const FCityGMLTile& B) {
+        return A.Cell.Y != B.Cell.Y ? A.Cell.Y < B.Cell.Y : A.Cell.X < B.Cell.X;
+    });
+    OutTiles = MoveTemp(Tiles);
+    Tiles.Reset();
+    TileIndices.Reset();
+}
+
+bool FCityGMLTileSpool::LoadTile(FCityGMLTile& Tile) const
+{
+    if (Tile.SpillFiles.Num() == 0) {
+        return true;
+    }
+
+    // Die ausgelagerten Teile sind älter als die Gebäude im Speicher und kommen daher zuerst
+    bool bLoaded = true;
+    FCityGMLGeometryStore Geometry;
+    for (const FString& SpillPath : Tile.SpillFiles) {
+        FCityGMLGeometryStore Part;
+        FString LoD;
+        if (!CityGMLGeometryCache::LoadFromFile(SpillPath, SpillKey, Part, LoD)) {
+            UE_LOG(LogTemp, Warning, TEXT("Could not read spilled CityGML tile %s"), *SpillPath);
+            bLoaded = false;
+            continue;
+        }
+        Geometry.Append(MoveTemp(Part));
+        IFileManager::Get().Delete(*SpillPath, false, false, true);
+    }
+    Geometry.Append(MoveTemp(Tile.Geometry));
+    Tile.Geometry = MoveTemp(Geometry);
+    Tile.SpillFiles.Reset();
+    return bLoaded;
+}
+
+void FCityGMLTileSpool::Reset()
+{
+    if (!SpillDir.IsEmpty()) {
+        IFileManager::Get().DeleteDirectory(*SpillDir, false, true);
+    }
+    bActive = false;
+    Tiles.Empty();
+    TileIndices.Empty();
+    BuildingHashes.Empty();
+    ResidentBytes = 0;
+    PeakBytes = 0;
+    SpilledBytes = 0;
+    NumSpillFiles = 0;
+}
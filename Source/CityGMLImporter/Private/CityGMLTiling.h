@@ -0,0 +1,117 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "CityGMLGeometryStore.h"
+
+/**
+ * Eine Kachel eines regelmäßigen Rasters in der Grundebene mit allen Gebäuden, deren Grundriss-Schwerpunkt in ihr liegt.
+ * Die Positionen der Gebäude sind auf den Ursprung der Kachel bezogen, sodass der Actor der Kachel
+ * an Origin platziert wird und jede Kachel einzeln vom Renderer verworfen werden kann.
+ */
+struct FCityGMLTile
+{
+	/** Zelle im Raster, X und Y in Kacheln */
+	FIntPoint Cell = FIntPoint::ZeroValue;
+	/** Mittelpunkt der Kachel in Unreal-Koordinaten, Z ist 0 */
+	FVector Origin = FVector::ZeroVector;
+	/** Die Gebäude der Kachel in der Reihenfolge des Quellspeichers */
+	FCityGMLGeometryStore Geometry;
+	/** Dreiecke der Kachel, bleibt gültig, wenn Geometry ausgelagert oder freigegeben ist */
+	int32 NumTriangles = 0;
+
+	/** Nur bei FCityGMLTileSpool: ausgelagerte Teile der Kachel, älteste zuerst, sie gehören vor die Gebäude in Geometry */
+	TArray<FString> SpillFiles;
+	/** Nur bei FCityGMLTileSpool: GetBuildingHash jedes Gebäudes der Kachel, auch der ausgelagerten */
+	TArray<uint64> BuildingHashes;
+};
+
+namespace CityGMLTiling
+{
+	/**
+	 * Verteilt die Gebäude eines Speichers anhand ihres Grundriss-Schwerpunkts auf ein Raster.
+	 * Leere Kacheln werden nicht erzeugt, die Kacheln sind nach Zeile und Spalte sortiert.
+	 *
+	 * @param Geometry Der Speicher mit allen Gebäuden
+	 * @param TileSize Kantenlänge einer Kachel in Unreal-Einheiten, muss größer als 0 sein
+	 * @param OutTiles Die belegten Kacheln
+	 */
+	void BuildTiles(const FCityGMLGeometryStore& Geometry, float TileSize, TArray<FCityGMLTile>& OutTiles);
+}
+
+/**
+ * Baut die Kacheln eines Imports Datei für Datei auf, ohne alle Gebäude gleichzeitig im Speicher zu halten.
+ *
+ * Jede fertige Datei wird sofort auf die Kacheln verteilt und kann danach freigegeben werden.
+ * Belegen die Kacheln zusammen mit den Dateien, die noch gelesen werden oder auf ihre Verteilung warten,
+ * mehr als drei Viertel des Budgets, werden die größten Kacheln im Format des Geometrie-Caches
+ * unter Saved/CityGMLSpill ausgelagert und erst mit LoadTile wieder gelesen, wenn ihr Mesh erzeugt wird.
+ * Das letzte Viertel bleibt für die Datei, die gerade verteilt wird.
+ * Die Kacheln enthalten dieselben Gebäude in derselben Reihenfolge wie bei CityGMLTiling::BuildTiles über alle Dateien.
+ */
+class FCityGMLTileSpool
+{
+public:
+	/**
+	 * Beginnt einen neuen Import, ausgelagerte Dateien eines früheren Imports werden gelöscht.
+	 *
+	 * @param InTileSize Kantenlänge einer Kachel in Unreal-Einheiten, muss größer als 0 sein
+	 * @param InBudgetBytes Obergrenze für die Geometrie der Kacheln und der gerade verteilten Datei
+	 */
+	void Begin(float InTileSize, int64 InBudgetBytes);
+	/**
+	 * Verteilt die Gebäude einer Datei auf die Kacheln und lagert bei Bedarf Kacheln aus.
+	 * Die Dateien müssen in Auswahlreihenfolge übergeben werden.
+	 *
+	 * @param Geometry Die Geometrie der Datei, wird danach nicht mehr benötigt
+	 * @param OutstandingBytes Speicher der übrigen Dateien, die gerade gelesen werden oder auf ihre Verteilung warten
+	 */
+	void AddFile(const FCityGMLGeometryStore& Geometry, int64 OutstandingBytes = 0);
+	/**
+	 * Übergibt die Kacheln nach der letzten Datei, nach Zeile und Spalte sortiert.
+	 * Ausgelagerte Kacheln enthalten in Geometry nur die Gebäude seit dem letzten Auslagern.
+	 *
+	 * @param OutTiles Die belegten Kacheln
+	 */
+	void Finish(TArray<FCityGMLTile>& OutTiles);
+	/**
+	 * Liest die ausgelagerten Teile einer Kachel wieder ein, danach enthält Geometry alle Gebäude der Kachel.
+	 *
+	 * @param Tile Eine Kachel aus Finish
+	 * @return false, wenn ein Teil nicht gelesen werden konnte
+	 */
+	bool LoadTile(FCityGMLTile& Tile) const;
+	/** Löscht alle ausgelagerten Dateien und beendet den Import */
+	void Reset();
+
+	bool IsActive() const { return bActive; }
+	/** GetBuildingHash jedes Gebäudes mit seinen ursprünglichen Positionen, in Reihenfolge der Dateien */
+	const TArray<uint64>& GetBuildingHashes() const { return BuildingHashes; }
+	int64 GetBudgetBytes() const { return BudgetBytes; }
+	/** Speicher der Geometrie aller Kacheln, die nicht ausgelagert ist */
+	int64 GetResidentBytes() const { return ResidentBytes; }
+	/** Höchster Speicherbedarf der Kacheln zusammen mit der gerade verteilten und den noch ausstehenden Dateien */
+	int64 GetPeakBytes() const { return PeakBytes; }
+	/** Größe aller ausgelagerten Dateien */
+	int64 GetSpilledBytes() const { return SpilledBytes; }
+	int32 GetNumSpillFiles() const { return NumSpillFiles; }
+
+private:
+	/** Lagert die größten Kacheln aus, bis sie höchstens TargetBytes belegen */
+	void SpillLargestTiles(int64 TargetBytes);
+
+	bool bActive = false;
+	float TileSize = 0.0f;
+	int64 BudgetBytes = 0;
+	FString SpillDir;
+	TArray<FCityGMLTile> Tiles;
+	/** Zelle -> Index in Tiles */
+	TMap<FIntPoint, int32> TileIndices;
+	TArray<uint64> BuildingHashes;
+	/** Speicher der Geometrie aller Kacheln, die nicht ausgelagert ist */
+	int64 ResidentBytes = 0;
+	int64 PeakBytes = 0;
+	int64 SpilledBytes = 0;
+	int32 NumSpillFiles = 0;
+};
@@ -0,0 +1,610 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#include "CityGMLTriangulator.h"
+#include "CityGMLVertexKernels.h"
+#include "HAL/IConsoleManager.h"
+#include "Math/RandomStream.h"
+#include "GeometryData.h"
+#include "GeometryDataHelper.h"
+
+FVector FCityGMLTriangulator::ComputeNormal(TArrayView<const FVector> Ring)
+{
+    return CityGMLVertexKernels::ComputeRingNormal(Ring);
+}
+
+FVector FCityGMLTriangulator::Triangulate(TArrayView<const FVector> Points, TArrayView<const int32> HoleStarts, int32 IndexBase, TArray<int32>& OutIndices)
+{
+    const int32 NumPoints = Points.Num();
+    const int32 OuterEnd = HoleStarts.Num() > 0 ? HoleStarts[0] : NumPoints;
+    if (OuterEnd < 3) {
+        return FVector::ZeroVector;
+    }
+    const FVector Normal = ComputeNormal(MakeArrayView(Points.GetData(), OuterEnd));
+    if (Normal.IsZero()) {
+        return Normal;
+    }
+
+    // Basis mit U x V = Normal, der äußere Ring läuft in der Ebene damit immer gegen den Uhrzeigersinn
+    const FVector U = (FMath::Abs(Normal.Z) < 0.9f ? FVector::CrossProduct(FVector::UpVector, Normal) : FVector::CrossProduct(FVector::ForwardVector, Normal)).GetSafeNormal();
+    const FVector V = FVector::CrossProduct(Normal, U);
+    const FVector Origin = Points[0];
+    Projected.SetNumUninitialized(NumPoints, false);
+    for (int32 i = 0; i < NumPoints; ++i) {
+        const FVector Point = Points[i] - Origin;
+        Projected[i] = FVector2D(FVector::DotProduct(Point, U), FVector::DotProduct(Point, V));
+    }
+
+    // Der Fan ist nur bei Dreiecken und streng konvexen Vierecken sicher gültig
+    if (HoleStarts.Num() == 0 && (NumPoints == 3 || (NumPoints == 4 && IsConvexQuad()))) {
+        for (int32 k = 1; k < NumPoints - 1; ++k) {
+            OutIndices.Add(IndexBase);
+            OutIndices.Add(IndexBase + k);
+            OutIndices.Add(IndexBase + k + 1);
+        }
+        return Normal;
+    }
+
+    NumEarClipped++;
+    Output = &OutIndices;
+    OutputBase = IndexBase;
+    Nodes.Reset();
+    int32 OuterNode = LinkRing(0, OuterEnd, true);
+    if (OuterNode == INDEX_NONE || Nodes[OuterNode].Next == Nodes[OuterNode].Prev) {
+        return Normal;
+    }
+    if (HoleStarts.Num() > 0) {
+        OuterNode = EliminateHoles(HoleStarts, NumPoints, OuterNode);
+    }
+    EarcutLinked(OuterNode, 0);
+    Output = nullptr;
+    return Normal;
+}
+
+void FCityGMLTriangulator::TriangulateBatch(const FCityGMLPolygonBatch& Batch, TArray<int32>& OutIndices, TArray<int32>* OutPolygonIndexStart)
+{
+    for (int32 Polygon = 0; Polygon < Batch.NumPolygons(); ++Polygon) {
+        if (OutPolygonIndexStart) {
+            OutPolygonIndexStart->Add(OutIndices.Num());
+        }
+        const int32 FirstRing = Batch.PolygonRingStart[Polygon];
+        const int32 RingEnd = Batch.GetPolygonRingEnd(Polygon);
+        if (FirstRing >= RingEnd) {
+            continue;
+        }
+        const int32 PointBegin = Batch.RingStart[FirstRing];
+        const int32 PointEnd = Batch.GetRingEnd(RingEnd - 1);
+        BatchHoleStarts.Reset();
+        for (int32 Ring = FirstRing + 1; Ring < RingEnd; ++Ring) {
+            BatchHoleStarts.Add(Batch.RingStart[Ring] - PointBegin);
+        }
+        Triangulate(MakeArrayView(Batch.Points.GetData() + PointBegin, PointEnd - PointBegin), BatchHoleStarts, PointBegin, OutIndices);
+    }
+}
+
+bool FCityGMLTriangulator::IsConvexQuad() const
+{
+    for (int32 i = 0; i < 4; ++i) {
+        const FVector2D& A = Projected[i];
+        const FVector2D& B = Projected[(i + 1) % 4];
+        const FVector2D& C = Projected[(i + 2) % 4];
+        if (FVector2D::CrossProduct(B - A, C - B) <= 0.0f) {
+            return false;
+        }
+    }
+    return true;
+}
+
+int32 FCityGMLTriangulator::InsertNode(int32 Index, int32 Last)
+{
+    const int32 Node = Nodes.Add(FNode{ Index, Projected[Index].X, Projected[Index].Y, INDEX_NONE, INDEX_NONE });
+    if (Last == INDEX_NONE) {
+        Nodes[Node].Prev = Node;
+        Nodes[Node].Next = Node;
+    }
+    else {
+        const int32 LastNext = Nodes[Last].Next;
+        Nodes[Node].Next = LastNext;
+        Nodes[Node].Prev = Last;
+        Nodes[LastNext].Prev = Node;
+        Nodes[Last].Next = Node;
+    }
+    return Node;
+}
+
+void FCityGMLTriangulator::RemoveNode(int32 Node)
+{
+    // Prev und Next des entfernten Knotens bleiben gesetzt, die Aufrufer laufen darüber weiter
+    Nodes[Nodes[Node].Next].Prev = Nodes[Node].Prev;
+    Nodes[Nodes[Node].Prev].Next = Nodes[Node].Next;
+}
+
+int32 FCityGMLTriangulator::LinkRing(int32 Begin, int32 End, bool bOuter)
+{
+    float SignedArea = 0.0f;
+    for (int32 i = Begin, j = End - 1; i < End; j = i++) {
+        SignedArea += (Projected[j].X - Projected[i].X) * (Projected[i].Y + Projected[j].Y);
+    }
+
+    int32 Last = INDEX_NONE;
+    if (bOuter == (SignedArea > 0.0f)) {
+        for (int32 i = Begin; i < End; ++i) {
+            Last = InsertNode(i, Last);
+        }
+    }
+    else {
+        for (int32 i = End - 1; i >= Begin; --i) {
+            Last = InsertNode(i, Last);
+        }
+    }
+    if (Last != INDEX_NONE && Equals(Last, Nodes[Last].Next)) {
+        RemoveNode(Last);
+        Last = Nodes[Last].Next;
+    }
+    return Last;
+}
+
+int32 FCityGMLTriangulator::FilterPoints(int32 Start, int32 End)
+{
+    if (Start == INDEX_NONE) {
+        return Start;
+    }
+    if (End == INDEX_NONE) {
+        End = Start;
+    }
+    int32 P = Start;
+    bool bAgain;
+    do {
+        bAgain = false;
+        const int32 Next = Nodes[P].Next;
+        if (Equals(P, Next) || Area(Nodes[P].Prev, P, Next) == 0.0f) {
+            RemoveNode(P);
+            P = End = Nodes[P].Prev;
+            if (P == Nodes[P].Next) {
+                break;
+            }
+            bAgain = true;
+        }
+        else {
+            P = Next;
+        }
+    } while (bAgain || P != End);
+    return End;
+}
+
+void FCityGMLTriangulator::EarcutLinked(int32 Ear, int32 Pass)
+{
+    if (Ear == INDEX_NONE) {
+        return;
+    }
+    int32 Stop = Ear;
+    while (Nodes[Ear].Prev != Nodes[Ear].Next) {
+        const int32 Prev = Nodes[Ear].Prev;
+        const int32 Next = Nodes[Ear].Next;
+        if (IsEar(Ear)) {
+            EmitTriangle(Prev, Ear, Next);
+            RemoveNode(Ear);
+            // Den nächsten Punkt überspringen ergibt weniger schmale Dreiecke
+            Ear = Nodes[Next].Next;
+            Stop = Ear;
+            continue;
+        }
+        Ear = Next;
+
+        // Einmal um den Ring ohne Ohr: erst aufräumen, dann Überschneidungen auflösen, zuletzt teilen
+        if (Ear == Stop) {
+            if (Pass == 0) {
+                EarcutLinked(FilterPoints(Ear), 1);
+            }
+            else if (Pass == 1) {
+                EarcutLinked(CureLocalIntersections(FilterPoints(Ear)), 2);
+            }
+            else {
+                SplitEarcut(Ear);
+            }
+            break;
+        }
+    }
+}
+
+bool FCityGMLTriangulator::IsEar(int32 Ear) const
+{
+    const FNode& A = Nodes[Nodes[Ear].Prev];
+    const FNode& B = Nodes[Ear];
+    const FNode& C = Nodes[Nodes[Ear].Next];
+    if (Area(Nodes[Ear].Prev, Ear, Nodes[Ear].Next) >= 0.0f) {
+        // Spitzer Winkel nach innen, kein Ohr
+        return false;
+    }
+
+    // Kein anderer Punkt darf im Dreieck liegen, das umschließende Rechteck sortiert die meisten schnell aus
+    const float MinX = FMath::Min3(A.X, B.X, C.X);
+    const float MinY = FMath::Min3(A.Y, B.Y, C.Y);
+    const float MaxX = FMath::Max3(A.X, B.X, C.X);
+    const float MaxY = FMath::Max3(A.Y, B.Y, C.Y);
+    for (int32 P = C.Next; P != B.Prev; P = Nodes[P].Next) {
+        const FNode& Node = Nodes[P];
+        if (Node.X >= MinX && Node.X <= MaxX && Node.Y >= MinY && Node.Y <= MaxY
+            && PointInTriangle(A.X, A.Y, B.X, B.Y, C.X, C.Y, Node.X, Node.Y)
+            && Area(Node.Prev, P, Node.Next) >= 0.0f) {
+            return false;
+        }
+    }
+    return true;
+}
+
+int32 FCityGMLTriangulator::CureLocalIntersections(int32 Start)
+{
+    int32 P = Start;
+    do {
+        const int32 A = Nodes[P].Prev;
+        const int32 B = Nodes[Nodes[P].Next].Next;
+        if (!Equals(A, B) && Intersects(A, P, Nodes[P].Next, B) && LocallyInside(A, B) && LocallyInside(B, A)) {
+            EmitTriangle(A, P, B);
+            RemoveNode(Nodes[P].Next);
+            RemoveNode(P);
+            P = Start = B;
+        }
+        P = Nodes[P].Next;
+    } while (P != Start);
+    return FilterPoints(P);
+}
+
+void FCityGMLTriangulator::SplitEarcut(int32 Start)
+{
+    int32 A = Start;
+    do {
+        for (int32 B = Nodes[Nodes[A].Next].Next; B != Nodes[A].Prev; B = Nodes[B].Next) {
+            if (Nodes[A].Index != Nodes[B].Index && IsValidDiagonal(A, B)) {
+                int32 C = SplitPolygon(A, B);
+                A = FilterPoints(A, Nodes[A].Next);
+                C = FilterPoints(C, Nodes[C].Next);
+                EarcutLinked(A, 0);
+                EarcutLinked(C, 0);
+                return;
+            }
+        }
+        A = Nodes[A].Next;
+    } while (A != Start);
+}
+
+int32 FCityGMLTriangulator::EliminateHoles(TArrayView<const int32> HoleStarts, int32 NumPoints, int32 OuterNode)
+{
+    HoleQueue.Reset();
+    for (int32 i = 0; i < HoleStarts.Num(); ++i) {
+        const int32 Begin = HoleStarts[i];
+        const int32 End = i + 1 < HoleStarts.Num() ? HoleStarts[i + 1] : NumPoints;
+        if (End - Begin < 3) {
+            continue;
+        }
+        const int32 List = LinkRing(Begin, End, false);
+        if (List != INDEX_NONE && Nodes[List].Next != Nodes[List].Prev) {
+            HoleQueue.Add(GetLeftmost(List));
+        }
+    }
+
+    // Von links nach rechts, so findet jedes Loch eine Brücke zum äußeren Ring oder zu einem schon eingefügten Loch
+    HoleQueue.Sort([this](int32 A, int32 B) {
+        return Nodes[A].X < Nodes[B].X || (Nodes[A].X == Nodes[B].X && Nodes[A].Y < Nodes[B].Y);
+    });
+    for (int32 Hole : HoleQueue) {
+        OuterNode = EliminateHole(Hole, OuterNode);
+    }
+    return OuterNode;
+}
+
+int32 FCityGMLTriangulator::EliminateHole(int32 Hole, int32 OuterNode)
+{
+    const int32 Bridge = FindHoleBridge(Hole, OuterNode);
+    if (Bridge == INDEX_NONE) {
+        return OuterNode;
+    }
+    const int32 BridgeReverse = SplitPolygon(Bridge, Hole);
+    // Kollineare Punkte an beiden Enden der Brücke entfernen
+    FilterPoints(BridgeReverse, Nodes[BridgeReverse].Next);
+    return FilterPoints(Bridge, Nodes[Bridge].Next);
+}
+
+int32 FCityGMLTriangulator::FindHoleBridge(int32 Hole, int32 OuterNode) const
+{
+    const float HX = Nodes[Hole].X;
+    const float HY = Nodes[Hole].Y;
+    float QX = -MAX_flt;
+    int32 M = INDEX_NONE;
+
+    // Die Kante links vom Loch, die ein Strahl vom linken Punkt des Lochs nach links zuerst trifft
+    int32 P = OuterNode;
+    do {
+        const FNode& Node = Nodes[P];
+        const FNode& Next = Nodes[Node.Next];
+        if (HY <= Node.Y && HY >= Next.Y && Next.Y != Node.Y) {
+            const float X = Node.X + (HY - Node.Y) * (Next.X - Node.X) / (Next.Y - Node.Y);
+            if (X <= HX && X > QX) {
+                QX = X;
+                M = Node.X < Next.X ? P : Node.Next;
+                if (X == HX) {
+                    // Das Loch berührt die Kante, ihr linker Endpunkt ist die Brücke
+                    return M;
+                }
+            }
+        }
+        P = Node.Next;
+    } while (P != OuterNode);
+    if (M == INDEX_NONE) {
+        return M;
+    }
+
+    // Liegen Punkte im Dreieck aus Loch, Schnittpunkt und Endpunkt, wird der mit dem kleinsten Winkel zum Strahl genommen
+    const int32 Stop = M;
+    const float MX = Nodes[M].X;
+    const float MY = Nodes[M].Y;
+    float TanMin = MAX_flt;
+    P = M;
+    do {
+        const FNode& Node = Nodes[P];
+        if (HX >= Node.X && Node.X >= MX && HX != Node.X
+            && PointInTriangle(HY < MY ? HX : QX, HY, MX, MY, HY < MY ? QX : HX, HY, Node.X, Node.Y)) {
+            const float Tan = FMath::Abs(HY - Node.Y) / (HX - Node.X);
+            if (LocallyInside(P, Hole)
+                && (Tan < TanMin || (Tan == TanMin && (Node.X > Nodes[M].X || (Node.X == Nodes[M].X && SectorContainsSector(M, P)))))) {
+                M = P;
+                TanMin = Tan;
+            }
+        }
+        P = Node.Next;
+    } while (P != Stop);
+    return M;
+}
+
+int32 FCityGMLTriangulator::SplitPolygon(int32 A, int32 B)
+{
+    const int32 A2 = Nodes.Add(FNode{ Nodes[A].Index, Nodes[A].X, Nodes[A].Y, INDEX_NONE, INDEX_NONE });
+    const int32 B2 = Nodes.Add(FNode{ Nodes[B].Index, Nodes[B].X, Nodes[B].Y, INDEX_NONE, INDEX_NONE });
+    const int32 AN = Nodes[A].Next;
+    const int32 BP = Nodes[B].Prev;
+
+    Nodes[A].Next = B;
+    Nodes[B].Prev = A;
+    Nodes[A2].Next = AN;
+    Nodes[AN].Prev = A2;
+    Nodes[B2].Next = A2;
+    Nodes[A2].Prev = B2;
+    Nodes[BP].Next = B2;
+    Nodes[B2].Prev = BP;
+    return B2;
+}
+
+int32 FCityGMLTriangulator::GetLeftmost(int32 Start) const
+{
+    int32 Leftmost = Start;
+    int32 P = Start;
+    do {
+        if (Nodes[P].X < Nodes[Leftmost].X || (Nodes[P].X == Nodes[Leftmost].X && Nodes[P].Y < Nodes[Leftmost].Y)) {
+            Leftmost = P;
+        }
+        P = Nodes[P].Next;
+    } while (P != Start);
+    return Leftmost;
+}
+
+bool FCityGMLTriangulator::IsValidDiagonal(int32 A, int32 B) const
+{
+    const FNode& NA = Nodes[A];
+    const FNode& NB = Nodes[B];
+    if (Nodes[NA.Next].Index == NB.Index || Nodes[NA.Prev].Index == NB.Index || IntersectsPolygon(A, B)) {
+        return false;
+    }
+    // Sichtbar und ohne gegenläufige Sektoren, oder der Sonderfall einer Diagonale der Länge null
+    return (LocallyInside(A, B) && LocallyInside(B, A) && MiddleInside(A, B) && (Area(NA.Prev, A, NB.Prev) != 0.0f || Area(A, NB.Prev, B) != 0.0f))
+        || (Equals(A, B) && Area(NA.Prev, A, NA.Next) > 0.0f && Area(NB.Prev, B, NB.Next) > 0.0f);
+}
+
+bool FCityGMLTriangulator::Intersects(int32 P1, int32 Q1, int32 P2, int32 Q2) const
+{
+    const float O1 = FMath::Sign(Area(P1, Q1, P2));
+    const float O2 = FMath::Sign(Area(P1, Q1, Q2));
+    const float O3 = FMath::Sign(Area(P2, Q2, P1));
+    const float O4 = FMath::Sign(Area(P2, Q2, Q1));
+    if (O1 != O2 && O3 != O4) {
+        return true;
+    }
+
+    // Kollineare Punkte berühren die andere Strecke, wenn sie innerhalb ihres Rechtecks liegen
+    auto OnSegment = [this](int32 P, int32 Q, int32 R) {
+        return Nodes[Q].X <= FMath::Max(Nodes[P].X, Nodes[R].X) && Nodes[Q].X >= FMath::Min(Nodes[P].X, Nodes[R].X)
+            && Nodes[Q].Y <= FMath::Max(Nodes[P].Y, Nodes[R].Y) && Nodes[Q].Y >= FMath::Min(Nodes[P].Y, Nodes[R].Y);
+    };
+    return (O1 == 0.0f && OnSegment(P1, P2, Q1))
+        || (O2 == 0.0f && OnSegment(P1, Q2, Q1))
+        || (O3 == 0.0f && OnSegment(P2, P1, Q2))
+        || (O4 == 0.0f && OnSegment(P2, Q1, Q2));
+}
+
+bool FCityGMLTriangulator::IntersectsPolygon(int32 A, int32 B) const
+{
+    const int32 IndexA = Nodes[A].Index;
+    const int32 IndexB = Nodes[B].Index;
+    int32 P = A;
+    do {
+        const int32 Next = Nodes[P].Next;
+        if (Nodes[P].Index != IndexA && Nodes[Next].Index != IndexA && Nodes[P].Index != IndexB && Nodes[Next].Index != IndexB
+            && Intersects(P, Next, A, B)) {
+            return true;
+        }
+        P = Next;
+    } while (P != A);
+    return false;
+}
+
+bool FCityGMLTriangulator::LocallyInside(int32 A, int32 B) const
+{
+    const FNode& NA = Nodes[A];
+    if (Area(NA.Prev, A, NA.Next) < 0.0f) {
+        return Area(A, B, NA.Next) >= 0.0f && Area(A, NA.Prev, B) >= 0.0f;
+    }
+    return Area(A, B, NA.Prev) < 0.0f || Area(A, NA.Next, B) < 0.0f;
+}
+
+bool FCityGMLTriangulator::MiddleInside(int32 A, int32 B) const
+{
+    const float PX = (Nodes[A].X + Nodes[B].X) * 0.5f;
+    const float PY = (Nodes[A].Y + Nodes[B].Y) * 0.5f;
+    bool bInside = false;
+    int32 P = A;
+    do {
+        const FNode& Node = Nodes[P];
+        const FNode& Next = Nodes[Node.Next];
+        if ((Node.Y > PY) != (Next.Y > PY) && Next.Y != Node.Y && PX < (Next.X - Node.X) * (PY - Node.Y) / (Next.Y - Node.Y) + Node.X) {
+            bInside = !bInside;
+        }
+        P = Node.Next;
+    } while (P != A);
+    return bInside;
+}
+
+bool FCityGMLTriangulator::SectorContainsSector(int32 M, int32 P) const
+{
+    return Area(Nodes[M].Prev, M, Nodes[P].Prev) < 0.0f && Area(Nodes[P].Next, M, Nodes[M].Next) < 0.0f;
+}
+
+void FCityGMLTriangulator::EmitTriangle(int32 A, int32 B, int32 C)
+{
+    Output->Add(OutputBase + Nodes[A].Index);
+    Output->Add(OutputBase + Nodes[B].Index);
+    Output->Add(OutputBase + Nodes[C].Index);
+}
+
+namespace
+{
+    /** Fläche eines Rings, über die Newell-Summe und damit unabhängig von seiner Ebene */
+    float RingArea(TArrayView<const FVector> Ring)
+    {
+        FVector Sum = FVector::ZeroVector;
+        for (int32 i = 1; i + 1 < Ring.Num(); ++i) {
+            Sum += FVector::CrossProduct(Ring[i] - Ring[0], Ring[i + 1] - Ring[0]);
+        }
+        return Sum.Size() * 0.5f;
+    }
+
+    /**
+     * Erzeugt sternförmige und damit meist konkave Polygone in zufälligen Ebenen, so groß wie Wände und Dachflächen.
+     * Die Löcher sind Rechtecke im Uhrzeigersinn in einer Reihe um den Mittelpunkt, sie liegen immer im äußeren Ring.
+     */
+    void MakeBenchmarkPolygons(int32 Count, int32 NumVertices, int32 NumHoles, FCityGMLPolygonBatch& OutBatch)
+    {
+        FRandomStream Random(4711);
+        OutBatch.Reset();
+        for (int32 i = 0; i < Count; ++i) {
+            const FQuat Rotation(Random.GetUnitVector(), Random.FRandRange(0.0f, PI));
+            const FVector Center(Random.FRandRange(-100000.0f, 100000.0f), Random.FRandRange(-100000.0f, 100000.0f), Random.FRandRange(0.0f, 5000.0f));
+            const float Radius = Random.FRandRange(300.0f, 2000.0f);
+            OutBatch.AddPolygon();
+            OutBatch.AddRing();
+            for (int32 v = 0; v < NumVertices; ++v) {
+                const float Angle = 2.0f * PI * v / NumVertices;
+                const float R = Radius * Random.FRandRange(0.5f, 1.0f);
+                OutBatch.Points.Add(Center + Rotation.RotateVector(FVector(R * FMath::Cos(Angle), R * FMath::Sin(Angle), 0.0f)));
+            }
+            const float HalfWidth = 0.2f * Radius / FMath::Max(NumHoles, 1);
+            for (int32 h = 0; h < NumHoles; ++h) {
+                const float X = Radius * (-0.25f + 0.5f * (h + 0.5f) / NumHoles);
+                const float Y = 0.1f * Radius;
+                OutBatch.AddRing();
+                OutBatch.Points.Add(Center + Rotation.RotateVector(FVector(X - HalfWidth, -Y, 0.0f)));
+                OutBatch.Points.Add(Center + Rotation.RotateVector(FVector(X - HalfWidth, Y, 0.0f)));
+                OutBatch.Points.Add(Center + Rotation.RotateVector(FVector(X + HalfWidth, Y, 0.0f)));
+                OutBatch.Points.Add(Center + Rotation.RotateVector(FVector(X + HalfWidth, -Y, 0.0f)));
+            }
+        }
+    }
+
+    /**
+     * Misst auf einem Thread GeometryDataHelper::MakeFace gegen FCityGMLTriangulator, dazu Polygone mit Löchern,
+     * die MakeFace nicht kann. Prüft außerdem, ob die Dreiecke genau die Fläche der Polygone abdecken.
+     * Aufruf in der Konsole: CityGML.BenchmarkTriangulation [Anzahl Polygone] [Vertices] [Löcher] [Durchläufe]
+     */
+    void BenchmarkTriangulation(const TArray<FString>& Args)
+    {
+        const int32 Count = FMath::Max(Args.Num() > 0 ? FCString::Atoi(*Args[0]) : 10000, 1);
+        const int32 NumVertices = FMath::Max(Args.Num() > 1 ? FCString::Atoi(*Args[1]) : 12, 4);
+        const int32 NumHoles = FMath::Max(Args.Num() > 2 ? FCString::Atoi(*Args[2]) : 2, 1);
+        const int32 Iterations = FMath::Max(Args.Num() > 3 ? FCString::Atoi(*Args[3]) : 5, 1);
+
+        FCityGMLPolygonBatch Plain;
+        FCityGMLPolygonBatch WithHoles;
+        MakeBenchmarkPolygons(Count, NumVertices, 0, Plain);
+        MakeBenchmarkPolygons(Count, NumVertices, NumHoles, WithHoles);
+
+        // MakeFace braucht ein eigenes Array pro Fläche, die Kopien werden vor der Messung angelegt
+        TArray<TArray<FVector>> Faces;
+        Faces.Reserve(Count);
+        for (int32 Polygon = 0; Polygon < Plain.NumPolygons(); ++Polygon) {
+            const int32 Ring = Plain.PolygonRingStart[Polygon];
+            Faces.Emplace(Plain.Points.GetData() + Plain.RingStart[Ring], Plain.GetRingEnd(Ring) - Plain.RingStart[Ring]);
+        }
+
+        int64 MakeFaceTriangles = 0;
+        double Start = FPlatformTime::Seconds();
+        for (int32 Iteration = 0; Iteration < Iterations; ++Iteration) {
+            for (const TArray<FVector>& Face : Faces) {
+                FGeometryData Data = GeometryDataHelper::MakeFace(Face, false);
+                MakeFaceTriangles += Data.Indices.Num() / 3;
+            }
+        }
+        const double MakeFaceSeconds = FPlatformTime::Seconds() - Start;
+
+        FCityGMLTriangulator Triangulator;
+        TArray<int32> Indices;
+        int64 PlainTriangles = 0;
+        Start = FPlatformTime::Seconds();
+        for (int32 Iteration = 0; Iteration < Iterations; ++Iteration) {
+            Indices.Reset();
+            Triangulator.TriangulateBatch(Plain, Indices);
+            PlainTriangles += Indices.Num() / 3;
+        }
+        const double PlainSeconds = FPlatformTime::Seconds() - Start;
+
+        TArray<int32> PolygonIndexStart;
+        int64 HoleTriangles = 0;
+        Start = FPlatformTime::Seconds();
+        for (int32 Iteration = 0; Iteration < Iterations; ++Iteration) {
+            Indices.Reset();
+            PolygonIndexStart.Reset();
+            Triangulator.TriangulateBatch(WithHoles, Indices, &PolygonIndexStart);
+            HoleTriangles += Indices.Num() / 3;
+        }
+        const double HoleSeconds = FPlatformTime::Seconds() - Start;
+
+        // Die Dreiecke müssen die Fläche des äußeren Rings ohne die Löcher genau abdecken
+        float MaxAreaError = 0.0f;
+        for (int32 Polygon = 0; Polygon < WithHoles.NumPolygons(); ++Polygon) {
+            float Expected = 0.0f;
+            for (int32 Ring = WithHoles.PolygonRingStart[Polygon]; Ring < WithHoles.GetPolygonRingEnd(Polygon); ++Ring) {
+                const float Area = RingArea(MakeArrayView(WithHoles.Points.GetData() + WithHoles.RingStart[Ring], WithHoles.GetRingEnd(Ring) - WithHoles.RingStart[Ring]));
+                Expected += Ring == WithHoles.PolygonRingStart[Polygon] ? Area : -Area;
+            }
+            const int32 IndexEnd = Polygon + 1 < PolygonIndexStart.Num() ? PolygonIndexStart[Polygon + 1] : Indices.Num();
+            float Actual = 0.0f;
+            for (int32 i = PolygonIndexStart[Polygon]; i < IndexEnd; i += 3) {
+                const FVector& A = WithHoles.Points[Indices[i]];
+                Actual += FVector::CrossProduct(WithHoles.Points[Indices[i + 1]] - A, WithHoles.Points[Indices[i + 2]] - A).Size() * 0.5f;
+            }
+            MaxAreaError = FMath::Max(MaxAreaError, FMath::Abs(Actual - Expected) / FMath::Max(Expected, KINDA_SMALL_NUMBER));
+        }
+
+        const double Polygons = double(Count) * Iterations;
+        UE_LOG(LogTemp, Log, TEXT("Triangulation benchmark: %d polygons, %d vertices, %d iterations, one thread"), Count, NumVertices, Iterations);
+        UE_LOG(LogTemp, Log, TEXT("  MakeFace:             %.3f s (%.0f polygons/s, %.0f triangles/s)"),
+            MakeFaceSeconds, Polygons / FMath::Max(MakeFaceSeconds, 1e-9), MakeFaceTriangles / FMath::Max(MakeFaceSeconds, 1e-9));
+        UE_LOG(LogTemp, Log, TEXT("  FCityGMLTriangulator: %.3f s (%.0f polygons/s, %.0f triangles/s), %.1fx faster"),
+            PlainSeconds, Polygons / FMath::Max(PlainSeconds, 1e-9), PlainTriangles / FMath::Max(PlainSeconds, 1e-9), MakeFaceSeconds / FMath::Max(PlainSeconds, 1e-9));
+        UE_LOG(LogTemp, Log, TEXT("  with %d holes:         %.3f s (%.0f polygons/s, %.0f triangles/s)"),
+            NumHoles, HoleSeconds, Polygons / FMath::Max(HoleSeconds, 1e-9), HoleTriangles / FMath::Max(HoleSeconds, 1e-9));
+        UE_LOG(LogTemp, Log, TEXT("  max relative area error with holes %g"), MaxAreaError);
+    }
+
+    FAutoConsoleCommand BenchmarkTriangulationCommand(
+        TEXT("CityGML.BenchmarkTriangulation"),
+        TEXT("Compares the ear clipping triangulator with GeometryDataHelper::MakeFace on one thread. Args: [PolygonCount] [Vertices] [Holes] [Iterations]"),
+        FConsoleCommandWithArgsDelegate::CreateStatic(&BenchmarkTriangulation)
+    );
+}
@@ -0,0 +1,145 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+/**
+ * Viele ebene Polygone in einem gemeinsamen Puffer: alle Punkte hintereinander in Points,
+ * die Ringe über ihren ersten Punkt und die Polygone über ihren ersten Ring. Der erste Ring eines Polygons ist der äußere,
+ * die übrigen sind Löcher. Kein Ring enthält den schließenden Punkt.
+ */
+struct FCityGMLPolygonBatch
+{
+	TArray<FVector> Points;
+	/** Ein Eintrag pro Ring: erster Punkt in Points */
+	TArray<int32> RingStart;
+	/** Ein Eintrag pro Polygon: erster Ring in RingStart */
+	TArray<int32> PolygonRingStart;
+
+	int32 NumPolygons() const { return PolygonRingStart.Num(); }
+	int32 NumRings() const { return RingStart.Num(); }
+	int32 GetRingEnd(int32 Ring) const { return Ring + 1 < RingStart.Num() ? RingStart[Ring + 1] : Points.Num(); }
+	int32 GetPolygonRingEnd(int32 Polygon) const { return Polygon + 1 < PolygonRingStart.Num() ? PolygonRingStart[Polygon + 1] : RingStart.Num(); }
+
+	/** Beginnt ein neues Polygon, der nächste Ring ist sein äußerer */
+	void AddPolygon() { PolygonRingStart.Add(RingStart.Num()); }
+	/** Beginnt einen Ring des zuletzt begonnenen Polygons, seine Punkte werden danach an Points angehängt */
+	void AddRing() { RingStart.Add(Points.Num()); }
+	void Reset()
+	{
+		Points.Reset();
+		RingStart.Reset();
+		PolygonRingStart.Reset();
+	}
+};
+
+/**
+ * Trianguliert ebene Polygone mit Löchern durch Ear Clipping, nach dem Verfahren von earcut.
+ *
+ * Jedes Polygon wird in die Ebene projiziert, die am besten zu seinem äußeren Ring passt (Newell-Normale).
+ * Löcher werden über eine Brücke zum äußeren Ring in einen einzigen Ring eingefügt, danach werden Ohren abgeschnitten.
+ * Findet sich kein Ohr mehr, werden doppelte Punkte entfernt, dann lokale Selbstüberschneidungen aufgelöst und zuletzt
+ * der Ring an einer gültigen Diagonale geteilt, sodass auch unsaubere Daten vollständig trianguliert werden.
+ * Nur Dreiecke und konvexe Vierecke ohne Löcher werden als Fan zerlegt, nur dort ist der Fan sicher gültig.
+ *
+ * Die Arbeitspuffer bleiben zwischen den Polygonen erhalten, nach den ersten Flächen wird nichts mehr allokiert.
+ * Eine Instanz darf nur von einem Thread gleichzeitig benutzt werden.
+ */
+class FCityGMLTriangulator
+{
+public:
+	/**
+	 * Trianguliert ein Polygon und hängt seine Dreiecke an OutIndices an.
+	 * Die Dreiecke haben denselben Umlaufsinn wie der äußere Ring, Löcher dürfen in beiden Richtungen umlaufen.
+	 *
+	 * @param Points Alle Punkte des Polygons, der äußere Ring und danach die Löcher, jeweils ohne schließenden Punkt
+	 * @param HoleStarts Erster Punkt jedes Lochs in Points, leer für ein Polygon ohne Löcher
+	 * @param IndexBase Wird auf jeden Index addiert, z.B. der erste Vertex der Fläche im Geometrie-Speicher
+	 * @param OutIndices Array, an das drei Indizes pro Dreieck angehängt werden
+	 * @return Normale der Ebene des äußeren Rings, der Nullvektor wenn der äußere Ring keine Fläche hat
+	 */
+	FVector Triangulate(TArrayView<const FVector> Points, TArrayView<const int32> HoleStarts, int32 IndexBase, TArray<int32>& OutIndices);
+	/**
+	 * Trianguliert alle Polygone eines Puffers, die Indizes beziehen sich auf Batch.Points.
+	 *
+	 * @param Batch Die Polygone
+	 * @param OutIndices Die Dreiecke aller Polygone, werden angehängt
+	 * @param OutPolygonIndexStart Optional, pro Polygon der erste seiner Indizes in OutIndices
+	 */
+	void TriangulateBatch(const FCityGMLPolygonBatch& Batch, TArray<int32>& OutIndices, TArray<int32>* OutPolygonIndexStart = nullptr);
+
+	/** Normale eines Rings nach Newell, auch für konkave und nicht ganz ebene Ringe. Nullvektor bei entarteten Ringen, siehe CityGMLVertexKernels::ComputeRingNormal */
+	static FVector ComputeNormal(TArrayView<const FVector> Ring);
+
+	/** Anzahl der Polygone, die seit dem Anlegen durch Ear Clipping statt als Fan zerlegt wurden */
+	int32 GetNumEarClipped() const { return NumEarClipped; }
+
+private:
+	/** Ein Punkt im doppelt verketteten Ring, Brücken zu Löchern verdoppeln Punkte */
+	struct FNode
+	{
+		/** Index des Punkts im Polygon */
+		int32 Index;
+		float X;
+		float Y;
+		int32 Prev;
+		int32 Next;
+	};
+
+	int32 InsertNode(int32 Index, int32 Last);
+	void RemoveNode(int32 Node);
+	/** Verkettet einen Ring, der äußere gegen und Löcher im Uhrzeigersinn. Gibt den letzten Knoten zurück */
+	int32 LinkRing(int32 Begin, int32 End, bool bOuter);
+	/** Entfernt doppelte und kollineare Punkte zwischen Start und End */
+	int32 FilterPoints(int32 Start, int32 End = INDEX_NONE);
+	void EarcutLinked(int32 Ear, int32 Pass);
+	bool IsEar(int32 Ear) const;
+	int32 CureLocalIntersections(int32 Start);
+	void SplitEarcut(int32 Start);
+	int32 EliminateHoles(TArrayView<const int32> HoleStarts, int32 NumPoints, int32 OuterNode);
+	int32 EliminateHole(int32 Hole, int32 OuterNode);
+	int32 FindHoleBridge(int32 Hole, int32 OuterNode) const;
+	/** Teilt den Ring an der Diagonale A-B in zwei Ringe und gibt den Knoten nach der Kopie von B zurück */
+	int32 SplitPolygon(int32 A, int32 B);
+	int32 GetLeftmost(int32 Start) const;
+	bool IsValidDiagonal(int32 A, int32 B) const;
+	bool IntersectsPolygon(int32 A, int32 B) const;
+	bool LocallyInside(int32 A, int32 B) const;
+	bool MiddleInside(int32 A, int32 B) const;
+	bool SectorContainsSector(int32 M, int32 P) const;
+	/** true, wenn sich die Strecken P1-Q1 und P2-Q2 schneiden oder berühren */
+	bool Intersects(int32 P1, int32 Q1, int32 P2, int32 Q2) const;
+	/** true, wenn die ersten vier projizierten Punkte ein streng konvexes Viereck gegen den Uhrzeigersinn bilden */
+	bool IsConvexQuad() const;
+	void EmitTriangle(int32 A, int32 B, int32 C);
+
+	/** Doppelte Fläche des Dreiecks P, Q, R mit umgekehrtem Vorzeichen, negativ bei Drehung gegen den Uhrzeigersinn */
+	float Area(int32 P, int32 Q, int32 R) const
+	{
+		const FNode& NP = Nodes[P];
+		const FNode& NQ = Nodes[Q];
+		const FNode& NR = Nodes[R];
+		return (NQ.Y - NP.Y) * (NR.X - NQ.X) - (NQ.X - NP.X) * (NR.Y - NQ.Y);
+	}
+	bool Equals(int32 A, int32 B) const { return Nodes[A].X == Nodes[B].X && Nodes[A].Y == Nodes[B].Y; }
+	/** true, wenn P im Dreieck A, B, C oder auf seinem Rand liegt */
+	static bool PointInTriangle(float AX, float AY, float BX, float BY, float CX, float CY, float PX, float PY)
+	{
+		return (CX - PX) * (AY - PY) >= (AX - PX) * (CY - PY)
+			&& (AX - PX) * (BY - PY) >= (BX - PX) * (AY - PY)
+			&& (BX - PX) * (CY - PY) >= (CX - PX) * (BY - PY);
+	}
+
+	/** Alle Knoten des aktuellen Polygons, Prev und Next sind Indizes in dieses Array */
+	TArray<FNode> Nodes;
+	/** Die Punkte des aktuellen Polygons in der Ebene */
+	TArray<FVector2D> Projected;
+	/** Linker Knoten jedes Lochs, nach X sortiert */
+	TArray<int32> HoleQueue;
+	/** Löcher des aktuellen Polygons bei TriangulateBatch */
+	TArray<int32> BatchHoleStarts;
+	TArray<int32>* Output = nullptr;
+	int32 OutputBase = 0;
+	int32 NumEarClipped = 0;
+};
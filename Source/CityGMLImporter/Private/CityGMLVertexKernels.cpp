@@ -0,0 +1,591 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#include "CityGMLVertexKernels.h"
+#include "HAL/IConsoleManager.h"
+#include "Math/RandomStream.h"
+
+#define CITYGML_SIMD_UTM (PLATFORM_ENABLE_VECTORINTRINSICS && PLATFORM_CPU_X86_FAMILY)
+#if CITYGML_SIMD_UTM
+#include <emmintrin.h>
+#endif
+
+// Die Kernels lesen und schreiben FVector-Puffer als lückenlose Folge von Floats
+static_assert(sizeof(FVector) == 3 * sizeof(float), "FVector must be three packed floats");
+static_assert(sizeof(FVector2D) == 2 * sizeof(float), "FVector2D must be two packed floats");
+
+namespace
+{
+    /** Liest vier aufeinanderfolgende Vertices und sortiert sie in je ein Register für X, Y und Z um */
+    FORCEINLINE void LoadVertices4(const FVector* Vertices, VectorRegister& OutX, VectorRegister& OutY, VectorRegister& OutZ)
+    {
+        const float* Data = &Vertices->X;
+        const VectorRegister R0 = VectorLoad(Data);     // x0 y0 z0 x1
+        const VectorRegister R1 = VectorLoad(Data + 4); // y1 z1 x2 y2
+        const VectorRegister R2 = VectorLoad(Data + 8); // z2 x3 y3 z3
+        const VectorRegister T = VectorShuffle(R1, R2, 2, 3, 1, 2); // x2 y2 x3 y3
+        const VectorRegister U = VectorShuffle(R0, R1, 1, 2, 0, 1); // y0 z0 y1 z1
+        const VectorRegister W = VectorShuffle(R2, R2, 0, 3, 0, 3); // z2 z3 z2 z3
+        OutX = VectorShuffle(R0, T, 0, 3, 0, 2);
+        OutY = VectorShuffle(U, T, 0, 2, 1, 3);
+        OutZ = VectorShuffle(U, W, 1, 3, 0, 1);
+    }
+
+    /** Gegenstück zu LoadVertices4: schreibt vier Vertices aus den Registern für X, Y und Z */
+    FORCEINLINE void StoreVertices4(const VectorRegister& X, const VectorRegister& Y, const VectorRegister& Z, FVector* OutVertices)
+    {
+        float* Data = &OutVertices->X;
+        VectorStore(VectorShuffle(VectorShuffle(X, Y, 0, 1, 0, 1), VectorShuffle(Z, X, 0, 0, 1, 1), 0, 2, 0, 2), Data);
+        VectorStore(VectorShuffle(VectorShuffle(Y, Z, 1, 1, 1, 1), VectorShuffle(X, Y, 2, 3, 2, 3), 0, 2, 0, 2), Data + 4);
+        VectorStore(VectorShuffle(VectorShuffle(Z, X, 2, 2, 3, 3), VectorShuffle(Y, Z, 3, 3, 3, 3), 0, 2, 0, 2), Data + 8);
+    }
+
+    FORCEINLINE float HorizontalSum(const VectorRegister& Value)
+    {
+        float Lanes[4];
+        VectorStore(Value, Lanes);
+        return (Lanes[0] + Lanes[1]) + (Lanes[2] + Lanes[3]);
+    }
+
+    /** Tangente, wenn die aufsummierte keine Richtung in der Ebene hat: irgendeine feste Richtung senkrecht zur Normale */
+    FVector FallbackTangent(const FVector& Normal)
+    {
+        const FVector Tangent = (FMath::Abs(Normal.Z) < 0.9f ? FVector::CrossProduct(FVector::UpVector, Normal) : FVector::CrossProduct(FVector::ForwardVector, Normal)).GetSafeNormal();
+        return Tangent.IsZero() ? FVector::ForwardVector : Tangent;
+    }
+
+    /** Anteil der Summe, der mindestens senkrecht zur Normale liegen muss, sonst ist die Richtung nur Rundungsrauschen */
+    constexpr float MinTangentFraction = 1e-6f;
+}
+
+bool CityGMLVertexKernels::IsVectorized()
+{
+    return PLATFORM_ENABLE_VECTORINTRINSICS != 0;
+}
+
+void CityGMLVertexKernels::TransformUtmScalar(const double* Coordinates, int32 NumVertices, const FCityGMLUtmTransform& Transform, FVector* OutVertices)
+{
+    for (int32 i = 0; i < NumVertices; ++i) {
+        const double* Coordinate = Coordinates + 3 * i;
+        // Vertausche die Achsen: X -> Y und Y -> X ( X Osten/ Y Norden), der Ursprung wird in double abgezogen
+        OutVertices[i] = FVector(
+            float((Coordinate[1] - Transform.OriginY) * Transform.Scale),
+            float((Coordinate[0] - Transform.OriginX) * Transform.Scale),
+            float(Coordinate[2] * Transform.Scale) + Transform.ZOffset);
+    }
+}
+
+void CityGMLVertexKernels::TransformUtm(const double* Coordinates, int32 NumVertices, const FCityGMLUtmTransform& Transform, FVector* OutVertices)
+{
+    int32 i = 0;
+#if CITYGML_SIMD_UTM
+    // Zwei Vertices pro double-Register, dieselben Rechenschritte wie die Referenz und damit bitgleich
+    const __m128d OriginX = _mm_set1_pd(Transform.OriginX);
+    const __m128d OriginY = _mm_set1_pd(Transform.OriginY);
+    const __m128d Scale = _mm_set1_pd(Transform.Scale);
+    const VectorRegister ZOffset = VectorSetFloat1(Transform.ZOffset);
+    for (; i + 4 <= NumVertices; i += 4) {
+        const double* Coordinate = Coordinates + 3 * i;
+        const __m128d D0 = _mm_loadu_pd(Coordinate);      // x0 y0
+        const __m128d D1 = _mm_loadu_pd(Coordinate + 2);  // z0 x1
+        const __m128d D2 = _mm_loadu_pd(Coordinate + 4);  // y1 z1
+        const __m128d D3 = _mm_loadu_pd(Coordinate + 6);  // x2 y2
+        const __m128d D4 = _mm_loadu_pd(Coordinate + 8);  // z2 x3
+        const __m128d D5 = _mm_loadu_pd(Coordinate + 10); // y3 z3
+
+        const __m128d UnrealX01 = _mm_mul_pd(_mm_sub_pd(_mm_shuffle_pd(D0, D2, 1), OriginY), Scale);
+        const __m128d UnrealX23 = _mm_mul_pd(_mm_sub_pd(_mm_shuffle_pd(D3, D5, 1), OriginY), Scale);
+        const __m128d UnrealY01 = _mm_mul_pd(_mm_sub_pd(_mm_shuffle_pd(D0, D1, 2), OriginX), Scale);
+        const __m128d UnrealY23 = _mm_mul_pd(_mm_sub_pd(_mm_shuffle_pd(D3, D4, 2), OriginX), Scale);
+        const __m128d UnrealZ01 = _mm_mul_pd(_mm_shuffle_pd(D1, D2, 2), Scale);
+        const __m128d UnrealZ23 = _mm_mul_pd(_mm_shuffle_pd(D4, D5, 2), Scale);
+
+        const VectorRegister X = _mm_movelh_ps(_mm_cvtpd_ps(UnrealX01), _mm_cvtpd_ps(UnrealX23));
+        const VectorRegister Y = _mm_movelh_ps(_mm_cvtpd_ps(UnrealY01), _mm_cvtpd_ps(UnrealY23));
+        const VectorRegister Z = VectorAdd(_mm_movelh_ps(_mm_cvtpd_ps(UnrealZ01), _mm_cvtpd_ps(UnrealZ23)), ZOffset);
+        StoreVertices4(X, Y, Z, OutVertices + i);
+    }
+#endif
+    TransformUtmScalar(Coordinates + 3 * i, NumVertices - i, Transform, OutVertices + i);
+}
+
+FVector CityGMLVertexKernels::ComputeRingNormalScalar(TArrayView<const FVector> Ring)
+{
+    if (Ring.Num() < 3) {
+        return FVector::ZeroVector;
+    }
+    // Auf den ersten Punkt bezogen, sonst löschen sich bei Unreal-Koordinaten die Stellen gegenseitig aus
+    const FVector Origin = Ring[0];
+    FVector Normal = FVector::ZeroVector;
+    for (int32 i = 0, j = Ring.Num() - 1; i < Ring.Num(); j = i++) {
+        const FVector A = Ring[j] - Origin;
+        const FVector B = Ring[i] - Origin;
+        Normal.X += (A.Y - B.Y) * (A.Z + B.Z);
+        Normal.Y += (A.Z - B.Z) * (A.X + B.X);
+        Normal.Z += (A.X - B.X) * (A.Y + B.Y);
+    }
+    return Normal.GetSafeNormal();
+}
+
+FVector CityGMLVertexKernels::ComputeRingNormal(TArrayView<const FVector> Ring)
+{
+    const int32 NumPoints = Ring.Num();
+    if (NumPoints < 3) {
+        return FVector::ZeroVector;
+    }
+    const FVector Origin = Ring[0];
+    FVector Normal = FVector::ZeroVector;
+
+    // Vier Kanten pro Durchlauf: die Anfangspunkte ab i - 1 und die Endpunkte ab i überlappen sich
+    int32 i = 1;
+    if (NumPoints >= 5) {
+        const VectorRegister OriginX = VectorSetFloat1(Origin.X);
+        const VectorRegister OriginY = VectorSetFloat1(Origin.Y);
+        const VectorRegister OriginZ = VectorSetFloat1(Origin.Z);
+        VectorRegister SumX = VectorZero();
+        VectorRegister SumY = VectorZero();
+        VectorRegister SumZ = VectorZero();
+        for (; i + 4 <= NumPoints; i += 4) {
+            VectorRegister AX, AY, AZ, BX, BY, BZ;
+            LoadVertices4(Ring.GetData() + i - 1, AX, AY, AZ);
+            LoadVertices4(Ring.GetData() + i, BX, BY, BZ);
+            AX = VectorSubtract(AX, OriginX);
+            AY = VectorSubtract(AY, OriginY);
+            AZ = VectorSubtract(AZ, OriginZ);
+            BX = VectorSubtract(BX, OriginX);
+            BY = VectorSubtract(BY, OriginY);
+            BZ = VectorSubtract(BZ, OriginZ);
+            SumX = VectorMultiplyAdd(VectorSubtract(AY, BY), VectorAdd(AZ, BZ), SumX);
+            SumY = VectorMultiplyAdd(VectorSubtract(AZ, BZ), VectorAdd(AX, BX), SumY);
+            SumZ = VectorMultiplyAdd(VectorSubtract(AX, BX), VectorAdd(AY, BY), SumZ);
+        }
+        Normal = FVector(HorizontalSum(SumX), HorizontalSum(SumY), HorizontalSum(SumZ));
+    }
+
+    // Die restlichen Kanten und die schließende Kante vom letzten zum ersten Punkt
+    for (int32 j = i - 1; j < NumPoints; ++j) {
+        const FVector A = Ring[j] - Origin;
+        const FVector B = (j + 1 < NumPoints ? Ring[j + 1] : Ring[0]) - Origin;
+        Normal.X += (A.Y - B.Y) * (A.Z + B.Z);
+        Normal.Y += (A.Z - B.Z) * (A.X + B.X);
+        Normal.Z += (A.X - B.X) * (A.Y + B.Y);
+    }
+    return Normal.GetSafeNormal();
+}
+
+void CityGMLVertexKernels::BoxProjectUVsScalar(TArrayView<const FVector> Vertices, float Scale, FVector2D* OutUVs)
+{
+    for (int32 i = 0; i < Vertices.Num(); ++i) {
+        const FVector& Vertex = Vertices[i];
+        FVector2D& UV = OutUVs[i];
+
+        if (FMath::Abs(Vertex.Z) > FMath::Abs(Vertex.X) && FMath::Abs(Vertex.Z) > FMath::Abs(Vertex.Y)) {
+            // Projekt auf die Z-Ebene
+            UV.X = Vertex.X / Scale;
+            UV.Y = Vertex.Y / Scale;
+        }
+        else if (FMath::Abs(Vertex.X) > FMath::Abs(Vertex.Y)) {
+            // Projekt auf die X-Ebene
+            UV.X = Vertex.Y / Scale;
+            UV.Y = Vertex.Z / Scale;
+        }
+        else {
+            // Projekt auf die Y-Ebene
+            UV.X = Vertex.X / Scale;
+            UV.Y = Vertex.Z / Scale;
+        }
+    }
+}
+
+void CityGMLVertexKernels::BoxProjectUVs(TArrayView<const FVector> Vertices, float Scale, FVector2D* OutUVs)
+{
+    const int32 NumVertices = Vertices.Num();
+    // Die Verzweigungen der Referenz werden zu Masken, statt zu teilen wird mit dem Kehrwert multipliziert
+    const VectorRegister InvScale = VectorSetFloat1(1.0f / Scale);
+    int32 i = 0;
+    for (; i + 4 <= NumVertices; i += 4) {
+        VectorRegister X, Y, Z;
+        LoadVertices4(Vertices.GetData() + i, X, Y, Z);
+        const VectorRegister AbsX = VectorAbs(X);
+        const VectorRegister AbsY = VectorAbs(Y);
+        const VectorRegister AbsZ = VectorAbs(Z);
+        const VectorRegister MaskZ = VectorBitwiseAnd(VectorCompareGT(AbsZ, AbsX), VectorCompareGT(AbsZ, AbsY));
+        const VectorRegister MaskX = VectorCompareGT(AbsX, AbsY);
+
+        const VectorRegister U = VectorMultiply(VectorSelect(MaskZ, X, VectorSelect(MaskX, Y, X)), InvScale);
+        const VectorRegister V = VectorMultiply(VectorSelect(MaskZ, Y, Z), InvScale);
+
+        // u0 v0 u1 v1 und u2 v2 u3 v3
+        float* Data = &OutUVs[i].X;
+        VectorStore(VectorSwizzle(VectorShuffle(U, V, 0, 1, 0, 1), 0, 2, 1, 3), Data);
+        VectorStore(VectorSwizzle(VectorShuffle(U, V, 2, 3, 2, 3), 0, 2, 1, 3), Data + 4);
+    }
+    for (; i < NumVertices; ++i) {
+        const FVector& Vertex = Vertices[i];
+        const float AbsX = FMath::Abs(Vertex.X);
+        const float AbsY = FMath::Abs(Vertex.Y);
+        const float AbsZ = FMath::Abs(Vertex.Z);
+        const float InvScaleScalar = 1.0f / Scale;
+        if (AbsZ > AbsX && AbsZ > AbsY) {
+            OutUVs[i] = FVector2D(Vertex.X * InvScaleScalar, Vertex.Y * InvScaleScalar);
+        }
+        else {
+            OutUVs[i] = FVector2D((AbsX > AbsY ? Vertex.Y : Vertex.X) * InvScaleScalar, Vertex.Z * InvScaleScalar);
+        }
+    }
+}
+
+void CityGMLVertexKernels::ComputeTangentsScalar(TArrayView<const FVector> Vertices, TArrayView<const FVector2D> UVs, TArrayView<const FVector> Normals, TArrayView<const int32> Triangles, int32 IndexBase, FVector* OutTangents)
+{
+    const int32 NumVertices = Vertices.Num();
+    for (int32 i = 0; i < NumVertices; ++i) {
+        OutTangents[i] = FVector::ZeroVector;
+    }
+
+    // Jedes Dreieck trägt seine Tangente zu allen drei Vertices bei
+    for (int32 i = 0; i + 2 < Triangles.Num(); i += 3) {
+        const int32 I0 = Triangles[i] - IndexBase;
+        const int32 I1 = Triangles[i + 1] - IndexBase;
+        const int32 I2 = Triangles[i + 2] - IndexBase;
+
+        const FVector Edge1 = Vertices[I1] - Vertices[I0];
+        const FVector Edge2 = Vertices[I2] - Vertices[I0];
+        const FVector2D UVEdge1 = UVs[I1] - UVs[I0];
+        const FVector2D UVEdge2 = UVs[I2] - UVs[I0];
+
+        // Dreiecke ohne Ausdehnung in den UVs haben keine Tangente
+        const float Determinant = UVEdge1.X * UVEdge2.Y - UVEdge2.X * UVEdge1.Y;
+        if (Determinant == 0.0f) {
+            continue;
+        }
+        const FVector Tangent = (Edge1 * UVEdge2.Y - Edge2 * UVEdge1.Y) / Determinant;
+        OutTangents[I0] += Tangent;
+        OutTangents[I1] += Tangent;
+        OutTangents[I2] += Tangent;
+    }
+
+    // Gram-Schmidt: senkrecht zur Normale stellen und normieren
+    for (int32 i = 0; i < NumVertices; ++i) {
+        const FVector& Normal = Normals[i];
+        const FVector Sum = OutTangents[i];
+        const FVector Tangent = Sum - Normal * FVector::DotProduct(Normal, Sum);
+        const float LengthSquared = Tangent.SizeSquared();
+        OutTangents[i] = LengthSquared > MinTangentFraction * Sum.SizeSquared() ? Tangent / FMath::Sqrt(LengthSquared) : FallbackTangent(Normal);
+    }
+}
+
+void CityGMLVertexKernels::ComputeTangents(TArrayView<const FVector> Vertices, TArrayView<const FVector2D> UVs, TArrayView<const FVector> Normals, TArrayView<const int32> Triangles, int32 IndexBase, FVector* OutTangents)
+{
+    const int32 NumVertices = Vertices.Num();
+    FMemory::Memzero(OutTangents, NumVertices * sizeof(FVector));
+
+    // Vier Dreiecke pro Durchlauf: Vertices und UVs werden eingesammelt, gerechnet wird in Registern,
+    // aufsummiert wird wieder einzeln in derselben Reihenfolge wie in der Referenz
+    const int32 NumIndices = Triangles.Num() - Triangles.Num() % 3;
+    int32 i = 0;
+    for (; i + 12 <= NumIndices; i += 12) {
+        int32 I0[4], I1[4], I2[4];
+        for (int32 k = 0; k < 4; ++k) {
+            I0[k] = Triangles[i + 3 * k] - IndexBase;
+            I1[k] = Triangles[i + 3 * k + 1] - IndexBase;
+            I2[k] = Triangles[i + 3 * k + 2] - IndexBase;
+        }
+        const FVector* P = Vertices.GetData();
+        const FVector2D* T = UVs.GetData();
+        const VectorRegister X0 = MakeVectorRegister(P[I0[0]].X, P[I0[1]].X, P[I0[2]].X, P[I0[3]].X);
+        const VectorRegister Y0 = MakeVectorRegister(P[I0[0]].Y, P[I0[1]].Y, P[I0[2]].Y, P[I0[3]].Y);
+        const VectorRegister Z0 = MakeVectorRegister(P[I0[0]].Z, P[I0[1]].Z, P[I0[2]].Z, P[I0[3]].Z);
+        const VectorRegister U0 = MakeVectorRegister(T[I0[0]].X, T[I0[1]].X, T[I0[2]].X, T[I0[3]].X);
+        const VectorRegister V0 = MakeVectorRegister(T[I0[0]].Y, T[I0[1]].Y, T[I0[2]].Y, T[I0[3]].Y);
+
+        const VectorRegister Edge1X = VectorSubtract(MakeVectorRegister(P[I1[0]].X, P[I1[1]].X, P[I1[2]].X, P[I1[3]].X), X0);
+        const VectorRegister Edge1Y = VectorSubtract(MakeVectorRegister(P[I1[0]].Y, P[I1[1]].Y, P[I1[2]].Y, P[I1[3]].Y), Y0);
+        const VectorRegister Edge1Z = VectorSubtract(MakeVectorRegister(P[I1[0]].Z, P[I1[1]].Z, P[I1[2]].Z, P[I1[3]].Z), Z0);
+        const VectorRegister Edge2X = VectorSubtract(MakeVectorRegister(P[I2[0]].X, P[I2[1]].X, P[I2[2]].X, P[I2[3]].X), X0);
+        const VectorRegister Edge2Y = VectorSubtract(MakeVectorRegister(P[I2[0]].Y, P[I2[1]].Y, P[I2[2]].Y, P[I2[3]].Y), Y0);
+        const VectorRegister Edge2Z = VectorSubtract(MakeVectorRegister(P[I2[0]].Z, P[I2[1]].Z, P[I2[2]].Z, P[I2[3]].Z), Z0);
+        const VectorRegister UVEdge1U = VectorSubtract(MakeVectorRegister(T[I1[0]].X, T[I1[1]].X, T[I1[2]].X, T[I1[3]].X), U0);
+        const VectorRegister UVEdge1V = VectorSubtract(MakeVectorRegister(T[I1[0]].Y, T[I1[1]].Y, T[I1[2]].Y, T[I1[3]].Y), V0);
+        const VectorRegister UVEdge2U = VectorSubtract(MakeVectorRegister(T[I2[0]].X, T[I2[1]].X, T[I2[2]].X, T[I2[3]].X), U0);
+        const VectorRegister UVEdge2V = VectorSubtract(MakeVectorRegister(T[I2[0]].Y, T[I2[1]].Y, T[I2[2]].Y, T[I2[3]].Y), V0);
+
+        const VectorRegister Determinant = VectorSubtract(VectorMultiply(UVEdge1U, UVEdge2V), VectorMultiply(UVEdge2U, UVEdge1V));
+        // Dreiecke ohne Ausdehnung in den UVs tragen nichts bei, ihr Quotient wird ausgeblendet
+        const VectorRegister Valid = VectorCompareNE(Determinant, VectorZero());
+        const VectorRegister InvDeterminant = VectorSelect(Valid, VectorDivide(VectorOne(), Determinant), VectorZero());
+
+        float TangentX[4], TangentY[4], TangentZ[4];
+        VectorStore(VectorMultiply(VectorSubtract(VectorMultiply(Edge1X, UVEdge2V), VectorMultiply(Edge2X, UVEdge1V)), InvDeterminant), TangentX);
+        VectorStore(VectorMultiply(VectorSubtract(VectorMultiply(Edge1Y, UVEdge2V), VectorMultiply(Edge2Y, UVEdge1V)), InvDeterminant), TangentY);
+        VectorStore(VectorMultiply(VectorSubtract(VectorMultiply(Edge1Z, UVEdge2V), VectorMultiply(Edge2Z, UVEdge1V)), InvDeterminant), TangentZ);
+        for (int32 k = 0; k < 4; ++k) {
+            const FVector Tangent(TangentX[k], TangentY[k], TangentZ[k]);
+            OutTangents[I0[k]] += Tangent;
+            OutTangents[I1[k]] += Tangent;
+            OutTangents[I2[k]] += Tangent;
+        }
+    }
+    for (; i < NumIndices; i += 3) {
+        const int32 I0 = Triangles[i] - IndexBase;
+        const int32 I1 = Triangles[i + 1] - IndexBase;
+        const int32 I2 = Triangles[i + 2] - IndexBase;
+        const FVector Edge1 = Vertices[I1] - Vertices[I0];
+        const FVector Edge2 = Vertices[I2] - Vertices[I0];
+        const FVector2D UVEdge1 = UVs[I1] - UVs[I0];
+        const FVector2D UVEdge2 = UVs[I2] - UVs[I0];
+        const float Determinant = UVEdge1.X * UVEdge2.Y - UVEdge2.X * UVEdge1.Y;
+        if (Determinant != 0.0f) {
+            const FVector Tangent = (Edge1 * UVEdge2.Y - Edge2 * UVEdge1.Y) * (1.0f / Determinant);
+            OutTangents[I0] += Tangent;
+            OutTangents[I1] += Tangent;
+            OutTangents[I2] += Tangent;
+        }
+    }
+
+    // Gram-Schmidt für vier Vertices gleichzeitig, nur Vertices ohne brauchbare Summe laufen einzeln
+    const VectorRegister MinFraction = VectorSetFloat1(MinTangentFraction);
+    int32 v = 0;
+    for (; v + 4 <= NumVertices; v += 4) {
+        VectorRegister SumX, SumY, SumZ, NormalX, NormalY, NormalZ;
+        LoadVertices4(OutTangents + v, SumX, SumY, SumZ);
+        LoadVertices4(Normals.GetData() + v, NormalX, NormalY, NormalZ);
+        const VectorRegister Dot = VectorMultiplyAdd(SumX, NormalX, VectorMultiplyAdd(SumY, NormalY, VectorMultiply(SumZ, NormalZ)));
+        const VectorRegister TangentX = VectorSubtract(SumX, VectorMultiply(NormalX, Dot));
+        const VectorRegister TangentY = VectorSubtract(SumY, VectorMultiply(NormalY, Dot));
+        const VectorRegister TangentZ = VectorSubtract(SumZ, VectorMultiply(NormalZ, Dot));
+        const VectorRegister LengthSquared = VectorMultiplyAdd(TangentX, TangentX, VectorMultiplyAdd(TangentY, TangentY, VectorMultiply(TangentZ, TangentZ)));
+        const VectorRegister SumSquared = VectorMultiplyAdd(SumX, SumX, VectorMultiplyAdd(SumY, SumY, VectorMultiply(SumZ, SumZ)));
+        const VectorRegister Valid = VectorCompareGT(LengthSquared, VectorMultiply(SumSquared, MinFraction));
+        const VectorRegister InvLength = VectorSelect(Valid, VectorReciprocalSqrtAccurate(LengthSquared), VectorZero());
+        StoreVertices4(VectorMultiply(TangentX, InvLength), VectorMultiply(TangentY, InvLength), VectorMultiply(TangentZ, InvLength), OutTangents + v);
+
+        const int32 ValidLanes = VectorMaskBits(Valid);
+        if (ValidLanes != 0xF) {
+            for (int32 k = 0; k < 4; ++k) {
+                if ((ValidLanes & (1 << k)) == 0) {
+                    OutTangents[v + k] = FallbackTangent(Normals[v + k]);
+                }
+            }
+        }
+    }
+    for (; v < NumVertices; ++v) {
+        const FVector& Normal = Normals[v];
+        const FVector Sum = OutTangents[v];
+        const FVector Tangent = Sum - Normal * FVector::DotProduct(Normal, Sum);
+        const float LengthSquared = Tangent.SizeSquared();
+        OutTangents[v] = LengthSquared > MinTangentFraction * Sum.SizeSquared() ? Tangent * FMath::InvSqrt(LengthSquared) : FallbackTangent(Normal);
+    }
+}
+
+namespace
+{
+    /**
+     * Flächen wie beim Import: ebene, konvexe Polygone in zufälligen Ebenen in UTM-Koordinaten um einen Ursprung,
+     * dazu ihre Dreiecke als Fan. Jede dritte Fläche ist waagerecht, jede vierte liegt nahe am Ursprung,
+     * damit alle drei Projektionen der UVs vorkommen.
+     */
+    struct FKernelTestData
+    {
+        TArray<double> Coordinates;
+        TArray<int32> FaceStart;
+        TArray<int32> Indices;
+        TArray<int32> FaceIndexStart;
+
+        int32 NumVertices() const { return Coordinates.Num() / 3; }
+        int32 GetFaceEnd(int32 Face) const { return Face + 1 < FaceStart.Num() ? FaceStart[Face + 1] : NumVertices(); }
+        int32 GetFaceIndexEnd(int32 Face) const { return Face + 1 < FaceIndexStart.Num() ? FaceIndexStart[Face + 1] : Indices.Num(); }
+    };
+
+    void MakeKernelTestData(int32 NumFaces, FCityGMLUtmTransform& OutTransform, FKernelTestData& OutData)
+    {
+        FRandomStream Random(4711);
+        OutTransform.OriginX = 565000.0;
+        OutTransform.OriginY = 5933000.0;
+        OutTransform.Scale = 100.0;
+        OutTransform.ZOffset = 200.0f;
+        for (int32 Face = 0; Face < NumFaces; ++Face) {
+            const int32 NumPoints = Random.RandRange(3, 20);
+            const FVector Axis = Face % 3 == 0 ? FVector::UpVector : Random.GetUnitVector();
+            const FQuat Rotation(Axis, Random.FRandRange(0.0f, PI));
+            const float Extent = Face % 4 == 1 ? 30.0f : 2000.0f;
+            const double CenterX = OutTransform.OriginX + Random.FRandRange(-Extent, Extent);
+            const double CenterY = OutTransform.OriginY + Random.FRandRange(-Extent, Extent);
+            const double CenterZ = Random.FRandRange(0.0f, 60.0f);
+            const float Radius = Random.FRandRange(1.0f, 20.0f);
+
+            OutData.FaceStart.Add(OutData.NumVertices());
+            OutData.FaceIndexStart.Add(OutData.Indices.Num());
+            for (int32 v = 0; v < NumPoints; ++v) {
+                const float Angle = 2.0f * PI * v / NumPoints;
+                const FVector Offset = Rotation.RotateVector(FVector(Radius * FMath::Cos(Angle), Radius * FMath::Sin(Angle), 0.0f));
+                OutData.Coordinates.Add(CenterX + Offset.X);
+                OutData.Coordinates.Add(CenterY + Offset.Y);
+                OutData.Coordinates.Add(CenterZ + Offset.Z);
+            }
+            for (int32 k = 1; k < NumPoints - 1; ++k) {
+                OutData.Indices.Add(0);
+                OutData.Indices.Add(k);
+                OutData.Indices.Add(k + 1);
+            }
+        }
+    }
+
+    float MaxDifference(TArrayView<const FVector> A, TArrayView<const FVector> B)
+    {
+        float Max = 0.0f;
+        for (int32 i = 0; i < A.Num(); ++i) {
+            Max = FMath::Max(Max, (A[i] - B[i]).GetAbsMax());
+        }
+        return Max;
+    }
+
+    /** Größter Unterschied relativ zum Betrag, die UVs sind mit großen Koordinaten selbst groß */
+    float MaxRelativeDifference(TArrayView<const FVector2D> A, TArrayView<const FVector2D> B)
+    {
+        float Max = 0.0f;
+        for (int32 i = 0; i < A.Num(); ++i) {
+            Max = FMath::Max(Max, (A[i] - B[i]).GetAbsMax() / FMath::Max(A[i].GetAbsMax(), 1.0f));
+        }
+        return Max;
+    }
+
+    /** Läuft eine Funktion Iterations mal und gibt die gemessenen Sekunden zurück */
+    template<typename FunctionType>
+    double TimeKernel(int32 Iterations, FunctionType&& Function)
+    {
+        const double Start = FPlatformTime::Seconds();
+        for (int32 Iteration = 0; Iteration < Iterations; ++Iteration) {
+            Function();
+        }
+        return FPlatformTime::Seconds() - Start;
+    }
+
+    void LogKernel(const TCHAR* Name, float Difference, float Tolerance, double ScalarSeconds, double VectorSeconds, bool& bAllPassed)
+    {
+        const bool bPassed = Difference <= Tolerance;
+        bAllPassed &= bPassed;
+        if (bPassed) {
+            UE_LOG(LogTemp, Log, TEXT("  %-18s max difference %g (tolerance %g) passed, scalar %.3f s, kernel %.3f s, speedup %.1fx"),
+                Name, Difference, Tolerance, ScalarSeconds, VectorSeconds, ScalarSeconds / FMath::Max(VectorSeconds, 1e-9));
+        }
+        else {
+            UE_LOG(LogTemp, Error, TEXT("  %-18s max difference %g (tolerance %g) FAILED, scalar %.3f s, kernel %.3f s"),
+                Name, Difference, Tolerance, ScalarSeconds, VectorSeconds);
+        }
+    }
+
+    /**
+     * Prüft jeden Kernel gegen seine skalare Referenz und misst beide auf einem Thread, jeweils Fläche für Fläche wie beim Import.
+     * Aufruf in der Konsole: CityGML.TestVertexKernels [Anzahl Flächen] [Durchläufe]
+     */
+    void TestVertexKernels(const TArray<FString>& Args)
+    {
+        const int32 NumFaces = FMath::Max(Args.Num() > 0 ? FCString::Atoi(*Args[0]) : 20000, 1);
+        const int32 Iterations = FMath::Max(Args.Num() > 1 ? FCString::Atoi(*Args[1]) : 10, 1);
+
+        FCityGMLUtmTransform Transform;
+        FKernelTestData Data;
+        MakeKernelTestData(NumFaces, Transform, Data);
+        const int32 NumVertices = Data.NumVertices();
+        const float UVScale = float(Transform.Scale);
+
+        TArray<FVector> ScalarPositions, VectorPositions, ScalarNormals, VectorNormals, ScalarTangents, VectorTangents;
+        TArray<FVector2D> ScalarUVs, VectorUVs;
+        ScalarPositions.SetNumUninitialized(NumVertices);
+        VectorPositions.SetNumUninitialized(NumVertices);
+        ScalarNormals.SetNumUninitialized(NumVertices);
+        VectorNormals.SetNumUninitialized(NumVertices);
+        ScalarTangents.SetNumUninitialized(NumVertices);
+        VectorTangents.SetNumUninitialized(NumVertices);
+        ScalarUVs.SetNumUninitialized(NumVertices);
+        VectorUVs.SetNumUninitialized(NumVertices);
+
+        // Jede Stufe bekommt dieselben Eingaben, die der Referenz, damit nur der jeweilige Kernel verglichen wird
+        auto TransformFaces = [&](bool bVector) {
+            for (int32 Face = 0; Face < NumFaces; ++Face) {
+                const int32 Start = Data.FaceStart[Face];
+                const int32 Count = Data.GetFaceEnd(Face) - Start;
+                const double* Coordinates = Data.Coordinates.GetData() + 3 * Start;
+                if (bVector) {
+                    CityGMLVertexKernels::TransformUtm(Coordinates, Count, Transform, VectorPositions.GetData() + Start);
+                }
+                else {
+                    CityGMLVertexKernels::TransformUtmScalar(Coordinates, Count, Transform, ScalarPositions.GetData() + Start);
+                }
+            }
+        };
+        auto NormalFaces = [&](bool bVector) {
+            TArray<FVector>& Normals = bVector ? VectorNormals : ScalarNormals;
+            for (int32 Face = 0; Face < NumFaces; ++Face) {
+                const int32 Start = Data.FaceStart[Face];
+                const int32 End = Data.GetFaceEnd(Face);
+                const TArrayView<const FVector> Ring(ScalarPositions.GetData() + Start, End - Start);
+                const FVector Normal = bVector ? CityGMLVertexKernels::ComputeRingNormal(Ring) : CityGMLVertexKernels::ComputeRingNormalScalar(Ring);
+                for (int32 v = Start; v < End; ++v) {
+                    Normals[v] = Normal;
+                }
+            }
+        };
+        auto UVFaces = [&](bool bVector) {
+            for (int32 Face = 0; Face < NumFaces; ++Face) {
+                const int32 Start = Data.FaceStart[Face];
+                const TArrayView<const FVector> Vertices(ScalarPositions.GetData() + Start, Data.GetFaceEnd(Face) - Start);
+                if (bVector) {
+                    CityGMLVertexKernels::BoxProjectUVs(Vertices, UVScale, VectorUVs.GetData() + Start);
+                }
+                else {
+                    CityGMLVertexKernels::BoxProjectUVsScalar(Vertices, UVScale, ScalarUVs.GetData() + Start);
+                }
+            }
+        };
+        auto TangentFaces = [&](bool bVector) {
+            for (int32 Face = 0; Face < NumFaces; ++Face) {
+                const int32 Start = Data.FaceStart[Face];
+                const int32 Count = Data.GetFaceEnd(Face) - Start;
+                const TArrayView<const FVector> Vertices(ScalarPositions.GetData() + Start, Count);
+                const TArrayView<const FVector2D> UVs(ScalarUVs.GetData() + Start, Count);
+                const TArrayView<const FVector> Normals(ScalarNormals.GetData() + Start, Count);
+                const TArrayView<const int32> Triangles(Data.Indices.GetData() + Data.FaceIndexStart[Face], Data.GetFaceIndexEnd(Face) - Data.FaceIndexStart[Face]);
+                if (bVector) {
+                    CityGMLVertexKernels::ComputeTangents(Vertices, UVs, Normals, Triangles, 0, VectorTangents.GetData() + Start);
+                }
+                else {
+                    CityGMLVertexKernels::ComputeTangentsScalar(Vertices, UVs, Normals, Triangles, 0, ScalarTangents.GetData() + Start);
+                }
+            }
+        };
+
+        UE_LOG(LogTemp, Log, TEXT("Vertex kernel test: %d faces, %d vertices, %d iterations, one thread, %s"),
+            NumFaces, NumVertices, Iterations, CityGMLVertexKernels::IsVectorized() ? TEXT("vector intrinsics") : TEXT("no vector intrinsics"));
+        bool bAllPassed = true;
+
+        double ScalarSeconds = TimeKernel(Iterations, [&]() { TransformFaces(false); });
+        double VectorSeconds = TimeKernel(Iterations, [&]() { TransformFaces(true); });
+        // Die Umrechnung rechnet in derselben Reihenfolge und muss bitgleich sein
+        LogKernel(TEXT("TransformUtm"), MaxDifference(ScalarPositions, VectorPositions), 0.0f, ScalarSeconds, VectorSeconds, bAllPassed);
+
+        ScalarSeconds = TimeKernel(Iterations, [&]() { NormalFaces(false); });
+        VectorSeconds = TimeKernel(Iterations, [&]() { NormalFaces(true); });
+        LogKernel(TEXT("ComputeRingNormal"), MaxDifference(ScalarNormals, VectorNormals), 1e-4f, ScalarSeconds, VectorSeconds, bAllPassed);
+
+        ScalarSeconds = TimeKernel(Iterations, [&]() { UVFaces(false); });
+        VectorSeconds = TimeKernel(Iterations, [&]() { UVFaces(true); });
+        LogKernel(TEXT("BoxProjectUVs"), MaxRelativeDifference(ScalarUVs, VectorUVs), 1e-6f, ScalarSeconds, VectorSeconds, bAllPassed);
+
+        ScalarSeconds = TimeKernel(Iterations, [&]() { TangentFaces(false); });
+        VectorSeconds = TimeKernel(Iterations, [&]() { TangentFaces(true); });
+        LogKernel(TEXT("ComputeTangents"), MaxDifference(ScalarTangents, VectorTangents), 1e-4f, ScalarSeconds, VectorSeconds, bAllPassed);
+
+        if (bAllPassed) {
+            UE_LOG(LogTemp, Log, TEXT("Vertex kernel test passed"));
+        }
+        else {
+            UE_LOG(LogTemp, Error, TEXT("Vertex kernel test FAILED"));
+        }
+    }
+
+    FAutoConsoleCommand TestVertexKernelsCommand(
+        TEXT("CityGML.TestVertexKernels"),
+        TEXT("Checks the vertex kernels against their scalar references and times both on one thread. Args: [FaceCount] [Iterations]"),
+        FConsoleCommandWithArgsDelegate::CreateStatic(&TestVertexKernels)
+    );
+}
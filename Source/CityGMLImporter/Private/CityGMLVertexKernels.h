@@ -0,0 +1,77 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+/** Parameter der Umrechnung von ETRS89/UTM32 in Unreal-Koordinaten, dieselbe Rechnung wie ConvertUtmToUnreal */
+struct FCityGMLUtmTransform
+{
+	/** Ursprung in UTM, wird in double abgezogen */
+	double OriginX = 0.0;
+	double OriginY = 0.0;
+	double Scale = 1.0;
+	/** Wird nach der Skalierung auf Z addiert */
+	float ZOffset = 0.0f;
+};
+
+/**
+ * Kernels für die Schritte nach dem Parsen einer Fläche, jeweils über zusammenhängende Vertex-Puffer statt pro Vertex.
+ *
+ * Vier Vertices werden gemeinsam in Vektorregistern verarbeitet (VectorRegister, also SSE, NEON oder FPU),
+ * aus den FVector-Puffern werden sie dafür in X-, Y- und Z-Register umsortiert und wieder zurück.
+ * Die Umrechnung aus UTM braucht double und ist nur auf x86 vektorisiert, sonst läuft die skalare Referenz.
+ *
+ * Zu jedem Kernel gibt es eine skalare Referenz mit der ursprünglichen Rechnung. Die Umrechnung aus UTM ist bitgleich,
+ * die übrigen Kernels summieren in anderer Reihenfolge oder multiplizieren mit dem Kehrwert und weichen um Rundungsfehler ab.
+ * `CityGML.TestVertexKernels` vergleicht beide Varianten und misst ihre Laufzeit.
+ */
+namespace CityGMLVertexKernels
+{
+	/** true, wenn die Kernels auf dieser Plattform Vektorbefehle nutzen */
+	bool IsVectorized();
+
+	/**
+	 * Rechnet Koordinaten aus der Datei in Unreal-Koordinaten um: X und Y werden vertauscht, der Ursprung abgezogen und skaliert.
+	 *
+	 * @param Coordinates X, Y, Z aus der posList, drei Werte pro Vertex
+	 * @param NumVertices Anzahl der Vertices
+	 * @param Transform Ursprung, Skalierung und Höhenversatz
+	 * @param OutVertices Ziel für NumVertices Vertices
+	 */
+	void TransformUtm(const double* Coordinates, int32 NumVertices, const FCityGMLUtmTransform& Transform, FVector* OutVertices);
+	void TransformUtmScalar(const double* Coordinates, int32 NumVertices, const FCityGMLUtmTransform& Transform, FVector* OutVertices);
+
+	/**
+	 * Normale eines Rings nach Newell, auch für konkave und nicht ganz ebene Ringe.
+	 *
+	 * @return Die Normale mit Länge 1, der Nullvektor bei entarteten Ringen
+	 */
+	FVector ComputeRingNormal(TArrayView<const FVector> Ring);
+	FVector ComputeRingNormalScalar(TArrayView<const FVector> Ring);
+
+	/**
+	 * Box-Projektion der UVs: jeder Vertex wird auf die Ebene senkrecht zu seiner betragsgrößten Koordinate projiziert.
+	 *
+	 * @param Vertices Die Vertices einer Fläche
+	 * @param Scale Die Koordinaten werden durch Scale geteilt
+	 * @param OutUVs Ziel für so viele UVs wie Vertices
+	 */
+	void BoxProjectUVs(TArrayView<const FVector> Vertices, float Scale, FVector2D* OutUVs);
+	void BoxProjectUVsScalar(TArrayView<const FVector> Vertices, float Scale, FVector2D* OutUVs);
+
+	/**
+	 * Tangenten pro Vertex: die Tangente jedes Dreiecks wird auf seine drei Vertices aufsummiert,
+	 * danach wird jede Summe senkrecht zur Normale des Vertex gestellt und normiert.
+	 * Vertices ohne brauchbares Dreieck bekommen eine beliebige Tangente senkrecht zu ihrer Normale.
+	 *
+	 * @param Vertices Die Vertices einer Fläche
+	 * @param UVs Die UVs der Fläche, gleich viele wie Vertices
+	 * @param Normals Die Normalen der Fläche, gleich viele wie Vertices
+	 * @param Triangles Die Indizes der Dreiecke der Fläche
+	 * @param IndexBase Wird von jedem Index abgezogen, z.B. der erste Vertex der Fläche im Geometrie-Speicher
+	 * @param OutTangents Ziel für so viele Tangenten wie Vertices
+	 */
+	void ComputeTangents(TArrayView<const FVector> Vertices, TArrayView<const FVector2D> UVs, TArrayView<const FVector> Normals, TArrayView<const int32> Triangles, int32 IndexBase, FVector* OutTangents);
+	void ComputeTangentsScalar(TArrayView<const FVector> Vertices, TArrayView<const FVector2D> UVs, TArrayView<const FVector> Normals, TArrayView<const int32> Triangles, int32 IndexBase, FVector* OutTangents);
+}
@@ -0,0 +1,375 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#include "CityGMLXmlTokenizer.h"
+#include "Misc/Parse.h"
+#include <string.h>
+
+#define LOCTEXT_NAMESPACE "FCityGMLImporterModule"
+
+namespace
+{
+    FORCEINLINE bool IsSpace(ANSICHAR Char)
+    {
+        return Char == ' ' || Char == '\n' || Char == '\r' || Char == '\t';
+    }
+
+    /** Sucht ein Zeichen mit memchr, das auf allen Plattformen vektorisiert ist */
+    FORCEINLINE const ANSICHAR* FindChar(const ANSICHAR* Begin, const ANSICHAR* End, ANSICHAR Char)
+    {
+        return Begin < End ? static_cast<const ANSICHAR*>(memchr(Begin, Char, End - Begin)) : nullptr;
+    }
+
+    /** Sucht eine Zeichenfolge wie `-->`, nullptr wenn sie nicht vollständig im Puffer liegt */
+    const ANSICHAR* FindSequence(const ANSICHAR* Begin, const ANSICHAR* End, const ANSICHAR* Sequence)
+    {
+        const int32 Length = FCStringAnsi::Strlen(Sequence);
+        for (const ANSICHAR* Cursor = FindChar(Begin, End, Sequence[0]); Cursor; Cursor = FindChar(Cursor + 1, End, Sequence[0])) {
+            if (End - Cursor < Length) {
+                return nullptr;
+            }
+            if (FCStringAnsi::Strncmp(Cursor, Sequence, Length) == 0) {
+                return Cursor;
+            }
+        }
+        return nullptr;
+    }
+
+    FORCEINLINE bool StartsWith(const ANSICHAR* Begin, const ANSICHAR* End, const ANSICHAR* Prefix)
+    {
+        const int32 Length = FCStringAnsi::Strlen(Prefix);
+        return End - Begin >= Length && FCStringAnsi::Strncmp(Begin, Prefix, Length) == 0;
+    }
+
+    /** Ende eines öffnenden Tags, ein '>' in Attributwerten zählt nicht */
+    const ANSICHAR* FindTagEnd(const ANSICHAR* Begin, const ANSICHAR* End)
+    {
+        ANSICHAR Quote = 0;
+        for (const ANSICHAR* Cursor = Begin; Cursor < End; ++Cursor) {
+            if (Quote) {
+                if (*Cursor == Quote) {
+                    Quote = 0;
+                }
+            }
+            else if (*Cursor == '"' || *Cursor == '\'') {
+                Quote = *Cursor;
+            }
+            else if (*Cursor == '>') {
+                return Cursor;
+            }
+        }
+        return nullptr;
+    }
+
+    FAnsiStringView Trim(const ANSICHAR* Begin, const ANSICHAR* End)
+    {
+        while (Begin < End && IsSpace(*Begin)) {
+            ++Begin;
+        }
+        while (End > Begin && IsSpace(End[-1])) {
+            --End;
+        }
+        return FAnsiStringView(Begin, int32(End - Begin));
+    }
+}
+
+FCityGMLXmlTokenizer::FCityGMLXmlTokenizer(ICityGMLXmlCallback& InCallback)
+    : Callback(InCallback)
+{}
+
+void FCityGMLXmlTokenizer::Fail(const FText& InError, int64 Offset)
+{
+    if (!bFailed) {
+        bFailed = true;
+        Error = InError;
+        ErrorOffset = StreamOffset + Offset;
+    }
+}
+
+bool FCityGMLXmlTokenizer::Parse(const ANSICHAR* Text, int64 Size)
+{
+    StreamOffset = 0;
+    Tokenize(Text, Text + Size, true);
+    if (bFailed || bAborted) {
+        return false;
+    }
+    if (Depth != 0) {
+        Fail(LOCTEXT("XmlUnexpectedEnd", "Unexpected end of file"), Size);
+        return false;
+    }
+    return true;
+}
+
+bool FCityGMLXmlTokenizer::Feed(const uint8* Data, int32 Size)
+{
+    const ANSICHAR* Cursor = reinterpret_cast<const ANSICHAR*>(Data);
+    const ANSICHAR* End = Cursor + Size;
+
+    // Das angeschnittene Token wird nur bis zum nächsten '<' ergänzt, danach geht es direkt im neuen Block weiter
+    while (Carry.Num() > 0 && Cursor < End) {
+        const ANSICHAR* Next = FindChar(Cursor, End, '<');
+        const ANSICHAR* TakeEnd = Next ? Next + 1 : End;
+        const int32 Taken = int32(TakeEnd - Cursor);
+        Carry.Append(Cursor, Taken);
+        Cursor = TakeEnd;
+        MaxCarryBytes = FMath::Max(MaxCarryBytes, Carry.Num());
+
+        const int64 Used = Tokenize(Carry.GetData(), Carry.GetData() + Carry.Num(), false);
+        if (bFailed || bAborted) {
+            return false;
+        }
+        StreamOffset += Used;
+        const int32 Rest = Carry.Num() - int32(Used);
+        if (Rest <= Taken) {
+            // Der Rest liegt vollständig im neuen Block
+            Cursor -= Rest;
+            Carry.Reset();
+        }
+        else {
+            Carry.RemoveAt(0, int32(Used), false);
+        }
+    }
+
+    if (Carry.Num() == 0 && Cursor < End) {
+        const int64 Used = Tokenize(Cursor, End, false);
+        if (bFailed || bAborted) {
+            return false;
+        }
+        StreamOffset += Used;
+        Carry.Append(Cursor + Used, int32(End - Cursor - Used));
+        MaxCarryBytes = FMath::Max(MaxCarryBytes, Carry.Num());
+    }
+    return true;
+}
+
+bool FCityGMLXmlTokenizer::Finish()
+{
+    if (bFailed || bAborted) {
+        return false;
+    }
+    const int64 Used = Tokenize(Carry.GetData(), Carry.GetData() + Carry.Num(), true);
+    if (bFailed || bAborted) {
+        return false;
+    }
+    Carry.Empty();
+    if (Depth != 0) {
+        Fail(LOCTEXT("XmlUnexpectedEnd", "Unexpected end of file"), Used);
+        return false;
+    }
+    return true;
+}
+
+int64 FCityGMLXmlTokenizer::Tokenize(const ANSICHAR* Begin, const ANSICHAR* End, bool bFinal)
+{
+    const ANSICHAR* Cursor = Begin;
+    // Ein Token ist angeschnitten: am Ende des Textes ein Fehler, sonst geht es mit dem nächsten Block weiter
+    auto Incomplete = [this, &Cursor, Begin, bFinal]() {
+        if (bFinal) {
+            Fail(LOCTEXT("XmlUnexpectedEnd", "Unexpected end of file"), Cursor - Begin);
+        }
+        return Cursor - Begin;
+    };
+    auto Abort = [this, &Cursor, Begin]() {
+        bAborted = true;
+        return Cursor - Begin;
+    };
+
+    if (!bStarted) {
+        if (End - Cursor < 3 && !bFinal) {
+            return 0;
+        }
+        bStarted = true;
+        const uint8* Bytes = reinterpret_cast<const uint8*>(Cursor);
+        if (End - Cursor >= 2 && ((Bytes[0] == 0xFF && Bytes[1] == 0xFE) || (Bytes[0] == 0xFE && Bytes[1] == 0xFF))) {
+            Fail(LOCTEXT("XmlUtf16", "UTF-16 encoded files are not supported, please save the file as UTF-8"), 0);
+            return 0;
+        }
+        if (End - Cursor >= 3 && Bytes[0] == 0xEF && Bytes[1] == 0xBB && Bytes[2] == 0xBF) {
+            Cursor += 3;
+        }
+    }
+
+    while (Cursor < End) {
+        if (*Cursor != '<') {
+            // Text nach einem Kindelement gehört zu keinem Element und wird übersprungen
+            const ANSICHAR* Next = FindChar(Cursor, End, '<');
+            Cursor = Next ? Next : End;
+            continue;
+        }
+        if (End - Cursor < 2) {
+            return Incomplete();
+        }
+
+        if (Cursor[1] == '?') {
+            const ANSICHAR* Close = FindSequence(Cursor + 2, End, "?>");
+            if (!Close) {
+                return Incomplete();
+            }
+            Cursor = Close + 2;
+        }
+        else if (Cursor[1] == '!') {
+            if (End - Cursor < 9 && !bFinal) {
+                return Incomplete();
+            }
+            const ANSICHAR* Close = nullptr;
+            if (StartsWith(Cursor, End, "<!--")) {
+                Close = FindSequence(Cursor + 4, End, "-->");
+                Close = Close ? Close + 3 : nullptr;
+            }
+            else if (StartsWith(Cursor, End, "<![CDATA[")) {
+                Close = FindSequence(Cursor + 9, End, "]]>");
+                Close = Close ? Close + 3 : nullptr;
+            }
+            else {
+                // DOCTYPE, eine interne Teilmenge in [] kann selbst '>' enthalten
+                int32 Brackets = 0;
+                for (const ANSICHAR* Scan = Cursor + 2; Scan < End; ++Scan) {
+                    Brackets += *Scan == '[' ? 1 : (*Scan == ']' ? -1 : 0);
+                    if (*Scan == '>' && Brackets <= 0) {
+                        Close = Scan + 1;
+                        break;
+                    }
+                }
+            }
+            if (!Close) {
+                return Incomplete();
+            }
+            Cursor = Close;
+        }
+        else if (Cursor[1] == '/') {
+            const ANSICHAR* Close = FindChar(Cursor + 2, End, '>');
+            if (!Close) {
+                return Incomplete();
+            }
+            if (Depth == 0) {
+                Fail(LOCTEXT("XmlUnmatchedClose", "Closing tag without opening tag"), Cursor - Begin);
+                return Cursor - Begin;
+            }
+            Depth--;
+            if (!Callback.ProcessClose(Trim(Cursor + 2, Close))) {
+                return Abort();
+            }
+            Cursor = Close + 1;
+        }
+        else {
+            const ANSICHAR* TagEnd = FindTagEnd(Cursor + 1, End);
+            if (!TagEnd) {
+                return Incomplete();
+            }
+            const bool bEmptyElement = TagEnd[-1] == '/';
+            const ANSICHAR* AttributesEnd = bEmptyElement ? TagEnd - 1 : TagEnd;
+
+            const ANSICHAR* NameEnd = Cursor + 1;
+            while (NameEnd < AttributesEnd && !IsSpace(*NameEnd)) {
+                ++NameEnd;
+            }
+            const FAnsiStringView Name(Cursor + 1, int32(NameEnd - Cursor - 1));
+            if (Name.Len() == 0) {
+                Fail(LOCTEXT("XmlMissingName", "Element without a name"), Cursor - Begin);
+                return Cursor - Begin;
+            }
+
+            // Der Text reicht bis zum nächsten Tag, dieses muss für ein vollständiges Token im Puffer liegen
+            const ANSICHAR* DataEnd = TagEnd + 1;
+            if (!bEmptyElement) {
+                DataEnd = FindChar(TagEnd + 1, End, '<');
+                if (!DataEnd) {
+                    if (!bFinal) {
+                        return Cursor - Begin;
+                    }
+                    DataEnd = End;
+                }
+            }
+            for (const ANSICHAR* Attribute = NameEnd; ;) {
+                while (Attribute < AttributesEnd && IsSpace(*Attribute)) {
+                    ++Attribute;
+                }
+                if (Attribute >= AttributesEnd) {
+                    break;
+                }
+                const ANSICHAR* AttributeNameEnd = Attribute;
+                while (AttributeNameEnd < AttributesEnd && *AttributeNameEnd != '=' && !IsSpace(*AttributeNameEnd)) {
+                    ++AttributeNameEnd;
+                }
+                const ANSICHAR* Value = AttributeNameEnd;
+                while (Value < AttributesEnd && (IsSpace(*Value) || *Value == '=')) {
+                    ++Value;
+                }
+                const ANSICHAR* ValueEnd = (Value < AttributesEnd && (*Value == '"' || *Value == '\'')) ? FindChar(Value + 1, AttributesEnd, *Value) : nullptr;
+                if (!ValueEnd) {
+                    Fail(LOCTEXT("XmlBadAttribute", "Malformed attribute"), Attribute - Begin);
+                    return Cursor - Begin;
+                }
+                if (!Callback.ProcessAttribute(FAnsiStringView(Attribute, int32(AttributeNameEnd - Attribute)), FAnsiStringView(Value + 1, int32(ValueEnd - Value - 1)))) {
+                    return Abort();
+                }
+                Attribute = ValueEnd + 1;
+            }
+            if (!Callback.ProcessElement(Name, bEmptyElement ? FAnsiStringView() : Trim(TagEnd + 1, DataEnd))) {
+                return Abort();
+            }
+
+            if (bEmptyElement) {
+                if (!Callback.ProcessClose(Name)) {
+                    return Abort();
+                }
+            }
+            else {
+                Depth++;
+            }
+            Cursor = DataEnd;
+        }
+    }
+    return Cursor - Begin;
+}
+
+FString CityGMLXml::ToString(FAnsiStringView Text)
+{
+    FUTF8ToTCHAR Converter(Text.GetData(), Text.Len());
+    FString Result(Converter.Length(), Converter.Get());
+    if (!Result.Contains(TEXT("&"), ESearchCase::CaseSensitive)) {
+        return Result;
+    }
+
+    // Nur Namen und Adressen gehen hier durch, die Entities werden daher erst nach der Umwandlung aufgelöst
+    FString Decoded;
+    Decoded.Reserve(Result.Len());
+    for (int32 i = 0; i < Result.Len();) {
+        if (Result[i] == '&') {
+            const int32 Semicolon = Result.Find(TEXT(";"), ESearchCase::CaseSensitive, ESearchDir::FromStart, i);
+            if (Semicolon > i + 1) {
+                const FString Entity = Result.Mid(i + 1, Semicolon - i - 1);
+                TCHAR Char = 0;
+                if (Entity == TEXT("lt")) {
+                    Char = '<';
+                }
+                else if (Entity == TEXT("gt")) {
+                    Char = '>';
+                }
+                else if (Entity == TEXT("amp")) {
+                    Char = '&';
+                }
+                else if (Entity == TEXT("quot")) {
+                    Char = '"';
+                }
+                else if (Entity == TEXT("apos")) {
+                    Char = '\'';
+                }
+                else if (Entity.StartsWith(TEXT("#x"), ESearchCase::CaseSensitive)) {
+                    Char = TCHAR(FParse::HexNumber(*Entity + 2));
+                }
+                else if (Entity.StartsWith(TEXT("#"), ESearchCase::CaseSensitive)) {
+                    Char = TCHAR(FCString::Atoi(*Entity + 1));
+                }
+                if (Char != 0) {
+                    Decoded.AppendChar(Char);
+                    i = Semicolon + 1;
+                    continue;
+                }
+            }
+        }
+        Decoded.AppendChar(Result[i++]);
+    }
+    return Decoded;
+}
+
+#undef LOCTEXT_NAMESPACE
@@ -0,0 +1,108 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Containers/StringView.h"
+
+/**
+ * Empfänger der Token des FCityGMLXmlTokenizer. Anders als bei IFastXmlCallback kommen die Attribute eines Elements
+ * vor dem Element selbst, damit Namespace-Deklarationen schon für seinen eigenen Namen gelten.
+ * Alle Views zeigen in den gelesenen UTF-8 Text, Entities sind nicht aufgelöst.
+ */
+class ICityGMLXmlCallback
+{
+public:
+	virtual ~ICityGMLXmlCallback() {}
+
+	/**
+	 * Ein Element wurde geöffnet.
+	 *
+	 * @param Name Tag mit Präfix, z.B. `gml:posList`
+	 * @param Data Text bis zum ersten Kindelement oder zum Ende des Elements, ohne Leerzeichen an Anfang und Ende
+	 * @return false bricht das Parsen ab
+	 */
+	virtual bool ProcessElement(FAnsiStringView Name, FAnsiStringView Data) = 0;
+	/** Ein Attribut des Elements, das als nächstes mit ProcessElement geöffnet wird. false bricht das Parsen ab */
+	virtual bool ProcessAttribute(FAnsiStringView Name, FAnsiStringView Value) = 0;
+	/** Ein Element wurde geschlossen, auch bei `<tag/>`. false bricht das Parsen ab */
+	virtual bool ProcessClose(FAnsiStringView Name) = 0;
+};
+
+/**
+ * Zerlegt UTF-8 XML direkt im Puffer in Elemente, Attribute und Texte, ohne Strings anzulegen
+ * oder den Text nach UTF-16 umzuwandeln. Kommentare, Processing Instructions, CDATA und DOCTYPE werden übersprungen.
+ *
+ * Der Text kann auf einmal übergeben werden (gemappte Datei), dann bleiben alle Views so lange gültig wie der Puffer.
+ * Blockweise übergebener Text (entpackte Archive) wird dort weitergelesen, wo ein Token am Blockende angeschnitten war.
+ * Umkopiert wird dabei nur das angeschnittene Token, die Views gelten dann nur während des jeweiligen Aufrufs.
+ */
+class FCityGMLXmlTokenizer
+{
+public:
+	explicit FCityGMLXmlTokenizer(ICityGMLXmlCallback& InCallback);
+
+	/**
+	 * Liest einen vollständigen Text.
+	 *
+	 * @param Text Anfang des Textes, muss nicht nullterminiert sein
+	 * @param Size Länge in Bytes
+	 * @return true, wenn der Text vollständig gelesen wurde
+	 */
+	bool Parse(const ANSICHAR* Text, int64 Size);
+	/**
+	 * Liest den nächsten Block eines blockweise übergebenen Textes. Nach dem letzten Block muss Finish aufgerufen werden.
+	 *
+	 * @return false bei einem Fehler oder wenn der Empfänger abgebrochen hat
+	 */
+	bool Feed(const uint8* Data, int32 Size);
+	/** Liest den Rest nach dem letzten Block, true wenn alle Elemente geschlossen wurden */
+	bool Finish();
+
+	/** true, wenn der Text kein gültiges XML war. Ein Abbruch durch den Empfänger ist kein Fehler */
+	bool HasFailed() const { return bFailed; }
+	const FText& GetError() const { return Error; }
+	/** Byte-Position des Fehlers im Text */
+	int64 GetErrorOffset() const { return ErrorOffset; }
+	/** Größtes Token, das beim blockweisen Lesen über eine Blockgrenze hinweg umkopiert werden musste */
+	int32 GetMaxCarryBytes() const { return MaxCarryBytes; }
+
+private:
+	/**
+	 * Liest alle vollständigen Token eines Puffers.
+	 *
+	 * @param bFinal true, wenn nach dem Puffer kein Text mehr folgt
+	 * @return Anzahl der gelesenen Bytes, der Rest beginnt mit einem angeschnittenen Token
+	 */
+	int64 Tokenize(const ANSICHAR* Begin, const ANSICHAR* End, bool bFinal);
+	void Fail(const FText& InError, int64 Offset);
+
+	ICityGMLXmlCallback& Callback;
+	/** Angeschnittenes Token vom Ende des letzten Blocks */
+	TArray<ANSICHAR> Carry;
+	/** Position des ersten noch nicht gelesenen Bytes im gesamten Text */
+	int64 StreamOffset = 0;
+	/** Anzahl der geöffneten Elemente */
+	int32 Depth = 0;
+	int32 MaxCarryBytes = 0;
+	bool bStarted = false;
+	bool bFailed = false;
+	bool bAborted = false;
+	FText Error;
+	int64 ErrorOffset = -1;
+};
+
+namespace CityGMLXml
+{
+	/** Vergleicht einen Token mit einem Tag oder Attributnamen, Groß- und Kleinschreibung zählen */
+	FORCEINLINE bool Equals(FAnsiStringView Text, const ANSICHAR* Literal)
+	{
+		if (Text.Len() == 0) {
+			return Literal[0] == 0;
+		}
+		return FCStringAnsi::Strncmp(Text.GetData(), Literal, Text.Len()) == 0 && Literal[Text.Len()] == 0;
+	}
+
+	/** Wandelt einen Token in einen FString um und löst dabei die XML-Entities auf */
+	FString ToString(FAnsiStringView Text);
+}
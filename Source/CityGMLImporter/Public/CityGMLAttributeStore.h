@@ -0,0 +1,159 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Containers/StringView.h"
+
+/** Adresse eines Gebäudes aus xAL, fehlende Teile bleiben leer */
+struct FCityGMLAddress
+{
+	FString Street;
+	FString Number;
+	FString PostalCode;
+
+	bool IsEmpty() const { return Street.IsEmpty() && Number.IsEmpty() && PostalCode.IsEmpty(); }
+	void Reset()
+	{
+		Street.Reset();
+		Number.Reset();
+		PostalCode.Reset();
+	}
+};
+
+/**
+ * Pool für Texte, die sich oft wiederholen: jeder Text liegt nur einmal im Pool und wird über seinen Index referenziert.
+ * Alle Zeichen liegen hintereinander in einem Array, es gibt keine Allokation pro Text. Index 0 ist der leere Text.
+ */
+class FCityGMLStringPool
+{
+public:
+	FCityGMLStringPool();
+
+	/** Index des Textes, beim ersten Auftreten wird er angelegt */
+	int32 Intern(FStringView Text);
+	/** Index des Textes oder INDEX_NONE, wenn er nicht im Pool liegt */
+	int32 Find(FStringView Text) const;
+	FStringView Get(int32 Index) const { return FStringView(Chars.GetData() + Starts[Index], Starts[Index + 1] - Starts[Index]); }
+	/** Anzahl der Texte inklusive des leeren Textes */
+	int32 Num() const { return Starts.Num() - 1; }
+	SIZE_T GetAllocatedSize() const;
+	void Reset();
+	/** Liest oder schreibt die Texte, die Hashtabelle wird beim Laden neu aufgebaut */
+	void Serialize(FArchive& Ar);
+
+private:
+	static uint32 HashText(FStringView Text);
+	/** Baut die Hashtabelle mit NumSlots Plätzen neu auf, NumSlots ist eine Zweierpotenz */
+	void Rehash(int32 NumSlots);
+	int32 FindSlot(FStringView Text, uint32 Hash) const;
+
+	TArray<TCHAR> Chars;
+	/** Anfang jedes Textes in Chars, ein Eintrag mehr als Texte */
+	TArray<int32> Starts;
+	/** Offene Adressierung über die Indizes der Texte, INDEX_NONE für freie Plätze */
+	TArray<int32> Slots;
+};
+
+/**
+ * Spaltenweise Sachdaten der Gebäude eines FCityGMLGeometryStore, eine Zeile pro Gebäude in derselben Reihenfolge.
+ * Texte liegen interniert im Pool, die Spalten enthalten nur ihre Indizes.
+ *
+ * Nach BuildIndex werden Gebäude über gml:id, Adresse und Lage gefunden, ohne alle Zeilen zu durchsuchen.
+ * Jede Änderung der Zeilen verwirft den Index.
+ */
+struct FCityGMLAttributeStore
+{
+	/** Wert in MeasuredHeights, wenn die Datei keine bldg:measuredHeight enthält */
+	static constexpr float NoHeight = -1.0f;
+
+	FCityGMLStringPool Strings;
+	/** Ein Eintrag pro Gebäude, Indizes in Strings */
+	TArray<int32> Ids;
+	TArray<int32> Streets;
+	TArray<int32> Numbers;
+	TArray<int32> PostalCodes;
+	/** Ein Eintrag pro Gebäude: Bitmaske der vorkommenden ECityGMLSurfaceType, Bit n für den Wert n */
+	TArray<uint8> SurfaceTypes;
+	/** Ein Eintrag pro Gebäude: bldg:measuredHeight in Metern oder NoHeight */
+	TArray<float> MeasuredHeights;
+
+	int32 Num() const { return Ids.Num(); }
+	FStringView GetId(int32 Building) const { return Strings.Get(Ids[Building]); }
+	FCityGMLAddress GetAddress(int32 Building) const;
+
+	/**
+	 * Hängt eine Zeile an.
+	 *
+	 * @param Id Die gml:id des Gebäudes
+	 * @param Address Straße, Hausnummer und Postleitzahl, kann leer sein
+	 * @param MeasuredHeight Höhe in Metern oder NoHeight
+	 */
+	void Add(FStringView Id, const FCityGMLAddress& Address, float MeasuredHeight);
+	/** Kopiert eine Zeile aus einem anderen Speicher, die Texte werden in den eigenen Pool übernommen */
+	void AddRow(const FCityGMLAttributeStore& Source, int32 Building);
+	/** Hängt alle Zeilen eines anderen Speichers an. Der andere Speicher ist danach leer */
+	void Append(FCityGMLAttributeStore&& Other);
+
+	/**
+	 * Baut die Hash-Indizes über gml:id und Adresse und ein Raster über die Grundrisse auf.
+	 *
+	 * @param InBounds Umschließender Quader jedes Gebäudes in Unreal-Koordinaten, einer pro Zeile
+	 */
+	void BuildIndex(TArray<FBox>&& InBounds);
+	bool IsIndexed() const { return bIndexed; }
+	/** Umschließender Quader eines Gebäudes, nur nach BuildIndex */
+	const FBox& GetBounds(int32 Building) const { return Bounds[Building]; }
+
+	/**
+	 * Sucht Gebäude über ihre gml:id, Groß- und Kleinschreibung zählen.
+	 *
+	 * @return Das erste Gebäude mit dieser gml:id oder INDEX_NONE
+	 */
+	int32 FindById(FStringView Id) const;
+	/**
+	 * Sucht Gebäude über ihre Adresse, Straße und Hausnummer müssen genau übereinstimmen.
+	 *
+	 * @param Street Die Straße
+	 * @param Number Die Hausnummer, leer für alle Gebäude der Straße
+	 * @param OutBuildings Die gefundenen Gebäude in aufsteigender Reihenfolge
+	 */
+	void FindByAddress(FStringView Street, FStringView Number, TArray<int32>& OutBuildings) const;
+	/**
+	 * Sucht alle Gebäude, deren Grundriss-Rechteck das Rechteck Box in der Grundebene berührt.
+	 *
+	 * @param Box Rechteck in Unreal-Koordinaten
+	 * @param OutBuildings Die gefundenen Gebäude in aufsteigender Reihenfolge
+	 */
+	void FindInBox(const FBox2D& Box, TArray<int32>& OutBuildings) const;
+
+	/** Von Spalten, Pool und Index belegter Speicher in Bytes */
+	SIZE_T GetAllocatedSize() const;
+	/** Liest oder schreibt Pool und Spalten, der Index wird nicht gespeichert */
+	void Serialize(FArchive& Ar);
+	/** true, wenn alle Spalten gleich lang sind und auf gültige Texte zeigen */
+	bool IsConsistent() const;
+	void Reset();
+
+private:
+	/** Verwirft den Index, nach jeder Änderung der Zeilen */
+	void ResetIndex();
+	FIntPoint GetCell(const FVector2D& Point) const;
+
+	bool bIndexed = false;
+	TArray<FBox> Bounds;
+	/** Index der gml:id im Pool -> Gebäude */
+	TMultiMap<int32, int32> IdIndex;
+	/** Straße und Hausnummer als Indizes im Pool -> Gebäude */
+	TMultiMap<uint64, int32> AddressIndex;
+	/** Straße -> Gebäude, für die Suche ohne Hausnummer */
+	TMultiMap<int32, int32> StreetIndex;
+
+	/** Gleichmäßiges Raster über alle Grundrisse, jede Zelle listet die Gebäude, deren Rechteck sie berührt */
+	FVector2D GridOrigin = FVector2D::ZeroVector;
+	float CellSize = 1.0f;
+	FIntPoint GridSize = FIntPoint::ZeroValue;
+	/** Gebäude der Zelle X + Y * GridSize.X im Bereich [CellStart[Zelle], CellStart[Zelle + 1]) von CellBuildings */
+	TArray<int32> CellStart;
+	TArray<int32> CellBuildings;
+};
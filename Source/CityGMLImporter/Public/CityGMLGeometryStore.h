@@ -0,0 +1,141 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "ProceduralMeshComponent.h"
+#include "CityGMLAttributeStore.h"
+
+/** Art einer Fläche, abgeleitet aus dem Tag ihres bldg:boundedBy */
+enum class ECityGMLSurfaceType : uint8
+{
+	/** LoD1 oder unbekannte Begrenzungsfläche */
+	Other,
+	Roof,
+	Wall,
+	Ground,
+	Num
+};
+
+/**
+ * Flacher Speicher für die triangulierte Geometrie vieler Gebäude.
+ *
+ * Alle Vertex-Attribute liegen hintereinander in je einem Array (Structure of Arrays),
+ * Flächen und Gebäude werden nur über Start-Tabellen beschrieben. Die Dreiecksindizes
+ * beziehen sich auf den ersten Vertex des Speichers, sodass Positions und Indices direkt
+ * als Mesh-Section verwendet werden können.
+ */
+struct FCityGMLGeometryStore
+{
+	/** Ein Eintrag pro Vertex */
+	TArray<FVector> Positions;
+	TArray<FVector> Normals;
+	TArray<FVector2D> UVs;
+	TArray<FProcMeshTangent> Tangents;
+	/** Drei Einträge pro Dreieck */
+	TArray<int32> Indices;
+
+	/** Ein Eintrag pro Fläche: erster eigener Vertex und erster Index der Fläche */
+	TArray<int32> FaceVertexStart;
+	TArray<int32> FaceIndexStart;
+	TArray<ECityGMLSurfaceType> FaceSurfaceType;
+
+	/** Ein Eintrag pro Gebäude: erste Fläche */
+	TArray<int32> BuildingFaceStart;
+	/** Sachdaten der Gebäude wie gml:id und Adresse, eine Zeile pro Gebäude */
+	FCityGMLAttributeStore Attributes;
+
+	int32 NumBuildings() const { return BuildingFaceStart.Num(); }
+	int32 NumFaces() const { return FaceVertexStart.Num(); }
+	int32 NumVertices() const { return Positions.Num(); }
+	int32 NumTriangles() const { return Indices.Num() / 3; }
+	/** Von allen Arrays belegter Speicher in Bytes */
+	SIZE_T GetAllocatedSize() const;
+
+	/** Flächen eines Gebäudes im Bereich [GetFirstFace, GetFaceEnd) */
+	int32 GetFirstFace(int32 Building) const { return BuildingFaceStart[Building]; }
+	int32 GetFaceEnd(int32 Building) const { return Building + 1 < NumBuildings() ? BuildingFaceStart[Building + 1] : NumFaces(); }
+
+	/** Vertices und Indizes eines Gebäudes im Bereich [Start, End), gilt auch nach WeldVertices */
+	int32 GetBuildingVertexStart(int32 Building) const { return GetFirstFace(Building) < NumFaces() ? FaceVertexStart[GetFirstFace(Building)] : NumVertices(); }
+	int32 GetBuildingVertexEnd(int32 Building) const { return GetFaceEnd(Building) < NumFaces() ? FaceVertexStart[GetFaceEnd(Building)] : NumVertices(); }
+	int32 GetBuildingIndexStart(int32 Building) const { return GetFirstFace(Building) < NumFaces() ? FaceIndexStart[GetFirstFace(Building)] : Indices.Num(); }
+	int32 GetBuildingIndexEnd(int32 Building) const { return GetFaceEnd(Building) < NumFaces() ? FaceIndexStart[GetFaceEnd(Building)] : Indices.Num(); }
+
+	/** Eigene Vertices einer Fläche im Bereich [FaceVertexStart, GetFaceVertexEnd) */
+	int32 GetFaceVertexEnd(int32 Face) const { return Face + 1 < NumFaces() ? FaceVertexStart[Face + 1] : NumVertices(); }
+	/** Indizes einer Fläche im Bereich [FaceIndexStart, GetFaceIndexEnd) */
+	int32 GetFaceIndexEnd(int32 Face) const { return Face + 1 < NumFaces() ? FaceIndexStart[Face + 1] : Indices.Num(); }
+
+	/**
+	 * Beginnt ein neues Gebäude, alle folgenden Flächen gehören zu ihm.
+	 *
+	 * @param Id Die gml:id des Gebäudes
+	 * @param Address Straße, Hausnummer und Postleitzahl, kann leer sein
+	 * @param MeasuredHeight bldg:measuredHeight in Metern, falls angegeben
+	 */
+	void AddBuilding(FStringView Id, const FCityGMLAddress& Address, float MeasuredHeight = FCityGMLAttributeStore::NoHeight);
+	/**
+	 * Beginnt eine neue Fläche des zuletzt begonnenen Gebäudes.
+	 * Danach werden die Vertices, Attribute und Indizes der Fläche direkt an die Arrays angehängt.
+	 *
+	 * @param SurfaceType Dach, Wand oder Boden, soweit bekannt
+	 */
+	void AddFace(ECityGMLSurfaceType SurfaceType = ECityGMLSurfaceType::Other);
+	/**
+	 * Kopiert ein einzelnes Gebäude aus einem anderen Speicher an das Ende dieses Speichers.
+	 *
+	 * @param Source Der Speicher, der das Gebäude enthält
+	 * @param Building Index des Gebäudes in Source
+	 * @param Translation Wird auf alle Positionen addiert, z.B. um sie auf einen lokalen Ursprung zu beziehen
+	 */
+	void AppendBuilding(const FCityGMLGeometryStore& Source, int32 Building, const FVector& Translation);
+	/**
+	 * Verschweißt innerhalb jedes Gebäudes Vertices mit gleicher Position, deren Normalen höchstens
+	 * um CreaseAngle voneinander abweichen. Kanten zwischen Wänden und Dach bleiben so hart, während
+	 * Ecken benachbarter Flächen in derselben Ebene nur noch einmal gespeichert werden.
+	 * Die Normalen zusammengelegter Vertices werden gemittelt, Dreiecke, die dabei zu einer Linie
+	 * oder einem Punkt werden, entfallen.
+	 *
+	 * @param Tolerance Rasterweite, auf die die Positionen für den Vergleich gerundet werden
+	 * @param CreaseAngle Größter Winkel zwischen zwei Normalen in Grad, bei dem noch verschweißt wird
+	 * @return Anzahl der entfernten Vertices
+	 */
+	int32 WeldVertices(float Tolerance, float CreaseAngle);
+	/**
+	 * Berechnet den Mittelpunkt aller Vertices eines Gebäudes in der Grundebene (Z ist 0).
+	 *
+	 * @param Building Index des Gebäudes
+	 * @return Der Schwerpunkt der Vertices in X und Y
+	 */
+	FVector GetBuildingCentroid(int32 Building) const;
+	/**
+	 * Berechnet einen Hash über Geometrie und Attribute eines Gebäudes: Positionen, Normalen, UVs,
+	 * Flächen, Dreiecke, gml:id, Adresse und Höhe. Indizes werden dabei auf den Anfang des Gebäudes bezogen,
+	 * sodass der Hash nicht von der Lage des Gebäudes im Speicher abhängt.
+	 *
+	 * @param Building Index des Gebäudes
+	 * @return Der Hash, gleich für inhaltlich gleiche Gebäude
+	 */
+	uint64 GetBuildingHash(int32 Building) const;
+	/**
+	 * Hängt einen anderen Speicher an und verschiebt dabei dessen Indizes und Start-Tabellen.
+	 * Der andere Speicher ist danach leer.
+	 *
+	 * @param Other Der anzuhängende Speicher
+	 */
+	void Append(FCityGMLGeometryStore&& Other);
+	/**
+	 * Berechnet den umschließenden Quader jedes Gebäudes.
+	 *
+	 * @param OutBounds Ein Quader pro Gebäude, wird angehängt
+	 */
+	void GetBuildingBounds(TArray<FBox>& OutBounds) const;
+	/**
+	 * Berechnet den umschließenden Quader jedes Gebäudes und baut damit den Index der Sachdaten auf,
+	 * danach können Gebäude über gml:id, Adresse und Lage gesucht werden.
+	 */
+	void BuildAttributeIndex();
+	/** Leert alle Arrays */
+	void Reset();
+};
@@ -3,8 +3,130 @@
 #pragma once
 
 #include "CoreMinimal.h"
+#include "Containers/StringView.h"
 #include "Modules/ModuleManager.h"
-#include "XmlFile.h"
+#include "ProceduralMeshComponent.h"
+#include "CityGMLGeometryStore.h"
+#include "HAL/ThreadSafeBool.h"
+#include "HAL/ThreadSafeCounter.h"
+#include "Async/Future.h"
+
+struct FCityGMLBuilding;
+struct FCityGMLLoDPaths;
+class SNotificationItem;
+class UStaticMesh;
+struct FCityGMLInstanceGroup;
+struct FCityGMLSource;
+struct FCityGMLSurface;
+struct FCityGMLTile;
+class FCityGMLTriangulator;
+
+/** Summierte Zeiten in Sekunden der einzelnen Schritte beim Triangulieren der Flächen */
+struct FCityGMLPhaseTimes
+{
+	double PosListSeconds = 0.0;
+	/** Triangulierung der Ringe, der Name stammt von GeometryDataHelper::MakeFace und bleibt für die CSV-Spalten erhalten */
+	double MakeFaceSeconds = 0.0;
+	double UVSeconds = 0.0;
+	double TangentSeconds = 0.0;
+	double WeldSeconds = 0.0;
+
+	FCityGMLPhaseTimes& operator+=(const FCityGMLPhaseTimes& Other)
+	{
+		PosListSeconds += Other.PosListSeconds;
+		MakeFaceSeconds += Other.MakeFaceSeconds;
+		UVSeconds += Other.UVSeconds;
+		TangentSeconds += Other.TangentSeconds;
+		WeldSeconds += Other.WeldSeconds;
+		return *this;
+	}
+};
+
+/**
+ * Das Ergebnis einer einzelnen Datei, bevor es in den globalen Geometrie-Speicher übernommen wird.
+ * Die Dreiecksindizes werden erst beim Anhängen an den globalen Speicher verschoben,
+ * daher kann jede Datei und jeder Block von Gebäuden unabhängig auf einem eigenen Thread verarbeitet werden.
+ */
+struct FCityGMLFileGeometry
+{
+	FString FilePath;
+	bool bSucceeded = false;
+	/** true, wenn die Geometrie aus dem Cache unter Saved/CityGMLCache stammt */
+	bool bFromCache = false;
+	FText Error;
+
+	/** Die Gebäude in der Reihenfolge der Datei */
+	FCityGMLGeometryStore Geometry;
+
+	/** Zeiten in Sekunden für das Laden, Parsen und Triangulieren der Datei */
+	double ReadSeconds = 0.0;
+	double ParseSeconds = 0.0;
+	double TriangulateSeconds = 0.0;
+	/** Aufteilung der Triangulierungszeit, summiert über alle Tasks */
+	FCityGMLPhaseTimes PhaseTimes;
+	/** Beim Verschweißen entfernte Vertices */
+	int32 WeldedVertices = 0;
+};
+
+/** Kennzahlen einer Datei für die CSV-Zusammenfassung des Imports */
+struct FCityGMLFileStats
+{
+	FString FilePath;
+	bool bSucceeded = false;
+	bool bFromCache = false;
+	double ReadSeconds = 0.0;
+	double ParseSeconds = 0.0;
+	double TriangulateSeconds = 0.0;
+	FCityGMLPhaseTimes PhaseTimes;
+	int32 Buildings = 0;
+	int32 Faces = 0;
+	int32 Vertices = 0;
+	int32 Triangles = 0;
+	/** Beim Verschweißen entfernte Vertices, 0 bei Dateien aus dem Cache */
+	int32 WeldedVertices = 0;
+	/** Von der Geometrie der Datei belegter Speicher */
+	int64 Bytes = 0;
+};
+
+/**
+ * Fortschritt eines laufenden Imports. Die Zähler werden von den Worker-Threads erhöht
+ * und auf dem Game-Thread für die Fortschrittsanzeige gelesen.
+ */
+struct FCityGMLImportProgress
+{
+	/** Wird über den Cancel-Button gesetzt und von allen Phasen abgefragt */
+	FThreadSafeBool bCancelRequested;
+
+	int32 NumFiles = 0;
+	/** Dateien, die vollständig von der Festplatte geladen wurden */
+	FThreadSafeCounter FilesRead;
+	/** Dateien, deren Parsen abgeschlossen ist */
+	FThreadSafeCounter FilesParsed;
+	FThreadSafeCounter BuildingsParsed;
+	FThreadSafeCounter BuildingsTriangulated;
+
+	/** Phase "Build meshes", läuft auf dem Game-Thread */
+	bool bBuildingMeshes = false;
+	int32 MeshesBuilt = 0;
+	int32 NumMeshes = 0;
+};
+
+/** Ein Actor des letzten Imports, über seinen Schlüssel (gml:id oder Kachel) wiedergefunden */
+struct FCityGMLImportedMesh
+{
+	/** Hash über die Gebäude des Actors und die Einstellungen, mit denen er erzeugt wurde */
+	uint64 Hash = 0;
+	TWeakObjectPtr<AActor> Actor;
+};
+
+/** Vergleich eines Imports mit dem vorherigen bei IncrementalImport */
+struct FCityGMLUpdateCounts
+{
+	int32 Unchanged = 0;
+	int32 Modified = 0;
+	int32 Added = 0;
+	int32 Removed = 0;
+};
 
 class FCityGMLImporterModule : public IModuleInterface
 {
@@ -14,6 +136,31 @@ public:
 	virtual void StartupModule() override;
 	virtual void ShutdownModule() override;
 
+	/**
+	 * Führt den Import ohne Benutzeroberfläche und ohne Actors aus, z.B. aus dem CityGMLImport-Commandlet.
+	 * Es wird dieselbe Pipeline wie beim Import über das Menü verwendet. Skalierung, Ursprung, Cache und Auswahlbereich
+	 * gelten nur für diesen Aufruf, die Einstellungen des Editors und die Geometrie seines letzten Imports bleiben unverändert.
+	 *
+	 * @param Files Pfade zu den CityGML Dateien
+	 * @param Scale Skalierung für diesen Import
+	 * @param Origin UTM-Koordinate, die bei Dateien mit gml:Envelope abgezogen wird
+	 * @param bUseCache Geometrie-Cache unter Saved/CityGMLCache verwenden
+	 * @param OutGeometry Alle Gebäude aller erfolgreich gelesenen Dateien in Reihenfolge der Dateien
+	 * @param OutFileStats Optional, Zeiten und Kennzahlen pro Datei
+	 * @param Region Optional, Auswahlbereich im Format von ImportRegion, leer für alle Gebäude
+	 * @return Anzahl der erfolgreich gelesenen Dateien, -1 wenn bereits ein Import läuft oder der Bereich ungültig ist
+	 */
+	int32 RunHeadlessImport(const TArray<FString>& Files, float Scale, FVector Origin, bool bUseCache, FCityGMLGeometryStore& OutGeometry, TArray<FCityGMLFileStats>* OutFileStats = nullptr, const FString& Region = FString());
+	/**
+	 * Sucht Gebäude des letzten Imports über den Index der Sachdaten und hebt sie im Level hervor:
+	 * um jedes Gebäude wird für `HighlightSeconds` ein Quader gezeichnet, eigene Actors der Gebäude werden ausgewählt.
+	 * Gefundene Gebäude und die Dauer der Suche stehen im Output Log, wird über `CityGML.FindBuilding` aufgerufen.
+	 *
+	 * @param Args `id <gml:id>`, `address <Straße> [Hausnummer]` oder `box <MinX> <MinY> <MaxX> <MaxY>` in UTM-Koordinaten wie ImportRegion
+	 * @return Die gefundenen Gebäude als Index in der Geometrie des letzten Imports
+	 */
+	TArray<int32> FindBuildings(const TArray<FString>& Args);
+
 private:
 
 	/**
@@ -24,52 +171,167 @@ private:
 	 */
 	void AddMenuExtension(FMenuBuilder& Builder);
 	/**
-	 * Öffnet XML- und GML-Dateien, setzt globale Variablen zurück und ruft für jede Datei die Methode `ProcessCityGML` auf.
+	 * Öffnet XML- und GML-Dateien und startet den Import mit `StartImport`.
+	 * Läuft bereits ein Import, wird kein weiterer gestartet.
 	 */
 	void PluginButtonClicked();
 	/**
-	 * Liest eine Datei mit dem nativen XML-Parser der Unreal Engine ein
-	 * und wandelt diese in eine Node-Struktur um.
-	 * Überprüft, ob es sich um CityGML handelt, und bestimmt den Startpunkt für die Anzeige der Gebäude.
-	 * Am Ende wird geprüft, welches LoD (Level of Detail) vorliegt,
-	 * um dann das passende LoD zu verarbeiten oder eine Fehlermeldung auszugeben.
+	 * Setzt die globalen Variablen zurück und startet den Import im Hintergrund, der Editor bleibt dabei bedienbar.
+	 * Der Fortschritt wird in einer Benachrichtigung mit Cancel-Button angezeigt,
+	 * die Actors werden danach in `TickImport` über mehrere Editor-Ticks verteilt erzeugt.
 	 *
-	 * @param FilePath Pfad zur CityGML Datei
+	 * @param Files Pfade zu den CityGML Dateien
 	 */
-	void ProcessCityGML(const FString& FilePath);
+	void StartImport(const TArray<FString>& Files);
 	/**
-	 * Verarbeitet CityGML LoD1-Daten.
+	 * Hintergrundteil des Imports: verarbeitet alle Dateien, führt sie in Auswahlreihenfolge zusammen
+	 * und bereitet bei Bedarf die Kacheln vor. Es wird noch nichts im Level verändert.
 	 *
-	 * Durchläuft die Knoten, um die Vertices auszulesen.
-	 * Mithilfe von Hilfsfunktionen können aus den Vertices weitere Werte berechnet werden.
-	 * Die Gebäudedaten werden in Arrays gespeichert und in globale Variablen geschrieben.
-	 * 
-	 * @param CityObjectMembers Referenz auf die Children des RootNodes
-	 * @param OffSetVector Ein `FVector`, der verwendet wird, um die Position der Gebäude in der Welt zu verschieben.
+	 * @param Files Pfade zu den CityGML Dateien
 	 */
-	void ProcessLoD1(const TArray<FXmlNode*>& CityObjectMembers, FVector Offsetvector);
+	void RunImport(const TArray<FString>& Files);
 	/**
-	 * Verarbeitet CityGML LoD2-Daten.
+	 * Hintergrundteil des Imports bei `MemoryBudgetMB` mit OneMesh und TiledMesh: jede fertige Datei wird in Auswahlreihenfolge
+	 * sofort auf die Kacheln verteilt und freigegeben, statt erst im globalen Geometrie-Speicher zusammengeführt zu werden.
+	 * Kacheln über dem Budget lagert `FCityGMLTileSpool` auf die Festplatte aus. Im globalen Speicher bleiben nur die Sachdaten.
 	 *
-	 * Durchläuft die Knoten, um die Vertices auszulesen.
-	 * Mithilfe von Hilfsfunktionen können aus den Vertices weitere Werte berechnet werden.
-	 * Die Gebäudedaten werden in Arrays gespeichert und in globale Variablen geschrieben.
+	 * @param Files Pfade zu den CityGML Dateien
+	 */
+	void RunBudgetedImport(const TArray<FString>& Files);
+	/**
+	 * Wird jeden Editor-Tick aufgerufen, solange ein Import läuft. Aktualisiert die Fortschrittsanzeige
+	 * und erzeugt, sobald der Hintergrundteil fertig ist, pro Tick Actors bis `MeshBuildBudgetMs` erreicht ist.
 	 *
-	 * @param CityObjectMembers Referenz auf die Children des RootNodes
-	 * @param OffSetVector Ein `FVector`, der verwendet wird, um die Position der Gebäude in der Welt zu verschieben.
+	 * @param DeltaTime Zeit seit dem letzten Tick
+	 * @return false, wenn der Import abgeschlossen ist und der Ticker entfernt werden kann
 	 */
-	void ProcessLoD2(const TArray<FXmlNode*>& CityObjectMembers, FVector Offsetvector);
+	bool TickImport(float DeltaTime);
+	/** Fordert den Abbruch des laufenden Imports an, wird über den Cancel-Button aufgerufen */
+	void CancelImport();
 	/**
-	 * Verarbeitet CityGML LoD3-Daten.
+	 * Beendet den Import. Bei einem Abbruch werden alle bereits erzeugten Actors wieder entfernt,
+	 * sodass das Level unverändert bleibt.
 	 *
-	 * Durchläuft die Knoten, um die Vertices auszulesen.
-	 * Mithilfe von Hilfsfunktionen können aus den Vertices weitere Werte berechnet werden.
-	 * Die Gebäudedaten werden in Arrays gespeichert und in globale Variablen geschrieben, nur die Addressdaten liegen in LoD3 noch nicht vor.
+	 * @param bCancelled true, wenn der Import abgebrochen wurde
+	 */
+	void FinishImport(bool bCancelled);
+	/**
+	 * Schreibt die Kennzahlen des Imports als CSV nach Saved/CityGMLImporter/Stats, eine Zeile pro Datei und eine Summenzeile.
+	 * Die Plugin-Version steht in jeder Zeile, damit Messungen verschiedener Versionen verglichen werden können.
+	 */
+	void WriteStatsCsv();
+	/** Text der Fortschrittsanzeige für die aktuelle Phase: Lesen, Parsen, Triangulieren oder Meshes erzeugen */
+	FText GetProgressText() const;
+	/**
+	 * Erzeugt den Actor mit der Nummer Job: eine Kachel, das eine gemeinsame Mesh oder ein Gebäude, je nach `OneMesh` und `TiledMesh`.
 	 *
-	 * @param CityObjectMembers Referenz auf die Children des RootNodes
-	 * @param OffSetVector Ein `FVector`, der verwendet wird, um die Position der Gebäude in der Welt zu verschieben.
+	 * @param World Die Editor-Welt
+	 * @param Job Nummer zwischen 0 und der Anzahl der Meshes des Imports
+	 * @return Der erzeugte Actor oder nullptr
 	 */
-	void ProcessLoD3(const TArray<FXmlNode*>& CityObjectMembers, FVector Offsetvector);
+	AActor* CreateMeshJob(UWorld* World, int32 Job);
+	/**
+	 * Erzeugt bei `BakeStaticMeshes` für die übergebenen Jobs je ein UStaticMesh-Asset unter `StaticMeshPath`,
+	 * baut sie gemeinsam und platziert sie mit je einem AStaticMeshActor im Level.
+	 *
+	 * @param World Die Editor-Welt
+	 * @param Jobs Nummern der Jobs wie bei CreateMeshJob
+	 */
+	void CreateStaticMeshBatch(UWorld* World, TArrayView<const int32> Jobs);
+	/**
+	 * Platziert alle Gebäude einer Gruppe gleicher Gebäude als Instanzen eines Meshes
+	 * mit einer UHierarchicalInstancedStaticMeshComponent.
+	 *
+	 * @param World Die Editor-Welt
+	 * @param StaticMesh Das aus dem Prototyp der Gruppe erzeugte Asset, Pivot im Ursprung des Prototyps
+	 * @param Group Die Gruppe mit den Ursprüngen aller Gebäude
+	 * @param Label Name des Actors, die Anzahl der Instanzen wird angehängt
+	 * @return Der erzeugte Actor oder nullptr
+	 */
+	AActor* SpawnInstancedBuildings(UWorld* World, UStaticMesh* StaticMesh, const FCityGMLInstanceGroup& Group, const FString& Label);
+	/** Gibt das Verhältnis von Gebäuden zu eindeutigen Meshes und den eingesparten Speicher im Output Log aus */
+	void LogInstanceStats() const;
+	/**
+	 * Berechnet nach dem Zusammenführen den Hash jedes Gebäudes und jedes Jobs. Gebäude werden über ihre gml:id
+	 * mit dem letzten Import verglichen, Jobs über ihren Schlüssel: die gml:id des Gebäudes bzw. Prototyps,
+	 * die Zelle der Kachel oder "CityGMLMesh". Läuft im Hintergrundteil des Imports.
+	 */
+	void HashMeshJobs();
+	/**
+	 * Wählt die Jobs aus, deren Actor neu erzeugt werden muss. Bei `IncrementalImport` bleiben Actors des letzten Imports
+	 * mit gleichem Schlüssel und gleichem Hash stehen, sonst werden alle Jobs erzeugt.
+	 */
+	void SelectMeshJobs();
+	/**
+	 * Übernimmt die Actors dieses Imports als Stand für den nächsten Vergleich. Bei `IncrementalImport` werden
+	 * vorher die Actors des letzten Imports entfernt, die ersetzt wurden oder deren Gebäude nicht mehr vorkommen.
+	 */
+	void ApplyMeshUpdates();
+	/**
+	 * Verarbeitet alle Dateien, entweder nacheinander oder verteilt auf mehrere Worker-Threads.
+	 * Zip-Archive werden vorher in ihre Einträge aufgelöst, jeder Eintrag wird wie eine eigene Datei verarbeitet.
+	 * Die Ergebnisse stehen unabhängig von der Threadanzahl in derselben Reihenfolge wie die Dateien.
+	 *
+	 * @param Files Pfade zu den CityGML Dateien, .gml.gz Dateien oder Zip-Archiven
+	 * @param Progress Fortschritt und Cancel-Flag des Imports, NumFiles wird auf die Anzahl der Eingaben gesetzt
+	 * @param OnFileDone Optional, erhält jedes Ergebnis in Reihenfolge der Dateien, sobald es und alle vorherigen fertig sind.
+	 *                   Läuft auf einem Worker-Thread, nie zweimal gleichzeitig, und darf die Geometrie des Ergebnisses freigeben.
+	 *                   Ist `CityTileSpool` aktiv, beginnen neue Dateien nur, solange sie geschätzt ins Budget passen, und OnFileDone
+	 *                   erhält den Speicher der Dateien, die noch gelesen werden oder auf ihre Verteilung warten
+	 * @return Ein Ergebnis pro Datei bzw. Eintrag
+	 */
+	TArray<FCityGMLFileGeometry> ProcessCityGMLFiles(const TArray<FString>& Files, FCityGMLImportProgress& Progress, const TFunction<void(FCityGMLFileGeometry&, int64)>& OnFileDone = nullptr);
+	/**
+	 * Liest eine Datei oder einen Archiv-Eintrag mit dem FCityGMLReader vorwärts ein, ohne eine Node-Struktur aufzubauen.
+	 * Der Reader überprüft, ob es sich um CityGML handelt, und bestimmt das LoD (Level of Detail).
+	 * Fertig gelesene Gebäude werden blockweise auf dem Task-Graph trianguliert, während der Reader weiterliest,
+	 * und in Lesereihenfolge wieder eingesammelt.
+	 * Ist `UseGeometryCache` aktiv und liegt ein passender Cache-Eintrag vor, wird die Geometrie daraus geladen,
+	 * sonst wird sie nach dem Triangulieren in den Cache geschrieben.
+	 * Es werden keine globalen Variablen verändert, die Methode kann daher auf Worker-Threads laufen.
+	 *
+	 * @param Source Die CityGML Datei oder der Eintrag eines Zip-Archivs
+	 * @param FileGeometry Ergebnis der Datei inklusive Fehlermeldung und Zeiten
+	 * @param Progress Fortschritt und Cancel-Flag des Imports
+	 */
+	void ProcessCityGML(const FCityGMLSource& Source, FCityGMLFileGeometry& FileGeometry, FCityGMLImportProgress& Progress);
+	/**
+	 * Übernimmt das Ergebnis einer Datei in den globalen Geometrie-Speicher.
+	 * Die Dreiecksindizes werden dabei um die Anzahl der bisherigen Vertices verschoben.
+	 * Die Dateien müssen nacheinander in Auswahlreihenfolge übernommen werden.
+	 *
+	 * @param FileGeometry Ergebnis einer Datei
+	 */
+	void MergeFileGeometry(FCityGMLFileGeometry& FileGeometry);
+	/**
+	 * Verarbeitet ein Gebäude für jedes LoD auf dieselbe Weise, die Unterschiede stehen in den Pfaden des LoD.
+	 *
+	 * Bei LoD2 wird jedes bldg:boundedBy zu einer Fläche aus seinem ersten surfaceMember,
+	 * bei LoD1 und LoD3 jeder surfaceMember des lod1Solid bzw. jedes bldg:boundedBy.
+	 * Die Gebäudedaten werden direkt an den übergebenen Geometrie-Speicher angehängt.
+	 *
+	 * @param Building Das vom Reader gelesene Gebäude
+	 * @param Paths Die Pfade des LoD der Datei
+	 * @param OffsetVector Ein `FVector`, der verwendet wird, um die Position der Gebäude in der Welt zu verschieben.
+	 * @param Geometry Der Speicher, an den das Gebäude angehängt wird
+	 * @param Triangulator Arbeitspuffer für die Triangulierung, einer pro Task
+	 * @param Times Zeiten der einzelnen Schritte, werden aufsummiert
+	 */
+	void TriangulateBuilding(const FCityGMLBuilding& Building, const FCityGMLLoDPaths& Paths, FVector OffsetVector, FCityGMLGeometryStore& Geometry, FCityGMLTriangulator& Triangulator, FCityGMLPhaseTimes& Times);
+	/**
+	 * Liest eine Fläche aus den posLists eines surfaceMembers, trianguliert sie und berechnet Normalen, UVs und Tangenten.
+	 * Der äußere Ring und die inneren Ringe werden direkt in die Positionen des Speichers gelesen, die Dreiecke
+	 * direkt in seine Indizes geschrieben. Alles wird angehängt, auch wenn die Fläche weniger als drei Vertices besitzt.
+	 *
+	 * @param Building Das Gebäude mit dem Text der posLists
+	 * @param Surface Die Begrenzungsfläche, ihr Typ wird übernommen
+	 * @param Member Index des surfaceMembers, INDEX_NONE für eine leere Fläche
+	 * @param OffsetVector Ein FVector, der den Verschiebungsvektor repräsentiert, der auf die Koordinaten angewendet wird.
+	 * @param Geometry Der Speicher des aktuellen Gebäudes
+	 * @param Triangulator Arbeitspuffer für die Triangulierung
+	 * @param Times Zeiten für posList, Triangulierung, UVs und Tangenten, werden aufsummiert
+	 */
+	void AddFace(const FCityGMLBuilding& Building, const FCityGMLSurface& Surface, int32 Member, FVector OffsetVector, FCityGMLGeometryStore& Geometry, FCityGMLTriangulator& Triangulator, FCityGMLPhaseTimes& Times);
 	/**
 	 * Konvertiert die Koordianten aus CityGMl, welcher im ETRS89_UTM32 Format vorliegen in Unreal Engine Koordinaten.
 	 * Dafür werden X und Y vertauscht, die Sklaierung miteinbezogen und der OffsetVektor berücksichtigt.
@@ -80,72 +342,135 @@ private:
 	 * @param OriginOffset Startpunktsvektor, der als Offset für die Umrechnung dient.
 	 * @return Ein `FVector`, der die umgerechneten Koordinaten für die Unreal Engine repräsentiert.
 	 */
-	FVector ConvertUtmToUnreal(float UTM_X, float UTM_Y, float UTM_Z,  FVector OriginOffset);
+	FVector ConvertUtmToUnreal(double UTM_X, double UTM_Y, double UTM_Z,  FVector OriginOffset);
 	/**
-	 * Erstellt und spawnt statische Mesh-Objekte in der Unreal Engine basierend auf den gegebenen Gebäude-Polygonen und Dreieckslisten.
+	 * Erstellt und spawnt ein statisches Mesh-Objekt für ein Gebäude aus dem Geometrie-Speicher.
 	 * Jedes Gebäude wird als ein eigenes AStaticMeshActor-Objekt erstellt.
+	 * Die Flächen werden zu einer Mesh-Section zusammengefasst, bei `SectionPerSurfaceType` zu einer Section pro Dach, Wand und Boden.
+	 * Normalen, UVs und Tangenten werden übernommen, die Indizes auf den Anfang der Section bezogen.
 	 *
-	 * @param Buildings Ein TArray von Gebäuden, wobei jedes Gebäude eine Liste von Polygonen enthält, die wiederrum durch FVector-Arrays repräsentiert werden.
-	 * @param Triangles Ein TArray von Dreiecklisten, die die Dreiecke der Polygone definieren.
-	 * @param BuildingIds Ein TArray<FString>, das die ID der Gebäude enthält.
+	 * @param World Die Editor-Welt
+	 * @param Geometry Der Geometrie-Speicher mit den Flächen, Dreiecken und IDs der Gebäude.
+	 * @param Building Index des Gebäudes
+	 * @return Der erzeugte Actor oder nullptr
 	 */
-	void CreateMeshFromPolygon(TArray<TArray<TArray<FVector>>>& Buildings, TArray<TArray<TArray<int32>>>& Triangles, TArray<FString> BuildingIds);
+	AActor* CreateMeshFromPolygon(UWorld* World, const FCityGMLGeometryStore& Geometry, int32 Building);
 	/**
-	 * Erstellt ein einziges Mesh aus mehreren Gebäude-Polygonen und Dreieckslisten.
-	 * Die Gebäude werden in ein einzelnes Mesh kombiniert, das als ein einziges statisches Mesh-Objekt in der Unreal Engine dargestellt wird.
+	 * Erstellt ein einziges Mesh aus allen Gebäuden im Geometrie-Speicher.
+	 * Die Puffer des Speichers werden ohne Umkopieren als eine Mesh-Section übergeben, die als ein einziges statisches Mesh-Objekt in der Unreal Engine dargestellt wird.
 	 *
-	 * @param Buildings Ein TArray von Gebäuden, wobei jedes Gebäude eine Liste von Polygonen enthält, die wiederrum durch FVector-Arrays repräsentiert werden.
-	 * @param Triangles Ein TArray von Dreiecklisten, die die Dreiecke der Polygone definieren.
+	 * @param World Die Editor-Welt
+	 * @param Geometry Der Geometrie-Speicher mit allen Gebäuden.
+	 * @return Der erzeugte Actor oder nullptr
 	 */
-	void CreateOneMeshFromPolygon(TArray<TArray<TArray<FVector>>>& Buildings, TArray<TArray<TArray<int32>>>& Triangles);
+	AActor* CreateOneMeshFromPolygon(UWorld* World, const FCityGMLGeometryStore& Geometry);
 	/**
-	 * Liest die Koordinaten eines Polygons aus einem CityGML-Dokument und konvertiert sie in Unreal Engine-Koordinaten unter Berücksichtigung des Offset-Vektors.
-	 * Diese Methode kann von allen ProcessLoD Methoden durch die ähnliche Strucktur von CityGML genutzt werden und nutzt selbst ConvertUtmToUnreal.
+	 * Erstellt das Mesh-Objekt einer Kachel aus `CityGMLTiling::BuildTiles` mit einer Mesh-Section.
+	 * Der Actor wird im Mittelpunkt der Kachel platziert, die Vertices sind bereits darauf bezogen,
+	 * sodass jede Kachel einzeln verworfen werden kann.
+	 * Bei `MemoryBudgetMB` werden ausgelagerte Teile vorher geladen und die Geometrie der Kachel danach freigegeben.
 	 *
-	 * @param PolygonNode Ein FXmlNode, das das Polygon-Element des CityGML-Dokuments repräsentiert.
+	 * @param World Die Editor-Welt
+	 * @param TileIndex Index der Kachel
+	 * @return Der erzeugte Actor oder nullptr
+	 */
+	AActor* CreateTileMesh(UWorld* World, int32 TileIndex);
+	/**
+	 * Lädt bei `MemoryBudgetMB` die ausgelagerten Teile einer Kachel. Fehlt ein Teil oder ist er beschädigt,
+	 * wird ein Fehler mit der Zelle der Kachel ausgegeben und die Geometrie der Kachel freigegeben.
+	 *
+	 * @param Tile Die Kachel
+	 * @return false, wenn die Kachel unvollständig ist und nicht erzeugt werden darf
+	 */
+	bool LoadSpilledTile(FCityGMLTile& Tile);
+	/** Gibt Anzahl der Kacheln, Dreiecke pro Kachel und Draw Calls im Output Log aus */
+	void LogTileStats();
+	/** Gibt bei `MemoryBudgetMB` den höchsten Speicherbedarf des Imports und des Prozesses im Vergleich zum Budget aus */
+	void LogMemoryBudget();
+	/**
+	 * Liest die Koordinaten eines Rings aus dem Inhalt einer gml:posList und konvertiert sie in Unreal Engine-Koordinaten unter Berücksichtigung des Offset-Vektors.
+	 * Die Zahlen werden mit CityGMLPosList ohne Zwischenstrings direkt aus dem UTF-8 Text der Datei gelesen.
+	 * Diese Methode wird für alle LoDs über AddFace genutzt. Die Koordinaten werden zuerst alle gelesen und dann gemeinsam
+	 * mit CityGMLVertexKernels::TransformUtm umgerechnet, bitgleich zu ConvertUtmToUnreal.
+	 * Der letzte Punkt schließt den Ring und wird nicht übernommen.
+	 *
+	 * @param PosList Der Inhalt der gml:posList eines äußeren oder inneren Rings.
 	 * @param OffsetVector Ein FVector, der den Verschiebungsvektor repräsentiert, der auf die Koordinaten angewendet wird.
-	 * @return Ein TArray<FVector>, das die konvertierten Koordinaten des Polygons als TArray zurückgibt.
+	 * @param OutVertices Array, an das die konvertierten Koordinaten angehängt werden, z.B. die Positionen des Geometrie-Speichers.
+	 * @return Anzahl der angehängten Punkte
 	 */
-	TArray<FVector> ParsePolygon(const FXmlNode* PolygonNode, FVector OffsetVector);
+	int32 ParseRing(FAnsiStringView PosList, FVector OffsetVector, TArray<FVector>& OutVertices);
 	/**
 	 * Generiert aus dem TArray an Vertices welches mitgegeben wird eine Liste von Indizes, die die Dreiecke des Polygons definieren.
 	 * Der Fan-Algorithmus wird verwendet, um die Dreiecke aus den gegebenen Vertices zu erstellen.
+	 * Das ist nur bei konvexen Ringen ohne Löcher gültig, AddFace nutzt daher den FCityGMLTriangulator.
 	 *
 	 * @param Vertices Ein TArray<FVector>, das die Eckpunkte des Polygons enthält.
+	 * @param FaceVertexOffset Index des ersten Vertex der Fläche.
 	 * @return Ein TArray<int32>, das die Indizes der Vertices enthält, die die Dreiecke des Polygons definieren.
 	 */
-	TArray<int32> GenerateTriangles(const TArray<FVector>& Vertices);
+	TArray<int32> GenerateTriangles(const TArray<FVector>& Vertices, int32 FaceVertexOffset);
 	/**
 	 * Berechnet den Normalenvektor für eine Fläche basierend auf den gegebenen Vertices.
 	 * Der Vektor wird so oft in ein Normalen Array eingetragen, wie die Fläche Vertices besitzt.
 	 *
 	 * @param Vertices Ein TArray<FVector>, das die Eckpunkte des Polygons enthält.
+	 * @param OutNormals Array, an das die Normalen angehängt werden.
 	 */
-	void GenerateNormals(const TArray<FVector>& Vertices);
+	void GenerateNormals(const TArray<FVector>& Vertices, TArray<FVector>& OutNormals);
 	/**
 	 * Generiert die UV-Koordinaten für die Vertices einer Fläche, die für die Texturierung in Unreal Engine verwendet werden.
+	 * Box-Projektion über CityGMLVertexKernels::BoxProjectUVs, vier Vertices gleichzeitig.
 	 *
-	 * @param Vertices Ein TArray<FVector>, das die Eckpunkte des Polygons enthält.
+	 * @param Vertices Die Eckpunkte der Fläche.
+	 * @param OutUVs Array, an das die UV-Koordinaten angehängt werden.
 	 */
-	void GenerateUVs(const TArray<FVector>& Vertices);
+	void GenerateUVs(TArrayView<const FVector> Vertices, TArray<FVector2D>& OutUVs);
 	/**
 	 * Berechnet die Tangenten für die Vertices einer Fläche, die für die Normalen- und Texturierungseffekte in Unreal Engine verwendet werden.
+	 * Jeder Vertex bekommt die Summe der Tangenten seiner Dreiecke, senkrecht zu seiner Normale, siehe CityGMLVertexKernels::ComputeTangents.
 	 *
-	 * @param Vertices Ein TArray<FVector>, das die Eckpunkte des Polygons enthält.
-	 * @param Triangles Ein TArray<int32>, das die Indizes der Vertices enthält, die die Dreiecke der Fläche definieren.
+	 * @param Vertices Die Eckpunkte der Fläche.
+	 * @param Triangles Die Indizes der Dreiecke der Fläche.
+	 * @param FaceVertexOffset Index des ersten Vertex der Fläche, wird von jedem Index in Triangles abgezogen.
+	 * @param FaceUVs Die UV-Koordinaten der Fläche, gleich viele wie Vertices.
+	 * @param FaceNormals Die Normalen der Fläche, gleich viele wie Vertices.
+	 * @param OutTangents Array, an das die Tangenten angehängt werden.
 	 */
-	void GenerateTangents(const TArray<FVector>& Vertices, const TArray<int32> Triangles);
-	 /**
-	  * Extrahiert Adressinformationen wie Straße, Hausnummer und Postleitzahl aus CityGML Dokumenten.
-	  * Die Methode durchsucht den mitgegebenen XML-Baum nach den relevanten Adressdaten und gibt diese in einem Array zurück.
-	  *
-	  * @param AddressNode Ein FXmlNode, der den Knoten des CityGML-Dokuments enthält, der die Adressinformationen repräsentiert.
-	  * @return Ein TArray<FString>, das die extrahierten Adressinformationen enthält: Straße, Hausnummer und Postleitzahl.
-	  *									Wenn eine Information fehlt, wird an dieser Stelle ein leerer String zurückgegeben.
-	  */
-	TArray<FString> GetAdress(const FXmlNode* AddressNode);
+	void GenerateTangents(TArrayView<const FVector> Vertices, TArrayView<const int32> Triangles, int32 FaceVertexOffset, TArrayView<const FVector2D> FaceUVs, TArrayView<const FVector> FaceNormals, TArray<FProcMeshTangent>& OutTangents);
 
 
 
 	TSharedPtr<FUICommandList> PluginCommands;
+
+	/** Zustand des laufenden Imports, ungültig wenn gerade nichts importiert wird */
+	TSharedPtr<FCityGMLImportProgress, ESPMode::ThreadSafe> ActiveImport;
+	TFuture<void> ImportTask;
+	TSharedPtr<SNotificationItem> ProgressNotification;
+	FDelegateHandle TickerHandle;
+	/** Bereits erzeugte Actors, werden bei einem Abbruch wieder entfernt */
+	TArray<TWeakObjectPtr<AActor>> SpawnedActors;
+	/** Bei BakeStaticMeshes angelegte Assets, werden bei einem Abbruch wieder verworfen */
+	TArray<TWeakObjectPtr<UStaticMesh>> CreatedStaticMeshes;
+	double ImportStartSeconds = 0.0;
+	/** Anzahl der Flächen und der erzeugten Sections im Modus pro Gebäude, für die Ausgabe im Output Log */
+	int32 FacesMeshed = 0;
+	int32 SectionsCreated = 0;
+	double MeshStartSeconds = 0.0;
+	/** Kennzahlen pro Datei für WriteStatsCsv */
+	TArray<FCityGMLFileStats> FileStats;
+
+	/** Stand des letzten abgeschlossenen Imports für IncrementalImport: Hash pro gml:id und Actor pro Job-Schlüssel */
+	TMap<FString, uint64> ImportedBuildings;
+	TMap<FString, FCityGMLImportedMesh> ImportedMeshes;
+	/** Dasselbe für den laufenden Import, wird erst in ApplyMeshUpdates übernommen */
+	TMap<FString, uint64> CurrentBuildings;
+	TMap<FString, FCityGMLImportedMesh> CurrentMeshes;
+	/** Schlüssel und Hash pro Job aus HashMeshJobs */
+	TArray<FString> JobKeys;
+	TArray<uint64> JobHashes;
+	/** Jobs, deren Actor in TickImport erzeugt wird */
+	TArray<int32> PendingJobs;
+	FCityGMLUpdateCounts BuildingUpdates;
+	FCityGMLUpdateCounts MeshUpdates;
 };